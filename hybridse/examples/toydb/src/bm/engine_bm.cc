@@ -149,6 +149,17 @@ static void BM_EngineRunBatchWindowSumFeature5Window5(
     EngineRunBatchWindowSumFeature5Window5(&state, BENCHMARK, state.range(0),
                                            state.range(1));
 }
+// range(0) is the number of threads and range(1) the number of rows
+static void BM_EngineRunBatchWindowAggParallelOneKey(
+    benchmark::State& state) {  // NOLINT
+    EngineRunBatchWindowAggParallel(&state, BENCHMARK, "col0", state.range(0),
+                                    state.range(1));
+}
+static void BM_EngineRunBatchWindowAggParallelEightKeys(
+    benchmark::State& state) {  // NOLINT
+    EngineRunBatchWindowAggParallel(&state, BENCHMARK, "col6", state.range(0),
+                                    state.range(1));
+}
 
 // request engine simple bm
 BENCHMARK(BM_EngineRequestSimpleSelectVarchar);
@@ -314,6 +325,15 @@ BENCHMARK(BM_EngineWindowSumFeature5ExcludeCurrentTime)
     ->Args({100, 100})
     ->Args({1000, 1000})
     ->Args({10000, 10000});
+// scaling of batch window aggregation over 1-32 threads
+BENCHMARK(BM_EngineRunBatchWindowAggParallelOneKey)
+    ->RangeMultiplier(2)
+    ->Ranges({{1, 32}, {100000, 100000}})
+    ->UseRealTime();
+BENCHMARK(BM_EngineRunBatchWindowAggParallelEightKeys)
+    ->RangeMultiplier(2)
+    ->Ranges({{1, 32}, {100000, 100000}})
+    ->UseRealTime();
 
 }  // namespace bm
 }  // namespace hybridse
@@ -306,6 +306,55 @@ void EngineRunBatchWindowSumFeature5Window5(benchmark::State* state, MODE mode,
         std::to_string(limit_cnt) + ";";
     EngineBatchMode(sql, mode, limit_cnt, size, state);
 }
+void EngineRunBatchWindowAggParallel(benchmark::State* state, MODE mode,
+                                     const std::string& partition_col,
+                                     int64_t thread_num,
+                                     int64_t size) {  // NOLINT
+    // no limit, which keeps the keys serial
+    const std::string sql =
+        "SELECT "
+        "sum(col4) OVER w1 as w1_col4_sum, "
+        "max(col1) OVER w1 as w1_col1_max, "
+        "count(col3) OVER w1 as w1_col3_cnt "
+        "FROM t1 WINDOW w1 AS (PARTITION BY " +
+        partition_col +
+        " ORDER BY col5 ROWS_RANGE BETWEEN 100s PRECEDING AND CURRENT ROW);";
+    InitializeNativeTarget();
+    InitializeNativeTargetAsmPrinter();
+    auto catalog = vm::BuildOnePkTableStorage(size);
+    vm::EngineOptions options;
+    options.SetBatchWindowAggThreadNum(thread_num);
+    Engine engine(catalog, options);
+    BatchRunSession session;
+    base::Status query_status;
+    engine.Get(sql, "db", session, query_status);
+    switch (mode) {
+        case BENCHMARK: {
+            for (auto _ : *state) {
+                std::vector<hybridse::codec::Row> outputs;
+                benchmark::DoNotOptimize(session.Run(outputs));
+            }
+            state->SetItemsProcessed(state->iterations() * size);
+            break;
+        }
+        case TEST: {
+            std::vector<hybridse::codec::Row> outputs;
+            ASSERT_EQ(0, session.Run(outputs));
+            ASSERT_EQ(static_cast<uint64_t>(size), outputs.size());
+            // the run of an engine without the pool is the expectation
+            Engine serial_engine(catalog);
+            BatchRunSession serial_session;
+            ASSERT_TRUE(serial_engine.Get(sql, "db", serial_session, query_status));
+            std::vector<hybridse::codec::Row> expects;
+            ASSERT_EQ(0, serial_session.Run(expects));
+            ASSERT_EQ(expects.size(), outputs.size());
+            for (size_t i = 0; i < expects.size(); i++) {
+                ASSERT_EQ(0, expects[i].compare(outputs[i])) << "row " << i;
+            }
+            break;
+        }
+    }
+}
 void EngineRunBatchWindowMultiAggWindow25Feature25(benchmark::State* state,
                                                    MODE mode, int64_t limit_cnt,
                                                    int64_t size) {  // NOLINT
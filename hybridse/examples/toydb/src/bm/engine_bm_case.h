@@ -55,6 +55,12 @@ void EngineRunBatchWindowSumFeature5Window5(benchmark::State* state, MODE mode,
 void EngineRunBatchWindowMultiAggWindow25Feature25(benchmark::State* state,
                                                    MODE mode, int64_t limit_cnt,
                                                    int64_t size);  // NOLINT
+// the window aggregation of batch mode on thread_num threads, partition by
+// col0 for one key and by col6 for eight keys
+void EngineRunBatchWindowAggParallel(benchmark::State* state, MODE mode,
+                                     const std::string& partition_col,
+                                     int64_t thread_num,
+                                     int64_t size);  // NOLINT
 void EngineRunBatchWindowSumFeature5(benchmark::State* state, MODE mode,
                                      int64_t limit_cnt,
                                      int64_t size);  // NOLINT
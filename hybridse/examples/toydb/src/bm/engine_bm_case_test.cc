@@ -68,6 +68,11 @@ TEST_F(EngineBMCaseTest, EngineRunBatchWindowSumFeature1_TEST) {
     EngineRunBatchWindowSumFeature1(nullptr, TEST, 100L, 100L);
     EngineRunBatchWindowSumFeature1(nullptr, TEST, 1000L, 1000L);
 }
+TEST_F(EngineBMCaseTest, EngineRunBatchWindowAggParallel_TEST) {
+    EngineRunBatchWindowAggParallel(nullptr, TEST, "col0", 4, 10000L);
+    EngineRunBatchWindowAggParallel(nullptr, TEST, "col6", 4, 10000L);
+    EngineRunBatchWindowAggParallel(nullptr, TEST, "col6", 32, 100L);
+}
 TEST_F(EngineBMCaseTest, EngineRunBatchWindowSumFeature5Window5_TEST) {
     EngineRunBatchWindowSumFeature5Window5(nullptr, TEST, 100L, 100L);
 }
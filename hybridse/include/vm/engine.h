@@ -17,11 +17,15 @@
 #ifndef HYBRIDSE_INCLUDE_VM_ENGINE_H_
 #define HYBRIDSE_INCLUDE_VM_ENGINE_H_
 
+#include <condition_variable>  //NOLINT
+#include <deque>
+#include <functional>
 #include <map>
 #include <memory>
 #include <mutex>  //NOLINT
 #include <set>
 #include <string>
+#include <thread>  //NOLINT
 #include <utility>
 #include <vector>
 #include <unordered_map>
@@ -37,6 +41,9 @@
 #include "vm/router.h"
 
 namespace hybridse {
+namespace base {
+class WorkStealingPool;
+}  // namespace base
 namespace vm {
 
 using ::hybridse::codec::Row;
@@ -103,6 +110,25 @@ class EngineOptions {
         return enable_batch_window_parallelization_;
     }
 
+    /// Set the number of threads a batch window aggregation runs its
+    /// partitions on, default `1`.
+    EngineOptions* SetBatchWindowAggThreadNum(uint32_t thread_num);
+    /// Return the number of threads of a batch window aggregation.
+    inline uint32_t GetBatchWindowAggThreadNum() const {
+        return batch_window_agg_thread_num_;
+    }
+
+    /// Set `true` to run table projects, filters and group aggregations of
+    /// batch mode over batches of rows instead of row by row, default `false`.
+    inline EngineOptions* SetEnableBatchVectorized(bool flag) {
+        enable_batch_vectorized_ = flag;
+        return this;
+    }
+    /// Return if the engine runs batch mode over batches of rows.
+    inline bool IsEnableBatchVectorized() const {
+        return enable_batch_vectorized_;
+    }
+
     /// Set `true` to enable window column purning
     inline EngineOptions* SetEnableWindowColumnPruning(bool flag) {
         enable_window_column_pruning_ = flag;
@@ -113,6 +139,22 @@ class EngineOptions {
         return enable_window_column_pruning_;
     }
 
+    /// Set the times a batch mode query is got from the cache before it is
+    /// compiled again with aggressive optimizations in background, default
+    /// `0` to disable it.
+    ///
+    /// If not `0`, batch mode queries are compiled without optimizations at
+    /// first, which is faster for the queries run only a few times. The hot
+    /// ones run the optimized code once the background compile is done.
+    inline EngineOptions* SetTieredCompileThreshold(uint32_t threshold) {
+        tiered_compile_threshold_ = threshold;
+        return this;
+    }
+    /// Return the times a query is got before it is compiled with aggressive optimizations.
+    inline uint32_t GetTieredCompileThreshold() const {
+        return tiered_compile_threshold_;
+    }
+
     /// Set the maximum number of cache entries, default is `50`.
     inline void SetMaxSqlCacheSize(uint32_t size) {
         max_sql_cache_size_ = size;
@@ -138,7 +180,10 @@ class EngineOptions {
     bool batch_request_optimized_;
     bool enable_expr_optimize_;
     bool enable_batch_window_parallelization_;
+    uint32_t batch_window_agg_thread_num_;
+    bool enable_batch_vectorized_;
     bool enable_window_column_pruning_;
+    uint32_t tiered_compile_threshold_;
     uint32_t max_sql_cache_size_;
     bool enable_spark_unsaferow_format_;
     JitOptions jit_options_;
@@ -197,6 +242,8 @@ class RunSession {
     bool is_debug_;
     std::string sp_name_;
     std::shared_ptr<const std::unordered_map<std::string, std::string>> options_ = nullptr;
+    // the threads of the engine a batch window aggregation runs its partitions on
+    std::shared_ptr<base::WorkStealingPool> window_agg_pool_ = nullptr;
     friend Engine;
 };
 
@@ -423,6 +470,12 @@ class Engine {
     /// \brief Get engine's options
     EngineOptions GetEngineOptions();
 
+    /// \brief Set a function called with the sql and the result each time
+    /// the background compile of a hot sql with optimizations is done.
+    ///
+    /// The function runs on the background compile thread.
+    void SetTieredCompileHook(const std::function<void(const std::string& sql, bool ok)>& hook);
+
  private:
     bool GetDependentTables(const node::PlanNode* node, const std::string& default_db,
                             std::set<std::pair<std::string, std::string>>* db_tables, base::Status& status);  // NOLINT
@@ -432,11 +485,22 @@ class Engine {
     bool SetCacheLocked(const std::string& db, const std::string& sql,
                         EngineMode engine_mode,
                         std::shared_ptr<CompileInfo> info);
+    // replace the cached info of the sql with info if the cache still holds
+    // old_info, return false if it is evicted or cleared
+    bool ReplaceCacheLocked(const std::string& db, const std::string& sql,
+                            EngineMode engine_mode,
+                            const std::shared_ptr<CompileInfo>& old_info,
+                            const std::shared_ptr<CompileInfo>& info);
 
     bool IsCompatibleCache(RunSession& session,  // NOLINT
                            std::shared_ptr<CompileInfo> info,
                            base::Status& status);  // NOLINT
 
+    // count a hit of a cached info compiled without optimizations, and
+    // schedule the background compile once the info is hot
+    std::shared_ptr<CompileInfo> GetTieredInfo(const std::shared_ptr<CompileInfo>& info);
+    void OptimizedCompileLoop();
+
     bool Explain(const std::string& sql, const std::string& db,
                  EngineMode engine_mode, const codec::Schema& parameter_schema,
                  const std::set<size_t>& common_column_indices,
@@ -445,6 +509,18 @@ class Engine {
     EngineOptions options_;
     base::SpinMutex mu_;
     EngineLRUCache lru_cache_;
+
+    // the hot infos to compile with aggressive optimizations in background
+    std::mutex tiered_mu_;
+    std::condition_variable tiered_cv_;
+    std::deque<std::shared_ptr<CompileInfo>> tiered_queue_;
+    bool tiered_stop_;
+    std::thread tiered_thread_;
+    std::function<void(const std::string&, bool)> tiered_hook_;
+
+    // shared by the batch sessions, null unless the window aggregation
+    // runs on more than one thread
+    std::shared_ptr<base::WorkStealingPool> window_agg_pool_;
 };
 
 /// \brief Local tablet is responsible to run a task locally.
@@ -65,14 +65,22 @@ class CompileInfo {
                                 const std::string& tab) = 0;
 };
 
+/// \brief The cached CompileInfo of a sql.
+///
+/// The boost lru_cache never updates the value of a cached key, so the
+/// info is kept in a slot to be replaced in place.
+struct CompileInfoSlot {
+    std::shared_ptr<CompileInfo> info;
+};
+
 /// @typedef EngineLRUCache
 /// - EngineMode
 ///     - DB name
 ///       - SQL string
-///           - CompileInfo
+///           - CompileInfoSlot
 typedef std::map<EngineMode,
                 std::map<std::string,
-                    boost::compute::detail::lru_cache<std::string, std::shared_ptr<CompileInfo>>>>
+                    boost::compute::detail::lru_cache<std::string, std::shared_ptr<CompileInfoSlot>>>>
     EngineLRUCache;
 
 class CompileInfoCache {
@@ -101,11 +109,29 @@ class JitOptions {
     bool IsEnablePerf() const { return enable_perf_; }
     void SetEnablePerf(bool flag) { enable_perf_ = flag; }
 
+    // the dir to keep the compiled objects of sql modules, which are loaded
+    // instead of compiling the same sql again, empty to disable the cache
+    const std::string& GetObjectCacheDir() const { return object_cache_dir_; }
+    void SetObjectCacheDir(const std::string& dir) { object_cache_dir_ = dir; }
+
+    // the bytes the objects in the cache dir may take, the least recently
+    // used ones are removed beyond it, 0 for no limit
+    uint64_t GetObjectCacheMaxSize() const { return object_cache_max_size_; }
+    void SetObjectCacheMaxSize(uint64_t size) { object_cache_max_size_ = size; }
+
+    // 0 compiles fast without the optimizations, 2 runs the default
+    // optimizations and 3 runs the aggressive ones for the host cpu
+    uint32_t GetOptLevel() const { return opt_level_; }
+    void SetOptLevel(uint32_t level) { opt_level_ = level; }
+
  private:
     bool enable_mcjit_ = false;
     bool enable_vtune_ = false;
     bool enable_gdb_ = false;
     bool enable_perf_ = false;
+    std::string object_cache_dir_ = "";
+    uint64_t object_cache_max_size_ = 1024ull << 20;
+    uint32_t opt_level_ = 2;
 };
 }  // namespace vm
 }  // namespace hybridse
@@ -54,6 +54,8 @@ struct DescComparor {
     }
 };
 
+class IncrementalWindowAgg;
+
 typedef std::deque<std::pair<uint64_t, Row>> MemTimeTable;
 typedef std::vector<Row> MemTable;
 typedef std::map<std::string, MemTimeTable, std::greater<std::string>>
@@ -249,9 +251,27 @@ class Window : public MemTimeTableHandler {
     Window()
         : MemTimeTableHandler(),
           exclude_current_time_(false),
-          instance_not_in_window_(false) {}
+          instance_not_in_window_(false),
+          enable_incremental_agg_(false),
+          front_added_cnt_(0),
+          back_popped_cnt_(0),
+          front_popped_cnt_(0) {}
     virtual ~Window() {}
 
+    // count the updates so that the incremental aggregations can catch up
+    void AddFrontRow(const uint64_t key, const Row& v) {
+        MemTimeTableHandler::AddFrontRow(key, v);
+        front_added_cnt_++;
+    }
+    void PopBackRow() {
+        MemTimeTableHandler::PopBackRow();
+        back_popped_cnt_++;
+    }
+    void PopFrontRow() {
+        MemTimeTableHandler::PopFrontRow();
+        front_popped_cnt_++;
+    }
+
     std::unique_ptr<RowIterator> GetIterator() override {
         std::unique_ptr<vm::MemTimeTableIterator> it(
             new vm::MemTimeTableIterator(&table_, schema_));
@@ -286,9 +306,33 @@ class Window : public MemTimeTableHandler {
         exclude_current_time_ = flag;
     }
 
+    const bool enable_incremental_agg() const {
+        return enable_incremental_agg_;
+    }
+    void set_enable_incremental_agg(const bool flag) {
+        enable_incremental_agg_ = flag;
+    }
+    const uint64_t front_added_cnt() const { return front_added_cnt_; }
+    const uint64_t back_popped_cnt() const { return back_popped_cnt_; }
+    const uint64_t front_popped_cnt() const { return front_popped_cnt_; }
+
+    // the state of the incremental aggregation with the given id, which
+    // lives as long as the window
+    std::shared_ptr<IncrementalWindowAgg>& GetIncrementalAgg(uint32_t id) {
+        if (id >= incremental_aggs_.size()) {
+            incremental_aggs_.resize(id + 1);
+        }
+        return incremental_aggs_[id];
+    }
+
  protected:
     bool exclude_current_time_;
     bool instance_not_in_window_;
+    bool enable_incremental_agg_;
+    uint64_t front_added_cnt_;
+    uint64_t back_popped_cnt_;
+    uint64_t front_popped_cnt_;
+    std::vector<std::shared_ptr<IncrementalWindowAgg>> incremental_aggs_;
 };
 class WindowRange {
  public:
@@ -108,6 +108,8 @@ class FnInfo {
         frames_.clear();
         schemas_ctx_ = nullptr;
         fn_ptr_ = nullptr;
+        batch_fn_name_ = "";
+        batch_fn_ptr_ = nullptr;
     }
 
     const node::FrameNode *GetFrame(size_t idx) const {
@@ -123,6 +125,12 @@ class FnInfo {
     const int8_t *fn_ptr() const { return fn_ptr_; }
     void SetFnPtr(const int8_t *fn) { fn_ptr_ = fn; }
 
+    // the function which runs fn over a batch of rows, empty if not built
+    const std::string &batch_fn_name() const { return batch_fn_name_; }
+    void SetBatchFnName(const std::string &name) { batch_fn_name_ = name; }
+    const int8_t *batch_fn_ptr() const { return batch_fn_ptr_; }
+    void SetBatchFnPtr(const int8_t *fn) { batch_fn_ptr_ = fn; }
+
  private:
     std::string fn_name_ = "";
     vm::Schema fn_schema_;
@@ -139,6 +147,10 @@ class FnInfo {
 
     // function ptr
     const int8_t *fn_ptr_ = nullptr;
+
+    // batch function name and ptr
+    std::string batch_fn_name_ = "";
+    const int8_t *batch_fn_ptr_ = nullptr;
 };
 
 class FnComponent {
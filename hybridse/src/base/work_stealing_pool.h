@@ -0,0 +1,189 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HYBRIDSE_SRC_BASE_WORK_STEALING_POOL_H_
+#define HYBRIDSE_SRC_BASE_WORK_STEALING_POOL_H_
+
+#include <algorithm>
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <functional>
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+#include <vector>
+#include "base/spin_lock.h"
+
+namespace hybridse {
+namespace base {
+
+/**
+ * Run batches of independent tasks on a group of threads.
+ *
+ * The threads are started once and wait for the batches. The tasks of a
+ * batch are dealt out to the threads in contiguous ranges. A thread takes
+ * tasks from the front of its own deque and, once the deque is empty,
+ * steals from the back of the others, so that a few heavy tasks do not hold
+ * the batch back. The batches of concurrent callers run one after another.
+ */
+class WorkStealingPool {
+ public:
+    explicit WorkStealingPool(size_t thread_num)
+        : thread_num_(std::max(thread_num, static_cast<size_t>(1))),
+          queues_(thread_num_),
+          fn_(nullptr),
+          batch_(0),
+          busy_(0),
+          stop_(false) {
+        threads_.reserve(thread_num_ - 1);
+        for (size_t w = 1; w < thread_num_; w++) {
+            threads_.emplace_back([this, w]() { Loop(w); });
+        }
+    }
+
+    ~WorkStealingPool() {
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+            stop_ = true;
+        }
+        work_cv_.notify_all();
+        for (auto& thread : threads_) {
+            thread.join();
+        }
+    }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    size_t thread_num() const { return thread_num_; }
+
+    // run fn(task_idx) for every idx of [0, task_num) and wait for them all,
+    // the calling thread is one of the workers
+    void Run(size_t task_num, const std::function<void(size_t)>& fn) {
+        if (thread_num_ <= 1 || task_num <= 1) {
+            for (size_t i = 0; i < task_num; i++) {
+                fn(i);
+            }
+            return;
+        }
+        std::lock_guard<std::mutex> run_lock(run_mu_);
+        size_t worker_num = std::min(thread_num_, task_num);
+        for (size_t w = 0; w < worker_num; w++) {
+            size_t begin = task_num * w / worker_num;
+            size_t end = task_num * (w + 1) / worker_num;
+            std::lock_guard<SpinMutex> lock(queues_[w].mu);
+            for (size_t i = begin; i < end; i++) {
+                queues_[w].tasks.push_back(i);
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+            fn_ = &fn;
+            busy_ = threads_.size();
+            batch_++;
+        }
+        work_cv_.notify_all();
+        Work(0, fn);
+        std::unique_lock<std::mutex> lock(mu_);
+        done_cv_.wait(lock, [this]() { return busy_ == 0; });
+        fn_ = nullptr;
+    }
+
+ private:
+    struct TaskQueue {
+        SpinMutex mu;
+        std::deque<size_t> tasks;
+    };
+
+    static bool PopFront(TaskQueue* queue, size_t* task) {
+        std::lock_guard<SpinMutex> lock(queue->mu);
+        if (queue->tasks.empty()) {
+            return false;
+        }
+        *task = queue->tasks.front();
+        queue->tasks.pop_front();
+        return true;
+    }
+
+    static bool PopBack(TaskQueue* queue, size_t* task) {
+        std::lock_guard<SpinMutex> lock(queue->mu);
+        if (queue->tasks.empty()) {
+            return false;
+        }
+        *task = queue->tasks.back();
+        queue->tasks.pop_back();
+        return true;
+    }
+
+    // wait for a batch, work on it and report back until the pool stops
+    void Loop(size_t self) {
+        uint64_t done_batch = 0;
+        while (true) {
+            const std::function<void(size_t)>* fn = nullptr;
+            {
+                std::unique_lock<std::mutex> lock(mu_);
+                work_cv_.wait(lock, [this, done_batch]() { return stop_ || batch_ != done_batch; });
+                if (stop_) {
+                    return;
+                }
+                done_batch = batch_;
+                fn = fn_;
+            }
+            Work(self, *fn);
+            {
+                std::lock_guard<std::mutex> lock(mu_);
+                busy_--;
+            }
+            done_cv_.notify_one();
+        }
+    }
+
+    // no task is added once the batch starts, so a worker is done after it
+    // finds every queue empty
+    void Work(size_t self, const std::function<void(size_t)>& fn) {
+        size_t task;
+        while (true) {
+            if (PopFront(&queues_[self], &task)) {
+                fn(task);
+                continue;
+            }
+            bool stolen = false;
+            for (size_t i = 1; i < queues_.size() && !stolen; i++) {
+                stolen = PopBack(&queues_[(self + i) % queues_.size()], &task);
+            }
+            if (!stolen) {
+                return;
+            }
+            fn(task);
+        }
+    }
+
+    const size_t thread_num_;
+    std::vector<TaskQueue> queues_;
+    std::vector<std::thread> threads_;
+    // held by a batch from dealing out the tasks until the workers are done
+    std::mutex run_mu_;
+    std::mutex mu_;
+    std::condition_variable work_cv_;
+    std::condition_variable done_cv_;
+    const std::function<void(size_t)>* fn_;
+    uint64_t batch_;
+    size_t busy_;
+    bool stop_;
+};
+
+}  // namespace base
+}  // namespace hybridse
+#endif  // HYBRIDSE_SRC_BASE_WORK_STEALING_POOL_H_
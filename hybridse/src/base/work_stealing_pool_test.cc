@@ -0,0 +1,112 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "base/work_stealing_pool.h"
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <mutex>   // NOLINT
+#include <set>
+#include <vector>
+#include "gtest/gtest.h"
+
+namespace hybridse {
+namespace base {
+
+class WorkStealingPoolTest : public ::testing::Test {};
+
+TEST_F(WorkStealingPoolTest, RunEachTaskOnceTest) {
+    for (size_t thread_num : {1, 2, 4, 16}) {
+        for (size_t task_num : {0, 1, 3, 1000}) {
+            WorkStealingPool pool(thread_num);
+            std::vector<std::atomic<int>> runs(task_num);
+            for (auto& run : runs) {
+                run = 0;
+            }
+            pool.Run(task_num, [&runs](size_t i) { runs[i]++; });
+            for (size_t i = 0; i < task_num; i++) {
+                ASSERT_EQ(1, runs[i]) << "task " << i;
+            }
+        }
+    }
+}
+
+TEST_F(WorkStealingPoolTest, StealSkewedTasksTest) {
+    // the tasks dealt to the first thread are slow, the others steal them
+    WorkStealingPool pool(4);
+    std::vector<std::thread::id> owners(40);
+    pool.Run(owners.size(), [&owners](size_t i) {
+        if (i < 10) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        owners[i] = std::this_thread::get_id();
+    });
+    std::set<std::thread::id> slow_owners(owners.begin(), owners.begin() + 10);
+    ASSERT_LT(1u, slow_owners.size());
+}
+
+TEST_F(WorkStealingPoolTest, ReuseThreadsTest) {
+    // the batches run on the threads started with the pool
+    WorkStealingPool pool(4);
+    std::mutex mu;
+    std::set<std::thread::id> workers;
+    for (int batch = 0; batch < 20; batch++) {
+        std::vector<std::atomic<int>> runs(100);
+        for (auto& run : runs) {
+            run = 0;
+        }
+        pool.Run(runs.size(), [&](size_t i) {
+            runs[i]++;
+            std::lock_guard<std::mutex> lock(mu);
+            workers.insert(std::this_thread::get_id());
+        });
+        for (size_t i = 0; i < runs.size(); i++) {
+            ASSERT_EQ(1, runs[i]) << "batch " << batch << " task " << i;
+        }
+    }
+    ASSERT_GE(4u, workers.size());
+
+    // the batches of concurrent callers do not mix
+    std::vector<std::thread> callers;
+    std::atomic<int> failed(0);
+    for (int c = 0; c < 4; c++) {
+        callers.emplace_back([&pool, &failed]() {
+            for (int batch = 0; batch < 10; batch++) {
+                std::vector<std::atomic<int>> runs(50);
+                for (auto& run : runs) {
+                    run = 0;
+                }
+                pool.Run(runs.size(), [&runs](size_t i) { runs[i]++; });
+                for (auto& run : runs) {
+                    if (run != 1) {
+                        failed++;
+                    }
+                }
+            }
+        });
+    }
+    for (auto& caller : callers) {
+        caller.join();
+    }
+    ASSERT_EQ(0, failed);
+}
+
+}  // namespace base
+}  // namespace hybridse
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
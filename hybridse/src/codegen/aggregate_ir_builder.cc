@@ -20,12 +20,18 @@
 #include <limits>
 #include <map>
 #include <memory>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "codegen/expr_ir_builder.h"
 #include "codegen/ir_base_builder.h"
 #include "codegen/variable_ir_builder.h"
 #include "gflags/gflags.h"
 #include "glog/logging.h"
+
+DECLARE_bool(enable_window_incremental_agg);
+
 namespace hybridse {
 namespace codegen {
 
@@ -589,6 +595,157 @@ base::Status ScheduleAggGenerators(
     return base::Status::OK();
 }
 
+base::Status AggregateIRBuilder::BuildIncrementalFeed(
+    const std::string& fn_name, const std::vector<std::string>& col_keys,
+    ::llvm::Function** output) {
+    ::llvm::LLVMContext& llvm_ctx = module_->getContext();
+    ::llvm::IRBuilder<> builder(llvm_ctx);
+    auto void_ty = ::llvm::Type::getVoidTy(llvm_ctx);
+    auto int8_ty = ::llvm::Type::getInt8Ty(llvm_ctx);
+    auto int32_ty = ::llvm::Type::getInt32Ty(llvm_ctx);
+    auto int64_ty = ::llvm::Type::getInt64Ty(llvm_ctx);
+    auto double_ty = ::llvm::Type::getDoubleTy(llvm_ctx);
+    auto ptr_ty = int8_ty->getPointerTo();
+
+    // void feed(int8_t* row_ptr, int8_t* state)
+    ::llvm::FunctionType* fnt =
+        ::llvm::FunctionType::get(void_ty, {ptr_ty, ptr_ty}, false);
+    ::llvm::Function* fn = ::llvm::Function::Create(
+        fnt, llvm::Function::ExternalLinkage, fn_name, module_);
+    ::llvm::BasicBlock* block = ::llvm::BasicBlock::Create(llvm_ctx, "feed", fn);
+    builder.SetInsertPoint(block);
+    ::llvm::Value* row_ptr = fn->arg_begin();
+    ::llvm::Value* state = fn->arg_begin() + 1;
+
+    auto get_slice_func = module_->getOrInsertFunction(
+        "hybridse_storage_get_row_slice",
+        ::llvm::FunctionType::get(ptr_ty, {ptr_ty, int64_ty}, false));
+    auto get_slice_size_func = module_->getOrInsertFunction(
+        "hybridse_storage_get_row_slice_size",
+        ::llvm::FunctionType::get(int64_ty, {ptr_ty, int64_ty}, false));
+    auto add_int64_func = module_->getOrInsertFunction(
+        "hybridse_window_incremental_agg_add_int64",
+        ::llvm::FunctionType::get(
+            void_ty, {ptr_ty, int32_ty, int64_ty, int8_ty}, false));
+    auto add_double_func = module_->getOrInsertFunction(
+        "hybridse_window_incremental_agg_add_double",
+        ::llvm::FunctionType::get(
+            void_ty, {ptr_ty, int32_ty, double_ty, int8_ty}, false));
+
+    std::unordered_map<size_t, std::pair<::llvm::Value*, ::llvm::Value*>>
+        used_slices;
+    for (size_t i = 0; i < col_keys.size(); ++i) {
+        auto& info = agg_col_infos_[col_keys[i]];
+        size_t slice_idx = info.schema_idx;
+        if (schema_context_->GetRowFormat() != nullptr) {
+            slice_idx =
+                schema_context_->GetRowFormat()->GetSliceId(info.schema_idx);
+        }
+        auto iter = used_slices.find(slice_idx);
+        if (iter == used_slices.end()) {
+            ::llvm::Value* idx_value =
+                llvm::ConstantInt::get(int64_ty, slice_idx, true);
+            ::llvm::Value* buf_ptr =
+                builder.CreateCall(get_slice_func, {row_ptr, idx_value});
+            ::llvm::Value* buf_size =
+                builder.CreateCall(get_slice_size_func, {row_ptr, idx_value});
+            iter = used_slices.insert({slice_idx, {buf_ptr, buf_size}}).first;
+        }
+
+        ScopeVar dummy_scope_var;
+        BufNativeIRBuilder buf_builder(info.schema_idx,
+                                       schema_context_->GetRowFormat(), block,
+                                       &dummy_scope_var);
+        NativeValue field_value;
+        CHECK_TRUE(buf_builder.BuildGetField(info.col_idx, iter->second.first,
+                                             iter->second.second, &field_value),
+                   common::kCodegenGetFieldError, "fail to gen fetch column")
+        ::llvm::Value* value = field_value.GetValue(&builder);
+        ::llvm::Value* is_null =
+            builder.CreateZExt(field_value.GetIsNull(&builder), int8_ty);
+        ::llvm::Value* col = builder.getInt32(i);
+        if (value->getType()->isIntegerTy()) {
+            builder.CreateCall(
+                add_int64_func,
+                {state, col, builder.CreateSExt(value, int64_ty), is_null});
+        } else {
+            builder.CreateCall(
+                add_double_func,
+                {state, col, builder.CreateFPCast(value, double_ty), is_null});
+        }
+    }
+    builder.CreateRetVoid();
+    *output = fn;
+    return base::Status::OK();
+}
+
+base::Status AggregateIRBuilder::BuildIncrementalOutputs(
+    ::llvm::BasicBlock* block, ::llvm::Value* state, ::llvm::Value* output_buf,
+    const std::vector<std::string>& col_keys, const vm::Schema& output_schema) {
+    ::llvm::LLVMContext& llvm_ctx = module_->getContext();
+    ::llvm::IRBuilder<> builder(block);
+    auto int32_ty = ::llvm::Type::getInt32Ty(llvm_ctx);
+    auto int64_ty = ::llvm::Type::getInt64Ty(llvm_ctx);
+    auto double_ty = ::llvm::Type::getDoubleTy(llvm_ctx);
+    auto ptr_ty = ::llvm::Type::getInt8Ty(llvm_ctx)->getPointerTo();
+    auto getter = [&](const std::string& name, ::llvm::Type* ret_ty) {
+        return module_->getOrInsertFunction(
+            "hybridse_window_incremental_agg_" + name,
+            ::llvm::FunctionType::get(ret_ty, {ptr_ty, int32_ty}, false));
+    };
+
+    std::map<uint32_t, NativeValue> dummy_map;
+    BufNativeEncoderIRBuilder output_encoder(&dummy_map, &output_schema, block);
+    for (size_t i = 0; i < col_keys.size(); ++i) {
+        auto& info = agg_col_infos_[col_keys[i]];
+        ::llvm::Type* col_ty =
+            GetOutputLlvmType(llvm_ctx, "sum", info.col_type);
+        CHECK_TRUE(col_ty != nullptr, common::kCodegenUdafError,
+                   "Unknown agg column type of ", col_keys[i])
+        bool is_int = col_ty->isIntegerTy();
+        ::llvm::Type* lane_ty = is_int ? int64_ty : double_ty;
+        std::string lane_name = is_int ? "_int64" : "_double";
+        ::llvm::Value* col = builder.getInt32(i);
+        ::llvm::Value* cnt =
+            builder.CreateCall(getter("count", int64_ty), {state, col});
+        ::llvm::Value* is_empty = builder.CreateICmpEQ(cnt, builder.getInt64(0));
+        auto to_col_ty = [&](::llvm::Value* value) {
+            return is_int ? builder.CreateTrunc(value, col_ty)
+                          : builder.CreateFPCast(value, col_ty);
+        };
+        for (size_t j = 0; j < info.GetOutputNum(); j++) {
+            auto& fname = info.agg_funcs[j];
+            NativeValue output;
+            if (fname == "count") {
+                output = NativeValue::Create(cnt);
+            } else if (fname == "sum") {
+                output = NativeValue::Create(to_col_ty(builder.CreateCall(
+                    getter("sum" + lane_name, lane_ty), {state, col})));
+            } else if (fname == "avg") {
+                ::llvm::Value* sum = builder.CreateCall(
+                    getter("sum" + lane_name, lane_ty), {state, col});
+                if (is_int) {
+                    sum = builder.CreateSIToFP(sum, double_ty);
+                }
+                output = NativeValue::Create(builder.CreateFDiv(
+                    sum, builder.CreateSIToFP(cnt, double_ty)));
+            } else if (fname == "min" || fname == "max") {
+                output = NativeValue::CreateWithFlag(
+                    to_col_ty(builder.CreateCall(
+                        getter(fname + lane_name, lane_ty), {state, col})),
+                    is_empty);
+            } else {
+                FAIL_STATUS(common::kCodegenUdafError,
+                            "Unknown agg function name: ", fname)
+            }
+            CHECK_STATUS(output_encoder.BuildEncodePrimaryField(
+                output_buf, info.output_idxs[j], output))
+        }
+    }
+    builder.CreateRetVoid();
+    return base::Status::OK();
+}
+
 base::Status AggregateIRBuilder::BuildMulti(const std::string& base_funcname,
                                     ExprIRBuilder* expr_ir_builder,
                                     VariableIRBuilder* variable_ir_builder,
@@ -649,6 +806,37 @@ base::Status AggregateIRBuilder::BuildMulti(const std::string& base_funcname,
     ::llvm::Value* iter_ptr = CreateAllocaAtHead(
         &builder, ::llvm::Type::getInt8Ty(llvm_ctx), "row_iter",
         ::llvm::ConstantInt::get(int64_ty, iter_bytes, true));
+
+    // update the aggregations incrementally if the window keeps the state,
+    // otherwise scan the whole window
+    if (FLAGS_enable_window_incremental_agg) {
+        std::vector<std::string> col_keys;
+        for (auto& pair : agg_col_infos_) {
+            col_keys.emplace_back(pair.first);
+        }
+        std::sort(col_keys.begin(), col_keys.end());
+        ::llvm::Function* feed_fn = nullptr;
+        CHECK_STATUS(BuildIncrementalFeed(fn_name + "_feed", col_keys, &feed_fn))
+        auto int32_ty = ::llvm::Type::getInt32Ty(llvm_ctx);
+        auto state_func = module_->getOrInsertFunction(
+            "hybridse_window_incremental_agg_state",
+            ::llvm::FunctionType::get(
+                ptr_ty, {ptr_ty, int32_ty, int32_ty, ptr_ty}, false));
+        ::llvm::Value* state = builder.CreateCall(
+            state_func, {input_arg, builder.getInt32(id_),
+                         builder.getInt32(col_keys.size()),
+                         builder.CreatePointerCast(feed_fn, ptr_ty)});
+        ::llvm::BasicBlock* incremental_block =
+            ::llvm::BasicBlock::Create(llvm_ctx, "incremental_agg", fn);
+        ::llvm::BasicBlock* scan_block =
+            ::llvm::BasicBlock::Create(llvm_ctx, "scan", fn);
+        builder.CreateCondBr(builder.CreateIsNull(state), scan_block,
+                             incremental_block);
+        CHECK_STATUS(BuildIncrementalOutputs(incremental_block, state,
+                                             output_arg, col_keys,
+                                             output_schema))
+        builder.SetInsertPoint(scan_block);
+    }
     auto get_iter_func = module_->getOrInsertFunction(
         "hybridse_storage_get_row_iter", void_ty, ptr_ty, ptr_ty);
     builder.CreateCall(get_iter_func, {input_arg, iter_ptr});
@@ -104,6 +104,15 @@ class AggregateIRBuilder {
     bool empty() const { return agg_col_infos_.empty(); }
 
  private:
+    base::Status BuildIncrementalFeed(const std::string& fn_name,
+                                      const std::vector<std::string>& col_keys,
+                                      ::llvm::Function** output);
+
+    base::Status BuildIncrementalOutputs(
+        ::llvm::BasicBlock* block, ::llvm::Value* state,
+        ::llvm::Value* output_buf, const std::vector<std::string>& col_keys,
+        const vm::Schema& output_schema);
+
     const vm::SchemasContext* schema_context_;
     ::llvm::Module* module_;
     const node::FrameNode* frame_node_;
@@ -21,6 +21,7 @@
 #include "codegen/ir_base_builder.h"
 #include "codegen/variable_ir_builder.h"
 #include "glog/logging.h"
+#include "vm/jit_wrapper.h"
 #include "vm/transform.h"
 
 using ::hybridse::common::kCodegenError;
@@ -155,6 +156,83 @@ Status RowFnLetIRBuilder::Build(
     return Status::OK();
 }
 
+Status RowFnLetIRBuilder::BuildBatch(const std::string& name,
+                                     const std::string& row_fn_name) {
+    ::llvm::Module* module = ctx_->GetModule();
+    ::llvm::LLVMContext& llvm_ctx = module->getContext();
+    CHECK_TRUE(module->getFunction(name) == NULL, kCodegenError, "function ",
+               name, " already exists");
+    ::llvm::Function* row_fn = module->getFunction(row_fn_name);
+    CHECK_TRUE(row_fn != nullptr, kCodegenError, "Fail to find row function ",
+               row_fn_name);
+
+    auto int64_ty = ::llvm::Type::getInt64Ty(llvm_ctx);
+    auto ptr_ty = ::llvm::Type::getInt8PtrTy(llvm_ctx);
+    auto ptr_ptr_ty = ptr_ty->getPointerTo();
+    ::llvm::Function* fn = nullptr;
+    bool ok = BuildFnHeader(
+        name,
+        {int64_ty, int64_ty->getPointerTo(), ptr_ptr_ty, ptr_ptr_ty, ptr_ty,
+         ptr_ptr_ty},
+        ::llvm::Type::getInt32Ty(llvm_ctx), &fn);
+    CHECK_TRUE(ok && fn != nullptr, kCodegenError,
+               "Fail to build fn header for name ", name);
+    // the row function is inlined into the loop, so that the decoding of the
+    // parameter row and other loop invariants are hoisted out of it
+    row_fn->addFnAttr(::llvm::Attribute::AlwaysInline);
+    fn->addFnAttr(vm::BATCH_FN_ATTR);
+
+    auto arg = fn->arg_begin();
+    ::llvm::Value* cnt = &*arg++;
+    ::llvm::Value* keys = &*arg++;
+    ::llvm::Value* rows = &*arg++;
+    ::llvm::Value* windows = &*arg++;
+    ::llvm::Value* parameter = &*arg++;
+    ::llvm::Value* outputs = &*arg++;
+
+    ::llvm::BasicBlock* entry_block =
+        ::llvm::BasicBlock::Create(llvm_ctx, "entry", fn);
+    ::llvm::BasicBlock* cond_block =
+        ::llvm::BasicBlock::Create(llvm_ctx, "batch_cond", fn);
+    ::llvm::BasicBlock* body_block =
+        ::llvm::BasicBlock::Create(llvm_ctx, "batch_body", fn);
+    ::llvm::BasicBlock* fail_block =
+        ::llvm::BasicBlock::Create(llvm_ctx, "batch_fail", fn);
+    ::llvm::BasicBlock* exit_block =
+        ::llvm::BasicBlock::Create(llvm_ctx, "batch_exit", fn);
+
+    ::llvm::IRBuilder<> builder(entry_block);
+    builder.CreateBr(cond_block);
+
+    builder.SetInsertPoint(cond_block);
+    ::llvm::PHINode* idx = builder.CreatePHI(int64_ty, 2, "idx");
+    idx->addIncoming(builder.getInt64(0), entry_block);
+    builder.CreateCondBr(builder.CreateICmpSLT(idx, cnt), body_block,
+                         exit_block);
+
+    builder.SetInsertPoint(body_block);
+    ::llvm::Value* key = builder.CreateLoad(
+        int64_ty, builder.CreateInBoundsGEP(int64_ty, keys, idx));
+    ::llvm::Value* row = builder.CreateLoad(
+        ptr_ty, builder.CreateInBoundsGEP(ptr_ty, rows, idx));
+    ::llvm::Value* window = builder.CreateLoad(
+        ptr_ty, builder.CreateInBoundsGEP(ptr_ty, windows, idx));
+    ::llvm::Value* output = builder.CreateInBoundsGEP(ptr_ty, outputs, idx);
+    ::llvm::Value* ret =
+        builder.CreateCall(row_fn, {key, row, window, parameter, output});
+    idx->addIncoming(builder.CreateAdd(idx, builder.getInt64(1)), body_block);
+    builder.CreateCondBr(builder.CreateICmpEQ(ret, builder.getInt32(0)),
+                         cond_block, fail_block);
+
+    // stop at the first row which fails
+    builder.SetInsertPoint(fail_block);
+    builder.CreateRet(ret);
+
+    builder.SetInsertPoint(exit_block);
+    builder.CreateRet(builder.getInt32(0));
+    return Status::OK();
+}
+
 base::Status RowFnLetIRBuilder::EncodeBuf(
     const std::map<uint32_t, NativeValue>* values, const vm::Schema& schema,
     VariableIRBuilder& variable_ir_builder,  // NOLINT (runtime/references)
@@ -45,6 +45,12 @@ class RowFnLetIRBuilder {
                  const std::vector<const node::FrameNode*>& project_frames,
                  const vm::Schema& output_schema);
 
+    // Build the function `name` which runs the row function `row_fn_name`
+    // over a batch of rows:
+    // int32_t name(int64_t cnt, int64_t* keys, int8_t** rows,
+    //              int8_t** windows, int8_t* parameter, int8_t** outputs)
+    Status BuildBatch(const std::string& name, const std::string& row_fn_name);
+
  private:
     bool BuildFnHeader(const std::string& name,
                        const std::vector<::llvm::Type*>& args_type,
@@ -22,3 +22,9 @@ DEFINE_string(default_db_name, "_hybridse",
 // Offline Spark config
 DEFINE_bool(enable_spark_unsaferow_format, false,
             "config if codec uses Spark UnsafeRow format");
+
+// Window aggregation config
+DEFINE_bool(enable_window_incremental_agg, false,
+            "config if sum/count/avg/min/max over a window are updated by "
+            "the rows entering and leaving the window instead of rescanning "
+            "the whole window for every row");
@@ -15,9 +15,45 @@
  */
 
 #include "vm/catalog_wrapper.h"
+
+#include "glog/logging.h"
+
 namespace hybridse {
 namespace vm {
 
+RowIterator* NewFilterIterator(std::unique_ptr<RowIterator> iter,
+                               const Row& parameter, const PredicateFun* fun) {
+    if (fun->IsBatchSupported()) {
+        return new IteratorBatchFilterWrapper(std::move(iter), parameter, fun);
+    }
+    return new IteratorFilterWrapper(std::move(iter), parameter, fun);
+}
+
+void IteratorBatchFilterWrapper::NextBatch() {
+    keys_.clear();
+    rows_.clear();
+    pos_ = 0;
+    while (rows_.empty() && iter_->Valid()) {
+        batch_keys_.clear();
+        batch_rows_.clear();
+        while (iter_->Valid() && batch_rows_.size() < kVectorizedBatchSize) {
+            batch_keys_.push_back(iter_->GetKey());
+            batch_rows_.push_back(iter_->GetValue());
+            iter_->Next();
+        }
+        if (!predicate_->Batch(batch_rows_, parameter_, &results_)) {
+            LOG(WARNING) << "fail to filter a batch of rows";
+            return;
+        }
+        for (size_t i = 0; i < batch_rows_.size(); i++) {
+            if (results_[i]) {
+                keys_.push_back(batch_keys_[i]);
+                rows_.push_back(batch_rows_[i]);
+            }
+        }
+    }
+}
+
 std::shared_ptr<TableHandler> PartitionProjectWrapper::GetSegment(
     const std::string& key) {
     auto segment = partition_handler_->GetSegment(key);
@@ -52,7 +88,7 @@ base::ConstIterator<uint64_t, Row>* PartitionFilterWrapper::GetRawIterator() {
     if (!iter) {
         return nullptr;
     } else {
-        return new IteratorFilterWrapper(std::move(iter), parameter_, fun_);
+        return NewFilterIterator(std::move(iter), parameter_, fun_);
     }
 }
 std::shared_ptr<PartitionHandler> TableProjectWrapper::GetPartition(
@@ -19,10 +19,14 @@
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 #include "vm/catalog.h"
 namespace hybridse {
 namespace vm {
 
+// the number of rows a batch function runs at once
+static const size_t kVectorizedBatchSize = 1024;
+
 class ProjectFun {
  public:
     virtual Row operator()(const Row& row, const Row& parameter) const = 0;
@@ -30,7 +34,19 @@ class ProjectFun {
 class PredicateFun {
  public:
     virtual bool operator()(const Row& row, const Row& parameter) const = 0;
+    // return true if the predicate can check a batch of rows at once
+    virtual bool IsBatchSupported() const { return false; }
+    // check a batch of rows, results[i] is the result of rows[i]
+    virtual bool Batch(const std::vector<Row>& rows, const Row& parameter,
+                       std::vector<bool>* results) const {
+        return false;
+    }
 };
+
+// Create the iterator of the rows of iter which pass the predicate, the
+// rows are checked a batch at a time if the predicate supports it
+RowIterator* NewFilterIterator(std::unique_ptr<RowIterator> iter,
+                               const Row& parameter, const PredicateFun* fun);
 class IteratorProjectWrapper : public RowIterator {
  public:
     IteratorProjectWrapper(std::unique_ptr<RowIterator> iter,
@@ -89,6 +105,50 @@ class IteratorFilterWrapper : public RowIterator {
     const PredicateFun* predicate_;
 };
 
+class IteratorBatchFilterWrapper : public RowIterator {
+ public:
+    IteratorBatchFilterWrapper(std::unique_ptr<RowIterator> iter,
+                               const Row& parameter,
+                               const PredicateFun* fun)
+        : RowIterator(), iter_(std::move(iter)), parameter_(parameter), predicate_(fun), pos_(0) {}
+    virtual ~IteratorBatchFilterWrapper() {}
+    bool Valid() const override { return pos_ < rows_.size(); }
+    void Next() override {
+        pos_++;
+        if (pos_ >= rows_.size()) {
+            NextBatch();
+        }
+    }
+    const uint64_t& GetKey() const override { return keys_[pos_]; }
+    const Row& GetValue() override { return rows_[pos_]; }
+    void Seek(const uint64_t& k) override {
+        iter_->Seek(k);
+        NextBatch();
+    }
+    void SeekToFirst() override {
+        iter_->SeekToFirst();
+        NextBatch();
+    }
+    bool IsSeekable() const override { return iter_->IsSeekable(); }
+
+ private:
+    // read batches of rows from iter until some of them pass the predicate
+    // or iter ends
+    void NextBatch();
+
+    std::unique_ptr<RowIterator> iter_;
+    const Row& parameter_;
+    const PredicateFun* predicate_;
+    // rows of the current batch which pass the predicate
+    std::vector<uint64_t> keys_;
+    std::vector<Row> rows_;
+    size_t pos_;
+    // rows read from iter and their results
+    std::vector<uint64_t> batch_keys_;
+    std::vector<Row> batch_rows_;
+    std::vector<bool> results_;
+};
+
 class WindowIteratorProjectWrapper : public WindowIterator {
  public:
     WindowIteratorProjectWrapper(std::unique_ptr<WindowIterator> iter,
@@ -136,7 +196,7 @@ class WindowIteratorFilterWrapper : public WindowIterator {
             return std::unique_ptr<RowIterator>();
         } else {
             return std::unique_ptr<RowIterator>(
-                new IteratorFilterWrapper(std::move(iter), parameter_, fun_));
+                NewFilterIterator(std::move(iter), parameter_, fun_));
         }
     }
     RowIterator* GetRawValue() override {
@@ -144,7 +204,7 @@ class WindowIteratorFilterWrapper : public WindowIterator {
         if (!iter) {
             return nullptr;
         } else {
-            return new IteratorFilterWrapper(std::move(iter), parameter_, fun_);
+            return NewFilterIterator(std::move(iter), parameter_, fun_);
         }
     }
     void Seek(const std::string& key) override { iter_->Seek(key); }
@@ -262,7 +322,7 @@ class PartitionFilterWrapper : public PartitionHandler {
             return std::unique_ptr<base::ConstIterator<uint64_t, Row>>();
         } else {
             return std::unique_ptr<RowIterator>(
-                new IteratorFilterWrapper(std::move(iter), parameter_, fun_));
+                NewFilterIterator(std::move(iter), parameter_, fun_));
         }
     }
     base::ConstIterator<uint64_t, Row>* GetRawIterator() override;
@@ -349,7 +409,7 @@ class TableFilterWrapper : public TableHandler {
             return std::unique_ptr<RowIterator>();
         } else {
             return std::unique_ptr<RowIterator>(
-                new IteratorFilterWrapper(std::move(iter), parameter_, fun_));
+                NewFilterIterator(std::move(iter), parameter_, fun_));
         }
     }
     const Types& GetTypes() override { return table_hander_->GetTypes(); }
@@ -370,7 +430,7 @@ class TableFilterWrapper : public TableHandler {
         return table_hander_->GetDatabase();
     }
     base::ConstIterator<uint64_t, Row>* GetRawIterator() override {
-        return new IteratorFilterWrapper(
+        return NewFilterIterator(
             static_cast<std::unique_ptr<RowIterator>>(
                 table_hander_->GetRawIterator()),
             parameter_,
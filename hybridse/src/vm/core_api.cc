@@ -17,6 +17,7 @@
 #include "vm/core_api.h"
 #include "base/sig_trace.h"
 #include "codec/fe_row_codec.h"
+#include "gflags/gflags.h"
 #include "udf/default_udf_library.h"
 #include "udf/udf.h"
 #include "vm/jit_runtime.h"
@@ -25,6 +26,8 @@
 #include "vm/runner.h"
 #include "vm/schemas_context.h"
 
+DECLARE_bool(enable_window_incremental_agg);
+
 namespace hybridse {
 namespace vm {
 
@@ -38,6 +41,9 @@ WindowInterface::WindowInterface(bool instance_not_in_window,
                       end_offset, rows_preceding, max_size)))) {
     window_impl_->set_instance_not_in_window(instance_not_in_window);
     window_impl_->set_exclude_current_time(exclude_current_time);
+    window_impl_->set_enable_incremental_agg(
+        FLAGS_enable_window_incremental_agg && !instance_not_in_window &&
+        !exclude_current_time);
 }
 
 bool WindowInterface::BufferData(uint64_t key, const Row& row) {
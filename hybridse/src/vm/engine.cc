@@ -19,6 +19,7 @@
 #include <utility>
 #include <vector>
 #include "base/fe_strings.h"
+#include "base/work_stealing_pool.h"
 #include "boost/none.hpp"
 #include "boost/optional.hpp"
 #include "codec/fe_row_codec.h"
@@ -49,7 +50,10 @@ EngineOptions::EngineOptions()
       batch_request_optimized_(true),
       enable_expr_optimize_(true),
       enable_batch_window_parallelization_(false),
+      batch_window_agg_thread_num_(1),
+      enable_batch_vectorized_(false),
       enable_window_column_pruning_(false),
+      tiered_compile_threshold_(0),
       max_sql_cache_size_(50),
       enable_spark_unsaferow_format_(false) {
     // TODO(chendihao): Pass the parameter to avoid global gflag
@@ -62,10 +66,32 @@ EngineOptions* EngineOptions::SetEnableSparkUnsaferowFormat(bool flag) {
     return this;
 }
 
-Engine::Engine(const std::shared_ptr<Catalog>& catalog) : cl_(catalog), options_(), mu_(), lru_cache_() {}
+EngineOptions* EngineOptions::SetBatchWindowAggThreadNum(uint32_t thread_num) {
+    batch_window_agg_thread_num_ = thread_num;
+    return this;
+}
+
+Engine::Engine(const std::shared_ptr<Catalog>& catalog)
+    : cl_(catalog), options_(), mu_(), lru_cache_(), tiered_stop_(false) {}
 Engine::Engine(const std::shared_ptr<Catalog>& catalog, const EngineOptions& options)
-    : cl_(catalog), options_(options), mu_(), lru_cache_() {}
-Engine::~Engine() {}
+    : cl_(catalog), options_(options), mu_(), lru_cache_(), tiered_stop_(false) {
+    if (options_.GetTieredCompileThreshold() > 0) {
+        tiered_thread_ = std::thread(&Engine::OptimizedCompileLoop, this);
+    }
+    if (options_.GetBatchWindowAggThreadNum() > 1) {
+        window_agg_pool_ = std::make_shared<base::WorkStealingPool>(options_.GetBatchWindowAggThreadNum());
+    }
+}
+Engine::~Engine() {
+    if (tiered_thread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(tiered_mu_);
+            tiered_stop_ = true;
+        }
+        tiered_cv_.notify_all();
+        tiered_thread_.join();
+    }
+}
 void Engine::InitializeGlobalLLVM() {
     if (LLVM_IS_INITIALIZED) return;
     LLVMInitializeNativeTarget();
@@ -209,8 +235,12 @@ bool Engine::IsCompatibleCache(RunSession& session,  // NOLINT
 
 bool Engine::Get(const std::string& sql, const std::string& db, RunSession& session,
                  base::Status& status) {  // NOLINT (runtime/references)
+    session.window_agg_pool_ = window_agg_pool_;
     std::shared_ptr<CompileInfo> cached_info = GetCacheLocked(db, sql, session.engine_mode());
     if (cached_info && IsCompatibleCache(session, cached_info, status)) {
+        if (options_.GetTieredCompileThreshold() > 0) {
+            cached_info = GetTieredInfo(cached_info);
+        }
         session.SetCompileInfo(cached_info);
         return true;
     }
@@ -230,8 +260,13 @@ bool Engine::Get(const std::string& sql, const std::string& db, RunSession& sess
     sql_context.is_batch_request_optimized = options_.IsBatchRequestOptimized();
     sql_context.enable_batch_window_parallelization = options_.IsEnableBatchWindowParallelization();
     sql_context.enable_window_column_pruning = options_.IsEnableWindowColumnPruning();
+    sql_context.enable_batch_vectorized = options_.IsEnableBatchVectorized();
     sql_context.enable_expr_optimize = options_.IsEnableExprOptimize();
     sql_context.jit_options = options_.jit_options();
+    if (options_.GetTieredCompileThreshold() > 0 && session.engine_mode() == kBatchMode) {
+        // compile fast at first, the hot sql is optimized in background
+        sql_context.jit_options.SetOptLevel(0);
+    }
     sql_context.options = session.GetOptions();
     if (session.engine_mode() == kBatchMode) {
         sql_context.parameter_types = dynamic_cast<BatchRunSession*>(&session)->GetParameterSchema();
@@ -269,6 +304,86 @@ bool Engine::Get(const std::string& sql, const std::string& db, RunSession& sess
     return true;
 }
 
+std::shared_ptr<CompileInfo> Engine::GetTieredInfo(const std::shared_ptr<CompileInfo>& info) {
+    auto sql_info = std::dynamic_pointer_cast<SqlCompileInfo>(info);
+    if (!sql_info || sql_info->get_sql_context().jit_options.GetOptLevel() != 0) {
+        return info;
+    }
+    // schedule it only once, when the hits reach the threshold
+    if (sql_info->IncHitCount() == options_.GetTieredCompileThreshold()) {
+        {
+            std::lock_guard<std::mutex> lock(tiered_mu_);
+            tiered_queue_.push_back(info);
+        }
+        tiered_cv_.notify_one();
+    }
+    return info;
+}
+
+void Engine::OptimizedCompileLoop() {
+    while (true) {
+        std::shared_ptr<SqlCompileInfo> info;
+        {
+            std::unique_lock<std::mutex> lock(tiered_mu_);
+            tiered_cv_.wait(lock, [this] { return tiered_stop_ || !tiered_queue_.empty(); });
+            if (tiered_stop_) {
+                return;
+            }
+            info = std::dynamic_pointer_cast<SqlCompileInfo>(tiered_queue_.front());
+            tiered_queue_.pop_front();
+        }
+        auto& cold_context = info->get_sql_context();
+        auto optimized = std::make_shared<SqlCompileInfo>();
+        auto& sql_context = optimized->get_sql_context();
+        sql_context.sql = cold_context.sql;
+        sql_context.db = cold_context.db;
+        sql_context.engine_mode = cold_context.engine_mode;
+        sql_context.is_cluster_optimized = cold_context.is_cluster_optimized;
+        sql_context.is_batch_request_optimized = cold_context.is_batch_request_optimized;
+        sql_context.enable_batch_window_parallelization = cold_context.enable_batch_window_parallelization;
+        sql_context.enable_window_column_pruning = cold_context.enable_window_column_pruning;
+        sql_context.enable_batch_vectorized = cold_context.enable_batch_vectorized;
+        sql_context.enable_expr_optimize = cold_context.enable_expr_optimize;
+        sql_context.jit_options = cold_context.jit_options;
+        sql_context.jit_options.SetOptLevel(3);
+        sql_context.options = cold_context.options;
+        sql_context.parameter_types = cold_context.parameter_types;
+
+        base::Status status;
+        SqlCompiler compiler(std::atomic_load_explicit(&cl_, std::memory_order_acquire), options_.IsKeepIr(), false,
+                             options_.IsPlanOnly());
+        bool ok = compiler.Compile(sql_context, status) && status.isOK();
+        if (ok && !options_.IsCompileOnly()) {
+            ok = compiler.BuildClusterJob(sql_context, status) && status.isOK();
+        }
+        if (ok) {
+            // the optimized info takes the place of the cold one in the cache, so
+            // that later gets hand it out and it is evicted on its own use
+            if (ReplaceCacheLocked(sql_context.db, sql_context.sql, sql_context.engine_mode, info, optimized)) {
+                DLOG(INFO) << "compile hot sql with optimizations done: " << sql_context.sql;
+            } else {
+                DLOG(INFO) << "drop optimized info of evicted sql: " << sql_context.sql;
+            }
+        } else {
+            // the sql keeps running the code compiled without optimizations
+            LOG(WARNING) << "fail to compile hot sql with optimizations: " << status << "\n" << sql_context.sql;
+        }
+        std::function<void(const std::string&, bool)> hook;
+        {
+            std::lock_guard<std::mutex> lock(tiered_mu_);
+            hook = tiered_hook_;
+        }
+        if (hook) {
+            hook(sql_context.sql, ok);
+        }
+    }
+}
+
+void Engine::SetTieredCompileHook(const std::function<void(const std::string& sql, bool ok)>& hook) {
+    std::lock_guard<std::mutex> lock(tiered_mu_);
+    tiered_hook_ = hook;
+}
+
 base::Status Engine::RegisterExternalFunction(const std::string& name, node::DataType return_type,
                                          const std::vector<node::DataType>& arg_types, bool is_aggregate,
                                          const std::vector<void*>& funcs) {
@@ -417,7 +532,7 @@ std::shared_ptr<CompileInfo> Engine::GetCacheLocked(const std::string& db, const
     if (value == boost::none) {
         return nullptr;
     } else {
-        return value.value();
+        return value.value()->info;
     }
 }
 
@@ -426,7 +541,7 @@ bool Engine::SetCacheLocked(const std::string& db, const std::string& sql, Engin
     std::lock_guard<base::SpinMutex> lock(mu_);
 
     auto& mode_cache = lru_cache_[engine_mode];
-    using BoostLRU = boost::compute::detail::lru_cache<std::string, std::shared_ptr<CompileInfo>>;
+    using BoostLRU = boost::compute::detail::lru_cache<std::string, std::shared_ptr<CompileInfoSlot>>;
     std::map<std::string, BoostLRU>::iterator db_iter = mode_cache.find(db);
     if (db_iter == mode_cache.end()) {
         db_iter = mode_cache.insert(db_iter, {db, BoostLRU(options_.GetMaxSqlCacheSize())});
@@ -434,7 +549,7 @@ bool Engine::SetCacheLocked(const std::string& db, const std::string& sql, Engin
     auto& lru = db_iter->second;
     auto value = lru.get(sql);
     if (value == boost::none || engine_mode == kBatchRequestMode) {
-        lru.insert(sql, info);
+        lru.insert(sql, std::make_shared<CompileInfoSlot>(CompileInfoSlot{info}));
         return true;
     } else {
         // TODO(xxx): Ensure compile result is stable
@@ -443,6 +558,29 @@ bool Engine::SetCacheLocked(const std::string& db, const std::string& sql, Engin
     }
 }
 
+bool Engine::ReplaceCacheLocked(const std::string& db, const std::string& sql, EngineMode engine_mode,
+                                const std::shared_ptr<CompileInfo>& old_info,
+                                const std::shared_ptr<CompileInfo>& info) {
+    std::lock_guard<base::SpinMutex> lock(mu_);
+    auto mode_iter = lru_cache_.find(engine_mode);
+    if (mode_iter == lru_cache_.end()) {
+        return false;
+    }
+    auto& mode_cache = mode_iter->second;
+    auto db_iter = mode_cache.find(db);
+    if (db_iter == mode_cache.end()) {
+        return false;
+    }
+    auto& lru = db_iter->second;
+    auto value = lru.get(sql);
+    // the sql is evicted or the cache is cleared since, the info may be stale
+    if (value == boost::none || value.value()->info != old_info) {
+        return false;
+    }
+    value.value()->info = info;
+    return true;
+}
+
 RunSession::RunSession(EngineMode engine_mode) : engine_mode_(engine_mode), is_debug_(false), sp_name_("") {}
 RunSession::~RunSession() {}
 
@@ -512,6 +650,7 @@ int32_t BatchRunSession::Run(std::vector<Row>& rows, uint64_t limit) {
 int32_t BatchRunSession::Run(const Row& parameter_row, std::vector<Row>& rows, uint64_t limit) {
     auto& sql_ctx = std::dynamic_pointer_cast<SqlCompileInfo>(compile_info_)->get_sql_context();
     RunnerContext ctx(&sql_ctx.cluster_job, parameter_row, is_debug_);
+    ctx.set_window_agg_pool(window_agg_pool_.get());
     auto output = sql_ctx.cluster_job.GetTask(0).GetRoot()->RunWithCache(ctx);
     if (!output) {
         DLOG(INFO) << "Run batch plan output is empty";
@@ -14,11 +14,16 @@
  * limitations under the License.
  */
 
+#include <chrono>  // NOLINT
+#include <condition_variable>  // NOLINT
+#include <mutex>  // NOLINT
+#include <vector>
 #include "case/case_data_mock.h"
 #include "gtest/gtest.h"
 #include "gtest/internal/gtest-param-util.h"
 #include "testing/engine_test_base.h"
 #include "udf/openmldb_udf.h"
+#include "vm/sql_compiler.h"
 
 using namespace llvm;       // NOLINT (build/namespaces)
 using namespace llvm::orc;  // NOLINT (build/namespaces)
@@ -83,6 +88,72 @@ TEST_F(EngineCompileTest, EngineLRUCacheTest) {
     }
 }
 
+TEST_F(EngineCompileTest, EngineTieredCompileTest) {
+    auto catalog = BuildSimpleCatalog();
+    hybridse::type::Database db;
+    db.set_name("simple_db");
+    hybridse::type::TableDef table_def;
+    sqlcase::CaseSchemaMock::BuildTableDef(table_def);
+    table_def.set_name("t1");
+    AddTable(db, table_def);
+    catalog->AddDatabase(db);
+
+    // the hook outlives the engine and its background thread
+    std::mutex mu;
+    std::condition_variable cv;
+    std::vector<bool> compiled;
+    EngineOptions options;
+    options.SetTieredCompileThreshold(2);
+    Engine engine(catalog, options);
+    engine.SetTieredCompileHook([&](const std::string& sql, bool ok) {
+        std::lock_guard<std::mutex> lock(mu);
+        compiled.push_back(ok);
+        cv.notify_all();
+    });
+    std::string sql = "select col1 + 1 as c1, col2 * 2 as c2 from t1 where col1 > 0;";
+    base::Status get_status;
+    BatchRunSession session1;
+    ASSERT_TRUE(engine.Get(sql, "simple_db", session1, get_status)) << get_status;
+    auto cold_info = std::dynamic_pointer_cast<SqlCompileInfo>(session1.GetCompileInfo());
+    ASSERT_EQ(0u, cold_info->get_sql_context().jit_options.GetOptLevel());
+
+    // the second hit schedules the background compile
+    for (int i = 0; i < 2; i++) {
+        BatchRunSession session;
+        ASSERT_TRUE(engine.Get(sql, "simple_db", session, get_status)) << get_status;
+        ASSERT_EQ(cold_info.get(), session.GetCompileInfo().get());
+    }
+    {
+        std::unique_lock<std::mutex> lock(mu);
+        ASSERT_TRUE(cv.wait_for(lock, std::chrono::seconds(60), [&] { return !compiled.empty(); }));
+        ASSERT_TRUE(compiled[0]);
+    }
+    // the optimized info replaces the cold one in the cache
+    BatchRunSession hot_session;
+    ASSERT_TRUE(engine.Get(sql, "simple_db", hot_session, get_status)) << get_status;
+    auto hot_info = std::dynamic_pointer_cast<SqlCompileInfo>(hot_session.GetCompileInfo());
+    ASSERT_TRUE(hot_info != nullptr);
+    auto& hot_context = hot_info->get_sql_context();
+    ASSERT_EQ(3u, hot_context.jit_options.GetOptLevel());
+    ASSERT_EQ(sql, hot_context.sql);
+    ASSERT_TRUE(hot_context.jit != nullptr);
+    ASSERT_TRUE(hot_context.physical_plan != nullptr);
+    ASSERT_EQ(cold_info->GetSchema().size(), hot_info->GetSchema().size());
+    // the later gets hand out the optimized info
+    for (int i = 0; i < 3; i++) {
+        BatchRunSession session;
+        ASSERT_TRUE(engine.Get(sql, "simple_db", session, get_status)) << get_status;
+        ASSERT_EQ(hot_info.get(), session.GetCompileInfo().get());
+    }
+
+    // the request mode sql is compiled with optimizations at once
+    RequestRunSession request_session;
+    ASSERT_TRUE(engine.Get("select col1 + 1 as c1 from t1;", "simple_db", request_session, get_status))
+        << get_status;
+    ASSERT_EQ(2u, std::dynamic_pointer_cast<SqlCompileInfo>(request_session.GetCompileInfo())
+                      ->get_sql_context()
+                      .jit_options.GetOptLevel());
+}
 
 TEST_F(EngineCompileTest, EngineWithParameterizedLRUCacheTest) {
     // Build Simple Catalog
@@ -0,0 +1,135 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "vm/incremental_agg.h"
+
+#include <algorithm>
+#include <memory>
+
+namespace hybridse {
+namespace vm {
+
+// the float sums are recomputed once the rows retracted exceed the window
+// size, which bounds the rounding error the retractions accumulate
+static const uint64_t kMinRetractBeforeRebuild = 64;
+
+void IncrementalWindowAgg::Feed(Window* window, uint64_t pos) {
+    Row row = window->At(pos);
+    feed_fn_(reinterpret_cast<int8_t*>(&row), reinterpret_cast<int8_t*>(this));
+    next_seq_++;
+}
+
+void IncrementalWindowAgg::Retract() {
+    for (uint32_t i = 0; i < col_num_; i++) {
+        int_cols_[i].Retract(head_seq_);
+        double_cols_[i].Retract(head_seq_);
+    }
+    head_seq_++;
+    retract_cnt_++;
+}
+
+void IncrementalWindowAgg::Rebuild(Window* window) {
+    for (uint32_t i = 0; i < col_num_; i++) {
+        int_cols_[i].Clear();
+        double_cols_[i].Clear();
+    }
+    head_seq_ = next_seq_;
+    retract_cnt_ = 0;
+    // the newest row is at the front of the window
+    for (uint64_t pos = window->GetCount(); pos > 0; pos--) {
+        Feed(window, pos - 1);
+    }
+}
+
+void IncrementalWindowAgg::Sync(Window* window) {
+    uint64_t added = window->front_added_cnt() - front_added_cnt_;
+    uint64_t back_popped = window->back_popped_cnt() - back_popped_cnt_;
+    bool front_popped = window->front_popped_cnt() != front_popped_cnt_;
+    front_added_cnt_ = window->front_added_cnt();
+    back_popped_cnt_ = window->back_popped_cnt();
+    front_popped_cnt_ = window->front_popped_cnt();
+
+    uint64_t size = window->GetCount();
+    // rows are evicted from the back, the oldest mirrored rows go first and
+    // the rest are the new rows which have never been fed
+    uint64_t retract = std::min(back_popped, Size());
+    uint64_t feed = std::min(added, size);
+    if (front_popped || Size() - retract + feed != size ||
+        (has_double_ && retract_cnt_ + retract >
+                            std::max(size, kMinRetractBeforeRebuild))) {
+        Rebuild(window);
+        return;
+    }
+    for (uint64_t i = 0; i < retract; i++) {
+        Retract();
+    }
+    for (uint64_t pos = feed; pos > 0; pos--) {
+        Feed(window, pos - 1);
+    }
+}
+
+int8_t* IncrementalAggState(int8_t* input, int32_t id, int32_t col_num,
+                            int8_t* feed_fn) {
+    auto list_ref = reinterpret_cast<codec::ListRef<Row>*>(input);
+    auto window = dynamic_cast<Window*>(
+        reinterpret_cast<codec::ListV<Row>*>(list_ref->list));
+    if (window == nullptr || !window->enable_incremental_agg()) {
+        return nullptr;
+    }
+    auto fn = reinterpret_cast<IncrementalWindowAgg::FeedFn>(feed_fn);
+    auto& agg = window->GetIncrementalAgg(id);
+    if (!agg || agg->col_num() != static_cast<uint32_t>(col_num) ||
+        agg->feed_fn() != fn) {
+        agg = std::make_shared<IncrementalWindowAgg>(col_num, fn);
+    }
+    agg->Sync(window);
+    return reinterpret_cast<int8_t*>(agg.get());
+}
+
+void IncrementalAggAddInt64(int8_t* agg, int32_t col, int64_t value,
+                            int8_t is_null) {
+    reinterpret_cast<IncrementalWindowAgg*>(agg)->AddInt64(col, value,
+                                                           is_null != 0);
+}
+void IncrementalAggAddDouble(int8_t* agg, int32_t col, double value,
+                             int8_t is_null) {
+    reinterpret_cast<IncrementalWindowAgg*>(agg)->AddDouble(col, value,
+                                                            is_null != 0);
+}
+int64_t IncrementalAggSumInt64(int8_t* agg, int32_t col) {
+    return reinterpret_cast<IncrementalWindowAgg*>(agg)->SumInt64(col);
+}
+double IncrementalAggSumDouble(int8_t* agg, int32_t col) {
+    return reinterpret_cast<IncrementalWindowAgg*>(agg)->SumDouble(col);
+}
+int64_t IncrementalAggCount(int8_t* agg, int32_t col) {
+    return reinterpret_cast<IncrementalWindowAgg*>(agg)->Count(col);
+}
+int64_t IncrementalAggMinInt64(int8_t* agg, int32_t col) {
+    return reinterpret_cast<IncrementalWindowAgg*>(agg)->MinInt64(col);
+}
+int64_t IncrementalAggMaxInt64(int8_t* agg, int32_t col) {
+    return reinterpret_cast<IncrementalWindowAgg*>(agg)->MaxInt64(col);
+}
+double IncrementalAggMinDouble(int8_t* agg, int32_t col) {
+    return reinterpret_cast<IncrementalWindowAgg*>(agg)->MinDouble(col);
+}
+double IncrementalAggMaxDouble(int8_t* agg, int32_t col) {
+    return reinterpret_cast<IncrementalWindowAgg*>(agg)->MaxDouble(col);
+}
+
+}  // namespace vm
+}  // namespace hybridse
@@ -0,0 +1,184 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HYBRIDSE_SRC_VM_INCREMENTAL_AGG_H_
+#define HYBRIDSE_SRC_VM_INCREMENTAL_AGG_H_
+
+#include <deque>
+#include <utility>
+#include <vector>
+#include "vm/mem_catalog.h"
+
+namespace hybridse {
+namespace vm {
+
+/**
+ * The running state of one column aggregated over a sliding window.
+ * sum and count support retraction, min and max are kept by monotonic
+ * deques of (sequence, value) so that evicting the oldest row is O(1)
+ * amortized.
+ */
+template <class T>
+struct IncrementalAggColumn {
+    IncrementalAggColumn() : sum(0), count(0) {}
+
+    void Add(uint64_t seq, T value, bool is_null) {
+        values.emplace_back(value, is_null);
+        if (is_null) {
+            return;
+        }
+        sum += value;
+        count++;
+        while (!min_queue.empty() && !(min_queue.back().second < value)) {
+            min_queue.pop_back();
+        }
+        min_queue.emplace_back(seq, value);
+        while (!max_queue.empty() && !(value < max_queue.back().second)) {
+            max_queue.pop_back();
+        }
+        max_queue.emplace_back(seq, value);
+    }
+
+    // retract the oldest row, whose sequence is seq
+    void Retract(uint64_t seq) {
+        if (values.empty()) {
+            return;
+        }
+        auto& front = values.front();
+        if (!front.second) {
+            sum -= front.first;
+            count--;
+            if (!min_queue.empty() && min_queue.front().first == seq) {
+                min_queue.pop_front();
+            }
+            if (!max_queue.empty() && max_queue.front().first == seq) {
+                max_queue.pop_front();
+            }
+        }
+        values.pop_front();
+    }
+
+    void Clear() {
+        values.clear();
+        min_queue.clear();
+        max_queue.clear();
+        sum = 0;
+        count = 0;
+    }
+
+    T Min() const { return min_queue.empty() ? 0 : min_queue.front().second; }
+    T Max() const { return max_queue.empty() ? 0 : max_queue.front().second; }
+
+    // (value, is_null) of the rows in the window, oldest first
+    std::deque<std::pair<T, bool>> values;
+    T sum;
+    int64_t count;
+    std::deque<std::pair<uint64_t, T>> min_queue;
+    std::deque<std::pair<uint64_t, T>> max_queue;
+};
+
+/**
+ * Aggregate state of the multi column aggregation over a window, which is
+ * updated by the rows added to and evicted from the window since the last
+ * call instead of scanning the whole window for every output row.
+ *
+ * The column values of a row are fetched by the codegen feed function,
+ * which calls AddInt64/AddDouble once for each column. Integral columns are
+ * accumulated in int64 and float columns in double.
+ */
+class IncrementalWindowAgg {
+ public:
+    // void feed(const Row* row, IncrementalWindowAgg* agg)
+    typedef void (*FeedFn)(int8_t*, int8_t*);
+
+    IncrementalWindowAgg(uint32_t col_num, FeedFn feed_fn)
+        : col_num_(col_num),
+          feed_fn_(feed_fn),
+          int_cols_(col_num),
+          double_cols_(col_num),
+          has_double_(false),
+          head_seq_(0),
+          next_seq_(0),
+          retract_cnt_(0),
+          front_added_cnt_(0),
+          back_popped_cnt_(0),
+          front_popped_cnt_(0) {}
+
+    uint32_t col_num() const { return col_num_; }
+    FeedFn feed_fn() const { return feed_fn_; }
+
+    // catch up with the rows added to and evicted from the window
+    void Sync(Window* window);
+
+    void AddInt64(uint32_t col, int64_t value, bool is_null) {
+        int_cols_[col].Add(next_seq_, value, is_null);
+    }
+    void AddDouble(uint32_t col, double value, bool is_null) {
+        has_double_ = true;
+        double_cols_[col].Add(next_seq_, value, is_null);
+    }
+
+    int64_t SumInt64(uint32_t col) const { return int_cols_[col].sum; }
+    double SumDouble(uint32_t col) const { return double_cols_[col].sum; }
+    int64_t Count(uint32_t col) const {
+        return int_cols_[col].values.empty() ? double_cols_[col].count
+                                             : int_cols_[col].count;
+    }
+    int64_t MinInt64(uint32_t col) const { return int_cols_[col].Min(); }
+    int64_t MaxInt64(uint32_t col) const { return int_cols_[col].Max(); }
+    double MinDouble(uint32_t col) const { return double_cols_[col].Min(); }
+    double MaxDouble(uint32_t col) const { return double_cols_[col].Max(); }
+
+ private:
+    void Feed(Window* window, uint64_t pos);
+    void Retract();
+    void Rebuild(Window* window);
+    uint64_t Size() const { return next_seq_ - head_seq_; }
+
+    const uint32_t col_num_;
+    const FeedFn feed_fn_;
+    std::vector<IncrementalAggColumn<int64_t>> int_cols_;
+    std::vector<IncrementalAggColumn<double>> double_cols_;
+    bool has_double_;
+    // sequence of the oldest row and the next row to feed
+    uint64_t head_seq_;
+    uint64_t next_seq_;
+    // rows retracted since the last rebuild
+    uint64_t retract_cnt_;
+    // window counters at the last sync
+    uint64_t front_added_cnt_;
+    uint64_t back_popped_cnt_;
+    uint64_t front_popped_cnt_;
+};
+
+// incremental window aggregation interfaces for llvm
+int8_t* IncrementalAggState(int8_t* input, int32_t id, int32_t col_num,
+                            int8_t* feed_fn);
+void IncrementalAggAddInt64(int8_t* agg, int32_t col, int64_t value,
+                            int8_t is_null);
+void IncrementalAggAddDouble(int8_t* agg, int32_t col, double value,
+                             int8_t is_null);
+int64_t IncrementalAggSumInt64(int8_t* agg, int32_t col);
+double IncrementalAggSumDouble(int8_t* agg, int32_t col);
+int64_t IncrementalAggCount(int8_t* agg, int32_t col);
+int64_t IncrementalAggMinInt64(int8_t* agg, int32_t col);
+int64_t IncrementalAggMaxInt64(int8_t* agg, int32_t col);
+double IncrementalAggMinDouble(int8_t* agg, int32_t col);
+double IncrementalAggMaxDouble(int8_t* agg, int32_t col);
+
+}  // namespace vm
+}  // namespace hybridse
+#endif  // HYBRIDSE_SRC_VM_INCREMENTAL_AGG_H_
@@ -0,0 +1,195 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "vm/incremental_agg.h"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+#include "codec/list_iterator_codec.h"
+#include "gtest/gtest.h"
+
+namespace hybridse {
+namespace vm {
+
+using codec::ArrayListV;
+using codec::ListRef;
+
+class IncrementalWindowAggTest : public ::testing::Test {
+ public:
+    IncrementalWindowAggTest() {}
+    ~IncrementalWindowAggTest() {}
+};
+
+// the rows of the test hold an int64 and a double, the value is null if the
+// flag after it is set
+struct TestRowValue {
+    int64_t i64;
+    int8_t i64_null;
+    double f64;
+    int8_t f64_null;
+};
+
+static Row CreateRow(int64_t i64, bool i64_null, double f64, bool f64_null) {
+    int8_t* ptr = reinterpret_cast<int8_t*>(malloc(sizeof(TestRowValue)));
+    auto value = reinterpret_cast<TestRowValue*>(ptr);
+    value->i64 = i64;
+    value->i64_null = i64_null;
+    value->f64 = f64;
+    value->f64_null = f64_null;
+    return Row(base::RefCountedSlice::CreateManaged(ptr, sizeof(TestRowValue)));
+}
+
+// what the codegen feed function does for the test rows
+static void FeedTestRow(int8_t* row_ptr, int8_t* state) {
+    auto row = reinterpret_cast<Row*>(row_ptr);
+    auto value = reinterpret_cast<TestRowValue*>(row->buf(0));
+    IncrementalAggAddInt64(state, 0, value->i64, value->i64_null);
+    IncrementalAggAddDouble(state, 1, value->f64, value->f64_null);
+}
+
+static void CheckWithScan(Window* window, int8_t* state) {
+    int64_t i64_sum = 0, i64_cnt = 0;
+    int64_t i64_min = std::numeric_limits<int64_t>::max();
+    int64_t i64_max = std::numeric_limits<int64_t>::lowest();
+    double f64_sum = 0;
+    int64_t f64_cnt = 0;
+    double f64_min = std::numeric_limits<double>::max();
+    double f64_max = std::numeric_limits<double>::lowest();
+    for (uint64_t pos = 0; pos < window->GetCount(); pos++) {
+        Row row = window->At(pos);
+        auto value = reinterpret_cast<TestRowValue*>(row.buf(0));
+        if (!value->i64_null) {
+            i64_sum += value->i64;
+            i64_cnt++;
+            i64_min = std::min(i64_min, value->i64);
+            i64_max = std::max(i64_max, value->i64);
+        }
+        if (!value->f64_null) {
+            f64_sum += value->f64;
+            f64_cnt++;
+            f64_min = std::min(f64_min, value->f64);
+            f64_max = std::max(f64_max, value->f64);
+        }
+    }
+    ASSERT_EQ(i64_sum, IncrementalAggSumInt64(state, 0));
+    ASSERT_EQ(i64_cnt, IncrementalAggCount(state, 0));
+    if (i64_cnt > 0) {
+        ASSERT_EQ(i64_min, IncrementalAggMinInt64(state, 0));
+        ASSERT_EQ(i64_max, IncrementalAggMaxInt64(state, 0));
+    }
+    ASSERT_NEAR(f64_sum, IncrementalAggSumDouble(state, 1), 1e-6);
+    ASSERT_EQ(f64_cnt, IncrementalAggCount(state, 1));
+    if (f64_cnt > 0) {
+        ASSERT_DOUBLE_EQ(f64_min, IncrementalAggMinDouble(state, 1));
+        ASSERT_DOUBLE_EQ(f64_max, IncrementalAggMaxDouble(state, 1));
+    }
+}
+
+static void CheckSlidingWindow(const WindowRange& range, uint64_t row_cnt,
+                               uint64_t step) {
+    HistoryWindow window(range);
+    window.set_enable_incremental_agg(true);
+    ListRef<Row> window_ref;
+    window_ref.list = reinterpret_cast<int8_t*>(&window);
+    auto feed_fn = reinterpret_cast<int8_t*>(&FeedTestRow);
+    for (uint64_t i = 0; i < row_cnt; i++) {
+        // a few values repeat so that min and max see ties
+        int64_t i64 = static_cast<int64_t>((i * 7919) % 97) - 50;
+        double f64 = static_cast<double>((i * 104729) % 89) / 7.0 - 5.0;
+        ASSERT_TRUE(window.BufferData(
+            1000 + i * 10, CreateRow(i64, i % 5 == 3, f64, i % 7 == 2)));
+        // rows of other instances enter the window without an output
+        if (i % step != 0) {
+            continue;
+        }
+        int8_t* state = IncrementalAggState(
+            reinterpret_cast<int8_t*>(&window_ref), 0, 2, feed_fn);
+        ASSERT_TRUE(state != nullptr);
+        ASSERT_NO_FATAL_FAILURE(CheckWithScan(&window, state));
+    }
+}
+
+TEST_F(IncrementalWindowAggTest, RowsWindowTest) {
+    CheckSlidingWindow(WindowRange::CreateRowsWindow(10), 500, 1);
+    CheckSlidingWindow(WindowRange::CreateRowsWindow(10), 500, 3);
+    CheckSlidingWindow(WindowRange::CreateRowsWindow(0), 100, 1);
+}
+
+TEST_F(IncrementalWindowAggTest, RowsRangeWindowTest) {
+    CheckSlidingWindow(WindowRange::CreateRowsRangeWindow(-200, 0), 500, 1);
+    CheckSlidingWindow(WindowRange::CreateRowsRangeWindow(-200, 0, 7), 500,
+                       1);
+    CheckSlidingWindow(WindowRange::CreateRowsRangeWindow(-5000, 0), 1000,
+                       13);
+    // rows are evicted more than the window size between two outputs
+    CheckSlidingWindow(WindowRange::CreateRowsRangeWindow(-30, 0), 500, 50);
+}
+
+TEST_F(IncrementalWindowAggTest, RowsMergeRowsRangeWindowTest) {
+    CheckSlidingWindow(
+        WindowRange::CreateRowsMergeRowsRangeWindow(-100, 20, 0), 500, 1);
+}
+
+TEST_F(IncrementalWindowAggTest, PureHistoryWindowTest) {
+    CheckSlidingWindow(WindowRange::CreateRowsRangeWindow(-200, -50), 500, 1);
+}
+
+TEST_F(IncrementalWindowAggTest, RebuildAfterPopFrontTest) {
+    HistoryWindow window(WindowRange::CreateRowsWindow(10));
+    window.set_enable_incremental_agg(true);
+    ListRef<Row> window_ref;
+    window_ref.list = reinterpret_cast<int8_t*>(&window);
+    auto feed_fn = reinterpret_cast<int8_t*>(&FeedTestRow);
+    for (uint64_t i = 0; i < 50; i++) {
+        ASSERT_TRUE(window.BufferData(i, CreateRow(i, false, i, false)));
+        int8_t* state = IncrementalAggState(
+            reinterpret_cast<int8_t*>(&window_ref), 0, 2, feed_fn);
+        ASSERT_NO_FATAL_FAILURE(CheckWithScan(&window, state));
+        // pop the newest row like the instance not in window does
+        if (i % 4 == 0) {
+            window.PopFrontData();
+        }
+    }
+}
+
+TEST_F(IncrementalWindowAggTest, DisabledTest) {
+    auto feed_fn = reinterpret_cast<int8_t*>(&FeedTestRow);
+    HistoryWindow window(WindowRange::CreateRowsWindow(10));
+    ASSERT_TRUE(window.BufferData(1, CreateRow(1, false, 1, false)));
+    ListRef<Row> window_ref;
+    window_ref.list = reinterpret_cast<int8_t*>(&window);
+    ASSERT_TRUE(nullptr ==
+                IncrementalAggState(reinterpret_cast<int8_t*>(&window_ref), 0,
+                                    2, feed_fn));
+
+    // the list is not a window, e.g. the inner frames of a window
+    std::vector<Row> rows({CreateRow(1, false, 1, false)});
+    ArrayListV<Row> list(&rows);
+    ListRef<Row> list_ref;
+    list_ref.list = reinterpret_cast<int8_t*>(&list);
+    ASSERT_TRUE(nullptr ==
+                IncrementalAggState(reinterpret_cast<int8_t*>(&list_ref), 0,
+                                    2, feed_fn));
+}
+
+}  // namespace vm
+}  // namespace hybridse
+int main(int argc, char** argv) {
+    ::testing::GTEST_FLAG(color) = "yes";
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
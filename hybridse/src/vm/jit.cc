@@ -22,6 +22,7 @@ extern "C" {
 #include <cstdlib>
 }
 #include "glog/logging.h"
+#include "llvm/Analysis/TargetTransformInfo.h"
 #include "llvm/ExecutionEngine/JITEventListener.h"
 #include "llvm/ExecutionEngine/JITSymbol.h"
 #include "llvm/ExecutionEngine/Orc/CompileUtils.h"
@@ -36,10 +37,16 @@ extern "C" {
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/Verifier.h"
+#include "llvm/Support/Host.h"
+#include "llvm/Target/TargetMachine.h"
+#include "llvm/Transforms/IPO.h"
+#include "llvm/Transforms/IPO/AlwaysInliner.h"
+#include "llvm/Transforms/IPO/PassManagerBuilder.h"
 #include "llvm/Transforms/InstCombine/InstCombine.h"
 #include "llvm/Transforms/Scalar.h"
 #include "llvm/Transforms/Scalar/GVN.h"
 #include "llvm/Transforms/Utils.h"
+#include "llvm/Transforms/Vectorize.h"
 #ifdef LLVM_EXT_ENABLE
 #include "llvm_ext/symbol_resolve.h"
 #endif
@@ -52,6 +59,75 @@ HybridSeJit::HybridSeJit(::llvm::orc::LLJITBuilderState& s, ::llvm::Error& e)
     : LLJIT(s, e) {}
 HybridSeJit::~HybridSeJit() {}
 
+static ::llvm::CodeGenOpt::Level GetCodeGenOptLevel(uint32_t opt_level) {
+    switch (opt_level) {
+        case 0:
+            return ::llvm::CodeGenOpt::None;
+        case 1:
+            return ::llvm::CodeGenOpt::Less;
+        case 2:
+            return ::llvm::CodeGenOpt::Default;
+        default:
+            return ::llvm::CodeGenOpt::Aggressive;
+    }
+}
+
+// the target machine of the host cpu, whose cost model the loop passes use,
+// null if the host is not supported
+static std::unique_ptr<::llvm::TargetMachine> CreateHostTargetMachine() {
+    auto jtmb = ::llvm::orc::JITTargetMachineBuilder::detectHost();
+    if (!jtmb) {
+        LOG(WARNING) << "Fail to detect host target: "
+                     << ::llvm::toString(jtmb.takeError());
+        return nullptr;
+    }
+    jtmb->setCPU(::llvm::sys::getHostCPUName().str());
+    auto tm = jtmb->createTargetMachine();
+    if (!tm) {
+        LOG(WARNING) << "Fail to create host target machine: "
+                     << ::llvm::toString(tm.takeError());
+        return nullptr;
+    }
+    return std::move(*tm);
+}
+
+// The batch functions loop over rows and call the row functions. Inline the
+// row functions into the loops, then hoist the loop invariants and vectorize
+// the loops with the cost model of the host cpu.
+static void RunBatchFnOptPasses(::llvm::Module* m) {
+    bool has_batch_fn = false;
+    for (auto it = m->begin(); it != m->end() && !has_batch_fn; ++it) {
+        has_batch_fn = it->hasFnAttribute(BATCH_FN_ATTR);
+    }
+    if (!has_batch_fn) {
+        return;
+    }
+    ::llvm::legacy::PassManager mpm;
+    mpm.add(::llvm::createAlwaysInlinerLegacyPass());
+    mpm.run(*m);
+
+    auto tm = CreateHostTargetMachine();
+    ::llvm::legacy::FunctionPassManager fpm(m);
+    if (tm != nullptr) {
+        fpm.add(::llvm::createTargetTransformInfoWrapperPass(
+            tm->getTargetIRAnalysis()));
+    }
+    fpm.add(::llvm::createPromoteMemoryToRegisterPass());
+    fpm.add(::llvm::createInstructionCombiningPass());
+    fpm.add(::llvm::createGVNPass());
+    fpm.add(::llvm::createLICMPass());
+    fpm.add(::llvm::createLoopVectorizePass());
+    fpm.add(::llvm::createInstructionCombiningPass());
+    fpm.add(::llvm::createCFGSimplificationPass());
+    fpm.doInitialization();
+    for (auto it = m->begin(); it != m->end(); ++it) {
+        if (it->hasFnAttribute(BATCH_FN_ATTR)) {
+            fpm.run(*it);
+        }
+    }
+    fpm.doFinalization();
+}
+
 static void RunDefaultOptPasses(::llvm::Module* m) {
     ::llvm::legacy::FunctionPassManager fpm(m);
     // Add some optimizations.
@@ -64,6 +140,50 @@ static void RunDefaultOptPasses(::llvm::Module* m) {
     for (auto it = m->begin(); it != m->end(); ++it) {
         fpm.run(*it);
     }
+    RunBatchFnOptPasses(m);
+}
+
+// The O3 pipeline of clang with the cost model of the host cpu, for the hot
+// sql which is worth the longer compile.
+static void RunAggressiveOptPasses(::llvm::Module* m) {
+    auto tm = CreateHostTargetMachine();
+    ::llvm::legacy::PassManager mpm;
+    ::llvm::legacy::FunctionPassManager fpm(m);
+    if (tm != nullptr) {
+        mpm.add(::llvm::createTargetTransformInfoWrapperPass(
+            tm->getTargetIRAnalysis()));
+        fpm.add(::llvm::createTargetTransformInfoWrapperPass(
+            tm->getTargetIRAnalysis()));
+    }
+    ::llvm::PassManagerBuilder builder;
+    builder.OptLevel = 3;
+    builder.SizeLevel = 0;
+    builder.Inliner = ::llvm::createFunctionInliningPass(3, 0, false);
+    builder.LoopVectorize = true;
+    builder.SLPVectorize = true;
+    if (tm != nullptr) {
+        tm->adjustPassManager(builder);
+    }
+    builder.populateFunctionPassManager(fpm);
+    builder.populateModulePassManager(mpm);
+    fpm.doInitialization();
+    for (auto it = m->begin(); it != m->end(); ++it) {
+        fpm.run(*it);
+    }
+    fpm.doFinalization();
+    mpm.run(*m);
+}
+
+static void RunLevelOptPasses(::llvm::Module* m, uint32_t opt_level) {
+    if (opt_level == 0) {
+        // the module is compiled as it is by the fast instruction selection
+        return;
+    }
+    if (opt_level >= 3) {
+        RunAggressiveOptPasses(m);
+        return;
+    }
+    RunDefaultOptPasses(m);
 }
 
 ::llvm::Error HybridSeJit::AddIRModule(::llvm::orc::JITDylib& jd,  // NOLINT
@@ -72,7 +192,7 @@ static void RunDefaultOptPasses(::llvm::Module* m) {
     if (auto err = applyDataLayout(*tsm.getModule())) return err;
     DLOG(INFO) << "add a module with key " << key << " with ins cnt "
                << tsm.getModule()->getInstructionCount();
-    RunDefaultOptPasses(tsm.getModule());
+    RunOptPasses(tsm.getModule());
     DLOG(INFO) << "after opt with ins cnt "
                << tsm.getModule()->getInstructionCount();
     return CompileLayer->add(jd, std::move(tsm), key);
@@ -83,11 +203,21 @@ bool HybridSeJit::OptModule(::llvm::Module* m) {
         return false;
     }
     DLOG(INFO) << "Module before opt:\n" << LlvmToString(*m);
-    RunDefaultOptPasses(m);
+    RunOptPasses(m);
     DLOG(INFO) << "Module after opt:\n" << LlvmToString(*m);
     return true;
 }
 
+void HybridSeJit::RunOptPasses(::llvm::Module* m) {
+    // the cached object is loaded in place of compiling the module, so the
+    // optimizations are skipped too
+    if (object_cache_ != nullptr && object_cache_->AssignKey(m)) {
+        DLOG(INFO) << "skip opt of cached module " << m->getModuleIdentifier();
+        return;
+    }
+    RunLevelOptPasses(m, opt_level_);
+}
+
 ::llvm::orc::VModuleKey HybridSeJit::CreateVModule() {
     ::llvm::orc::VModuleKey key = ES->allocateVModule();
     DLOG(INFO) << "allocate a new module key " << key;
@@ -150,8 +280,35 @@ bool HybridSeJit::AddSymbol(::llvm::orc::JITDylib& jd,
 
 bool HybridSeLlvmJitWrapper::Init() {
     DLOG(INFO) << "Start to initialize hybridse jit";
-    auto jit = ::llvm::Expected<std::unique_ptr<HybridSeJit>>(
-        HybridSeJitBuilder().create());
+    HybridSeJitBuilder builder;
+    auto jtmb = ::llvm::orc::JITTargetMachineBuilder::detectHost();
+    if (!jtmb) {
+        LOG(WARNING) << "fail to detect host target: "
+                     << ::llvm::toString(jtmb.takeError());
+        return false;
+    }
+    jtmb->setCodeGenOptLevel(GetCodeGenOptLevel(jit_options_.GetOptLevel()));
+    if (jit_options_.GetOptLevel() >= 3) {
+        jtmb->setCPU(::llvm::sys::getHostCPUName().str());
+    }
+    builder.setJITTargetMachineBuilder(std::move(*jtmb));
+    if (!jit_options_.GetObjectCacheDir().empty()) {
+        object_cache_ = std::unique_ptr<JitObjectCache>(new JitObjectCache(
+            jit_options_.GetObjectCacheDir(), jit_options_.GetOptLevel(),
+            jit_options_.GetObjectCacheMaxSize()));
+        auto cache = object_cache_.get();
+        builder.setCompileFunctionCreator(
+            [cache](::llvm::orc::JITTargetMachineBuilder jtmb)
+                -> ::llvm::Expected<::llvm::orc::IRCompileLayer::CompileFunction> {
+                auto tm = jtmb.createTargetMachine();
+                if (!tm) {
+                    return tm.takeError();
+                }
+                return ::llvm::orc::TMOwningSimpleCompiler(std::move(*tm),
+                                                           cache);
+            });
+    }
+    auto jit = ::llvm::Expected<std::unique_ptr<HybridSeJit>>(builder.create());
     {
         ::llvm::Error e = jit.takeError();
         if (e) {
@@ -161,6 +318,8 @@ bool HybridSeLlvmJitWrapper::Init() {
         }
     }
     this->jit_ = std::move(jit.get());
+    jit_->SetObjectCache(object_cache_.get());
+    jit_->SetOptLevel(jit_options_.GetOptLevel());
     jit_->Init();
 
     this->mi_ = std::unique_ptr<::llvm::orc::MangleAndInterner>(
@@ -206,11 +365,21 @@ bool HybridSeLlvmJitWrapper::AddExternalFunction(const std::string& name,
 }
 
 #ifdef LLVM_EXT_ENABLE
-bool HybridSeMcJitWrapper::Init() { return true; }
+bool HybridSeMcJitWrapper::Init() {
+    if (!jit_options_.GetObjectCacheDir().empty()) {
+        object_cache_ = std::unique_ptr<JitObjectCache>(new JitObjectCache(
+            jit_options_.GetObjectCacheDir(), jit_options_.GetOptLevel(),
+            jit_options_.GetObjectCacheMaxSize()));
+    }
+    return true;
+}
 
 bool HybridSeMcJitWrapper::OptModule(::llvm::Module* module) {
     DLOG(INFO) << "Module before opt:\n" << LlvmToString(*module);
-    RunDefaultOptPasses(module);
+    if (object_cache_ != nullptr && object_cache_->AssignKey(module)) {
+        return true;
+    }
+    RunLevelOptPasses(module, jit_options_.GetOptLevel());
     DLOG(INFO) << "Module after opt:\n" << LlvmToString(*module);
     return true;
 }
@@ -233,11 +402,14 @@ bool HybridSeMcJitWrapper::AddModule(
                 ? engine_builder.selectTarget()->createDataLayout()
                 : module_layout);
 
+        if (jit_options_.GetOptLevel() >= 3) {
+            engine_builder.setMCPU(::llvm::sys::getHostCPUName());
+        }
         execution_engine_ =
             engine_builder.setEngineKind(llvm::EngineKind::JIT)
                 .setErrorStr(&err_str_)
                 .setVerifyModules(true)
-                .setOptLevel(::llvm::CodeGenOpt::Level::Default)
+                .setOptLevel(GetCodeGenOptLevel(jit_options_.GetOptLevel()))
                 .setSymbolResolver(
                     std::unique_ptr<::llvm::LegacyJITSymbolResolver>(
                         ::llvm::cast<::llvm::LegacyJITSymbolResolver>(
@@ -248,6 +420,9 @@ bool HybridSeMcJitWrapper::AddModule(
                          << err_str_;
             return false;
         }
+        if (object_cache_ != nullptr) {
+            execution_engine_->setObjectCache(object_cache_.get());
+        }
         for (auto& pair : extern_functions_) {
             resolver->addSymbol(pair.first, pair.second);
         }
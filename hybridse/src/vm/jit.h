@@ -22,6 +22,7 @@
 #include <string>
 #include "llvm/ExecutionEngine/GenericValue.h"
 #include "llvm/ExecutionEngine/Orc/LLJIT.h"
+#include "vm/jit_object_cache.h"
 #include "vm/jit_wrapper.h"
 
 #ifdef LLVM_EXT_ENABLE
@@ -64,10 +65,21 @@ class HybridSeJit : public ::llvm::orc::LLJIT {
     static bool AddSymbol(::llvm::orc::JITDylib& jd,           // NOLINT
                           ::llvm::orc::MangleAndInterner& mi,  // NOLINT
                           const std::string& fn_name, void* fn_ptr);
+
+    // the cache has to be the one the compile function is built with
+    void SetObjectCache(JitObjectCache* cache) { object_cache_ = cache; }
+    // the optimizations to run, see JitOptions::SetOptLevel
+    void SetOptLevel(uint32_t level) { opt_level_ = level; }
     ~HybridSeJit();
 
  protected:
     HybridSeJit(::llvm::orc::LLJITBuilderState& s, ::llvm::Error& e);  // NOLINT
+
+ private:
+    void RunOptPasses(::llvm::Module* m);
+
+    JitObjectCache* object_cache_ = nullptr;
+    uint32_t opt_level_ = 2;
 };
 
 class HybridSeJitBuilder
@@ -88,6 +100,8 @@ std::string LlvmToString(const T& value) {
 class HybridSeLlvmJitWrapper : public HybridSeJitWrapper {
  public:
     HybridSeLlvmJitWrapper() {}
+    explicit HybridSeLlvmJitWrapper(const JitOptions& jit_options)
+        : jit_options_(jit_options) {}
     ~HybridSeLlvmJitWrapper() {}
 
     bool Init() override;
@@ -103,6 +117,9 @@ class HybridSeLlvmJitWrapper : public HybridSeJitWrapper {
         const std::string& funcname) override;
 
  private:
+    const JitOptions jit_options_;
+    // outlives the jit which compiles with it
+    std::unique_ptr<JitObjectCache> object_cache_;
     std::unique_ptr<HybridSeJit> jit_;
     std::unique_ptr<::llvm::orc::MangleAndInterner> mi_;
 };
@@ -133,6 +150,7 @@ class HybridSeMcJitWrapper : public HybridSeJitWrapper {
     const JitOptions jit_options_;
     std::string err_str_ = "";
     std::map<std::string, void*> extern_functions_;
+    std::unique_ptr<JitObjectCache> object_cache_;
     llvm::ExecutionEngine* execution_engine_ = nullptr;
 };
 #endif
@@ -0,0 +1,201 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "vm/jit_object_cache.h"
+
+#include <utime.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "glog/logging.h"
+#include "hybridse_version.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Host.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/SHA1.h"
+#include "llvm/Support/raw_ostream.h"
+
+namespace hybridse {
+namespace vm {
+
+static const char kObjectKeyPrefix[] = "hybridse_jit_";
+
+// the host target and the versions, the objects of other targets or versions
+// are never loaded
+static std::string GetTargetSignature() {
+    std::string sig;
+    ::llvm::raw_string_ostream ss(sig);
+    ss << ::llvm::sys::getProcessTriple() << ";" << ::llvm::sys::getHostCPUName() << ";";
+    ::llvm::StringMap<bool> features;
+    if (::llvm::sys::getHostCPUFeatures(features)) {
+        std::vector<std::string> enabled;
+        for (auto& feature : features) {
+            if (feature.getValue()) {
+                enabled.push_back(feature.getKey().str());
+            }
+        }
+        std::sort(enabled.begin(), enabled.end());
+        for (auto& feature : enabled) {
+            ss << "+" << feature;
+        }
+    }
+    ss << ";llvm " << LLVM_VERSION_STRING << ";hybridse " << HYBRIDSE_VERSION_MAJOR << "." << HYBRIDSE_VERSION_MINOR
+       << "." << HYBRIDSE_VERSION_BUG;
+    ss.flush();
+    return sig;
+}
+
+// set the mtime of an object to now, so that it is the last one to evict
+static void TouchObject(const std::string& path) { utime(path.c_str(), nullptr); }
+
+JitObjectCache::JitObjectCache(const std::string& dir, uint32_t opt_level, uint64_t max_size)
+    : dir_(dir), opt_level_(opt_level), max_size_(max_size) {
+    auto ec = ::llvm::sys::fs::create_directories(dir_);
+    if (ec) {
+        LOG(WARNING) << "fail to create jit object cache dir " << dir_ << ": " << ec.message();
+    }
+}
+
+bool JitObjectCache::AssignKey(::llvm::Module* m) {
+    static const std::string target_sig = GetTargetSignature();
+    std::string ir;
+    ::llvm::raw_string_ostream ss(ir);
+    ss << target_sig << ";opt " << opt_level_ << "\n" << *m;
+    ss.flush();
+    auto hash = ::llvm::SHA1::hash(
+        ::llvm::ArrayRef<uint8_t>(reinterpret_cast<const uint8_t*>(ir.data()), ir.size()));
+    m->setModuleIdentifier(kObjectKeyPrefix + ::llvm::toHex(hash, true));
+    std::string path = GetObjectPath(m);
+    if (!::llvm::sys::fs::exists(path)) {
+        return false;
+    }
+    // the object is loaded soon, keep it from the evictions until then
+    TouchObject(path);
+    return true;
+}
+
+std::string JitObjectCache::GetObjectPath(const ::llvm::Module* m) const {
+    auto& key = m->getModuleIdentifier();
+    if (key.compare(0, sizeof(kObjectKeyPrefix) - 1, kObjectKeyPrefix) != 0) {
+        return "";
+    }
+    return dir_ + "/" + key + ".o";
+}
+
+void JitObjectCache::notifyObjectCompiled(const ::llvm::Module* m, ::llvm::MemoryBufferRef obj) {
+    std::string path = GetObjectPath(m);
+    if (path.empty()) {
+        return;
+    }
+    // write to a temporary file and rename it, so that the processes sharing
+    // the dir never read a partial object
+    int fd = -1;
+    ::llvm::SmallString<128> tmp_path;
+    auto ec = ::llvm::sys::fs::createUniqueFile(path + ".tmp-%%%%%%", fd, tmp_path);
+    if (ec) {
+        LOG(WARNING) << "fail to create jit object file for " << path << ": " << ec.message();
+        return;
+    }
+    {
+        ::llvm::raw_fd_ostream os(fd, true);
+        os << obj.getBuffer();
+        os.close();
+        if (os.has_error()) {
+            LOG(WARNING) << "fail to write jit object file " << tmp_path.str().str();
+            os.clear_error();
+            ::llvm::sys::fs::remove(tmp_path);
+            return;
+        }
+    }
+    ec = ::llvm::sys::fs::rename(tmp_path, path);
+    if (ec) {
+        LOG(WARNING) << "fail to rename jit object file to " << path << ": " << ec.message();
+        ::llvm::sys::fs::remove(tmp_path);
+        return;
+    }
+    DLOG(INFO) << "cache jit object " << path;
+    if (max_size_ > 0) {
+        Evict(path);
+    }
+}
+
+void JitObjectCache::Evict(const std::string& keep_path) {
+    struct ObjectFile {
+        std::string path;
+        uint64_t size;
+        ::llvm::sys::TimePoint<> mtime;
+    };
+    std::vector<ObjectFile> objects;
+    uint64_t total_size = 0;
+    std::error_code ec;
+    for (::llvm::sys::fs::directory_iterator it(dir_, ec), end; it != end && !ec; it.increment(ec)) {
+        auto name = ::llvm::sys::path::filename(it->path());
+        if (!name.startswith(kObjectKeyPrefix) || !name.endswith(".o")) {
+            continue;
+        }
+        ::llvm::sys::fs::file_status status;
+        if (::llvm::sys::fs::status(it->path(), status)) {
+            continue;
+        }
+        objects.push_back({it->path(), status.getSize(), status.getLastModificationTime()});
+        total_size += status.getSize();
+    }
+    if (total_size <= max_size_) {
+        return;
+    }
+    std::sort(objects.begin(), objects.end(),
+              [](const ObjectFile& l, const ObjectFile& r) { return l.mtime < r.mtime; });
+    // the other processes sharing the dir may remove the same objects, the
+    // objects gone are not counted either way
+    for (auto& object : objects) {
+        if (total_size <= max_size_) {
+            break;
+        }
+        if (object.path == keep_path) {
+            continue;
+        }
+        total_size -= object.size;
+        ec = ::llvm::sys::fs::remove(object.path);
+        if (ec) {
+            LOG(WARNING) << "fail to remove jit object file " << object.path << ": " << ec.message();
+            continue;
+        }
+        DLOG(INFO) << "evict jit object " << object.path;
+    }
+}
+
+std::unique_ptr<::llvm::MemoryBuffer> JitObjectCache::getObject(const ::llvm::Module* m) {
+    std::string path = GetObjectPath(m);
+    if (path.empty()) {
+        return nullptr;
+    }
+    auto buf = ::llvm::MemoryBuffer::getFile(path);
+    if (!buf) {
+        return nullptr;
+    }
+    TouchObject(path);
+    DLOG(INFO) << "load cached jit object " << path;
+    return std::move(*buf);
+}
+
+}  // namespace vm
+}  // namespace hybridse
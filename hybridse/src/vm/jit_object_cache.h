@@ -0,0 +1,75 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HYBRIDSE_SRC_VM_JIT_OBJECT_CACHE_H_
+#define HYBRIDSE_SRC_VM_JIT_OBJECT_CACHE_H_
+
+#include <memory>
+#include <string>
+#include "llvm/ExecutionEngine/ObjectCache.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/MemoryBuffer.h"
+
+namespace hybridse {
+namespace vm {
+
+/**
+ * Object files of the compiled sql modules kept in a directory, so that a
+ * restarted process compiles the same sql without running the optimizations
+ * and the code generation again.
+ *
+ * The key of a module is the hash of its ir before the optimizations, the
+ * opt level, the host target and the versions of hybridse and llvm. The ir
+ * holds the schemas and the sql functions, and the udfs outside of it are
+ * resolved by name when the object is linked, so a change of any of them
+ * changes the key or is picked up by the linking.
+ *
+ * A loaded object has its mtime updated, and once the objects of the dir
+ * take more than the max size, the ones of the oldest mtime are removed.
+ */
+class JitObjectCache : public ::llvm::ObjectCache {
+ public:
+    // the objects of other opt levels are not loaded, max_size 0 keeps all
+    // the objects
+    JitObjectCache(const std::string& dir, uint32_t opt_level, uint64_t max_size);
+    ~JitObjectCache() {}
+
+    // set the key of the module as its identifier, which has to be called
+    // before the module is optimized, return true if the object is cached
+    bool AssignKey(::llvm::Module* m);
+
+    void notifyObjectCompiled(const ::llvm::Module* m,
+                              ::llvm::MemoryBufferRef obj) override;
+
+    std::unique_ptr<::llvm::MemoryBuffer> getObject(
+        const ::llvm::Module* m) override;
+
+ private:
+    // empty if the module has no key
+    std::string GetObjectPath(const ::llvm::Module* m) const;
+
+    // remove the least recently used objects except keep_path until the
+    // objects take no more than the max size
+    void Evict(const std::string& keep_path);
+
+    const std::string dir_;
+    const uint32_t opt_level_;
+    const uint64_t max_size_;
+};
+
+}  // namespace vm
+}  // namespace hybridse
+#endif  // HYBRIDSE_SRC_VM_JIT_OBJECT_CACHE_H_
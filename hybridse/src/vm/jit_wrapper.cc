@@ -38,6 +38,7 @@
 #include "llvm/Transforms/Utils.h"
 #include "udf/default_udf_library.h"
 #include "udf/udf.h"
+#include "vm/incremental_agg.h"
 #include "vm/jit.h"
 
 namespace hybridse {
@@ -76,14 +77,14 @@ HybridSeJitWrapper* HybridSeJitWrapper::Create(const JitOptions& jit_options) {
         return new HybridSeMcJitWrapper(jit_options);
 #else
         LOG(WARNING) << "McJit support is not enabled";
-        return new HybridSeLlvmJitWrapper();
+        return new HybridSeLlvmJitWrapper(jit_options);
 #endif
     } else {
         if (jit_options.IsEnableVtune() || jit_options.IsEnablePerf() ||
             jit_options.IsEnableGdb()) {
             LOG(WARNING) << "LLJIT do not support jit events";
         }
-        return new HybridSeLlvmJitWrapper();
+        return new HybridSeLlvmJitWrapper(jit_options);
     }
 }
 
@@ -204,6 +205,37 @@ void InitBuiltinJitSymbols(HybridSeJitWrapper* jit) {
         "hybridse_storage_get_row_slice_size",
         reinterpret_cast<void*>(&hybridse::vm::RowGetSliceSize));
 
+    jit->AddExternalFunction(
+        "hybridse_window_incremental_agg_state",
+        reinterpret_cast<void*>(&hybridse::vm::IncrementalAggState));
+    jit->AddExternalFunction(
+        "hybridse_window_incremental_agg_add_int64",
+        reinterpret_cast<void*>(&hybridse::vm::IncrementalAggAddInt64));
+    jit->AddExternalFunction(
+        "hybridse_window_incremental_agg_add_double",
+        reinterpret_cast<void*>(&hybridse::vm::IncrementalAggAddDouble));
+    jit->AddExternalFunction(
+        "hybridse_window_incremental_agg_sum_int64",
+        reinterpret_cast<void*>(&hybridse::vm::IncrementalAggSumInt64));
+    jit->AddExternalFunction(
+        "hybridse_window_incremental_agg_sum_double",
+        reinterpret_cast<void*>(&hybridse::vm::IncrementalAggSumDouble));
+    jit->AddExternalFunction(
+        "hybridse_window_incremental_agg_count",
+        reinterpret_cast<void*>(&hybridse::vm::IncrementalAggCount));
+    jit->AddExternalFunction(
+        "hybridse_window_incremental_agg_min_int64",
+        reinterpret_cast<void*>(&hybridse::vm::IncrementalAggMinInt64));
+    jit->AddExternalFunction(
+        "hybridse_window_incremental_agg_max_int64",
+        reinterpret_cast<void*>(&hybridse::vm::IncrementalAggMaxInt64));
+    jit->AddExternalFunction(
+        "hybridse_window_incremental_agg_min_double",
+        reinterpret_cast<void*>(&hybridse::vm::IncrementalAggMinDouble));
+    jit->AddExternalFunction(
+        "hybridse_window_incremental_agg_max_double",
+        reinterpret_cast<void*>(&hybridse::vm::IncrementalAggMaxDouble));
+
     jit->AddExternalFunction(
         "hybridse_memery_pool_alloc",
         reinterpret_cast<void*>(&udf::v1::AllocManagedStringBuf));
@@ -32,6 +32,10 @@ namespace vm {
 
 class JitOptions;
 
+// attribute of the functions which loop over a batch of rows, the loop
+// optimizations only run on them
+static const char BATCH_FN_ATTR[] = "hybridse-batch-fn";
+
 class HybridSeJitWrapper {
  public:
     HybridSeJitWrapper() {}
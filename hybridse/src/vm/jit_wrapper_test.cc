@@ -15,8 +15,14 @@
  */
 
 #include "vm/jit_wrapper.h"
+#include <dirent.h>
+#include <unistd.h>
+#include <utime.h>
+#include <set>
+#include <string>
 #include "codec/fe_row_codec.h"
 #include "gtest/gtest.h"
+#include "llvm/Support/FileSystem.h"
 #include "udf/udf.h"
 #include "vm/engine.h"
 #include "vm/simple_catalog.h"
@@ -162,6 +168,145 @@ TEST_F(JitWrapperTest, test_window) {
     delete jit;
 }
 
+static size_t CountObjectFiles(const std::string &dir) {
+    size_t cnt = 0;
+    DIR *d = opendir(dir.c_str());
+    if (d == nullptr) {
+        return 0;
+    }
+    struct dirent *entry;
+    while ((entry = readdir(d)) != nullptr) {
+        std::string name(entry->d_name);
+        if (name.size() > 2 && name.compare(name.size() - 2, 2, ".o") == 0) {
+            cnt++;
+        }
+    }
+    closedir(d);
+    return cnt;
+}
+
+TEST_F(JitWrapperTest, test_object_cache) {
+    std::string dir = "/tmp/jit_object_cache_test_" + std::to_string(getpid());
+    ::llvm::sys::fs::remove_directories(dir);
+    EngineOptions options;
+    options.jit_options().SetObjectCacheDir(dir);
+    auto catalog = GetTestCatalog();
+    std::string sql = "select col_1 + 1.0 as c1, col_2 * 2 as c2 from t1;";
+    ASSERT_TRUE(Compile(sql, options, catalog) != nullptr);
+    ASSERT_EQ(1u, CountObjectFiles(dir));
+
+    // compile again, the object is loaded from the cache
+    auto compile_info = Compile(sql, options, catalog);
+    ASSERT_TRUE(compile_info != nullptr);
+    ASSERT_EQ(1u, CountObjectFiles(dir));
+    auto &sql_context = compile_info->get_sql_context();
+    auto fn = sql_context.physical_plan->GetFnInfos()[0]->fn_ptr();
+    ASSERT_TRUE(fn != nullptr);
+
+    int8_t buf[1024];
+    auto schema = catalog->GetTable("db", "t1")->GetSchema();
+    codec::RowBuilder row_builder(*schema);
+    row_builder.SetBuffer(buf, 1024);
+    row_builder.AppendDouble(3.14);
+    row_builder.AppendInt64(42);
+    hybridse::codec::Row empty_parameter;
+    hybridse::codec::Row row(base::RefCountedSlice::Create(buf, 1024));
+    hybridse::codec::Row output = CoreAPI::RowProject(fn, row, empty_parameter);
+    codec::RowView row_view(sql_context.schema, output.buf(), output.size());
+    double c1;
+    int64_t c2;
+    ASSERT_EQ(row_view.GetDouble(0, &c1), 0);
+    ASSERT_EQ(row_view.GetInt64(1, &c2), 0);
+    ASSERT_DOUBLE_EQ(c1, 4.14);
+    ASSERT_EQ(c2, 84);
+
+    // another sql is compiled and cached
+    ASSERT_TRUE(Compile("select col_2 + 1 as c3 from t1;", options, catalog) != nullptr);
+    ASSERT_EQ(2u, CountObjectFiles(dir));
+    ::llvm::sys::fs::remove_directories(dir);
+}
+
+static std::set<std::string> ListObjectFiles(const std::string &dir) {
+    std::set<std::string> names;
+    DIR *d = opendir(dir.c_str());
+    if (d == nullptr) {
+        return names;
+    }
+    struct dirent *entry;
+    while ((entry = readdir(d)) != nullptr) {
+        std::string name(entry->d_name);
+        if (name.size() > 2 && name.compare(name.size() - 2, 2, ".o") == 0) {
+            names.insert(name);
+        }
+    }
+    closedir(d);
+    return names;
+}
+
+// the object of names_after not in names_before
+static std::string NewObjectFile(const std::set<std::string> &names_before,
+                                 const std::set<std::string> &names_after) {
+    for (auto &name : names_after) {
+        if (names_before.find(name) == names_before.end()) {
+            return name;
+        }
+    }
+    return "";
+}
+
+static void SetMtime(const std::string &path, time_t mtime) {
+    struct utimbuf times;
+    times.actime = mtime;
+    times.modtime = mtime;
+    ASSERT_EQ(0, utime(path.c_str(), &times));
+}
+
+TEST_F(JitWrapperTest, test_object_cache_evict) {
+    std::string dir = "/tmp/jit_object_cache_evict_test_" + std::to_string(getpid());
+    ::llvm::sys::fs::remove_directories(dir);
+    EngineOptions options;
+    options.jit_options().SetObjectCacheDir(dir);
+    options.jit_options().SetObjectCacheMaxSize(0);
+    auto catalog = GetTestCatalog();
+    std::string sql_a = "select col_1 + 1.0 as c1, col_2 * 2 as c2 from t1;";
+    std::string sql_b = "select col_2 + 1 as c3 from t1;";
+    std::string sql_c = "select col_2 + 2 as c3 from t1;";
+    ASSERT_TRUE(Compile(sql_a, options, catalog) != nullptr);
+    auto names = ListObjectFiles(dir);
+    ASSERT_EQ(1u, names.size());
+    std::string object_a = *names.begin();
+    ASSERT_TRUE(Compile(sql_b, options, catalog) != nullptr);
+    std::string object_b = NewObjectFile(names, ListObjectFiles(dir));
+    ASSERT_FALSE(object_b.empty());
+    uint64_t size_a = 0;
+    uint64_t size_b = 0;
+    ASSERT_FALSE(::llvm::sys::fs::file_size(dir + "/" + object_a, size_a));
+    ASSERT_FALSE(::llvm::sys::fs::file_size(dir + "/" + object_b, size_b));
+
+    // a was used after b, so b is evicted for c, which is as large as b
+    time_t now = time(nullptr);
+    SetMtime(dir + "/" + object_a, now - 200);
+    SetMtime(dir + "/" + object_b, now - 100);
+    options.jit_options().SetObjectCacheMaxSize(size_a + size_b);
+    ASSERT_TRUE(Compile(sql_a, options, catalog) != nullptr);
+    ASSERT_EQ(2u, ListObjectFiles(dir).size());
+    names = ListObjectFiles(dir);
+    ASSERT_TRUE(Compile(sql_c, options, catalog) != nullptr);
+    auto names_c = ListObjectFiles(dir);
+    std::string object_c = NewObjectFile(names, names_c);
+    ASSERT_FALSE(object_c.empty());
+    ASSERT_EQ(1u, names_c.count(object_a));
+    ASSERT_EQ(0u, names_c.count(object_b));
+
+    // the object just compiled is kept even if it is larger than the max size
+    options.jit_options().SetObjectCacheMaxSize(1);
+    ASSERT_TRUE(Compile(sql_b, options, catalog) != nullptr);
+    names = ListObjectFiles(dir);
+    ASSERT_EQ(1u, names.size());
+    ASSERT_EQ(object_b, *names.begin());
+    ::llvm::sys::fs::remove_directories(dir);
+}
+
 }  // namespace vm
 }  // namespace hybridse
 
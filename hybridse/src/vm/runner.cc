@@ -16,6 +16,7 @@
 
 #include "vm/runner.h"
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <utility>
@@ -23,6 +24,7 @@
 
 #include "absl/strings/str_cat.h"
 #include "base/texttable.h"
+#include "base/work_stealing_pool.h"
 #include "udf/udf.h"
 #include "vm/catalog_wrapper.h"
 #include "vm/core_api.h"
@@ -30,6 +32,7 @@
 #include "vm/mem_catalog.h"
 
 DECLARE_bool(enable_spark_unsaferow_format);
+DECLARE_bool(enable_window_incremental_agg);
 
 namespace hybridse {
 namespace vm {
@@ -1302,6 +1305,32 @@ std::shared_ptr<DataHandler> TableProjectRunner::Run(
     auto& parameter = ctx.GetParameterRow();
     iter->SeekToFirst();
     int32_t cnt = 0;
+    if (project_gen_.BatchValid()) {
+        std::vector<Row> rows;
+        std::vector<Row> outputs;
+        rows.reserve(kVectorizedBatchSize);
+        while (iter->Valid()) {
+            rows.clear();
+            while (iter->Valid() && rows.size() < kVectorizedBatchSize) {
+                if (limit_cnt_ > 0 && cnt++ >= limit_cnt_) {
+                    break;
+                }
+                rows.push_back(iter->GetValue());
+                iter->Next();
+            }
+            if (rows.empty()) {
+                break;
+            }
+            if (!project_gen_.Gen(rows, parameter, &outputs)) {
+                LOG(WARNING) << "Table Project Fail: fail to project a batch of rows";
+                return std::shared_ptr<DataHandler>();
+            }
+            for (auto& row : outputs) {
+                output_table->AddRow(row);
+            }
+        }
+        return output_table;
+    }
     while (iter->Valid()) {
         if (limit_cnt_ > 0 && cnt++ >= limit_cnt_) {
             break;
@@ -1446,6 +1475,19 @@ std::shared_ptr<DataHandler> WindowAggRunner::Run(
     // Compute output
     std::shared_ptr<MemTableHandler> output_table =
         std::shared_ptr<MemTableHandler>(new MemTableHandler());
+    // the keys run concurrently unless the limit needs them in order
+    auto pool = ctx.window_agg_pool();
+    if (nullptr != pool && limit_cnt_ <= 0) {
+        std::vector<std::string> keys;
+        while (instance_partition_iter->Valid()) {
+            keys.push_back(instance_partition_iter->GetKey().ToString());
+            instance_partition_iter->Next();
+        }
+        RunWindowAggParallel(pool, parameter, instance_partition,
+                             union_partitions, join_right_tables, keys,
+                             output_table);
+        return output_table;
+    }
     while (instance_partition_iter->Valid()) {
         auto key = instance_partition_iter->GetKey().ToString();
         RunWindowAggOnKey(parameter, instance_partition, union_partitions,
@@ -1516,6 +1558,11 @@ void WindowAggRunner::RunWindowAggOnKey(
     HistoryWindow window(instance_window_gen_.range_gen_.window_range_);
     window.set_instance_not_in_window(instance_not_in_window_);
     window.set_exclude_current_time(exclude_current_time_);
+    // the incremental aggregations catch up with rows entering the window and
+    // leaving it from the back, the two options below pop the newest rows
+    window.set_enable_incremental_agg(FLAGS_enable_window_incremental_agg &&
+                                      !instance_not_in_window_ &&
+                                      !exclude_current_time_);
 
     while (instance_segment_iter->Valid()) {
         if (limit_cnt_ > 0 && cnt >= limit_cnt_) {
@@ -1561,6 +1608,170 @@ void WindowAggRunner::RunWindowAggOnKey(
     }
 }
 
+void WindowAggRunner::RunWindowAggOnRange(
+    const Row& parameter, std::shared_ptr<TableHandler> instance_segment,
+    std::vector<std::shared_ptr<DataHandler>> join_right_tables,
+    uint64_t warmup_pos, uint64_t begin_pos, uint64_t end_pos,
+    std::shared_ptr<MemTableHandler> output_table) {
+    auto instance_segment_iter = instance_segment->GetIterator();
+    if (!instance_segment_iter) {
+        LOG(WARNING) << "Instance Segment is Empty";
+        return;
+    }
+    instance_segment_iter->SeekToFirst();
+    HistoryWindow window(instance_window_gen_.range_gen_.window_range_);
+    window.set_instance_not_in_window(instance_not_in_window_);
+    window.set_exclude_current_time(exclude_current_time_);
+    window.set_enable_incremental_agg(FLAGS_enable_window_incremental_agg &&
+                                      !instance_not_in_window_ &&
+                                      !exclude_current_time_);
+
+    for (uint64_t pos = 0; pos < end_pos && instance_segment_iter->Valid();
+         pos++, instance_segment_iter->Next()) {
+        if (pos < warmup_pos) {
+            continue;
+        }
+        Row row = instance_segment_iter->GetValue();
+        if (windows_join_gen_.Valid()) {
+            row = windows_join_gen_.Join(row, join_right_tables, parameter);
+        }
+        bool is_instance = pos >= begin_pos;
+        Row output = window_project_gen_.Gen(instance_segment_iter->GetKey(),
+                                             row, parameter, is_instance,
+                                             append_slices_, &window);
+        if (is_instance) {
+            output_table->AddRow(output);
+        }
+    }
+}
+
+uint64_t WindowAggRunner::WarmupPos(const std::vector<uint64_t>& orders,
+                                    uint64_t pos) const {
+    const WindowRange& range = instance_window_gen_.range_gen_.window_range_;
+    uint64_t rows_start = pos - std::min(pos, range.start_row_);
+    int64_t sub = static_cast<int64_t>(orders[pos]) + range.start_offset_;
+    uint64_t start_ts = sub < 0 ? 0u : static_cast<uint64_t>(sub);
+    uint64_t range_start =
+        std::lower_bound(orders.begin(), orders.begin() + pos, start_ts) -
+        orders.begin();
+    uint64_t warmup_pos;
+    if (Window::kFrameRows == range.frame_type_) {
+        warmup_pos = rows_start;
+    } else if (range.start_row_ > 0) {
+        // the window keeps the rows of both the rows and the range frame
+        warmup_pos = std::min(rows_start, range_start);
+    } else {
+        warmup_pos = range_start;
+    }
+    if (range.max_size_ > 0) {
+        warmup_pos = std::max(warmup_pos, pos - std::min(pos, range.max_size_));
+    }
+    return warmup_pos;
+}
+
+// a key is split into ranges of at least kMinWindowAggRangeSize rows, and
+// about kWindowAggRangesPerThread ranges are made for each thread so that
+// the threads finishing early can steal the rest
+static const uint64_t kMinWindowAggRangeSize = 1024;
+static const uint64_t kWindowAggRangesPerThread = 4;
+
+struct WindowAggRange {
+    size_t key_idx;
+    uint64_t warmup_pos;
+    uint64_t begin_pos;
+    uint64_t end_pos;
+};
+
+// Run window aggregation of the keys on a work stealing pool and append the
+// outputs in the order of the keys. The rows of a key are split into ranges
+// when the window only holds the instance rows and the frame is bounded, a
+// range buffers the rows its first frame covers before any output.
+void WindowAggRunner::RunWindowAggParallel(
+    base::WorkStealingPool* pool, const Row& parameter,
+    std::shared_ptr<PartitionHandler> instance_partition,
+    std::vector<std::shared_ptr<PartitionHandler>> union_partitions,
+    std::vector<std::shared_ptr<DataHandler>> join_right_tables,
+    const std::vector<std::string>& keys,
+    std::shared_ptr<MemTableHandler> output_table) {
+    std::vector<std::shared_ptr<MemTableHandler>> outputs;
+    // a window whose frame ends before the current row keeps the rows in
+    // front of its frame until newer rows enter, which a range can not replay
+    bool splittable =
+        0 == windows_union_gen_.inputs_cnt_ && !instance_not_in_window_ &&
+        !exclude_current_time_ &&
+        0 == instance_window_gen_.range_gen_.window_range_.end_offset_;
+    if (!splittable) {
+        outputs.resize(keys.size());
+        pool->Run(keys.size(), [&](size_t i) {
+            outputs[i] = std::make_shared<MemTableHandler>();
+            RunWindowAggOnKey(parameter, instance_partition, union_partitions,
+                              join_right_tables, keys[i], outputs[i]);
+        });
+    } else {
+        std::vector<std::shared_ptr<TableHandler>> segments(keys.size());
+        std::vector<std::vector<uint64_t>> orders(keys.size());
+        pool->Run(keys.size(), [&](size_t i) {
+            auto segment = instance_window_gen_.sort_gen_.Sort(
+                instance_partition->GetSegment(keys[i]));
+            if (!segment) {
+                return;
+            }
+            auto iter = segment->GetIterator();
+            if (!iter) {
+                return;
+            }
+            for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+                orders[i].push_back(iter->GetKey());
+            }
+            segments[i] = segment;
+        });
+        uint64_t total_cnt = 0;
+        for (auto& key_orders : orders) {
+            total_cnt += key_orders.size();
+        }
+        uint64_t range_size = std::max(
+            kMinWindowAggRangeSize,
+            total_cnt / (pool->thread_num() * kWindowAggRangesPerThread));
+        std::vector<WindowAggRange> ranges;
+        for (size_t i = 0; i < keys.size(); i++) {
+            if (!segments[i]) {
+                continue;
+            }
+            auto& key_orders = orders[i];
+            uint64_t cnt = key_orders.size();
+            bool sorted = std::is_sorted(key_orders.begin(), key_orders.end());
+            uint64_t begin_pos = 0;
+            do {
+                uint64_t end_pos = std::min(cnt, begin_pos + range_size);
+                // stop splitting if the next range has to buffer more rows
+                // than it outputs
+                if (!sorted || (end_pos < cnt &&
+                                end_pos - WarmupPos(key_orders, end_pos) >
+                                    range_size)) {
+                    end_pos = cnt;
+                }
+                uint64_t warmup_pos =
+                    begin_pos > 0 ? WarmupPos(key_orders, begin_pos) : 0;
+                ranges.push_back({i, warmup_pos, begin_pos, end_pos});
+                begin_pos = end_pos;
+            } while (begin_pos < cnt);
+        }
+        outputs.resize(ranges.size());
+        pool->Run(ranges.size(), [&](size_t i) {
+            auto& range = ranges[i];
+            outputs[i] = std::make_shared<MemTableHandler>();
+            RunWindowAggOnRange(parameter, segments[range.key_idx],
+                                join_right_tables, range.warmup_pos,
+                                range.begin_pos, range.end_pos, outputs[i]);
+        });
+    }
+    for (auto& output : outputs) {
+        for (uint64_t pos = 0; pos < output->GetCount(); pos++) {
+            output_table->AddRow(output->At(pos));
+        }
+    }
+}
+
 std::shared_ptr<DataHandler> RequestLastJoinRunner::Run(
     RunnerContext& ctx,
     const std::vector<std::shared_ptr<DataHandler>>& inputs) {  // NOLINT
@@ -2656,6 +2867,9 @@ std::shared_ptr<DataHandler> GroupAggRunner::Run(
         }
         iter->SeekToFirst();
         int32_t cnt = 0;
+        // run the groups a batch at a time if the functions support it
+        bool run_batch = agg_gen_.BatchValid() && (!having_condition_.Valid() || having_condition_.BatchValid());
+        std::vector<std::shared_ptr<TableHandler>> segments;
         while (iter->Valid()) {
             if (limit_cnt_ > 0 && cnt++ >= limit_cnt_) {
                 break;
@@ -2666,11 +2880,22 @@ std::shared_ptr<DataHandler> GroupAggRunner::Run(
                 LOG(WARNING) << "group aggregation fail: segment segment is null";
                 return std::shared_ptr<DataHandler>();
             }
-            if (!having_condition_.Valid() || having_condition_.Gen(segment, parameter)) {
+            if (run_batch) {
+                segments.push_back(segment);
+                if (segments.size() >= kVectorizedBatchSize) {
+                    if (!RunBatch(segments, parameter, output_table)) {
+                        return std::shared_ptr<DataHandler>();
+                    }
+                    segments.clear();
+                }
+            } else if (!having_condition_.Valid() || having_condition_.Gen(segment, parameter)) {
                 output_table->AddRow(agg_gen_.Gen(parameter, segment));
             }
             iter->Next();
         }
+        if (!segments.empty() && !RunBatch(segments, parameter, output_table)) {
+            return std::shared_ptr<DataHandler>();
+        }
         return output_table;
     } else {
         LOG(WARNING) << "group aggregation fail: input isn't partition/table ";
@@ -2678,6 +2903,32 @@ std::shared_ptr<DataHandler> GroupAggRunner::Run(
     }
 }
 
+bool GroupAggRunner::RunBatch(const std::vector<std::shared_ptr<TableHandler>>& segments, const Row& parameter,
+                              std::shared_ptr<MemTableHandler> output_table) {
+    std::vector<std::shared_ptr<TableHandler>> having_segments;
+    if (having_condition_.Valid()) {
+        std::vector<bool> results;
+        if (!having_condition_.Gen(segments, parameter, &results)) {
+            LOG(WARNING) << "group aggregation fail: fail to run having condition on a batch of groups";
+            return false;
+        }
+        for (size_t i = 0; i < segments.size(); i++) {
+            if (results[i]) {
+                having_segments.push_back(segments[i]);
+            }
+        }
+    }
+    std::vector<Row> outputs;
+    if (!agg_gen_.Gen(parameter, having_condition_.Valid() ? having_segments : segments, &outputs)) {
+        LOG(WARNING) << "group aggregation fail: fail to aggregate a batch of groups";
+        return false;
+    }
+    for (auto& row : outputs) {
+        output_table->AddRow(row);
+    }
+    return true;
+}
+
 void RequestAggUnionRunner::InitAggregator() {
     auto func_name = func_->GetName();
     auto agg_col_type = producers_[1]->row_parser()->GetType(*agg_col_);
@@ -3751,9 +4002,38 @@ const bool ConditionGenerator::Gen(std::shared_ptr<TableHandler> table, const co
     return Runner::GetColumnBool(cond_row.buf(), &row_view_, idxs_[0],
                                  row_view_.GetSchema()->Get(idxs_[0]).type());
 }
+bool ConditionGenerator::Gen(const std::vector<Row>& rows, const Row& parameter,
+                             std::vector<bool>* results) const {
+    std::vector<Row> cond_rows;
+    if (!Runner::BatchRowProject(batch_fn_, rows, parameter, &cond_rows)) {
+        return false;
+    }
+    results->resize(rows.size());
+    for (size_t i = 0; i < rows.size(); i++) {
+        (*results)[i] = Runner::GetColumnBool(cond_rows[i].buf(), &row_view_, idxs_[0],
+                                              row_view_.GetSchema()->Get(idxs_[0]).type());
+    }
+    return true;
+}
+bool ConditionGenerator::Gen(const std::vector<std::shared_ptr<TableHandler>>& tables,
+                             const codec::Row& parameter, std::vector<bool>* results) {
+    std::vector<Row> cond_rows;
+    if (!Runner::BatchGroupbyProject(batch_fn_, parameter, tables, &cond_rows)) {
+        return false;
+    }
+    results->resize(tables.size());
+    for (size_t i = 0; i < tables.size(); i++) {
+        (*results)[i] = Runner::GetColumnBool(cond_rows[i].buf(), &row_view_, idxs_[0],
+                                              row_view_.GetSchema()->Get(idxs_[0]).type());
+    }
+    return true;
+}
 const Row ProjectGenerator::Gen(const Row& row, const Row& parameter) {
     return CoreAPI::RowProject(fn_, row, parameter, false);
 }
+bool ProjectGenerator::Gen(const std::vector<Row>& rows, const Row& parameter, std::vector<Row>* outputs) {
+    return Runner::BatchRowProject(batch_fn_, rows, parameter, outputs);
+}
 
 const Row ConstProjectGenerator::Gen(const Row& parameter) {
     return CoreAPI::RowConstProject(fn_, parameter, false);
@@ -3762,6 +4042,10 @@ const Row ConstProjectGenerator::Gen(const Row& parameter) {
 const Row AggGenerator::Gen(const codec::Row& parameter_row, std::shared_ptr<TableHandler> table) {
     return Runner::GroupbyProject(fn_, parameter_row, table.get());
 }
+bool AggGenerator::Gen(const codec::Row& parameter_row, const std::vector<std::shared_ptr<TableHandler>>& tables,
+                       std::vector<Row>* outputs) {
+    return Runner::BatchGroupbyProject(batch_fn_, parameter_row, tables, outputs);
+}
 
 Row Runner::GroupbyProject(const int8_t* fn, const codec::Row& parameter, TableHandler* table) {
     auto iter = table->GetIterator();
@@ -3796,6 +4080,100 @@ Row Runner::GroupbyProject(const int8_t* fn, const codec::Row& parameter, TableH
         base::RefCountedSlice::CreateManaged(buf, RowView::GetSize(buf)));
 }
 
+// Run the batch function over the inputs, whose row is not empty, and
+// set outputs[i] to the output of the i-th input
+static bool RunBatchFn(const int8_t* batch_fn, const std::vector<size_t>& idxs, const std::vector<int64_t>& keys,
+                       const std::vector<const int8_t*>& rows, const std::vector<const int8_t*>& windows,
+                       const Row& parameter, std::vector<Row>* outputs) {
+    auto udf = reinterpret_cast<int32_t (*)(const int64_t, const int64_t*, const int8_t* const*,
+                                            const int8_t* const*, const int8_t*, int8_t**)>(
+        const_cast<int8_t*>(batch_fn));
+    auto parameter_ptr = reinterpret_cast<const int8_t*>(&parameter);
+    std::vector<int8_t*> bufs(idxs.size(), nullptr);
+
+    JitRuntime::get()->InitRunStep();
+    int32_t ret = udf(idxs.size(), keys.data(), rows.data(), windows.data(), parameter_ptr, bufs.data());
+    JitRuntime::get()->ReleaseRunStep();
+
+    for (size_t i = 0; i < idxs.size(); i++) {
+        if (bufs[i] != nullptr) {
+            (*outputs)[idxs[i]] = Row(base::RefCountedSlice::CreateManaged(bufs[i], RowView::GetSize(bufs[i])));
+        }
+    }
+    if (ret != 0) {
+        LOG(WARNING) << "fail to run batch udf " << ret;
+        return false;
+    }
+    return true;
+}
+
+bool Runner::BatchRowProject(const int8_t* batch_fn, const std::vector<Row>& rows, const Row& parameter,
+                             std::vector<Row>* outputs) {
+    outputs->assign(rows.size(), Row());
+    std::vector<size_t> idxs;
+    std::vector<const int8_t*> row_ptrs;
+    idxs.reserve(rows.size());
+    row_ptrs.reserve(rows.size());
+    // empty rows output empty rows as RowProject does
+    for (size_t i = 0; i < rows.size(); i++) {
+        if (!rows[i].empty()) {
+            idxs.push_back(i);
+            row_ptrs.push_back(reinterpret_cast<const int8_t*>(&rows[i]));
+        }
+    }
+    if (idxs.empty()) {
+        return true;
+    }
+    std::vector<int64_t> keys(idxs.size(), 0);
+    std::vector<const int8_t*> windows(idxs.size(), nullptr);
+    return RunBatchFn(batch_fn, idxs, keys, row_ptrs, windows, parameter, outputs);
+}
+
+bool Runner::BatchGroupbyProject(const int8_t* batch_fn, const Row& parameter,
+                                 const std::vector<std::shared_ptr<TableHandler>>& tables,
+                                 std::vector<Row>* outputs) {
+    outputs->assign(tables.size(), Row());
+    std::vector<size_t> idxs;
+    std::vector<int64_t> keys;
+    std::vector<Row> first_rows;
+    std::vector<codec::ListRef<Row>> window_refs;
+    idxs.reserve(tables.size());
+    keys.reserve(tables.size());
+    first_rows.reserve(tables.size());
+    window_refs.reserve(tables.size());
+    // the key and row of a group are its first row as GroupbyProject does,
+    // empty groups output empty rows
+    for (size_t i = 0; i < tables.size(); i++) {
+        auto iter = tables[i]->GetIterator();
+        if (!iter) {
+            LOG(WARNING) << "Agg table is empty";
+            continue;
+        }
+        iter->SeekToFirst();
+        if (!iter->Valid()) {
+            continue;
+        }
+        idxs.push_back(i);
+        keys.push_back(iter->GetKey());
+        first_rows.push_back(iter->GetValue());
+        codec::ListRef<Row> window_ref;
+        window_ref.list = reinterpret_cast<int8_t*>(tables[i].get());
+        window_refs.push_back(window_ref);
+    }
+    if (idxs.empty()) {
+        return true;
+    }
+    std::vector<const int8_t*> row_ptrs;
+    std::vector<const int8_t*> window_ptrs;
+    row_ptrs.reserve(idxs.size());
+    window_ptrs.reserve(idxs.size());
+    for (size_t i = 0; i < idxs.size(); i++) {
+        row_ptrs.push_back(reinterpret_cast<const int8_t*>(&first_rows[i]));
+        window_ptrs.push_back(reinterpret_cast<const int8_t*>(&window_refs[i]));
+    }
+    return RunBatchFn(batch_fn, idxs, keys, row_ptrs, window_ptrs, parameter, outputs);
+}
+
 const Row WindowProjectGenerator::Gen(const uint64_t key, const Row row,
                                       const codec::Row& parameter,
                                       bool is_instance, size_t append_slices,
@@ -25,6 +25,7 @@
 #include <utility>
 #include <vector>
 #include "base/fe_status.h"
+#include "base/work_stealing_pool.h"
 #include "codec/fe_row_codec.h"
 #include "node/node_manager.h"
 #include "vm/aggregator.h"
@@ -51,6 +52,7 @@ class FnGenerator {
  public:
     explicit FnGenerator(const FnInfo& info)
         : fn_(info.fn_ptr()),
+          batch_fn_(info.batch_fn_ptr()),
           fn_schema_(*info.fn_schema()),
           row_view_(fn_schema_) {
         for (int32_t idx = 0; idx < fn_schema_.size(); idx++) {
@@ -59,7 +61,10 @@ class FnGenerator {
     }
     virtual ~FnGenerator() {}
     inline const bool Valid() const { return nullptr != fn_; }
+    // return true if the function can run a batch of rows at once
+    inline const bool BatchValid() const { return nullptr != batch_fn_; }
     const int8_t* fn_;
+    const int8_t* batch_fn_;
     const Schema fn_schema_;
     const RowView row_view_;
     std::vector<int32_t> idxs_;
@@ -81,6 +86,8 @@ class ProjectGenerator : public FnGenerator {
         : FnGenerator(info), fun_(info.fn_ptr()) {}
     virtual ~ProjectGenerator() {}
     const Row Gen(const Row& row, const Row& parameter);
+    bool Gen(const std::vector<Row>& rows, const Row& parameter,
+             std::vector<Row>* outputs);
     RowProjectFun fun_;
 };
 
@@ -97,6 +104,9 @@ class AggGenerator : public FnGenerator {
     explicit AggGenerator(const FnInfo& info) : FnGenerator(info) {}
     virtual ~AggGenerator() {}
     const Row Gen(const codec::Row& parameter_row, std::shared_ptr<TableHandler> table);
+    bool Gen(const codec::Row& parameter_row,
+             const std::vector<std::shared_ptr<TableHandler>>& tables,
+             std::vector<Row>* outputs);
 };
 class WindowProjectGenerator : public FnGenerator {
  public:
@@ -124,6 +134,10 @@ class ConditionGenerator : public FnGenerator {
     virtual ~ConditionGenerator() {}
     const bool Gen(const Row& row, const Row& parameter) const;
     const bool Gen(std::shared_ptr<TableHandler> table, const codec::Row& parameter_row);
+    bool Gen(const std::vector<Row>& rows, const Row& parameter,
+             std::vector<bool>* results) const;
+    bool Gen(const std::vector<std::shared_ptr<TableHandler>>& tables,
+             const codec::Row& parameter_row, std::vector<bool>* results);
 };
 class RangeGenerator {
  public:
@@ -271,6 +285,13 @@ class FilterGenerator : public PredicateFun {
         }
         return condition_gen_.Gen(row, parameter);
     }
+    bool IsBatchSupported() const override {
+        return condition_gen_.BatchValid();
+    }
+    bool Batch(const std::vector<Row>& rows, const Row& parameter,
+               std::vector<bool>* results) const override {
+        return condition_gen_.Gen(rows, parameter, results);
+    }
 
  private:
     ConditionGenerator condition_gen_;
@@ -506,6 +527,13 @@ class Runner : public node::NodeBase<Runner> {
                              const bool is_instance,
                              size_t append_slices, Window* window);
     static Row GroupbyProject(const int8_t* fn, const Row& parameter, TableHandler* table);
+    // run the batch functions over rows and groups, outputs[i] is the output
+    // of rows[i] or tables[i]
+    static bool BatchRowProject(const int8_t* batch_fn, const std::vector<Row>& rows, const Row& parameter,
+                                std::vector<Row>* outputs);
+    static bool BatchGroupbyProject(const int8_t* batch_fn, const Row& parameter,
+                                    const std::vector<std::shared_ptr<TableHandler>>& tables,
+                                    std::vector<Row>* outputs);
     static const Row RowLastJoinTable(size_t left_slices, const Row& left_row,
                                       size_t right_slices,
                                       std::shared_ptr<TableHandler> right_table,
@@ -865,6 +893,9 @@ class GroupAggRunner : public Runner {
         RunnerContext& ctx,  // NOLINT
         const std::vector<std::shared_ptr<DataHandler>>& inputs)
         override;  // NOLINT
+    // Run the having condition and aggregation over a batch of groups
+    bool RunBatch(const std::vector<std::shared_ptr<TableHandler>>& segments, const Row& parameter,
+                  std::shared_ptr<MemTableHandler> output_table);
     KeyGenerator group_;
     ConditionGenerator having_condition_;
     AggGenerator agg_gen_;
@@ -934,6 +965,23 @@ class WindowAggRunner : public Runner {
         std::vector<std::shared_ptr<PartitionHandler>> union_partitions,
         std::vector<std::shared_ptr<DataHandler>> joins, const std::string& key,
         std::shared_ptr<MemTableHandler> output_table);
+    // Run window aggregation on the rows [begin_pos, end_pos) of a sorted
+    // instance segment, the rows from warmup_pos are buffered before
+    void RunWindowAggOnRange(
+        const Row& parameter, std::shared_ptr<TableHandler> instance_segment,
+        std::vector<std::shared_ptr<DataHandler>> joins, uint64_t warmup_pos,
+        uint64_t begin_pos, uint64_t end_pos,
+        std::shared_ptr<MemTableHandler> output_table);
+    void RunWindowAggParallel(
+        base::WorkStealingPool* pool, const Row& parameter,
+        std::shared_ptr<PartitionHandler> instance_partition,
+        std::vector<std::shared_ptr<PartitionHandler>> union_partitions,
+        std::vector<std::shared_ptr<DataHandler>> joins,
+        const std::vector<std::string>& keys,
+        std::shared_ptr<MemTableHandler> output_table);
+    // the first row the frame of the row at pos may cover, orders are the
+    // ascending order keys of a segment
+    uint64_t WarmupPos(const std::vector<uint64_t>& orders, uint64_t pos) const;
 
     const bool instance_not_in_window_;
     const bool exclude_current_time_;
@@ -1513,6 +1561,7 @@ class RunnerContext {
           requests_(),
           parameter_(parameter),
           is_debug_(is_debug),
+          window_agg_pool_(nullptr),
           batch_cache_() {}
     explicit RunnerContext(hybridse::vm::ClusterJob* cluster_job,
                            const hybridse::codec::Row& request,
@@ -1524,6 +1573,7 @@ class RunnerContext {
           requests_(),
           parameter_(),
           is_debug_(is_debug),
+          window_agg_pool_(nullptr),
           batch_cache_() {}
     explicit RunnerContext(hybridse::vm::ClusterJob* cluster_job,
                            const std::vector<Row>& request_batch,
@@ -1535,6 +1585,7 @@ class RunnerContext {
           requests_(request_batch),
           parameter_(),
           is_debug_(is_debug),
+          window_agg_pool_(nullptr),
           batch_cache_() {}
 
     const size_t GetRequestSize() const { return requests_.size(); }
@@ -1547,6 +1598,8 @@ class RunnerContext {
     void SetRequest(const hybridse::codec::Row& request);
     void SetRequests(const std::vector<hybridse::codec::Row>& requests);
     bool is_debug() const { return is_debug_; }
+    base::WorkStealingPool* window_agg_pool() const { return window_agg_pool_; }
+    void set_window_agg_pool(base::WorkStealingPool* pool) { window_agg_pool_ = pool; }
 
     const std::string& sp_name() { return sp_name_; }
     std::shared_ptr<DataHandler> GetCache(int64_t id) const;
@@ -1563,6 +1616,8 @@ class RunnerContext {
     hybridse::codec::Row parameter_;
     size_t idx_;
     const bool is_debug_;
+    // owned by the engine, null if the window aggregation runs serially
+    base::WorkStealingPool* window_agg_pool_;
     // TODO(chenjing): optimize
     std::map<int64_t, std::shared_ptr<DataHandler>> cache_;
     std::map<int64_t, std::shared_ptr<DataHandlerList>> batch_cache_;
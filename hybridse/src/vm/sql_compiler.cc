@@ -165,7 +165,7 @@ Status SqlCompiler::BuildBatchModePhysicalPlan(SqlContext* ctx, const ::hybridse
     vm::BatchModeTransformer transformer(&ctx->nm, ctx->db, cl_, &ctx->parameter_types, llvm_module, library,
                                          ctx->is_cluster_optimized, ctx->enable_expr_optimize,
                                          ctx->enable_batch_window_parallelization, ctx->enable_window_column_pruning,
-                                         ctx->options.get());
+                                         ctx->options.get(), ctx->enable_batch_vectorized);
     transformer.AddDefaultPasses();
     CHECK_STATUS(transformer.TransformPhysicalPlan(plan_list, output), "Fail to generate physical plan batch mode");
     ctx->schema = *(*output)->GetOutputSchema();
@@ -410,6 +410,15 @@ bool SqlCompiler::ResolvePlanFnAddress(vm::PhysicalOpNode* node,
                 }
                 const_cast<FnInfo*>(info_ptr)->SetFnPtr(addr);
             }
+            if (!info_ptr->batch_fn_name().empty()) {
+                auto addr = jit->FindFunction(info_ptr->batch_fn_name());
+                if (addr == nullptr) {
+                    LOG(WARNING) << "Fail to find jit function "
+                                 << info_ptr->batch_fn_name() << " for node\n"
+                                 << *node;
+                }
+                const_cast<FnInfo*>(info_ptr)->SetBatchFnPtr(addr);
+            }
         }
     }
     return true;
@@ -17,6 +17,7 @@
 #ifndef HYBRIDSE_SRC_VM_SQL_COMPILER_H_
 #define HYBRIDSE_SRC_VM_SQL_COMPILER_H_
 
+#include <atomic>
 #include <memory>
 #include <set>
 #include <string>
@@ -45,6 +46,7 @@ struct SqlContext {
     bool enable_expr_optimize = false;
     bool enable_batch_window_parallelization = true;
     bool enable_window_column_pruning = false;
+    bool enable_batch_vectorized = false;
 
     // the sql content
     std::string sql;
@@ -142,8 +144,12 @@ class SqlCompileInfo : public CompileInfo {
         return dynamic_cast<SqlCompileInfo*>(node);
     }
 
+    // count a hit of the info in the engine cache and return the hits so far
+    uint32_t IncHitCount() { return hit_cnt_.fetch_add(1, std::memory_order_relaxed) + 1; }
+
  private:
     hybridse::vm::SqlContext sql_ctx;
+    std::atomic<uint32_t> hit_cnt_{0};
 };
 
 class SqlCompiler {
@@ -68,7 +68,8 @@ BatchModeTransformer::BatchModeTransformer(node::NodeManager* node_manager, cons
                                            const udf::UdfLibrary* library, bool cluster_optimized_mode,
                                            bool enable_expr_opt, bool enable_window_parallelization,
                                            bool enable_window_column_pruning,
-                                           const std::unordered_map<std::string, std::string>* options)
+                                           const std::unordered_map<std::string, std::string>* options,
+                                           bool enable_batch_vectorized)
     : node_manager_(node_manager),
       db_(db),
       catalog_(catalog),
@@ -77,6 +78,7 @@ BatchModeTransformer::BatchModeTransformer(node::NodeManager* node_manager, cons
       cluster_optimized_mode_(cluster_optimized_mode),
       enable_batch_window_parallelization_(enable_window_parallelization),
       enable_batch_window_column_pruning_(enable_window_column_pruning),
+      enable_batch_vectorized_(enable_batch_vectorized),
       library_(library),
       plan_ctx_(node_manager, library, db, catalog, parameter_types, enable_expr_opt, options) {}
 
@@ -175,6 +177,30 @@ Status BatchModeTransformer::TransformPlanOp(const node::PlanNode* node, Physica
     return base::Status::OK();
 }
 
+// the functions which the batch mode runners run over a batch of rows
+static bool IsVectorizedFn(const PhysicalOpNode* node, const FnInfo* fn_info) {
+    switch (node->GetOpType()) {
+        case kPhysicalOpFilter: {
+            auto filter_op = dynamic_cast<const PhysicalFilterNode*>(node);
+            return fn_info == &filter_op->filter().condition_.fn_info();
+        }
+        case kPhysicalOpProject: {
+            auto project_op = dynamic_cast<const PhysicalProjectNode*>(node);
+            if (kTableProject == project_op->project_type_) {
+                return fn_info == &project_op->project().fn_info();
+            }
+            if (kGroupAggregation == project_op->project_type_) {
+                auto group_agg_op = dynamic_cast<const PhysicalGroupAggrerationNode*>(node);
+                return fn_info == &group_agg_op->project().fn_info() ||
+                       fn_info == &group_agg_op->having_condition_.fn_info();
+            }
+            return false;
+        }
+        default:
+            return false;
+    }
+}
+
 Status BatchModeTransformer::InitFnInfo(PhysicalOpNode* node,
                                         std::set<PhysicalOpNode*>* visited) {
     auto visited_iter = visited->find(node);
@@ -307,6 +333,12 @@ Status BatchModeTransformer::InitFnInfo(PhysicalOpNode* node,
         CHECK_STATUS(InstantiateLLVMFunction(*fn_infos[i]), "Instantiate ", i,
                      "th native function \"", fn_info->fn_name(),
                      "\" failed at node:\n", node->GetTreeString());
+        if (enable_batch_vectorized_ && IsVectorizedFn(node, fn_info)) {
+            CHECK_STATUS(InstantiateLLVMBatchFunction(*fn_info),
+                         "Instantiate batch function of \"",
+                         fn_info->fn_name(), "\" failed at node:\n",
+                         node->GetTreeString());
+        }
     }
     return Status::OK();
 }
@@ -945,6 +977,17 @@ Status BatchModeTransformer::InstantiateLLVMFunction(const FnInfo& fn_info) {
                          *fn_info.fn_schema());
 }
 
+Status BatchModeTransformer::InstantiateLLVMBatchFunction(const FnInfo& fn_info) {
+    std::string batch_fn_name = fn_info.fn_name() + "_batch";
+    codegen::CodeGenContext codegen_ctx(module_, fn_info.schemas_ctx(), plan_ctx_.parameter_types(), node_manager_);
+    codegen::RowFnLetIRBuilder builder(&codegen_ctx);
+    CHECK_STATUS(builder.BuildBatch(batch_fn_name, fn_info.fn_name()));
+    // the fn info is shared by the node, record the batch function on it the
+    // same way the compiler records the function addresses
+    const_cast<FnInfo&>(fn_info).SetBatchFnName(batch_fn_name);
+    return Status::OK();
+}
+
 bool BatchModeTransformer::AddDefaultPasses() {
     AddPass(PhysicalPlanPassType::kPassColumnProjectsOptimized);
     AddPass(PhysicalPlanPassType::kPassFilterOptimized);
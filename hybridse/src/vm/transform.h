@@ -105,7 +105,8 @@ class BatchModeTransformer {
                          bool cluster_optimized_mode = false, bool enable_expr_opt = false,
                          bool enable_window_parallelization = true,
                          bool enable_window_column_pruning = false,
-                         const std::unordered_map<std::string, std::string>* options = nullptr);
+                         const std::unordered_map<std::string, std::string>* options = nullptr,
+                         bool enable_batch_vectorized = false);
     virtual ~BatchModeTransformer();
     bool AddDefaultPasses();
 
@@ -219,6 +220,12 @@ class BatchModeTransformer {
      */
     Status InstantiateLLVMFunction(const FnInfo& fn_info);
 
+    /**
+     * Instantiate the llvm function which runs the function of fn info
+     * over a batch of rows, and name it as the batch function of fn info.
+     */
+    Status InstantiateLLVMBatchFunction(const FnInfo& fn_info);
+
     Status GenWindowJoinList(PhysicalWindowAggrerationNode* window_agg_op,
                              PhysicalOpNode* in);
     Status GenWindowUnionList(WindowUnionList* window_union_list,
@@ -253,6 +260,8 @@ class BatchModeTransformer {
     bool cluster_optimized_mode_;
     bool enable_batch_window_parallelization_;
     bool enable_batch_window_column_pruning_;
+    // build batch functions for the runners which run a batch of rows at once
+    bool enable_batch_vectorized_;
     std::vector<PhysicalPlanPassType> passes;
     LogicalOpMap op_map_;
     const udf::UdfLibrary* library_;
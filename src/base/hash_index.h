@@ -0,0 +1,198 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_BASE_HASH_INDEX_H_
+#define SRC_BASE_HASH_INDEX_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <utility>
+#include <vector>
+
+#include "base/skiplist.h"
+
+namespace openmldb {
+namespace base {
+
+// An open addressing hash index over the nodes of a skiplist, for the point
+// lookups that do not need the order. Get is lock free, Insert/Remove/Reclaim/Clear
+// need external synchronized. The index does not own the nodes, a removed node
+// must be kept until the readers are gone as the skiplist does.
+// A full table is replaced by a larger one, the old table is freed by Reclaim
+// with the version it is retired in
+template <class K, class V, class Hash, class Comparator>
+class HashIndex {
+ public:
+    HashIndex(uint32_t capacity, const Hash& hash, const Comparator& compare)
+        : table_(NULL), size_(0), used_(0), hash_(hash), compare_(compare), retired_() {
+        uint32_t cap = 16;
+        while (cap < capacity) {
+            cap <<= 1;
+        }
+        table_.store(new Table(cap), std::memory_order_relaxed);
+    }
+
+    ~HashIndex() {
+        Reclaim(UINT64_MAX);
+        delete table_.load(std::memory_order_relaxed);
+    }
+
+    HashIndex(const HashIndex&) = delete;
+    HashIndex& operator=(const HashIndex&) = delete;
+
+    Node<K, V>* Get(const K& key) const {
+        const Table* table = table_.load(std::memory_order_acquire);
+        uint32_t hash = hash_(key);
+        uint32_t mask = table->capacity - 1;
+        for (uint32_t i = 0, pos = hash & mask; i <= mask; i++, pos = (pos + 1) & mask) {
+            const Slot& slot = table->slots[pos];
+            Node<K, V>* node = slot.node.load(std::memory_order_acquire);
+            if (node == NULL) {
+                return NULL;
+            }
+            if (node != Tombstone() && slot.hash.load(std::memory_order_relaxed) == hash &&
+                compare_(node->GetKey(), key) == 0) {
+                return node;
+            }
+        }
+        return NULL;
+    }
+
+    // the key of node must not be in the index
+    void Insert(Node<K, V>* node, uint64_t version) {
+        Table* table = table_.load(std::memory_order_relaxed);
+        if ((used_ + 1) * 4 > table->capacity * 3) {
+            // grow if the live nodes fill half of the table, otherwise only drop the tombstones
+            uint32_t capacity = (size_ + 1) * 2 > table->capacity ? table->capacity * 2 : table->capacity;
+            Table* new_table = new Table(capacity);
+            for (uint32_t i = 0; i < table->capacity; i++) {
+                Node<K, V>* cur = table->slots[i].node.load(std::memory_order_relaxed);
+                if (cur != NULL && cur != Tombstone()) {
+                    Put(new_table, cur, table->slots[i].hash.load(std::memory_order_relaxed));
+                }
+            }
+            table_.store(new_table, std::memory_order_release);
+            retired_.push_back(std::make_pair(version, table));
+            table = new_table;
+            used_ = size_;
+        }
+        if (Put(table, node, hash_(node->GetKey()))) {
+            used_++;
+        }
+        size_++;
+    }
+
+    Node<K, V>* Remove(const K& key) {
+        Table* table = table_.load(std::memory_order_relaxed);
+        uint32_t hash = hash_(key);
+        uint32_t mask = table->capacity - 1;
+        for (uint32_t i = 0, pos = hash & mask; i <= mask; i++, pos = (pos + 1) & mask) {
+            Slot& slot = table->slots[pos];
+            Node<K, V>* node = slot.node.load(std::memory_order_relaxed);
+            if (node == NULL) {
+                return NULL;
+            }
+            if (node != Tombstone() && slot.hash.load(std::memory_order_relaxed) == hash &&
+                compare_(node->GetKey(), key) == 0) {
+                slot.node.store(Tombstone(), std::memory_order_release);
+                size_--;
+                return node;
+            }
+        }
+        return NULL;
+    }
+
+    // free the tables retired in version or before
+    void Reclaim(uint64_t version) {
+        auto it = retired_.begin();
+        while (it != retired_.end()) {
+            if (it->first <= version) {
+                delete it->second;
+                it = retired_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    // the readers must be gone
+    void Clear() {
+        Reclaim(UINT64_MAX);
+        Table* table = table_.load(std::memory_order_relaxed);
+        for (uint32_t i = 0; i < table->capacity; i++) {
+            table->slots[i].node.store(NULL, std::memory_order_relaxed);
+        }
+        size_ = 0;
+        used_ = 0;
+    }
+
+    uint32_t GetSize() const { return size_; }
+
+    uint64_t GetByteSize() const {
+        uint64_t byte_size = sizeof(Slot) * table_.load(std::memory_order_relaxed)->capacity;
+        for (const auto& kv : retired_) {
+            byte_size += sizeof(Slot) * kv.second->capacity;
+        }
+        return byte_size;
+    }
+
+ private:
+    struct Slot {
+        Slot() : hash(0), node(NULL) {}
+        std::atomic<uint32_t> hash;
+        std::atomic<Node<K, V>*> node;
+    };
+
+    struct Table {
+        explicit Table(uint32_t cap) : capacity(cap), slots(new Slot[cap]) {}
+        ~Table() { delete[] slots; }
+        uint32_t capacity;
+        Slot* slots;
+    };
+
+    static Node<K, V>* Tombstone() { return reinterpret_cast<Node<K, V>*>(1); }
+
+    // return true if an empty slot is taken, false if a tombstone is reused
+    static bool Put(Table* table, Node<K, V>* node, uint32_t hash) {
+        uint32_t mask = table->capacity - 1;
+        for (uint32_t pos = hash & mask;; pos = (pos + 1) & mask) {
+            Slot& slot = table->slots[pos];
+            Node<K, V>* cur = slot.node.load(std::memory_order_relaxed);
+            if (cur == NULL || cur == Tombstone()) {
+                // the readers see the hash of the node they load
+                slot.hash.store(hash, std::memory_order_relaxed);
+                slot.node.store(node, std::memory_order_release);
+                return cur == NULL;
+            }
+        }
+    }
+
+ private:
+    std::atomic<Table*> table_;
+    // the count of live nodes
+    uint32_t size_;
+    // the count of slots taken by live nodes and tombstones
+    uint32_t used_;
+    Hash const hash_;
+    Comparator const compare_;
+    std::vector<std::pair<uint64_t, Table*>> retired_;
+};
+
+}  // namespace base
+}  // namespace openmldb
+
+#endif  // SRC_BASE_HASH_INDEX_H_
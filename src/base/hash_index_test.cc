@@ -0,0 +1,154 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "base/hash_index.h"
+
+#include <atomic>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "base/hash.h"
+#include "base/slice.h"
+#include "gtest/gtest.h"
+
+namespace openmldb {
+namespace base {
+
+class HashIndexTest : public ::testing::Test {
+ public:
+    HashIndexTest() {}
+    ~HashIndexTest() {}
+};
+
+struct SliceComparator {
+    int operator()(const Slice& a, const Slice& b) const { return a.compare(b); }
+};
+
+struct SliceHasher {
+    uint32_t operator()(const Slice& key) const { return hash(key.data(), key.size(), 0xe17a1465); }
+};
+
+// all keys collide
+struct ConstHasher {
+    uint32_t operator()(const Slice& key) const { return 7; }
+};
+
+typedef Skiplist<Slice, uint32_t, SliceComparator> List;
+
+template <class Hash>
+void InsertKeys(List* list, HashIndex<Slice, uint32_t, Hash, SliceComparator>* index,
+                const std::vector<std::string>& keys, uint64_t version) {
+    for (uint32_t i = 0; i < keys.size(); i++) {
+        list->Insert(Slice(keys[i]), i);
+        index->Insert(list->GetNode(Slice(keys[i])), version);
+    }
+}
+
+TEST_F(HashIndexTest, InsertAndGet) {
+    SliceComparator cmp;
+    List list(12, 4, cmp);
+    HashIndex<Slice, uint32_t, SliceHasher, SliceComparator> index(4, SliceHasher(), cmp);
+    std::vector<std::string> keys;
+    for (uint32_t i = 0; i < 1000; i++) {
+        keys.push_back("key" + std::to_string(i));
+    }
+    InsertKeys(&list, &index, keys, 0);
+    ASSERT_EQ(1000u, index.GetSize());
+    for (uint32_t i = 0; i < keys.size(); i++) {
+        Node<Slice, uint32_t>* node = index.Get(Slice(keys[i]));
+        ASSERT_TRUE(node != NULL);
+        ASSERT_EQ(i, node->GetValue());
+    }
+    ASSERT_TRUE(index.Get(Slice("key1000")) == NULL);
+    ASSERT_TRUE(index.Get(Slice("")) == NULL);
+    uint64_t byte_size = index.GetByteSize();
+    index.Reclaim(0);
+    ASSERT_LT(index.GetByteSize(), byte_size);
+}
+
+TEST_F(HashIndexTest, Remove) {
+    SliceComparator cmp;
+    List list(12, 4, cmp);
+    HashIndex<Slice, uint32_t, ConstHasher, SliceComparator> index(16, ConstHasher(), cmp);
+    std::vector<std::string> keys = {"a", "b", "c", "d"};
+    InsertKeys(&list, &index, keys, 0);
+    // the keys after a removed one in the probe sequence are still found
+    ASSERT_TRUE(index.Remove(Slice("b")) == list.GetNode(Slice("b")));
+    ASSERT_TRUE(index.Remove(Slice("b")) == NULL);
+    ASSERT_TRUE(index.Get(Slice("b")) == NULL);
+    ASSERT_EQ(2u, index.Get(Slice("c"))->GetValue());
+    ASSERT_EQ(3u, index.Get(Slice("d"))->GetValue());
+    ASSERT_EQ(3u, index.GetSize());
+    // remove and insert many times, the tombstones do not fill the table
+    for (uint32_t i = 0; i < 100; i++) {
+        ASSERT_TRUE(index.Remove(Slice("a")) != NULL);
+        index.Insert(list.GetNode(Slice("a")), i);
+    }
+    ASSERT_EQ(3u, index.GetSize());
+    ASSERT_EQ(0u, index.Get(Slice("a"))->GetValue());
+    index.Clear();
+    ASSERT_EQ(0u, index.GetSize());
+    ASSERT_TRUE(index.Get(Slice("a")) == NULL);
+}
+
+TEST_F(HashIndexTest, ConcurrentGet) {
+    SliceComparator cmp;
+    List list(12, 4, cmp);
+    HashIndex<Slice, uint32_t, SliceHasher, SliceComparator> index(16, SliceHasher(), cmp);
+    std::vector<std::string> keys;
+    for (uint32_t i = 0; i < 10000; i++) {
+        keys.push_back("key" + std::to_string(i));
+    }
+    for (uint32_t i = 0; i < 100; i++) {
+        list.Insert(Slice(keys[i]), i);
+        index.Insert(list.GetNode(Slice(keys[i])), 0);
+    }
+    std::atomic<bool> stop(false);
+    std::vector<std::thread> readers;
+    for (uint32_t t = 0; t < 4; t++) {
+        readers.emplace_back([&index, &keys, &stop]() {
+            while (!stop.load(std::memory_order_relaxed)) {
+                // the first keys are never removed, the table is replaced under them
+                for (uint32_t i = 0; i < 100; i++) {
+                    Node<Slice, uint32_t>* node = index.Get(Slice(keys[i]));
+                    ASSERT_TRUE(node != NULL);
+                    ASSERT_EQ(i, node->GetValue());
+                }
+            }
+        });
+    }
+    for (uint32_t i = 100; i < keys.size(); i++) {
+        list.Insert(Slice(keys[i]), i);
+        index.Insert(list.GetNode(Slice(keys[i])), 0);
+        if (i % 3 == 0) {
+            index.Remove(Slice(keys[i - 1]));
+        }
+    }
+    stop.store(true, std::memory_order_relaxed);
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    index.Reclaim(0);
+}
+
+}  // namespace base
+}  // namespace openmldb
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
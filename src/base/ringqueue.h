@@ -54,6 +54,15 @@ class RingQueue {
         head_ = (head_ + 1) % max_size_;
         full_ = head_ == tail_;
     }
+    // the idx-th item from the oldest one, idx must be less than size()
+    const T& at(uint32_t idx) const { return buf_[(tail_ + idx) % max_size_]; }
+
+    void clear() {
+        head_ = 0;
+        tail_ = 0;
+        full_ = false;
+    }
+
     const T& pop() {
         const auto& val = buf_[tail_];
 
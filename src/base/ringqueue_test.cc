@@ -78,6 +78,25 @@ TEST_F(RingQueueTest, pop) {
     }
 }
 
+TEST_F(RingQueueTest, at) {
+    uint32_t size = 10;
+    RingQueue<uint32_t> rq(size);
+    for (uint32_t i = 1; i <= size + 5; i++) {
+        if (rq.full()) {
+            rq.pop();
+        }
+        rq.put(i);
+    }
+    for (uint32_t i = 0; i < size; i++) {
+        ASSERT_EQ(i + 6, rq.at(i));
+    }
+    rq.clear();
+    ASSERT_TRUE(rq.empty());
+    rq.put(1);
+    ASSERT_EQ(1u, rq.size());
+    ASSERT_EQ(1u, rq.at(0));
+}
+
 };  // namespace base
 }  // namespace openmldb
 
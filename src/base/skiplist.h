@@ -22,6 +22,7 @@
 
 #include <atomic>
 #include <iostream>
+#include <new>
 
 #include "base/random.h"
 
@@ -40,19 +41,31 @@ struct DefaultComparator {
 };
 
 // Skiplist node , a thread safe structure
+// The forward pointers are laid out at the tail of the node in the same
+// allocation, so a node must be created by `new (height) Node<K, V>(...)`
 template <class K, class V>
 class Node {
  public:
     // Set data reference and Node height
     Node(const K& key, V& value, uint8_t height)  // NOLINT
         : height_(height), key_(key), value_(value) {
-        nexts_ = new std::atomic<Node<K, V>*>[height];
+        InitNexts();
     }
 
     Node(uint8_t height) : height_(height), key_(), value_() {  // NOLINT
-        nexts_ = new std::atomic<Node<K, V>*>[height];
+        InitNexts();
     }
 
+    // Allocate the node with `height` forward pointers
+    static void* operator new(size_t size, uint8_t height) {
+        assert(height > 0);
+        return ::operator new(size + sizeof(std::atomic<Node<K, V>*>) * (height - 1));
+    }
+
+    static void operator delete(void* ptr) { ::operator delete(ptr); }
+
+    static void operator delete(void* ptr, uint8_t height) { ::operator delete(ptr); }
+
     // Set the next node with memory barrier
     void SetNext(uint8_t level, Node<K, V>* node) {
         assert(level < height_ && level >= 0);
@@ -81,13 +94,21 @@ class Node {
 
     const K& GetKey() const { return key_; }
 
-    ~Node() { delete[] nexts_; }
+    ~Node() {}
+
+ private:
+    void InitNexts() {
+        for (uint8_t i = 0; i < height_; i++) {
+            new (&nexts_[i]) std::atomic<Node<K, V>*>(NULL);
+        }
+    }
 
  private:
     uint8_t const height_;
     K const key_;
     V value_;
-    std::atomic<Node<K, V>*>* nexts_;
+    // the real length is height_
+    std::atomic<Node<K, V>*> nexts_[1];
 };
 
 template <class K, class V, class Comparator>
@@ -101,7 +122,7 @@ class Skiplist {
           rand_(0xdeadbeef),
           head_(NULL),
           tail_(NULL) {
-        head_ = new Node<K, V>(MaxHeight);
+        head_ = new (MaxHeight) Node<K, V>(MaxHeight);
         for (uint8_t i = 0; i < head_->Height(); i++) {
             head_->SetNext(i, NULL);
         }
@@ -111,6 +132,11 @@ class Skiplist {
 
     // Insert need external synchronized
     uint8_t Insert(const K& key, V& value) {  // NOLINT
+        return InsertNode(key, value)->Height();
+    }
+
+    // Insert and return the node of key
+    Node<K, V>* InsertNode(const K& key, V& value) {  // NOLINT
         uint8_t height = RandomHeight();
         Node<K, V>* pre[MaxHeight];
         FindLessOrEqual(key, pre);
@@ -128,7 +154,7 @@ class Skiplist {
             node->SetNextNoBarrier(i, pre[i]->GetNextNoBarrier(i));
             pre[i]->SetNext(i, node);
         }
-        return height;
+        return node;
     }
 
     bool IsEmpty() {
@@ -152,8 +178,9 @@ class Skiplist {
         if (result == NULL || compare_(result->GetKey(), key) != 0) {
             return NULL;
         }
+        // lock-free readers may reach the successors through pre, so publish with barrier
         for (uint8_t i = 0; i < result->Height(); i++) {
-            pre[i]->SetNextNoBarrier(i, result->GetNextNoBarrier(i));
+            pre[i]->SetNext(i, result->GetNext(i));
             result->SetNextNoBarrier(i, NULL);
         }
         if (result == tail_) {
@@ -163,6 +190,31 @@ class Skiplist {
         return result;
     }
 
+    // Unlink is Remove that keeps the next pointers of the removed node, so a reader
+    // standing on it can still move on. Unlink need external synchronized
+    Node<K, V>* Unlink(const K& key) {
+        Node<K, V>* pre[MaxHeight];
+        for (uint8_t i = 0; i < MaxHeight; i++) {
+            pre[i] = head_;
+        }
+        Node<K, V>* target = FindLessOrEqual(key, pre);
+        if (target == NULL) {
+            return NULL;
+        }
+        Node<K, V>* result = target->GetNextNoBarrier(0);
+        if (result == NULL || compare_(result->GetKey(), key) != 0) {
+            return NULL;
+        }
+        for (uint8_t i = 0; i < result->Height(); i++) {
+            pre[i]->SetNext(i, result->GetNext(i));
+        }
+        if (result == tail_) {
+            pre[0] == head_ ? tail_.store(NULL, std::memory_order_relaxed)
+                            : tail_.store(pre[0], std::memory_order_relaxed);
+        }
+        return result;
+    }
+
     // Split list two parts, the return part is just a linkedlist
     Node<K, V>* Split(const K& key) {
         Node<K, V>* pre[MaxHeight];
@@ -251,6 +303,15 @@ class Skiplist {
         return -1;
     }
 
+    // return the node of key or NULL
+    Node<K, V>* GetNode(const K& key) {
+        Node<K, V>* node = FindEqual(key);
+        if (node != head_ && compare_(node->GetKey(), key) == 0) {
+            return node;
+        }
+        return NULL;
+    }
+
     Node<K, V>* GetLast() { return tail_.load(std::memory_order_acquire); }
 
     uint32_t GetSize() {
@@ -364,7 +425,7 @@ class Skiplist {
 
  private:
     Node<K, V>* NewNode(const K& key, V& value, uint8_t height) {  // NOLINT
-        Node<K, V>* node = new Node<K, V>(key, value, height);
+        Node<K, V>* node = new (height) Node<K, V>(key, value, height);
         return node;
     }
 
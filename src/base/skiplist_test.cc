@@ -77,14 +77,34 @@ struct StrComparator {
 TEST_F(NodeTest, SetNext) {
     uint32_t key = 1;
     uint32_t value = 2;
-    Node<uint32_t, uint32_t> node(key, value, 2);
+    Node<uint32_t, uint32_t>* node = new (2) Node<uint32_t, uint32_t>(key, value, 2);
     uint32_t key2 = 3;
     uint32_t value2 = 3;
-    Node<uint32_t, uint32_t> node2(key2, value2, 2);
-    node.SetNext(1, &node2);
-    Node<uint32_t, uint32_t>* node_ptr = node.GetNext(1);
+    Node<uint32_t, uint32_t>* node2 = new (2) Node<uint32_t, uint32_t>(key2, value2, 2);
+    ASSERT_TRUE(node->GetNext(0) == NULL);
+    ASSERT_TRUE(node->GetNext(1) == NULL);
+    node->SetNext(1, node2);
+    Node<uint32_t, uint32_t>* node_ptr = node->GetNext(1);
     ASSERT_EQ(3, (signed)node_ptr->GetValue());
     ASSERT_EQ(3, (signed)node_ptr->GetKey());
+    delete node;
+    delete node2;
+}
+
+TEST_F(NodeTest, InlineNexts) {
+    uint64_t key = 1;
+    void* value = NULL;
+    Node<uint64_t, void*>* node = new (12) Node<uint64_t, void*>(key, value, 12);
+    std::vector<Node<uint64_t, void*>*> nexts;
+    for (uint8_t i = 0; i < node->Height(); i++) {
+        nexts.push_back(new (1) Node<uint64_t, void*>(key, value, 1));
+        node->SetNext(i, nexts.back());
+    }
+    for (uint8_t i = 0; i < node->Height(); i++) {
+        ASSERT_EQ(nexts[i], node->GetNext(i));
+        delete nexts[i];
+    }
+    delete node;
 }
 
 TEST_F(NodeTest, NodeByteSize) {
@@ -596,6 +616,41 @@ TEST_F(SkiplistTest, Remove) {
     ASSERT_TRUE(sl.GetLast() == NULL);
 }
 
+TEST_F(SkiplistTest, Unlink) {
+    StrComparator cmp;
+    Skiplist<std::string, std::string, StrComparator> sl(12, 4, cmp);
+    std::string k1 = "a";
+    std::string k2 = "b";
+    std::string k3 = "h";
+    std::string v = "v";
+    sl.Insert(k1, v);
+    sl.Insert(k2, v);
+    sl.Insert(k3, v);
+    Skiplist<std::string, std::string, StrComparator>::Iterator* it = sl.NewIterator();
+    it->Seek(k2);
+    ASSERT_TRUE(it->Valid());
+    ASSERT_EQ("b", it->GetKey());
+    std::string k4 = "c";
+    ASSERT_TRUE(sl.Unlink(k4) == NULL);
+    Node<std::string, std::string>* node = sl.Unlink(k2);
+    ASSERT_FALSE(node == NULL);
+    ASSERT_EQ("b", node->GetKey());
+    std::string value;
+    ASSERT_EQ(-1, sl.Get(k2, value));
+    // the reader standing on the unlinked node moves on
+    it->Next();
+    ASSERT_TRUE(it->Valid());
+    ASSERT_EQ("h", it->GetKey());
+    Node<std::string, std::string>* node2 = sl.Unlink(k3);
+    ASSERT_FALSE(node2 == NULL);
+    ASSERT_EQ("a", sl.GetLast()->GetKey());
+    it->Next();
+    ASSERT_FALSE(it->Valid());
+    delete it;
+    delete node;
+    delete node2;
+}
+
 TEST_F(SkiplistTest, Get) {
     Comparator cmp;
     Skiplist<uint32_t, uint32_t, Comparator> sl(12, 4, cmp);
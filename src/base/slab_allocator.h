@@ -0,0 +1,266 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_BASE_SLAB_ALLOCATOR_H_
+#define SRC_BASE_SLAB_ALLOCATOR_H_
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <mutex>  // NOLINT
+#include <new>
+#include <vector>
+
+#include "base/spinlock.h"
+
+namespace openmldb {
+namespace base {
+
+// Size-classed slab allocator. Small buffers are carved out of big chunks and
+// recycled through per class free lists, so memory released by gc is reused by
+// the next put instead of going back to the system allocator one row at a time.
+// Freed slots are not reusable until the epoch they were freed in is reclaimed,
+// which lets the owner delay reuse the same way as the segment gc version.
+// A chunk whose slots are all reclaimed goes back to the system, so the memory
+// shrinks after a ttl sweep.
+class SlabAllocator {
+ public:
+    static const uint32_t kClassGranularity = 16;
+
+    SlabAllocator(uint32_t max_slab_size, uint32_t chunk_size)
+        : max_slab_size_(AlignUp(max_slab_size)),
+          chunk_size_(ChunkSize(max_slab_size_, chunk_size)),
+          classes_(max_slab_size_ / kClassGranularity),
+          epoch_(0),
+          chunk_cnt_(0),
+          reserved_byte_size_(0),
+          used_byte_size_(0),
+          pending_byte_size_(0) {}
+
+    ~SlabAllocator() {
+        for (auto& sc : classes_) {
+            for (char* chunk : sc.chunks) {
+                free(chunk);
+            }
+            sc.chunks.clear();
+        }
+    }
+
+    SlabAllocator(const SlabAllocator&) = delete;
+    SlabAllocator& operator=(const SlabAllocator&) = delete;
+
+    inline bool IsSlabSize(uint32_t size) const { return size > 0 && size <= max_slab_size_; }
+
+    // the memory must be released by Free with the same size
+    char* Alloc(uint32_t size) {
+        if (!IsSlabSize(size)) {
+            return new char[size];
+        }
+        uint32_t slot_size = AlignUp(size);
+        SizeClass& sc = classes_[slot_size / kClassGranularity - 1];
+        char* slot = NULL;
+        {
+            std::lock_guard<SpinMutex> lock(sc.mu);
+            if (sc.free_list != NULL) {
+                slot = sc.free_list;
+                sc.free_list = *reinterpret_cast<char**>(slot);
+            } else {
+                if (sc.cur == NULL || sc.cur + slot_size > sc.end) {
+                    char* chunk = NewChunk();
+                    sc.chunks.push_back(chunk);
+                    sc.cur = chunk + kClassGranularity;
+                    sc.end = chunk + chunk_size_;
+                }
+                slot = sc.cur;
+                sc.cur += slot_size;
+            }
+            GetChunkHeader(slot)->live_cnt++;
+        }
+        used_byte_size_.fetch_add(slot_size, std::memory_order_relaxed);
+        return slot;
+    }
+
+    // the slot is reusable after the current epoch is reclaimed
+    void Free(char* ptr, uint32_t size) {
+        if (ptr == NULL) {
+            return;
+        }
+        if (!IsSlabSize(size)) {
+            delete[] ptr;
+            return;
+        }
+        uint32_t slot_size = AlignUp(size);
+        SizeClass& sc = classes_[slot_size / kClassGranularity - 1];
+        uint64_t epoch = epoch_.load(std::memory_order_relaxed);
+        {
+            std::lock_guard<SpinMutex> lock(sc.mu);
+            if (sc.pending.empty() || sc.pending.back().epoch != epoch) {
+                sc.pending.push_back({epoch, ptr, ptr});
+                *reinterpret_cast<char**>(ptr) = NULL;
+            } else {
+                *reinterpret_cast<char**>(ptr) = sc.pending.back().head;
+                sc.pending.back().head = ptr;
+            }
+        }
+        used_byte_size_.fetch_sub(slot_size, std::memory_order_relaxed);
+        pending_byte_size_.fetch_add(slot_size, std::memory_order_relaxed);
+    }
+
+    uint64_t IncrEpoch() { return epoch_.fetch_add(1, std::memory_order_relaxed) + 1; }
+
+    uint64_t GetEpoch() const { return epoch_.load(std::memory_order_relaxed); }
+
+    // move the slots freed in epoch less or equal than the input one to free list
+    // and release the chunks left without live slots, return the byte size reclaimed
+    uint64_t Reclaim(uint64_t epoch) {
+        uint64_t reclaimed = 0;
+        for (uint32_t idx = 0; idx < classes_.size(); idx++) {
+            SizeClass& sc = classes_[idx];
+            uint64_t slot_size = (idx + 1) * kClassGranularity;
+            std::lock_guard<SpinMutex> lock(sc.mu);
+            bool has_empty_chunk = false;
+            while (!sc.pending.empty() && sc.pending.front().epoch <= epoch) {
+                PendingList& list = sc.pending.front();
+                for (char* slot = list.head; slot != NULL; slot = *reinterpret_cast<char**>(slot)) {
+                    reclaimed += slot_size;
+                    if (--GetChunkHeader(slot)->live_cnt == 0) {
+                        has_empty_chunk = true;
+                    }
+                }
+                *reinterpret_cast<char**>(list.tail) = sc.free_list;
+                sc.free_list = list.head;
+                sc.pending.pop_front();
+            }
+            if (has_empty_chunk) {
+                ReleaseEmptyChunks(&sc);
+            }
+        }
+        pending_byte_size_.fetch_sub(reclaimed, std::memory_order_relaxed);
+        return reclaimed;
+    }
+
+    // the byte size of chunks allocated from system
+    uint64_t GetReservedByteSize() const { return reserved_byte_size_.load(std::memory_order_relaxed); }
+
+    // the byte size of slots held by callers
+    uint64_t GetUsedByteSize() const { return used_byte_size_.load(std::memory_order_relaxed); }
+
+    // the byte size of slots waiting for reclaim
+    uint64_t GetPendingByteSize() const { return pending_byte_size_.load(std::memory_order_relaxed); }
+
+    uint64_t GetChunkCnt() const { return chunk_cnt_.load(std::memory_order_relaxed); }
+
+ private:
+    struct PendingList {
+        uint64_t epoch;
+        char* head;
+        char* tail;
+    };
+
+    struct SizeClass {
+        SizeClass() : mu(), free_list(NULL), cur(NULL), end(NULL), pending(), chunks() {}
+        SpinMutex mu;
+        char* free_list;
+        char* cur;
+        char* end;
+        std::deque<PendingList> pending;
+        std::vector<char*> chunks;
+    };
+
+    // kept in the first kClassGranularity bytes of a chunk, live_cnt counts the
+    // slots of the chunk held by callers or waiting for reclaim
+    struct ChunkHeader {
+        uint32_t live_cnt;
+    };
+
+    static inline uint32_t AlignUp(uint32_t size) {
+        return (size + kClassGranularity - 1) / kClassGranularity * kClassGranularity;
+    }
+
+    // a power of two, so that the chunk of a slot is found by masking its address
+    static uint32_t ChunkSize(uint32_t max_slab_size, uint32_t chunk_size) {
+        uint32_t min_size = std::max(chunk_size, max_slab_size + kClassGranularity);
+        uint32_t size = kClassGranularity;
+        while (size < min_size) {
+            size <<= 1;
+        }
+        return size;
+    }
+
+    inline ChunkHeader* GetChunkHeader(char* slot) const {
+        return reinterpret_cast<ChunkHeader*>(reinterpret_cast<uintptr_t>(slot) &
+                                              ~static_cast<uintptr_t>(chunk_size_ - 1));
+    }
+
+    char* NewChunk() {
+        void* chunk = NULL;
+        if (posix_memalign(&chunk, chunk_size_, chunk_size_) != 0) {
+            throw std::bad_alloc();
+        }
+        reinterpret_cast<ChunkHeader*>(chunk)->live_cnt = 0;
+        reserved_byte_size_.fetch_add(chunk_size_, std::memory_order_relaxed);
+        chunk_cnt_.fetch_add(1, std::memory_order_relaxed);
+        return reinterpret_cast<char*>(chunk);
+    }
+
+    // drop the slots of the chunks without live slots from the free list and give
+    // the chunks back to the system, run under the lock of the class
+    void ReleaseEmptyChunks(SizeClass* sc) {
+        char** link = &sc->free_list;
+        while (*link != NULL) {
+            char* slot = *link;
+            if (GetChunkHeader(slot)->live_cnt == 0) {
+                *link = *reinterpret_cast<char**>(slot);
+            } else {
+                link = reinterpret_cast<char**>(slot);
+            }
+        }
+        auto it = sc->chunks.begin();
+        while (it != sc->chunks.end()) {
+            char* chunk = *it;
+            if (reinterpret_cast<ChunkHeader*>(chunk)->live_cnt != 0) {
+                ++it;
+                continue;
+            }
+            if (sc->cur != NULL && GetChunkHeader(sc->cur - 1) == reinterpret_cast<ChunkHeader*>(chunk)) {
+                sc->cur = NULL;
+                sc->end = NULL;
+            }
+            free(chunk);
+            reserved_byte_size_.fetch_sub(chunk_size_, std::memory_order_relaxed);
+            chunk_cnt_.fetch_sub(1, std::memory_order_relaxed);
+            it = sc->chunks.erase(it);
+        }
+    }
+
+ private:
+    uint32_t const max_slab_size_;
+    uint32_t const chunk_size_;
+    std::vector<SizeClass> classes_;
+    std::atomic<uint64_t> epoch_;
+    std::atomic<uint64_t> chunk_cnt_;
+    std::atomic<uint64_t> reserved_byte_size_;
+    std::atomic<uint64_t> used_byte_size_;
+    std::atomic<uint64_t> pending_byte_size_;
+};
+
+}  // namespace base
+}  // namespace openmldb
+
+#endif  // SRC_BASE_SLAB_ALLOCATOR_H_
@@ -0,0 +1,170 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "base/slab_allocator.h"
+
+#include <string.h>
+
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace openmldb {
+namespace base {
+
+class SlabAllocatorTest : public ::testing::Test {
+ public:
+    SlabAllocatorTest() {}
+    ~SlabAllocatorTest() {}
+};
+
+TEST_F(SlabAllocatorTest, AllocAndFree) {
+    SlabAllocator slab(128, 1024);
+    ASSERT_TRUE(slab.IsSlabSize(1));
+    ASSERT_TRUE(slab.IsSlabSize(128));
+    ASSERT_FALSE(slab.IsSlabSize(129));
+    ASSERT_FALSE(slab.IsSlabSize(0));
+    char* a = slab.Alloc(10);
+    char* b = slab.Alloc(16);
+    memcpy(a, "0123456789", 10);
+    memcpy(b, "abcdefghijklmnop", 16);
+    ASSERT_EQ(0, memcmp(a, "0123456789", 10));
+    ASSERT_EQ(0, memcmp(b, "abcdefghijklmnop", 16));
+    ASSERT_EQ(1u, slab.GetChunkCnt());
+    ASSERT_EQ(1024u, slab.GetReservedByteSize());
+    ASSERT_EQ(32u, slab.GetUsedByteSize());
+    // larger than the max slab size falls back to heap
+    char* c = slab.Alloc(256);
+    ASSERT_EQ(32u, slab.GetUsedByteSize());
+    slab.Free(c, 256);
+    slab.Free(a, 10);
+    slab.Free(b, 16);
+    ASSERT_EQ(0u, slab.GetUsedByteSize());
+    ASSERT_EQ(32u, slab.GetPendingByteSize());
+}
+
+TEST_F(SlabAllocatorTest, Reclaim) {
+    SlabAllocator slab(128, 1024);
+    char* a = slab.Alloc(16);
+    slab.Free(a, 16);
+    // not reclaimed yet, the slot can not be reused
+    char* b = slab.Alloc(16);
+    ASSERT_NE(a, b);
+    uint64_t epoch = slab.IncrEpoch();
+    ASSERT_EQ(1u, epoch);
+    slab.Free(b, 16);
+    ASSERT_EQ(16u, slab.Reclaim(0));
+    ASSERT_EQ(16u, slab.GetPendingByteSize());
+    char* c = slab.Alloc(16);
+    ASSERT_EQ(a, c);
+    ASSERT_EQ(16u, slab.Reclaim(epoch));
+    ASSERT_EQ(0u, slab.GetPendingByteSize());
+    char* d = slab.Alloc(16);
+    ASSERT_EQ(b, d);
+    slab.Free(c, 16);
+    slab.Free(d, 16);
+}
+
+TEST_F(SlabAllocatorTest, MultiChunk) {
+    // a chunk of 256 bytes holds 3 slots of 64 bytes after its header
+    SlabAllocator slab(64, 256);
+    std::vector<char*> slots;
+    for (int i = 0; i < 10; i++) {
+        slots.push_back(slab.Alloc(64));
+    }
+    ASSERT_EQ(4u, slab.GetChunkCnt());
+    ASSERT_EQ(640u, slab.GetUsedByteSize());
+    for (char* slot : slots) {
+        slab.Free(slot, 64);
+    }
+    slab.Reclaim(slab.GetEpoch());
+    slots.clear();
+    for (int i = 0; i < 10; i++) {
+        slots.push_back(slab.Alloc(64));
+    }
+    ASSERT_EQ(4u, slab.GetChunkCnt());
+    for (char* slot : slots) {
+        slab.Free(slot, 64);
+    }
+}
+
+TEST_F(SlabAllocatorTest, ReleaseEmptyChunk) {
+    SlabAllocator slab(64, 256);
+    std::vector<char*> slots;
+    for (int i = 0; i < 9; i++) {
+        slots.push_back(slab.Alloc(64));
+    }
+    ASSERT_EQ(3u, slab.GetChunkCnt());
+    ASSERT_EQ(768u, slab.GetReservedByteSize());
+    // the chunk of the last slot is not empty until the slot is reclaimed
+    for (int i = 0; i < 8; i++) {
+        slab.Free(slots[i], 64);
+    }
+    ASSERT_EQ(3u, slab.GetChunkCnt());
+    slab.Reclaim(slab.IncrEpoch());
+    ASSERT_EQ(1u, slab.GetChunkCnt());
+    ASSERT_EQ(256u, slab.GetReservedByteSize());
+    // the free slots of the released chunks are not handed out again
+    char* a = slab.Alloc(64);
+    char* b = slab.Alloc(64);
+    ASSERT_EQ(1u, slab.GetChunkCnt());
+    ASSERT_TRUE(a == slots[6] || a == slots[7]);
+    ASSERT_TRUE(b == slots[6] || b == slots[7]);
+    memset(a, 1, 64);
+    memset(b, 2, 64);
+    slab.Free(a, 64);
+    slab.Free(b, 64);
+    slab.Free(slots[8], 64);
+    slab.Reclaim(slab.IncrEpoch());
+    ASSERT_EQ(0u, slab.GetChunkCnt());
+    ASSERT_EQ(0u, slab.GetReservedByteSize());
+    char* c = slab.Alloc(64);
+    ASSERT_EQ(1u, slab.GetChunkCnt());
+    slab.Free(c, 64);
+}
+
+TEST_F(SlabAllocatorTest, Concurrent) {
+    SlabAllocator slab(256, 4096);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&slab, t]() {
+            for (int i = 0; i < 10000; i++) {
+                uint32_t size = (i + t) % 256 + 1;
+                char* slot = slab.Alloc(size);
+                memset(slot, t, size);
+                slab.Free(slot, size);
+                if (i % 1000 == 0) {
+                    slab.Reclaim(slab.IncrEpoch());
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    ASSERT_EQ(0u, slab.GetUsedByteSize());
+    slab.Reclaim(slab.IncrEpoch());
+    ASSERT_EQ(0u, slab.GetChunkCnt());
+}
+
+}  // namespace base
+}  // namespace openmldb
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -86,6 +86,10 @@ enum ReturnCode {
     kProcedureAlreadyExists = 157,
     kProcedureNotFound = 158,
     kCreateFunctionFailed = 159,
+    kLogIndexMismatch = 160,
+    // the put or delete is applied to the table but its entry is not in the binlog, so it is
+    // not on the followers and lost on restart. a retry may apply it again
+    kAppliedNotReplicated = 161,
     kNameserverIsNotLeader = 300,
     kAutoFailoverIsEnabled = 301,
     kEndpointIsNotExist = 302,
@@ -503,7 +503,8 @@ RowView::RowView(const Schema& schema)
       size_(0),
       row_(NULL),
       schema_(schema),
-      offset_vec_() {
+      offset_vec_(),
+      dict_(NULL) {
     Init();
 }
 
@@ -515,7 +516,8 @@ RowView::RowView(const Schema& schema, const int8_t* row, uint32_t size)
       size_(size),
       row_(row),
       schema_(schema),
-      offset_vec_() {
+      offset_vec_(),
+      dict_(NULL) {
     if (schema_.size() == 0) {
         is_valid_ = false;
         return;
@@ -836,8 +838,12 @@ int32_t RowView::GetValue(const int8_t* row, uint32_t idx, char** val, uint32_t*
     if (offset_vec_.at(idx) < string_field_cnt_ - 1) {
         next_str_field_offset = field_offset + 1;
     }
-    return v1::GetStrField(row, field_offset, next_str_field_offset, str_field_start_offset_, GetAddrLength(size),
-                           reinterpret_cast<int8_t**>(val), length);
+    int32_t ret = v1::GetStrField(row, field_offset, next_str_field_offset, str_field_start_offset_,
+                                  GetAddrLength(size), reinterpret_cast<int8_t**>(val), length);
+    if (ret == 0 && IsDictRow(row)) {
+        return GetDictString(row, size, idx, val, length);
+    }
+    return ret;
 }
 
 int32_t RowView::GetString(uint32_t idx, char** val, uint32_t* length) const {
@@ -856,8 +862,150 @@ int32_t RowView::GetString(uint32_t idx, char** val, uint32_t* length) const {
     if (offset_vec_.at(idx) < string_field_cnt_ - 1) {
         next_str_field_offset = field_offset + 1;
     }
-    return v1::GetStrField(row_, field_offset, next_str_field_offset, str_field_start_offset_, str_addr_length_,
-                           reinterpret_cast<int8_t**>(val), length);
+    int32_t ret = v1::GetStrField(row_, field_offset, next_str_field_offset, str_field_start_offset_,
+                                  str_addr_length_, reinterpret_cast<int8_t**>(val), length);
+    if (ret == 0 && IsDictRow(row_)) {
+        return GetDictString(row_, size_, idx, val, length);
+    }
+    return ret;
+}
+
+int32_t RowView::GetDictString(const int8_t* row, uint32_t size, uint32_t idx, char** val, uint32_t* length) const {
+    uint32_t pos = offset_vec_.at(idx);
+    uint32_t map_size = BitMapSize(string_field_cnt_);
+    if (pos == string_field_cnt_ - 1) {
+        // the coded bitmap follows the last string field
+        if (*length < map_size) {
+            return -1;
+        }
+        *length -= map_size;
+    }
+    const uint8_t* coded_map = reinterpret_cast<const uint8_t*>(row + size - map_size);
+    if ((coded_map[pos >> 3] & (1 << (pos & 0x07))) == 0) {
+        return 0;
+    }
+    if (dict_ == NULL || *length != sizeof(uint32_t)) {
+        return -1;
+    }
+    uint32_t code = 0;
+    memcpy(&code, *val, sizeof(uint32_t));
+    const char* str = NULL;
+    if (!dict_->Decode(idx, code, &str, length)) {
+        return -1;
+    }
+    *val = const_cast<char*>(str);
+    return 0;
+}
+
+bool RowView::EncodeDictRow(const int8_t* row, const std::vector<uint32_t>& codes, std::string* out) const {
+    if (row == NULL || out == NULL || IsDictRow(row) || codes.size() != (uint64_t)schema_.size() ||
+        string_field_cnt_ == 0) {
+        return false;
+    }
+    std::vector<std::pair<const char*, uint32_t>> strs(string_field_cnt_, std::make_pair("", 0));
+    std::string coded_map(BitMapSize(string_field_cnt_), 0);
+    bool coded = false;
+    for (int32_t idx = 0; idx < schema_.size(); idx++) {
+        const ::openmldb::common::ColumnDesc& column = schema_.Get(idx);
+        if (column.data_type() != ::openmldb::type::kVarchar && column.data_type() != ::openmldb::type::kString) {
+            continue;
+        }
+        if (IsNULL(row, idx)) {
+            continue;
+        }
+        uint32_t pos = offset_vec_[idx];
+        if (codes[idx] != NO_DICT_CODE) {
+            strs[pos] = std::make_pair(reinterpret_cast<const char*>(&codes[idx]), sizeof(uint32_t));
+            coded_map[pos >> 3] |= 1 << (pos & 0x07);
+            coded = true;
+            continue;
+        }
+        char* val = NULL;
+        uint32_t length = 0;
+        if (GetValue(row, idx, &val, &length) != 0) {
+            return false;
+        }
+        strs[pos] = std::make_pair(val, length);
+    }
+    if (!coded) {
+        return false;
+    }
+    return BuildRow(row, DICT_FORMAT_VERSION, strs, &coded_map, out);
+}
+
+bool RowView::DecodeDictRow(const int8_t* row, std::string* out) const {
+    if (row == NULL || out == NULL || !IsDictRow(row) || string_field_cnt_ == 0) {
+        return false;
+    }
+    std::vector<std::pair<const char*, uint32_t>> strs(string_field_cnt_, std::make_pair("", 0));
+    for (int32_t idx = 0; idx < schema_.size(); idx++) {
+        const ::openmldb::common::ColumnDesc& column = schema_.Get(idx);
+        if (column.data_type() != ::openmldb::type::kVarchar && column.data_type() != ::openmldb::type::kString) {
+            continue;
+        }
+        if (IsNULL(row, idx)) {
+            continue;
+        }
+        char* val = NULL;
+        uint32_t length = 0;
+        if (GetValue(row, idx, &val, &length) != 0) {
+            return false;
+        }
+        strs[offset_vec_[idx]] = std::make_pair(val, length);
+    }
+    return BuildRow(row, 1, strs, NULL, out);
+}
+
+// copy the header and the fixed fields of row, then lay the strings out as RowBuilder does
+bool RowView::BuildRow(const int8_t* row, uint8_t format, const std::vector<std::pair<const char*, uint32_t>>& strs,
+                       const std::string* coded_map, std::string* out) const {
+    uint64_t total_size = str_field_start_offset_;
+    for (const auto& str : strs) {
+        total_size += str.second;
+    }
+    if (coded_map != NULL) {
+        total_size += coded_map->size();
+    }
+    if (total_size + string_field_cnt_ <= UINT8_MAX) {
+        total_size += string_field_cnt_;
+    } else if (total_size + string_field_cnt_ * 2 <= UINT16_MAX) {
+        total_size += string_field_cnt_ * 2;
+    } else if (total_size + string_field_cnt_ * 3 <= UINT24_MAX) {
+        total_size += string_field_cnt_ * 3;
+    } else if (total_size + string_field_cnt_ * 4 <= UINT32_MAX) {
+        total_size += string_field_cnt_ * 4;
+    } else {
+        return false;
+    }
+    out->resize(total_size);
+    int8_t* buf = reinterpret_cast<int8_t*>(&((*out)[0]));
+    memcpy(buf, row, str_field_start_offset_);
+    *(reinterpret_cast<uint8_t*>(buf)) = format;
+    *(reinterpret_cast<uint32_t*>(buf + VERSION_LENGTH)) = total_size;
+    uint8_t addr_length = GetAddrLength(total_size);
+    uint32_t str_offset = str_field_start_offset_ + addr_length * string_field_cnt_;
+    for (uint32_t pos = 0; pos < string_field_cnt_; pos++) {
+        int8_t* ptr = buf + str_field_start_offset_ + addr_length * pos;
+        if (addr_length == 1) {
+            *(reinterpret_cast<uint8_t*>(ptr)) = (uint8_t)str_offset;
+        } else if (addr_length == 2) {
+            *(reinterpret_cast<uint16_t*>(ptr)) = (uint16_t)str_offset;
+        } else if (addr_length == 3) {
+            *(reinterpret_cast<uint8_t*>(ptr)) = str_offset >> 16;
+            *(reinterpret_cast<uint8_t*>(ptr + 1)) = (str_offset & 0xFF00) >> 8;
+            *(reinterpret_cast<uint8_t*>(ptr + 2)) = str_offset & 0x00FF;
+        } else {
+            *(reinterpret_cast<uint32_t*>(ptr)) = str_offset;
+        }
+        if (strs[pos].second > 0) {
+            memcpy(buf + str_offset, strs[pos].first, strs[pos].second);
+        }
+        str_offset += strs[pos].second;
+    }
+    if (coded_map != NULL) {
+        memcpy(buf + str_offset, coded_map->data(), coded_map->size());
+    }
+    return true;
 }
 
 int32_t RowView::GetStrValue(uint32_t idx, std::string* val) const { return GetStrValue(row_, idx, val); }
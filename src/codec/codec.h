@@ -40,6 +40,9 @@ static constexpr uint8_t VERSION_LENGTH = 2;
 static constexpr uint8_t SIZE_LENGTH = 4;
 static constexpr uint8_t HEADER_LENGTH = VERSION_LENGTH + SIZE_LENGTH;
 static constexpr uint32_t UINT24_MAX = (1 << 24) - 1;
+// the format version of the rows whose string fields are coded by a StringDictReader
+static constexpr uint8_t DICT_FORMAT_VERSION = 2;
+static constexpr uint32_t NO_DICT_CODE = UINT32_MAX;
 
 struct RowContext;
 class RowBuilder;
@@ -49,6 +52,18 @@ class RowProject;
 // TODO(wangtaize) share the row codec context
 struct RowContext {};
 
+// A dictionary coded row has the layout of a plain row, but a coded string field holds
+// the 4 bytes code of its value, and the bitmap of the coded string fields is appended
+// after the last string field
+class StringDictReader {
+ public:
+    virtual ~StringDictReader() {}
+    // the value of code in the dictionary of column idx
+    virtual bool Decode(uint32_t idx, uint32_t code, const char** val, uint32_t* length) const = 0;
+};
+
+inline bool IsDictRow(const int8_t* row) { return *(reinterpret_cast<const uint8_t*>(row)) == DICT_FORMAT_VERSION; }
+
 class RowProject {
  public:
     RowProject(const std::map<int32_t, std::shared_ptr<Schema>>& vers_schema, const ProjectList& plist);
@@ -184,9 +199,20 @@ class RowView {
     int32_t GetStrValue(const int8_t* row, uint32_t idx, std::string* val) const;
     int32_t GetStrValue(uint32_t idx, std::string* val) const;
 
+    // the codes of the dictionary coded rows are resolved by dict
+    void SetStringDict(const StringDictReader* dict) { dict_ = dict; }
+    // code the string field idx of the plain row with codes[idx] unless it is NO_DICT_CODE,
+    // return false if no field is coded
+    bool EncodeDictRow(const int8_t* row, const std::vector<uint32_t>& codes, std::string* out) const;
+    // rebuild the plain row of a dictionary coded row
+    bool DecodeDictRow(const int8_t* row, std::string* out) const;
+
  private:
     bool Init();
     bool CheckValid(uint32_t idx, ::openmldb::type::DataType type) const;
+    int32_t GetDictString(const int8_t* row, uint32_t size, uint32_t idx, char** val, uint32_t* length) const;
+    bool BuildRow(const int8_t* row, uint8_t format, const std::vector<std::pair<const char*, uint32_t>>& strs,
+                  const std::string* coded_map, std::string* out) const;
 
  private:
     uint8_t str_addr_length_;
@@ -197,6 +223,7 @@ class RowView {
     const int8_t* row_;
     const Schema& schema_;
     std::vector<uint32_t> offset_vec_;
+    const StringDictReader* dict_;
 };
 
 namespace v1 {
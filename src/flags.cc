@@ -50,6 +50,10 @@ DEFINE_int32(gc_pool_size, 2, "the size of tablet gc thread pool");
 DEFINE_int32(gc_safe_offset, 1, "the safe offset of tablet gc in minute");
 DEFINE_uint64(gc_on_table_recover_count, 10000000, "make a gc on recover count");
 DEFINE_uint32(gc_deleted_pk_version_delta, 2, "config the gc version delta");
+DEFINE_bool(enable_gc_expire_index, false, "enable or disable the expire index for absolute ttl gc");
+DEFINE_uint32(gc_expire_index_bucket_ms, 60 * 1000, "config the time bucket of gc expire index in millisecond");
+DEFINE_uint32(gc_slice_key_cnt, 100000, "config the count of keys visited by gc between two pauses");
+DEFINE_uint32(gc_slice_sleep_ms, 0, "config the pause time between gc slices, 0 means no pause");
 DEFINE_double(mem_release_rate, 5, "specify memory release rate, which should be in 0 ~ 10");
 DEFINE_int32(task_pool_size, 3, "the size of tablet task thread pool");
 DEFINE_int32(io_pool_size, 2, "the size of tablet io task thread pool");
@@ -57,6 +61,15 @@ DEFINE_bool(use_name, false, "enable or disable use server name");
 DEFINE_string(data_dir, "./data", "the path of data dir");
 DEFINE_bool(enable_distsql, false, "enable or disable distribute sql");
 DEFINE_bool(enable_localtablet, true, "enable or disable local tablet opt when distribute sql circumstance");
+DEFINE_string(jit_object_cache_dir, "",
+              "the dir to keep the compiled objects of deployments, which restarted tablets load instead of "
+              "compiling again, empty disables the cache");
+DEFINE_uint32(jit_object_cache_max_mb, 1024,
+              "the max size in MB of the objects in jit_object_cache_dir, the least recently used objects are "
+              "removed beyond it, 0 means no limit");
+DEFINE_uint32(tiered_compile_threshold, 0,
+              "the times an ad-hoc batch query runs before it is compiled with aggressive optimizations in "
+              "background, the query is compiled without optimizations before it, 0 disables it");
 DEFINE_string(mini_window_size, "1d", "the default mini window size in pre-aggr table");
 
 // scan configuration
@@ -71,10 +84,16 @@ DEFINE_bool(binlog_notify_on_put, false, "config the sync log to follower strate
 DEFINE_bool(binlog_enable_crc, false, "enable crc");
 DEFINE_int32(binlog_coffee_time, 1000, "config the coffee time");
 DEFINE_int32(binlog_sync_wait_time, 100, "config the sync log wait time");
+DEFINE_uint32(binlog_sync_window_size, 1,
+              "the max count of append entries requests in flight to a follower, 1 waits for each of them");
 DEFINE_int32(binlog_sync_to_disk_interval, 20000, "config the interval of sync binlog to disk time");
 DEFINE_int32(binlog_delete_interval, 60000, "config the interval of delete binlog");
 DEFINE_int32(binlog_match_logoffset_interval, 1000, "config the interval of match log offset ");
 DEFINE_int32(binlog_name_length, 8, "binlog name length");
+DEFINE_bool(binlog_group_commit, false, "sync the binlog of the concurrent puts together before they return");
+DEFINE_int32(binlog_group_commit_max_size, 256, "the max count of entries synced together in group commit");
+DEFINE_uint32(binlog_ring_size, 0,
+              "the count of entries appended lately kept in memory for replication, 0 disables it");
 DEFINE_uint32(check_binlog_sync_progress_delta, 100000, "config the delta of check binlog sync progress");
 DEFINE_uint32(go_back_max_try_cnt, 10, "config max try time of go back");
 
@@ -103,7 +122,11 @@ DEFINE_int32(send_file_max_try, 3, "the max retry time when send file failed");
 DEFINE_int32(retry_send_file_wait_time_ms, 3000, "conf the wait time when retry send file");
 DEFINE_int32(stream_close_wait_time_ms, 1000, "the wait time before close stream");
 DEFINE_uint32(stream_block_size, 1 * 1204 * 1024, "config the write/read block size in streaming");
-DEFINE_int32(stream_bandwidth_limit, 10 * 1204 * 1024, "the limit bandwidth. Byte/Second");
+DEFINE_int32(stream_bandwidth_limit, 10 * 1204 * 1024,
+             "the limit bandwidth shared by the files sent together. Byte/Second");
+DEFINE_string(stream_compression, "off",
+              "the compression of the blocks sent in streaming, can be off, snappy. the receiver must support it");
+DEFINE_uint32(stream_send_file_concurrency, 1, "the count of the files sent concurrently in streaming");
 
 // if set 23, the task will execute 23:00 every day
 DEFINE_int32(make_snapshot_time, 23, "config the time to make snapshot");
@@ -114,6 +137,13 @@ DEFINE_uint32(make_snapshot_offline_interval, 60 * 60 * 24,
               "config tablet self makesnapshot when how long time do not "
               "makesnapshot from ns. unit is second");
 DEFINE_string(snapshot_compression, "off", "Type of snapshot compression, can be off, snappy, zlib");
+DEFINE_uint32(snapshot_format_version, 1,
+              "the format of the snapshot made, 1 is the log format, 2 is loaded by mmap and not compressed");
+DEFINE_uint32(snapshot_max_delta_num, 0,
+              "the max number of delta snapshots on the base snapshot, they are merged to a new base snapshot "
+              "once it is reached. 0 means to make the whole snapshot every time");
+DEFINE_bool(snapshot_dump_memtable, false,
+            "make the snapshot of memtable by dumping the rows in memory instead of replaying the binlog");
 DEFINE_int32(snapshot_pool_size, 1, "the size of tablet thread pool for making snapshot");
 
 DEFINE_uint32(load_index_max_wait_time, 120 * 60 * 1000, "config the max wait time of load index");
@@ -128,6 +158,22 @@ DEFINE_uint32(skiplist_max_height, 12, "the max height of skiplist");
 DEFINE_uint32(key_entry_max_height, 8, "the max height of key entry");
 DEFINE_uint32(latest_default_skiplist_height, 1, "the default height of skiplist for latest table");
 DEFINE_uint32(absolute_default_skiplist_height, 4, "the default height of skiplist for absolute table");
+DEFINE_bool(enable_memtable_slab, false, "enable or disable the slab allocator for memtable rows");
+DEFINE_uint32(memtable_slab_max_size, 2048, "config the max row size allocated from memtable slab");
+DEFINE_uint32(memtable_slab_chunk_size, 1024 * 1024, "config the chunk size of memtable slab");
+DEFINE_uint32(memtable_freeze_time, 0,
+              "config the time in second after which the rows of hot keys are frozen into blocks, 0 means disable");
+DEFINE_uint32(memtable_freeze_min_cnt, 10000, "config the min row count of a key to be frozen");
+DEFINE_bool(enable_memtable_block_compress, false, "enable or disable compressing the frozen rows of memtable");
+DEFINE_uint32(memtable_compress_block_cnt, 256, "config the max row count compressed together in a frozen block");
+DEFINE_bool(enable_memtable_key_index, false, "enable or disable the hash index of memtable keys for point lookups");
+DEFINE_bool(enable_memtable_segment_split, false, "enable or disable splitting the memtable segments of many keys");
+DEFINE_uint32(memtable_segment_split_max_depth, 2, "config the max times a memtable segment can be split, at most 8");
+DEFINE_uint32(memtable_segment_split_pk_cnt, 1000000, "config the key count of a memtable segment to be split");
+DEFINE_uint32(memtable_segment_split_wait_timeout, 600000,
+              "config the time in millisecond the split keys wait the key iterators before a warning is logged");
+DEFINE_bool(enable_memtable_string_dict, false, "enable or disable coding the repeated strings of memtable rows");
+DEFINE_uint32(memtable_string_dict_max_size, 65536, "config the max count of the strings coded for a column");
 DEFINE_bool(enable_show_tp, false, "enable show tp");
 DEFINE_uint32(max_col_display_length, 256, "config the max length of column display");
 
@@ -140,11 +186,16 @@ DEFINE_uint32(block_cache_mb, 4096,
 DEFINE_uint32(write_buffer_mb, 128, "Memtable size");
 DEFINE_uint32(block_cache_shardbits, 8, "Divide block cache into 2^8 shards to avoid cache contention");
 DEFINE_bool(verify_compression, false, "For debug");
+DEFINE_uint32(disk_bloom_bits_per_key, 10,
+              "Bits per key of the key prefix bloom filter in the sst files of disk tables, 0 disables the filter");
 
 // load table resouce control
 DEFINE_uint32(load_table_batch, 30, "set laod table batch size");
 DEFINE_uint32(load_table_thread_num, 3, "set load tabale thread pool size");
 DEFINE_uint32(load_table_queue_size, 1000, "set load tabale queue size");
+DEFINE_uint32(recover_binlog_thread_num, 0,
+              "the count of threads to replay binlog in recovery, 0 replays it in the recovering thread");
+DEFINE_uint32(recover_binlog_chunk_size, 10000, "the count of binlog records decoded together in recovery");
 
 // multiple data center
 DEFINE_uint32(get_replica_status_interval, 10000, "config the interval to sync replica cluster status time");
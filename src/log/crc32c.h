@@ -32,6 +32,10 @@ namespace log {
 // crc32c of a stream of data.
 extern uint32_t Extend(uint32_t init_crc, const char* data, size_t n);
 
+// Return true if Extend() runs on the SSE4.2 crc32 instruction rather than
+// the portable table driven implementation.
+extern bool IsHardwareAccelerated();
+
 // Return the crc32c of data[0,n-1]
 inline uint32_t Value(const char* data, size_t n) { return Extend(0, data, n); }
 
@@ -0,0 +1,126 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "log/crc32c.h"
+#include "log/log_reader.h"
+#include "log/log_writer.h"
+#include "log/sequential_file.h"
+#include "log/writable_file.h"
+
+namespace openmldb {
+namespace log {
+
+static const char* kCompressTypes[] = {"off", "snappy", "zlib"};
+
+static std::string LogPath(const char* compress_type) {
+    return "/tmp/openmldb_log_bm_" + std::to_string(getpid()) + "_" + compress_type + ".log";
+}
+
+static void BM_Crc32c(benchmark::State& state) {  // NOLINT
+    std::string data(state.range(0), 'x');
+    uint32_t crc = 0;
+    for (auto _ : state) {
+        crc = Extend(crc, data.data(), data.size());
+    }
+    benchmark::DoNotOptimize(crc);
+    state.SetBytesProcessed(state.iterations() * data.size());
+    state.SetLabel(IsHardwareAccelerated() ? "sse4.2" : "portable");
+}
+
+// range(0) is the record size, range(1) the index of the compress type and
+// range(2) the number of pieces each record is handed to the writer in
+static void BM_LogWrite(benchmark::State& state) {  // NOLINT
+    const char* compress_type = kCompressTypes[state.range(1)];
+    std::string path = LogPath(compress_type);
+    FILE* fd = fopen(path.c_str(), "wb");
+    WritableFile* wf = NewWritableFile(path, fd);
+    Writer* writer = new Writer(compress_type, wf);
+    std::string record(state.range(0), 'x');
+    std::vector<Slice> pieces;
+    size_t piece_size = record.size() / state.range(2);
+    for (int64_t i = 0; i < state.range(2); i++) {
+        size_t len = i + 1 == state.range(2) ? record.size() - i * piece_size : piece_size;
+        pieces.emplace_back(record.data() + i * piece_size, len);
+    }
+    for (auto _ : state) {
+        writer->AddRecord(pieces.data(), pieces.size());
+    }
+    state.SetBytesProcessed(state.iterations() * record.size());
+    state.SetLabel(compress_type);
+    delete writer;
+    delete wf;
+    unlink(path.c_str());
+}
+
+static void BM_LogRead(benchmark::State& state) {  // NOLINT
+    const char* compress_type = kCompressTypes[state.range(1)];
+    std::string path = LogPath(compress_type);
+    FILE* fd_w = fopen(path.c_str(), "wb");
+    WritableFile* wf = NewWritableFile(path, fd_w);
+    Writer* writer = new Writer(compress_type, wf);
+    std::string record(state.range(0), 'x');
+    for (int i = 0; i < 10000; i++) {
+        writer->AddRecord(record);
+    }
+    writer->EndLog();
+    delete writer;
+    delete wf;
+    FILE* fd_r = fopen(path.c_str(), "rb");
+    SequentialFile* rf = NewSeqFile(path, fd_r);
+    Reader reader(rf, NULL, true, 0, state.range(1) > 0);
+    std::string scratch;
+    Slice value;
+    for (auto _ : state) {
+        if (!reader.ReadRecord(&value, &scratch).ok()) {
+            state.PauseTiming();
+            reader.GoBackToStart();
+            state.ResumeTiming();
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * record.size());
+    state.SetLabel(compress_type);
+    delete rf;
+    unlink(path.c_str());
+}
+
+static void RecordArgs(benchmark::internal::Benchmark* b, bool with_pieces) {
+    for (int64_t record_size : {128, 4096, 65536}) {
+        for (int64_t compress_type = 0; compress_type < 3; compress_type++) {
+            if (with_pieces) {
+                b->Args({record_size, compress_type, 1});
+            } else {
+                b->Args({record_size, compress_type});
+            }
+        }
+    }
+}
+
+BENCHMARK(BM_Crc32c)->Arg(64)->Arg(1024)->Arg(32 * 1024)->Arg(1024 * 1024);
+BENCHMARK(BM_LogWrite)
+    ->Apply([](benchmark::internal::Benchmark* b) { RecordArgs(b, true); })
+    ->Args({4096, 0, 4})
+    ->Args({65536, 0, 4});
+BENCHMARK(BM_LogRead)->Apply([](benchmark::internal::Benchmark* b) { RecordArgs(b, false); });
+
+}  // namespace log
+}  // namespace openmldb
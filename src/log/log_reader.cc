@@ -446,6 +446,15 @@ LogReader::~LogReader() {
 
 void LogReader::SetOffset(uint64_t start_offset) { start_offset_ = start_offset; }
 
+void LogReader::Reset(uint64_t start_offset) {
+    delete reader_;
+    reader_ = NULL;
+    delete sf_;
+    sf_ = NULL;
+    log_part_index_ = -1;
+    start_offset_ = start_offset;
+}
+
 void LogReader::GoBackToLastBlock() {
     if (sf_ == NULL || reader_ == NULL) {
         return;
@@ -462,6 +471,21 @@ void LogReader::GoBackToStart() {
 
 int LogReader::GetLogIndex() { return log_part_index_; }
 
+int LogReader::GetLogIndex(uint64_t offset) {
+    LogParts::Iterator* it = logs_->NewIterator();
+    it->SeekToFirst();
+    int index = -1;
+    while (it->Valid()) {
+        if (it->GetValue() <= offset) {
+            index = (int)it->GetKey();  // NOLINT
+            break;
+        }
+        it->Next();
+    }
+    delete it;
+    return index;
+}
+
 uint64_t LogReader::GetLastRecordEndOffset() {
     if (reader_ == NULL) {
         PDLOG(WARNING, "reader is NULL");
@@ -159,9 +159,13 @@ class LogReader {
     void GoBackToLastBlock();
     void GoBackToStart();
     int GetLogIndex();
+    // get the index of the log part to read the entries after offset
+    int GetLogIndex(uint64_t offset);
     int GetEndLogIndex();
     uint64_t GetLastRecordEndOffset();
     void SetOffset(uint64_t start_offset);
+    // close the current log part and read from the one of start_offset
+    void Reset(uint64_t start_offset);
     LogReader(const LogReader&) = delete;
     LogReader& operator=(const LogReader&) = delete;
 
@@ -388,6 +388,73 @@ TEST_F(LogWRTest, TestGoBack) {
     ASSERT_EQ("hello", value3.ToString());
 }
 
+TEST_F(LogWRTest, TestCrc32c) {
+    char buf[32];
+    memset(buf, 0, sizeof(buf));
+    ASSERT_EQ(0x8a9136aau, Value(buf, sizeof(buf)));
+    memset(buf, 0xff, sizeof(buf));
+    ASSERT_EQ(0x62a8ab43u, Value(buf, sizeof(buf)));
+    for (int i = 0; i < 32; i++) {
+        buf[i] = i;
+    }
+    ASSERT_EQ(0x46dd794eu, Value(buf, sizeof(buf)));
+    // the striped path of long buffers must agree with extending byte by byte
+    std::string data;
+    for (int i = 0; i < 60000; i++) {
+        data.push_back(static_cast<char>(rand()));  // NOLINT
+    }
+    for (size_t offset : {0, 1, 5}) {
+        for (size_t len : {0, 7, 767, 768, 769, 24575, 24576, 24577, 55555}) {
+            uint32_t crc = 1;
+            for (size_t i = 0; i < len; i++) {
+                crc = Extend(crc, data.data() + offset + i, 1);
+            }
+            ASSERT_EQ(crc, Extend(1, data.data() + offset, len)) << "offset " << offset << " len " << len;
+        }
+    }
+}
+
+TEST_F(LogWRTest, TestAddRecordGather) {
+    std::string log_dir = "/tmp/" + GenRand() + "/";
+    ::openmldb::base::MkdirRecur(log_dir);
+    std::string fname = "test.log";
+    std::string full_path = GetWritePath(log_dir + "/" + fname);
+    FILE* fd_w = fopen(full_path.c_str(), "ab+");
+    ASSERT_TRUE(fd_w != NULL);
+    WritableFile* wf = NewWritableFile(fname, fd_w);
+    Writer writer(FLAGS_snapshot_compression, wf);
+    // pieces crossing the block boundaries, including empty ones
+    std::vector<std::string> records;
+    for (uint32_t i = 0; i < 20; i++) {
+        std::vector<std::string> parts{"head" + std::to_string(i), "", std::string(i * 997, 'a' + i % 26),
+                                       std::string(block_size_ + i, 'z'), "tail"};
+        std::vector<Slice> slices(parts.begin(), parts.end());
+        ASSERT_TRUE(writer.AddRecord(slices.data(), slices.size()).ok());
+        std::string record;
+        for (const auto& part : parts) {
+            record.append(part);
+        }
+        records.push_back(record);
+    }
+    ASSERT_TRUE(writer.AddRecord(nullptr, 0).ok());
+    records.push_back("");
+    if (FLAGS_snapshot_compression != "off") {
+        writer.EndLog();
+    }
+    FILE* fd_r = fopen(full_path.c_str(), "rb");
+    ASSERT_TRUE(fd_r != NULL);
+    SequentialFile* rf = NewSeqFile(fname, fd_r);
+    Reader reader(rf, NULL, true, 0, compressed_);
+    for (const auto& record : records) {
+        std::string scratch;
+        Slice value;
+        ASSERT_TRUE(reader.ReadRecord(&value, &scratch).ok());
+        ASSERT_EQ(record, value.ToString());
+    }
+    delete wf;
+    delete rf;
+}
+
 TEST_F(LogWRTest, TestInit) {
     std::string log_dir = "/tmp/" + GenRand() + "/";
     ::openmldb::base::MkdirRecur(log_dir);
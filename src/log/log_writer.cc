@@ -24,6 +24,8 @@
 #include <stdint.h>
 #include <zlib.h>
 
+#include <algorithm>
+
 #include "base/endianconv.h"
 #include "base/glog_wapper.h"  // NOLINT
 #include "log/coding.h"
@@ -126,9 +128,16 @@ Status Writer::EndLog() {
     return s;
 }
 
-Status Writer::AddRecord(const Slice& slice) {
-    const char* ptr = slice.data();
-    size_t left = slice.size();
+Status Writer::AddRecord(const Slice& slice) { return AddRecord(&slice, 1); }
+
+Status Writer::AddRecord(const Slice* slices, size_t cnt) {
+    size_t left = 0;
+    for (size_t i = 0; i < cnt; i++) {
+        left += slices[i].size();
+    }
+    // the next byte to emit is slices[idx].data()[pos]
+    size_t idx = 0;
+    size_t pos = 0;
 
     // Fragment the record if necessary and emit it.  Note that if slice
     // is empty, we still want to iterate once to emit a single
@@ -172,8 +181,19 @@ Status Writer::AddRecord(const Slice& slice) {
         } else {
             type = kMiddleType;
         }
-        s = EmitPhysicalRecord(type, ptr, fragment_length);
-        ptr += fragment_length;
+        fragment_.clear();
+        for (size_t need = fragment_length; need > 0;) {
+            if (pos == slices[idx].size()) {
+                idx++;
+                pos = 0;
+                continue;
+            }
+            const size_t len = std::min(slices[idx].size() - pos, need);
+            fragment_.emplace_back(slices[idx].data() + pos, len);
+            pos += len;
+            need -= len;
+        }
+        s = EmitPhysicalRecord(type, fragment_.data(), fragment_.size(), fragment_length);
         left -= fragment_length;
         begin = false;
     } while (s.ok() && left > 0);
@@ -181,6 +201,11 @@ Status Writer::AddRecord(const Slice& slice) {
 }
 
 Status Writer::EmitPhysicalRecord(RecordType t, const char* ptr, size_t n) {
+    Slice piece(ptr, n);
+    return EmitPhysicalRecord(t, &piece, 1, n);
+}
+
+Status Writer::EmitPhysicalRecord(RecordType t, const Slice* pieces, size_t cnt, size_t n) {
     if (compress_type_ == kNoCompress) {
         assert(n <= 0xffff);  // Must fit in two bytes
     } else {
@@ -202,18 +227,21 @@ Status Writer::EmitPhysicalRecord(RecordType t, const char* ptr, size_t n) {
         buf[8] = static_cast<char>(t);
     }
     // Compute the crc of the record type and the payload.
-    uint32_t crc = Extend(type_crc_[t], ptr, n);
+    uint32_t crc = type_crc_[t];
+    for (size_t i = 0; i < cnt; i++) {
+        crc = Extend(crc, pieces[i].data(), pieces[i].size());
+    }
     crc = Mask(crc);  // Adjust for storage
     EncodeFixed32(buf, crc);
 
     if (compress_type_ == kNoCompress) {
         // Write the header and the payload
         Status s = dest_->Append(Slice(buf, header_size_));
+        for (size_t i = 0; i < cnt && s.ok(); i++) {
+            s = dest_->Append(pieces[i]);
+        }
         if (s.ok()) {
-            s = dest_->Append(Slice(ptr, n));
-            if (s.ok()) {
-                s = dest_->Flush();
-            }
+            s = dest_->Flush();
         }
         if (!s.ok()) {
             PDLOG(WARNING, "write error. %s", s.ToString().c_str());
@@ -223,8 +251,11 @@ Status Writer::EmitPhysicalRecord(RecordType t, const char* ptr, size_t n) {
         return s;
     } else {
         memcpy(buffer_ + block_offset_, &buf, header_size_);
-        memcpy(buffer_ + block_offset_ + header_size_, ptr, n);
-        block_offset_ += header_size_ + n;
+        block_offset_ += header_size_;
+        for (size_t i = 0; i < cnt; i++) {
+            memcpy(buffer_ + block_offset_, pieces[i].data(), pieces[i].size());
+            block_offset_ += pieces[i].size();
+        }
         // fill the trailer if kEofType
         if (t == kEofType) {
             memset(buffer_ + block_offset_, 0, block_size_ - block_offset_);
@@ -24,6 +24,7 @@
 #include <stdint.h>
 
 #include <string>
+#include <vector>
 
 #include "base/slice.h"
 #include "log/status.h"
@@ -50,6 +51,10 @@ class Writer {
     ~Writer();
 
     Status AddRecord(const Slice& slice);
+    // Add one record made of the concatenation of slices[0, cnt). The
+    // pieces are framed in place, so the caller does not have to join them
+    // into a contiguous buffer first.
+    Status AddRecord(const Slice* slices, size_t cnt);
     Status EndLog();
 
     inline CompressType GetCompressType() { return compress_type_; }
@@ -79,7 +84,11 @@ class Writer {
     Status CompressRecord();
     Status AppendInternal(WritableFile* wf, int leftover);
 
+    // the pieces of the fragment being emitted, reused across records
+    std::vector<Slice> fragment_;
+
     Status EmitPhysicalRecord(RecordType type, const char* ptr, size_t length);
+    Status EmitPhysicalRecord(RecordType type, const Slice* pieces, size_t cnt, size_t length);
 
     // No copying allowed
     Writer(const Writer&);
@@ -98,6 +107,10 @@ struct WriteHandle {
 
     Status Write(const ::openmldb::base::Slice& slice) { return lw_->AddRecord(slice); }
 
+    Status Write(const std::vector<::openmldb::base::Slice>& slices) {
+        return lw_->AddRecord(slices.data(), slices.size());
+    }
+
     Status Sync() { return wf_->Sync(); }
 
     Status EndLog() { return lw_->EndLog(); }
@@ -35,6 +35,9 @@
 
 DECLARE_int32(binlog_single_file_max_size);
 DECLARE_int32(binlog_name_length);
+DECLARE_bool(binlog_group_commit);
+DECLARE_int32(binlog_group_commit_max_size);
+DECLARE_uint32(binlog_ring_size);
 DECLARE_string(zk_cluster);
 
 namespace openmldb {
@@ -59,8 +62,15 @@ LogReplicator::LogReplicator(uint32_t tid, uint32_t pid, const std::string& path
       term_(0),
       mu_(),
       cv_(),
-      wmu_() {
+      wmu_(),
+      offset_mu_(),
+      offset_cv_(),
+      offset_waiter_cnt_(0),
+      ring_() {
     binlog_index_ = 0;
+    if (FLAGS_binlog_ring_size > 0) {
+        ring_.reset(new LogRing(FLAGS_binlog_ring_size));
+    }
     snapshot_log_part_index_.store(-1, std::memory_order_relaxed);
     snapshot_last_offset_.store(0, std::memory_order_relaxed);
     follower_offset_.store(0);
@@ -109,7 +119,7 @@ bool LogReplicator::Init() {
         for (const auto& kv : real_ep_map_) {
             std::shared_ptr<ReplicateNode> replicate_node =
                 std::make_shared<ReplicateNode>(kv.first, logs_, log_path_, tid_, pid_, &term_,
-                                                &log_offset_, &mu_, &cv_, false, &follower_offset_, kv.second);
+                                                &log_offset_, &mu_, &cv_, false, &follower_offset_, kv.second, ring_.get());
             if (replicate_node->Init() < 0) {
                 PDLOG(WARNING, "init replicate node %s error", kv.first.c_str());
                 return false;
@@ -233,6 +243,26 @@ void LogReplicator::SetOffset(uint64_t offset) { log_offset_.store(offset, std::
 
 uint64_t LogReplicator::GetOffset() { return log_offset_.load(std::memory_order_relaxed); }
 
+uint64_t LogReplicator::WaitOffset(uint64_t offset, uint64_t timeout_ms) {
+    uint64_t end_time = ::baidu::common::timer::get_micros() + timeout_ms * 1000;
+    offset_waiter_cnt_.fetch_add(1, std::memory_order_relaxed);
+    // pairs with the fence in ApplyEntry
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    uint64_t cur_offset = 0;
+    {
+        std::unique_lock<bthread::Mutex> lock(offset_mu_);
+        while ((cur_offset = GetOffset()) < offset) {
+            uint64_t now = ::baidu::common::timer::get_micros();
+            if (now >= end_time) {
+                break;
+            }
+            offset_cv_.wait_for(lock, static_cast<int64_t>(end_time - now));
+        }
+    }
+    offset_waiter_cnt_.fetch_sub(1, std::memory_order_relaxed);
+    return cur_offset;
+}
+
 void LogReplicator::SetSnapshotLogPartIndex(uint64_t offset) {
     snapshot_last_offset_.store(offset, std::memory_order_relaxed);
     ::openmldb::log::LogReader log_reader(logs_, log_path_, false);
@@ -286,7 +316,10 @@ uint64_t LogReplicator::GetLeaderTerm() { return term_.load(std::memory_order_re
 
 void LogReplicator::SetLeaderTerm(uint64_t term) { term_.store(term, std::memory_order_relaxed); }
 
-bool LogReplicator::ApplyEntry(const LogEntry& entry) {
+bool LogReplicator::ApplyEntry(const LogEntry& entry, bool* applied) {
+    if (applied != NULL) {
+        *applied = false;
+    }
     std::lock_guard<std::mutex> lock(wmu_);
     uint64_t last_log_offset = GetOffset();
     if (wh_ == NULL || (wh_->GetSize() / (1024 * 1024)) > (uint32_t)FLAGS_binlog_single_file_max_size) {
@@ -308,7 +341,19 @@ bool LogReplicator::ApplyEntry(const LogEntry& entry) {
         PDLOG(WARNING, "fail to write replication log in dir %s for %s", path_.c_str(), status.ToString().c_str());
         return false;
     }
+    if (ring_) {
+        ring_->Put(entry.log_index(), buffer);
+    }
     log_offset_.store(entry.log_index(), std::memory_order_relaxed);
+    // pairs with the fence in WaitOffset, a waiter not seen here sees the offset
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (offset_waiter_cnt_.load(std::memory_order_relaxed) > 0) {
+        std::lock_guard<bthread::Mutex> offset_lock(offset_mu_);
+        offset_cv_.notify_all();
+    }
+    if (applied != NULL) {
+        *applied = true;
+    }
     DEBUGLOG("sync log entry to offset %lu for %s", GetOffset(), path_.c_str());
     return true;
 }
@@ -340,11 +385,11 @@ int LogReplicator::AddReplicateNode(const std::map<std::string, std::string>& re
         if (tid == UINT32_MAX) {
             replicate_node =
                 std::make_shared<ReplicateNode>(endpoint, logs_, log_path_, tid_, pid_, &term_,
-                                                &log_offset_, &mu_, &cv_, false, &follower_offset_, kv.second);
+                                                &log_offset_, &mu_, &cv_, false, &follower_offset_, kv.second, ring_.get());
         } else {
             replicate_node =
                 std::make_shared<ReplicateNode>(endpoint, logs_, log_path_, tid, pid_, &term_, &log_offset_,
-                                                &mu_, &cv_, true, &follower_offset_, kv.second);
+                                                &mu_, &cv_, true, &follower_offset_, kv.second, ring_.get());
         }
         if (replicate_node->Init() < 0) {
             PDLOG(WARNING, "init replicate node %s error", endpoint.c_str());
@@ -409,6 +454,22 @@ void LogReplicator::GetReplicateInfo(std::map<std::string, uint64_t>& info_map)
     }
 }
 
+uint64_t LogReplicator::GetReplicateLag() {
+    std::lock_guard<bthread::Mutex> lock(mu_);
+    if (role_ != kLeaderNode) {
+        return 0;
+    }
+    uint64_t offset = GetOffset();
+    uint64_t lag = 0;
+    for (const auto& node : nodes_) {
+        uint64_t sync_offset = node->GetLastSyncOffset();
+        if (offset > sync_offset) {
+            lag = std::max(lag, offset - sync_offset);
+        }
+    }
+    return lag;
+}
+
 bool LogReplicator::DelAllReplicateNode() {
     std::vector<std::shared_ptr<ReplicateNode>> copied_nodes = nodes_;
     {
@@ -431,7 +492,71 @@ bool LogReplicator::DelAllReplicateNode() {
 }
 
 bool LogReplicator::AppendEntry(LogEntry& entry) {
+    if (FLAGS_binlog_group_commit) {
+        return GroupAppendEntry(entry);
+    }
     std::lock_guard<std::mutex> lock(wmu_);
+    return WriteEntry(entry);
+}
+
+bool LogReplicator::GroupAppendEntry(LogEntry& entry) {
+    CommitWriter writer(&entry);
+    std::unique_lock<bthread::Mutex> lock(gmu_);
+    writers_.push_back(&writer);
+    while (!writer.done && &writer != writers_.front()) {
+        writer.cv.wait(lock);
+    }
+    if (writer.done) {
+        return writer.ok;
+    }
+    // the entries queued so far are written and synced together, the next group
+    // gathers while this one syncs
+    std::vector<CommitWriter*> group;
+    for (CommitWriter* w : writers_) {
+        group.push_back(w);
+        if (group.size() >= (uint32_t)FLAGS_binlog_group_commit_max_size) {
+            break;
+        }
+    }
+    lock.unlock();
+    bool ok = true;
+    {
+        std::lock_guard<std::mutex> wlock(wmu_);
+        for (CommitWriter* w : group) {
+            ok = ok && WriteEntry(*w->entry);
+            w->ok = ok;
+        }
+        if (ok && wh_ != NULL) {
+            uint64_t consumed = ::baidu::common::timer::get_micros();
+            ::openmldb::log::Status status = wh_->Sync();
+            if (!status.ok()) {
+                PDLOG(WARNING, "fail to sync data for path %s", path_.c_str());
+                for (CommitWriter* w : group) {
+                    w->ok = false;
+                }
+            }
+            consumed = ::baidu::common::timer::get_micros() - consumed;
+            if (consumed > 20000) {
+                PDLOG(INFO, "sync %lu entries to disk for path %s consumed %lld ms", group.size(), path_.c_str(),
+                      consumed / 1000);
+            }
+        }
+    }
+    lock.lock();
+    for (CommitWriter* w : group) {
+        writers_.pop_front();
+        w->done = true;
+        if (w != &writer) {
+            w->cv.notify_one();
+        }
+    }
+    if (!writers_.empty()) {
+        writers_.front()->cv.notify_one();
+    }
+    return writer.ok;
+}
+
+bool LogReplicator::WriteEntry(LogEntry& entry) {
     if (wh_ == NULL || wh_->GetSize() / (1024 * 1024) > (uint32_t)FLAGS_binlog_single_file_max_size) {
         bool ok = RollWLogFile();
         if (!ok) {
@@ -448,6 +573,9 @@ bool LogReplicator::AppendEntry(LogEntry& entry) {
         PDLOG(WARNING, "fail to write replication log in dir %s for %s", path_.c_str(), status.ToString().c_str());
         return false;
     }
+    if (ring_) {
+        ring_->Put(cur_offset + 1, buffer);
+    }
     log_offset_.fetch_add(1, std::memory_order_relaxed);
     if (local_endpoints_.empty()) {  // if local replica are dead, leader direct
                                      // sync to remote replica
@@ -458,9 +586,18 @@ bool LogReplicator::AppendEntry(LogEntry& entry) {
 
 bool LogReplicator::RollWLogFile() {
     if (wh_ != NULL) {
-        wh_->EndLog();
+        // EndLog writes out the pending compressed block, then the file is synced before
+        // it is closed, as a group commit may roll in the middle and only sync the new file
+        ::openmldb::log::Status status = wh_->EndLog();
+        if (status.ok()) {
+            status = wh_->Sync();
+        }
         delete wh_;
         wh_ = NULL;
+        if (!status.ok()) {
+            PDLOG(WARNING, "fail to end the write log for path %s: %s", path_.c_str(), status.ToString().c_str());
+            return false;
+        }
     }
     std::string name =
         ::openmldb::base::FormatToString(binlog_index_.load(std::memory_order_relaxed), FLAGS_binlog_name_length) +
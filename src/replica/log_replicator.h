@@ -19,6 +19,7 @@
 
 #include <atomic>
 #include <condition_variable>  // NOLINT
+#include <deque>
 #include <map>
 #include <memory>
 #include <mutex>  // NOLINT
@@ -60,10 +61,12 @@ class LogReplicator {
 
     bool StartSyncing();
 
-    // the slave node receives master log entries
-    bool ApplyEntry(const ::openmldb::api::LogEntry& entry);
+    // the slave node receives master log entries. applied is set to false if the
+    // entry is in the binlog already, e.g. written by a pipelined request before
+    bool ApplyEntry(const ::openmldb::api::LogEntry& entry, bool* applied = NULL);
 
-    // the master node append entry
+    // the master node append entry, the entry is synced to disk before it returns
+    // if binlog_group_commit is set
     bool AppendEntry(::openmldb::api::LogEntry& entry);  // NOLINT
 
     //  data to slave nodes
@@ -84,6 +87,9 @@ class LogReplicator {
 
     void GetReplicateInfo(std::map<std::string, uint64_t>& info_map);  // NOLINT
 
+    // the max count of entries not synced to a follower yet, 0 if not leader
+    uint64_t GetReplicateLag();
+
     void MatchLogOffset();
 
     void ReplicateToNode(const std::string& endpoint);
@@ -94,6 +100,9 @@ class LogReplicator {
 
     uint64_t GetOffset();
 
+    // wait until the entries up to offset are applied or timeout_ms passes, return the offset
+    uint64_t WaitOffset(uint64_t offset, uint64_t timeout_ms);
+
     LogParts* GetLogPart();
 
     inline uint64_t GetLogOffset() { return log_offset_.load(std::memory_order_relaxed); }
@@ -111,6 +120,20 @@ class LogReplicator {
  private:
     bool OpenSeqFile(const std::string& path, SequentialFile** sf);
 
+    // write an entry to the binlog, wmu_ must be held
+    bool WriteEntry(::openmldb::api::LogEntry& entry);  // NOLINT
+
+    // append with the entries of the concurrent puts and sync them once
+    bool GroupAppendEntry(::openmldb::api::LogEntry& entry);  // NOLINT
+
+    struct CommitWriter {
+        explicit CommitWriter(::openmldb::api::LogEntry* entry) : entry(entry), done(false), ok(false), cv() {}
+        ::openmldb::api::LogEntry* entry;
+        bool done;
+        bool ok;
+        bthread::ConditionVariable cv;
+    };
+
  private:
     // the replicator root data path
     uint32_t tid_;
@@ -137,6 +160,18 @@ class LogReplicator {
     std::atomic<uint64_t> snapshot_last_offset_;
 
     std::mutex wmu_;
+
+    // the puts waiting for a group commit, the first one writes for the others
+    bthread::Mutex gmu_;
+    std::deque<CommitWriter*> writers_;
+
+    // the pipelined requests waiting for the entries before them, signalled by ApplyEntry
+    bthread::Mutex offset_mu_;
+    bthread::ConditionVariable offset_cv_;
+    std::atomic<uint32_t> offset_waiter_cnt_;
+
+    // the entries appended lately for the replicate nodes, NULL if disabled
+    std::unique_ptr<LogRing> ring_;
 };
 
 }  // namespace replica
@@ -17,6 +17,7 @@
 #include "replica/log_replicator.h"
 
 #include <brpc/server.h>
+#include <gflags/gflags.h>
 #include <gtest/gtest.h>
 #include <sched.h>
 #include <stdio.h>
@@ -24,6 +25,8 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <set>
+#include <thread>  // NOLINT
 #include <utility>
 
 #include "base/glog_wapper.h"
@@ -46,6 +49,9 @@ using ::openmldb::storage::Table;
 using ::openmldb::storage::TableIterator;
 using ::openmldb::storage::Ticket;
 
+DECLARE_bool(binlog_group_commit);
+DECLARE_uint32(binlog_sync_window_size);
+
 namespace openmldb {
 namespace replica {
 
@@ -82,18 +88,31 @@ class MockTabletImpl : public ::openmldb::api::TabletServer {
 
     void AppendEntries(RpcController* controller, const ::openmldb::api::AppendEntriesRequest* request,
                        ::openmldb::api::AppendEntriesResponse* response, Closure* done) {
+        // the pipelined requests may arrive out of order
+        for (int i = 0; i < 1000 && request->pre_log_index() > replicator_.GetOffset(); i++) {
+            bthread_usleep(100);
+        }
         uint64_t last_log_offset = replicator_.GetOffset();
+        if (request->pre_log_index() > last_log_offset) {
+            response->set_code(::openmldb::base::ReturnCode::kLogIndexMismatch);
+            response->set_log_offset(last_log_offset);
+            done->Run();
+            return;
+        }
         for (int32_t i = 0; i < request->entries_size(); i++) {
             if (request->entries(i).log_index() <= last_log_offset) {
                 continue;
             }
             const auto& entry = request->entries(i);
-            if (!replicator_.ApplyEntry(entry)) {
+            bool applied = false;
+            if (!replicator_.ApplyEntry(entry, &applied)) {
                 response->set_code(::openmldb::base::ReturnCode::kFailToAppendEntriesToReplicator);
                 response->set_msg("fail to append entries to replicator");
                 return;
             }
-            table_->Put(entry);
+            if (applied) {
+                table_->Put(entry);
+            }
         }
         response->set_log_offset(replicator_.GetOffset());
         done->Run();
@@ -147,6 +166,107 @@ TEST_F(LogReplicatorTest, BenchMark) {
     ASSERT_TRUE(ok);
 }
 
+TEST_F(LogReplicatorTest, GroupCommit) {
+    FLAGS_binlog_group_commit = true;
+    std::map<std::string, std::string> map;
+    std::string folder = "/tmp/" + GenRand() + "/";
+    LogReplicator replicator(1, 1, folder, map, kLeaderNode);
+    ASSERT_TRUE(replicator.Init());
+    std::mutex mu;
+    std::set<uint64_t> indexes;
+    std::atomic<uint32_t> failed(0);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; i++) {
+        threads.emplace_back([&] {
+            for (int j = 0; j < 100; j++) {
+                ::openmldb::api::LogEntry entry;
+                entry.set_term(1);
+                entry.set_pk("test" + std::to_string(j));
+                entry.set_value("test");
+                entry.set_ts(9527);
+                if (!replicator.AppendEntry(entry)) {
+                    failed++;
+                    continue;
+                }
+                std::lock_guard<std::mutex> lock(mu);
+                indexes.insert(entry.log_index());
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    ASSERT_EQ(0u, failed.load());
+    ASSERT_EQ(400u, replicator.GetLogOffset());
+    // every entry gets its own index
+    ASSERT_EQ(400u, indexes.size());
+    ASSERT_EQ(1u, *indexes.begin());
+    ASSERT_EQ(400u, *indexes.rbegin());
+    FLAGS_binlog_group_commit = false;
+}
+
+TEST_F(LogReplicatorTest, LogRing) {
+    LogRing ring(4);
+    std::shared_ptr<std::string> record;
+    ASSERT_FALSE(ring.Get(1, &record));
+    for (uint64_t i = 1; i <= 6; i++) {
+        ring.Put(i, "entry" + std::to_string(i));
+    }
+    // the oldest ones are dropped
+    ASSERT_FALSE(ring.Get(2, &record));
+    for (uint64_t i = 3; i <= 6; i++) {
+        ASSERT_TRUE(ring.Get(i, &record));
+        ASSERT_EQ("entry" + std::to_string(i), *record);
+    }
+    ASSERT_FALSE(ring.Get(7, &record));
+    // restart on a gap
+    ring.Put(10, "entry10");
+    ASSERT_FALSE(ring.Get(6, &record));
+    ASSERT_TRUE(ring.Get(10, &record));
+    ASSERT_EQ("entry10", *record);
+}
+
+TEST_F(LogReplicatorTest, PipelineSync) {
+    FLAGS_binlog_sync_window_size = 4;
+    brpc::ServerOptions options;
+    brpc::Server server;
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx", 0));
+    std::shared_ptr<MemTable> table =
+        std::make_shared<MemTable>("test", 3, 1, 8, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime);
+    table->Init();
+    {
+        std::string follower_addr = "127.0.0.1:18530";
+        std::string folder = "/tmp/" + GenRand() + "/";
+        MockTabletImpl* follower = new MockTabletImpl(kFollowerNode, folder, g_endpoints, table);
+        ASSERT_TRUE(follower->Init());
+        ASSERT_EQ(0, server.AddService(follower, brpc::SERVER_OWNS_SERVICE));
+        ASSERT_EQ(0, server.Start(follower_addr.c_str(), &options));
+    }
+    std::string folder = "/tmp/" + GenRand() + "/";
+    LogReplicator leader(3, 1, folder, g_endpoints, kLeaderNode);
+    ASSERT_TRUE(leader.Init());
+    std::map<std::string, std::string> map;
+    map.insert(std::make_pair("127.0.0.1:18530", ""));
+    ASSERT_EQ(0, leader.AddReplicateNode(map));
+    for (int i = 0; i < 500; i++) {
+        ::openmldb::api::LogEntry entry;
+        ::openmldb::test::AddDimension(0, "test_pk", &entry);
+        entry.set_value(::openmldb::test::EncodeKV("test_pk", "value" + std::to_string(i)));
+        entry.set_ts(i + 1);
+        ASSERT_TRUE(leader.AppendEntry(entry));
+    }
+    leader.Notify();
+    for (int i = 0; i < 100 && leader.GetReplicateLag() > 0; i++) {
+        sleep(1);
+    }
+    ASSERT_EQ(0u, leader.GetReplicateLag());
+    leader.DelAllReplicateNode();
+    ASSERT_EQ(500u, table->GetRecordCnt());
+    server.Stop(10000);
+    FLAGS_binlog_sync_window_size = 1;
+}
+
 TEST_F(LogReplicatorTest, LeaderAndFollowerMulti) {
     brpc::ServerOptions options;
     brpc::Server server0;
@@ -21,10 +21,12 @@
 #include <algorithm>
 
 #include "base/glog_wapper.h"  // NOLINT
+#include "base/status.h"
 #include "base/strings.h"
 
 DECLARE_int32(binlog_sync_batch_size);
 DECLARE_int32(binlog_sync_wait_time);
+DECLARE_uint32(binlog_sync_window_size);
 DECLARE_int32(binlog_coffee_time);
 DECLARE_int32(binlog_match_logoffset_interval);
 DECLARE_int32(request_max_retry);
@@ -35,6 +37,29 @@ DECLARE_uint32(go_back_max_try_cnt);
 namespace openmldb {
 namespace replica {
 
+void LogRing::Put(uint64_t log_index, const std::string& record) {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (!queue_.empty() && log_index != start_ + queue_.size()) {
+        queue_.clear();
+    }
+    if (queue_.empty()) {
+        start_ = log_index;
+    } else if (queue_.full()) {
+        queue_.pop();
+        start_++;
+    }
+    queue_.put(std::make_shared<std::string>(record));
+}
+
+bool LogRing::Get(uint64_t log_index, std::shared_ptr<std::string>* record) {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (log_index < start_ || log_index >= start_ + queue_.size()) {
+        return false;
+    }
+    *record = queue_.at(log_index - start_);
+    return true;
+}
+
 static void* RunSyncTask(void* args) {
     if (args == NULL) {
         PDLOG(WARNING, "input args is null");
@@ -49,7 +74,7 @@ static void* RunSyncTask(void* args) {
 ReplicateNode::ReplicateNode(const std::string& point, LogParts* logs, const std::string& log_path, uint32_t tid,
                              uint32_t pid, std::atomic<uint64_t>* term, std::atomic<uint64_t>* leader_log_offset,
                              bthread::Mutex* mu, bthread::ConditionVariable* cv, bool rep_follower,
-                             std::atomic<uint64_t>* follower_offset, const std::string& real_point)
+                             std::atomic<uint64_t>* follower_offset, const std::string& real_point, LogRing* ring)
     : log_reader_(logs, log_path, false),
       cache_(),
       endpoint_(point),
@@ -66,7 +91,12 @@ ReplicateNode::ReplicateNode(const std::string& point, LogParts* logs, const std
       cv_(cv),
       go_back_cnt_(0),
       rep_node_(rep_follower),
-      follower_offset_(follower_offset) {
+      follower_offset_(follower_offset),
+      ring_(ring),
+      in_ring_(false),
+      pending_(),
+      pending_cnt_(0),
+      sent_offset_(0) {
     if (!real_point.empty()) {
         rpc_client_ = openmldb::RpcClient<::openmldb::api::TabletServer_Stub>(real_point);
     }
@@ -138,10 +168,20 @@ void ReplicateNode::SyncData() {
             coffee_time = FLAGS_binlog_coffee_time;
         }
     }
+    if (!pending_.empty()) {
+        ResetPending();
+    }
     PDLOG(INFO, "replicate log to endpoint %s for table #tid %u #pid %u exist", endpoint_.c_str(), tid_, pid_);
 }
 
-int ReplicateNode::GetLogIndex() { return log_reader_.GetLogIndex(); }
+int ReplicateNode::GetLogIndex() {
+    if (in_ring_.load(std::memory_order_relaxed) || pending_cnt_.load(std::memory_order_relaxed) > 0) {
+        // the binlog after the last synced entry is needed once the node falls behind the ring
+        // or the pending requests fail
+        return log_reader_.GetLogIndex(last_sync_offset_);
+    }
+    return log_reader_.GetLogIndex();
+}
 
 bool ReplicateNode::IsLogMatched() { return log_matched_; }
 
@@ -178,6 +218,9 @@ int ReplicateNode::SyncData(uint64_t log_offset) {
         PDLOG(WARNING, "log offset [%lu] le last sync offset [%lu], do nothing", log_offset, last_sync_offset_);
         return 1;
     }
+    if (FLAGS_binlog_sync_window_size > 1 || !pending_.empty()) {
+        return PipelineSyncData(log_offset);
+    }
     ::openmldb::api::AppendEntriesRequest request;
     ::openmldb::api::AppendEntriesResponse response;
     uint64_t sync_log_offset = last_sync_offset_;
@@ -206,68 +249,9 @@ int ReplicateNode::SyncData(uint64_t log_offset) {
         if (!FLAGS_zk_cluster.empty()) {
             request.set_term(term_->load(std::memory_order_relaxed));
         }
-        uint32_t batchSize = log_offset - last_sync_offset_;
-        batchSize = std::min(batchSize, (uint32_t)FLAGS_binlog_sync_batch_size);
-        for (uint64_t i = 0; i < batchSize;) {
-            std::string buffer;
-            ::openmldb::base::Slice record;
-            ::openmldb::log::Status status = log_reader_.ReadNextRecord(&record, &buffer);
-            if (status.ok()) {
-                ::openmldb::api::LogEntry* entry = request.add_entries();
-                if (!entry->ParseFromString(record.ToString())) {
-                    PDLOG(WARNING, "bad protobuf format %s size %ld. tid %u pid %u",
-                          ::openmldb::base::DebugString(record.ToString()).c_str(), record.ToString().size(), tid_,
-                          pid_);
-                    request.mutable_entries()->RemoveLast();
-                    break;
-                }
-                DEBUGLOG("entry val %s log index %lld", entry->value().c_str(), entry->log_index());
-                if (entry->log_index() <= sync_log_offset) {
-                    DEBUGLOG("skip duplicate log offset %lld", entry->log_index());
-                    request.mutable_entries()->RemoveLast();
-                    continue;
-                }
-                // the log index should incr by 1
-                if ((sync_log_offset + 1) != entry->log_index()) {
-                    PDLOG(WARNING, "log missing expect offset %lu but %ld. tid %u pid %u", sync_log_offset + 1,
-                          entry->log_index(), tid_, pid_);
-                    request.mutable_entries()->RemoveLast();
-                    if (go_back_cnt_ > FLAGS_go_back_max_try_cnt) {
-                        log_reader_.GoBackToStart();
-                        go_back_cnt_ = 0;
-                        PDLOG(WARNING, "go back to start. tid %u pid %u endpoint %s", tid_, pid_, endpoint_.c_str());
-                    } else {
-                        log_reader_.GoBackToLastBlock();
-                        go_back_cnt_++;
-                    }
-                    need_wait = true;
-                    break;
-                }
-                sync_log_offset = entry->log_index();
-            } else if (status.IsWaitRecord()) {
-                DEBUGLOG("got a coffee time for[%s]", endpoint_.c_str());
-                need_wait = true;
-                break;
-            } else if (status.IsInvalidRecord()) {
-                DEBUGLOG("fail to get record. %s. tid %u pid %u", status.ToString().c_str(), tid_, pid_);
-                need_wait = true;
-                if (go_back_cnt_ > FLAGS_go_back_max_try_cnt) {
-                    log_reader_.GoBackToStart();
-                    go_back_cnt_ = 0;
-                    PDLOG(WARNING, "go back to start. tid %u pid %u endpoint %s", tid_, pid_, endpoint_.c_str());
-                } else {
-                    log_reader_.GoBackToLastBlock();
-                    go_back_cnt_++;
-                }
-                break;
-            } else {
-                PDLOG(WARNING, "fail to get record: %s. tid %u pid %u", status.ToString().c_str(), tid_, pid_);
-                need_wait = true;
-                break;
-            }
-            i++;
-            go_back_cnt_ = 0;
-        }
+        uint32_t batch_size = log_offset - last_sync_offset_;
+        batch_size = std::min(batch_size, (uint32_t)FLAGS_binlog_sync_batch_size);
+        need_wait = ReadEntries(batch_size, &sync_log_offset, &request);
     }
     if (request.entries_size() > 0) {
         bool ret = rpc_client_.SendRequest(&::openmldb::api::TabletServer_Stub::AppendEntries, &request, &response,
@@ -282,6 +266,10 @@ int ReplicateNode::SyncData(uint64_t log_offset) {
             if (request_from_cache) {
                 cache_.clear();
             }
+        } else if (ret && response.code() == ::openmldb::base::ReturnCode::kLogIndexMismatch) {
+            cache_.clear();
+            HandleMismatch(response.log_offset());
+            need_wait = true;
         } else {
             if (!request_from_cache) {
                 cache_.push_back(request);
@@ -296,6 +284,209 @@ int ReplicateNode::SyncData(uint64_t log_offset) {
     return 0;
 }
 
+int ReplicateNode::PipelineSyncData(uint64_t log_offset) {
+    if (pending_.empty()) {
+        sent_offset_ = last_sync_offset_;
+    }
+    bool need_wait = false;
+    if (sent_offset_ < log_offset && pending_.size() < FLAGS_binlog_sync_window_size) {
+        ::openmldb::api::AppendEntriesRequest request;
+        request.set_tid(tid_);
+        request.set_pid(pid_);
+        request.set_pre_log_index(sent_offset_);
+        if (!FLAGS_zk_cluster.empty()) {
+            request.set_term(term_->load(std::memory_order_relaxed));
+        }
+        uint64_t sync_log_offset = sent_offset_;
+        uint32_t batch_size = std::min(log_offset - sent_offset_, (uint64_t)FLAGS_binlog_sync_batch_size);
+        need_wait = ReadEntries(batch_size, &sync_log_offset, &request);
+        if (request.entries_size() > 0) {
+            auto cntl = std::make_shared<brpc::Controller>();
+            cntl->set_timeout_ms(FLAGS_request_timeout_ms);
+            cntl->set_max_retry(FLAGS_request_max_retry);
+            auto response = std::make_shared<::openmldb::api::AppendEntriesResponse>();
+            auto callback = new AppendEntriesCallback(response, cntl);
+            // one reference is released when the call is done and the other once the response is read
+            callback->Ref();
+            if (!rpc_client_.SendRequest(&::openmldb::api::TabletServer_Stub::AppendEntries, cntl.get(), &request,
+                                         response.get(), callback)) {
+                delete callback;
+                PDLOG(WARNING, "fail to send log to node %s. tid %u pid %u", endpoint_.c_str(), tid_, pid_);
+                ResetPending();
+                return 1;
+            }
+            pending_.push_back({sync_log_offset, callback});
+            pending_cnt_.store(pending_.size(), std::memory_order_relaxed);
+            sent_offset_ = sync_log_offset;
+            DEBUGLOG("send log to node[%s] to offset %lu, pending %lu", endpoint_.c_str(), sent_offset_,
+                     pending_.size());
+            if (!need_wait && sent_offset_ < log_offset && pending_.size() < FLAGS_binlog_sync_window_size) {
+                return 0;
+            }
+        }
+    }
+    // the window is full or no more entry to send now, wait for the oldest request.
+    // all of them are waited for before a coffee time
+    while (!pending_.empty()) {
+        if (!AckPending()) {
+            ResetPending();
+            return 1;
+        }
+        if (!need_wait) {
+            break;
+        }
+    }
+    if (need_wait) {
+        return 1;
+    }
+    return 0;
+}
+
+bool ReplicateNode::AckPending() {
+    PendingRequest pending = pending_.front();
+    pending_.pop_front();
+    pending_cnt_.store(pending_.size(), std::memory_order_relaxed);
+    const std::shared_ptr<brpc::Controller>& cntl = pending.callback->GetController();
+    const std::shared_ptr<::openmldb::api::AppendEntriesResponse>& response = pending.callback->GetResponse();
+    brpc::Join(cntl->call_id());
+    bool ok = false;
+    if (cntl->Failed()) {
+        PDLOG(WARNING, "fail to sync log to node %s. error %s tid %u pid %u", endpoint_.c_str(),
+              cntl->ErrorText().c_str(), tid_, pid_);
+    } else if (response->code() == ::openmldb::base::ReturnCode::kLogIndexMismatch) {
+        HandleMismatch(response->log_offset());
+    } else if (response->code() != 0) {
+        PDLOG(WARNING, "fail to sync log to node %s. msg %s tid %u pid %u", endpoint_.c_str(),
+              response->msg().c_str(), tid_, pid_);
+    } else {
+        DEBUGLOG("sync log to node[%s] to offset %lu", endpoint_.c_str(), pending.end_offset);
+        last_sync_offset_ = pending.end_offset;
+        if (!rep_node_.load(std::memory_order_relaxed) &&
+            (last_sync_offset_ > follower_offset_->load(std::memory_order_relaxed))) {
+            follower_offset_->store(last_sync_offset_, std::memory_order_relaxed);
+        }
+        ok = true;
+    }
+    pending.callback->UnRef();
+    return ok;
+}
+
+void ReplicateNode::ResetPending() {
+    for (const auto& pending : pending_) {
+        brpc::Join(pending.callback->GetController()->call_id());
+        pending.callback->UnRef();
+    }
+    pending_.clear();
+    pending_cnt_.store(0, std::memory_order_relaxed);
+    // the requests after a failed one may be rejected, send them again
+    sent_offset_ = last_sync_offset_;
+    log_reader_.Reset(last_sync_offset_);
+    in_ring_.store(false, std::memory_order_relaxed);
+}
+
+void ReplicateNode::HandleMismatch(uint64_t follower_log_offset) {
+    PDLOG(WARNING, "node %s log offset %lu mismatch last sync offset %lu. tid %u pid %u", endpoint_.c_str(),
+          follower_log_offset, last_sync_offset_, tid_, pid_);
+    if (follower_log_offset < last_sync_offset_) {
+        last_sync_offset_ = follower_log_offset;
+    }
+    log_reader_.Reset(last_sync_offset_);
+    in_ring_.store(false, std::memory_order_relaxed);
+}
+
+bool ReplicateNode::ReadEntries(uint32_t batch_size, uint64_t* sync_log_offset,
+                                ::openmldb::api::AppendEntriesRequest* request) {
+    bool need_wait = false;
+    if (ring_ != NULL) {
+        ReadRing(batch_size, sync_log_offset, request);
+        if (request->entries_size() > 0) {
+            in_ring_.store(true, std::memory_order_relaxed);
+            batch_size = 0;
+        } else if (in_ring_.load(std::memory_order_relaxed)) {
+            // fall behind the ring, read the binlog from the last entry read
+            log_reader_.Reset(*sync_log_offset);
+            in_ring_.store(false, std::memory_order_relaxed);
+        }
+    }
+    for (uint64_t i = 0; i < batch_size;) {
+        std::string buffer;
+        ::openmldb::base::Slice record;
+        ::openmldb::log::Status status = log_reader_.ReadNextRecord(&record, &buffer);
+        if (status.ok()) {
+            ::openmldb::api::LogEntry* entry = request->add_entries();
+            if (!entry->ParseFromString(record.ToString())) {
+                PDLOG(WARNING, "bad protobuf format %s size %ld. tid %u pid %u",
+                      ::openmldb::base::DebugString(record.ToString()).c_str(), record.ToString().size(), tid_, pid_);
+                request->mutable_entries()->RemoveLast();
+                break;
+            }
+            DEBUGLOG("entry val %s log index %lld", entry->value().c_str(), entry->log_index());
+            if (entry->log_index() <= *sync_log_offset) {
+                DEBUGLOG("skip duplicate log offset %lld", entry->log_index());
+                request->mutable_entries()->RemoveLast();
+                continue;
+            }
+            // the log index should incr by 1
+            if ((*sync_log_offset + 1) != entry->log_index()) {
+                PDLOG(WARNING, "log missing expect offset %lu but %ld. tid %u pid %u", *sync_log_offset + 1,
+                      entry->log_index(), tid_, pid_);
+                request->mutable_entries()->RemoveLast();
+                if (go_back_cnt_ > FLAGS_go_back_max_try_cnt) {
+                    log_reader_.GoBackToStart();
+                    go_back_cnt_ = 0;
+                    PDLOG(WARNING, "go back to start. tid %u pid %u endpoint %s", tid_, pid_, endpoint_.c_str());
+                } else {
+                    log_reader_.GoBackToLastBlock();
+                    go_back_cnt_++;
+                }
+                need_wait = true;
+                break;
+            }
+            *sync_log_offset = entry->log_index();
+        } else if (status.IsWaitRecord()) {
+            DEBUGLOG("got a coffee time for[%s]", endpoint_.c_str());
+            need_wait = true;
+            break;
+        } else if (status.IsInvalidRecord()) {
+            DEBUGLOG("fail to get record. %s. tid %u pid %u", status.ToString().c_str(), tid_, pid_);
+            need_wait = true;
+            if (go_back_cnt_ > FLAGS_go_back_max_try_cnt) {
+                log_reader_.GoBackToStart();
+                go_back_cnt_ = 0;
+                PDLOG(WARNING, "go back to start. tid %u pid %u endpoint %s", tid_, pid_, endpoint_.c_str());
+            } else {
+                log_reader_.GoBackToLastBlock();
+                go_back_cnt_++;
+            }
+            break;
+        } else {
+            PDLOG(WARNING, "fail to get record: %s. tid %u pid %u", status.ToString().c_str(), tid_, pid_);
+            need_wait = true;
+            break;
+        }
+        i++;
+        go_back_cnt_ = 0;
+    }
+    return need_wait;
+}
+
+void ReplicateNode::ReadRing(uint32_t batch_size, uint64_t* sync_log_offset,
+                             ::openmldb::api::AppendEntriesRequest* request) {
+    for (uint32_t i = 0; i < batch_size; i++) {
+        std::shared_ptr<std::string> record;
+        if (!ring_->Get(*sync_log_offset + 1, &record)) {
+            break;
+        }
+        ::openmldb::api::LogEntry* entry = request->add_entries();
+        if (!entry->ParseFromString(*record) || entry->log_index() != *sync_log_offset + 1) {
+            PDLOG(WARNING, "bad entry in ring, expect offset %lu. tid %u pid %u", *sync_log_offset + 1, tid_, pid_);
+            request->mutable_entries()->RemoveLast();
+            break;
+        }
+        *sync_log_offset = entry->log_index();
+    }
+}
+
 void ReplicateNode::Stop() {
     is_running_.store(false, std::memory_order_relaxed);
     if (worker_ == 0) {
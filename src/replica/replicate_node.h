@@ -18,9 +18,13 @@
 #define SRC_REPLICA_REPLICATE_NODE_H_
 
 #include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>  // NOLINT
 #include <string>
 #include <vector>
 
+#include "base/ringqueue.h"
 #include "base/skiplist.h"
 #include "bthread/bthread.h"
 #include "bthread/condition_variable.h"
@@ -36,12 +40,33 @@ namespace replica {
 using ::openmldb::log::LogReader;
 typedef ::openmldb::base::Skiplist<uint32_t, uint64_t, ::openmldb::base::DefaultComparator> LogParts;
 
+// the serialized entries appended lately, the replicate nodes close to the leader
+// read them here instead of the binlog files
+class LogRing {
+ public:
+    explicit LogRing(uint32_t size) : mu_(), queue_(size), start_(0) {}
+    LogRing(const LogRing&) = delete;
+    LogRing& operator=(const LogRing&) = delete;
+
+    // the entries must be put by the order of log index, the ring restarts on a gap
+    void Put(uint64_t log_index, const std::string& record);
+
+    // return false if the entry is not in the ring
+    bool Get(uint64_t log_index, std::shared_ptr<std::string>* record);
+
+ private:
+    std::mutex mu_;
+    ::openmldb::base::RingQueue<std::shared_ptr<std::string>> queue_;
+    // the log index of the oldest entry
+    uint64_t start_;
+};
+
 class ReplicateNode {
  public:
     ReplicateNode(const std::string& point, LogParts* logs, const std::string& log_path, uint32_t tid, uint32_t pid,
                   std::atomic<uint64_t>* term, std::atomic<uint64_t>* leader_log_offset, bthread::Mutex* mu,
                   bthread::ConditionVariable* cv, bool rep_follower, std::atomic<uint64_t>* follower_offset,
-                  const std::string& real_point);
+                  const std::string& real_point, LogRing* ring = NULL);
     int Init();
 
     int Start();
@@ -72,6 +97,32 @@ class ReplicateNode {
  private:
     int MatchLogOffsetFromNode();
 
+    // add the entries after sync_log_offset in the ring to request
+    void ReadRing(uint32_t batch_size, uint64_t* sync_log_offset, ::openmldb::api::AppendEntriesRequest* request);
+
+    // add the entries after sync_log_offset in the ring or the binlog to request,
+    // return true if the binlog has no more record to read now
+    bool ReadEntries(uint32_t batch_size, uint64_t* sync_log_offset, ::openmldb::api::AppendEntriesRequest* request);
+
+    // send the requests without waiting for the responses while the window is not full
+    int PipelineSyncData(uint64_t log_offset);
+
+    // wait for the response of the oldest pending request, return false if it fails
+    bool AckPending();
+
+    // wait for all pending requests and read the binlog again from the last synced entry
+    void ResetPending();
+
+    // the follower has fewer entries than the request expects, sync from its offset
+    void HandleMismatch(uint64_t follower_log_offset);
+
+ private:
+    typedef ::openmldb::RpcCallback<::openmldb::api::AppendEntriesResponse> AppendEntriesCallback;
+    struct PendingRequest {
+        uint64_t end_offset;
+        AppendEntriesCallback* callback;
+    };
+
  private:
     LogReader log_reader_;
     std::vector<::openmldb::api::AppendEntriesRequest> cache_;
@@ -90,6 +141,14 @@ class ReplicateNode {
     uint32_t go_back_cnt_;
     std::atomic<bool> rep_node_;
     std::atomic<uint64_t>* follower_offset_;  // max local cluster follower offset
+    LogRing* ring_;
+    // the last entries are read from the ring, the log reader is behind
+    std::atomic<bool> in_ring_;
+    // the requests in flight by the order of log index
+    std::deque<PendingRequest> pending_;
+    std::atomic<uint32_t> pending_cnt_;
+    // the last entry sent, it is not less than last_sync_offset_
+    uint64_t sent_offset_;
 };
 
 }  // namespace replica
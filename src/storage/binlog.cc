@@ -16,6 +16,7 @@
 
 #include "storage/binlog.h"
 
+#include <algorithm>
 #include <map>
 #include <set>
 #include <utility>
@@ -25,6 +26,7 @@
 #include "base/hash.h"
 #include "base/kv_iterator.h"
 #include "base/strings.h"
+#include "boost/bind.hpp"
 #include "codec/schema_codec.h"
 #include "common/timer.h"
 #include "gflags/gflags.h"
@@ -33,10 +35,154 @@
 
 DECLARE_uint64(gc_on_table_recover_count);
 DECLARE_int32(binlog_name_length);
+DECLARE_uint32(load_table_batch);
+DECLARE_uint32(load_table_queue_size);
+DECLARE_uint32(recover_binlog_thread_num);
+DECLARE_uint32(recover_binlog_chunk_size);
 
 namespace openmldb {
 namespace storage {
 
+static const uint32_t SEED = 0xe17a1465;
+
+// return false if the entry is replayed already
+static bool CheckOffset(uint64_t cur_offset, const ::openmldb::api::LogEntry& entry, uint32_t tid, uint32_t pid) {
+    if (cur_offset >= entry.log_index()) {
+        DEBUGLOG("offset %lu has been made snapshot", entry.log_index());
+        return false;
+    }
+    if (cur_offset + 1 != entry.log_index()) {
+        PDLOG(WARNING,
+              "missing log entry cur_offset %lu , new entry offset %lu for "
+              "tid %u, pid %u",
+              cur_offset, entry.log_index(), tid, pid);
+    }
+    return true;
+}
+
+static void ReportProgress(const std::shared_ptr<Table>& table, uint64_t succ_cnt, uint64_t failed_cnt) {
+    if (succ_cnt % 100000 == 0) {
+        PDLOG(INFO,
+              "[Recover] load data from binlog succ_cnt %lu, failed_cnt "
+              "%lu for tid %u, pid %u",
+              succ_cnt, failed_cnt, table->GetId(), table->GetPid());
+    }
+    if (succ_cnt % FLAGS_gc_on_table_recover_count == 0) {
+        table->SchedGc();
+    }
+}
+
+BinlogReplayer::BinlogReplayer(std::shared_ptr<Table> table, uint32_t thread_num, uint32_t chunk_size)
+    : table_(table),
+      chunk_size_(chunk_size),
+      records_(),
+      decode_pool_(thread_num, thread_num),
+      workers_() {
+    records_.reserve(chunk_size_);
+    for (uint32_t i = 0; i < thread_num; i++) {
+        workers_.emplace_back(new ::openmldb::base::TaskPool(1, FLAGS_load_table_queue_size));
+    }
+}
+
+bool BinlogReplayer::Add(const ::openmldb::base::Slice& record) {
+    records_.emplace_back(record.data(), record.size());
+    return records_.size() >= chunk_size_;
+}
+
+void BinlogReplayer::Replay(uint64_t* cur_offset, uint64_t* succ_cnt, uint64_t* failed_cnt) {
+    if (records_.empty()) {
+        return;
+    }
+    uint32_t size = records_.size();
+    auto entries = std::make_shared<std::vector<::openmldb::api::LogEntry>>(size);
+    std::vector<char> parsed(size, 0);
+    uint32_t slice_size = (size + workers_.size() - 1) / workers_.size();
+    uint32_t slice_cnt = (size + slice_size - 1) / slice_size;
+    ::openmldb::base::CountDownLatch latch(slice_cnt);
+    for (uint32_t start = 0; start < size; start += slice_size) {
+        decode_pool_.AddTask(boost::bind(&BinlogReplayer::Decode, this, start, std::min(start + slice_size, size),
+                                         entries.get(), &parsed, &latch));
+    }
+    latch.Wait();
+    records_.clear();
+    uint32_t tid = table_->GetId();
+    uint32_t pid = table_->GetPid();
+    std::vector<std::vector<uint32_t>> batches(workers_.size());
+    for (uint32_t i = 0; i < size; i++) {
+        if (!parsed[i]) {
+            (*failed_cnt)++;
+            continue;
+        }
+        const ::openmldb::api::LogEntry& entry = (*entries)[i];
+        if (!CheckOffset(*cur_offset, entry, tid, pid)) {
+            continue;
+        }
+        if (entry.has_method_type() && entry.method_type() == ::openmldb::api::MethodType::kDelete) {
+            if (entry.dimensions_size() == 0) {
+                PDLOG(WARNING, "no dimesion. tid %u pid %u offset %lu", tid, pid, entry.log_index());
+            } else {
+                // the delete may remove the entries of other workers
+                Dispatch(entries, &batches);
+                Wait();
+                table_->Delete(entry.dimensions(0).key(), entry.dimensions(0).idx());
+            }
+        } else {
+            // sharded by the first dimension only, see BinlogReplayer
+            const std::string& key = entry.dimensions_size() > 0 ? entry.dimensions(0).key() : entry.pk();
+            std::vector<uint32_t>& batch = batches[::openmldb::base::hash(key.data(), key.size(), SEED) %
+                                                   batches.size()];
+            batch.push_back(i);
+            if (batch.size() >= FLAGS_load_table_batch) {
+                Dispatch(entries, &batches);
+            }
+        }
+        *cur_offset = entry.log_index();
+        (*succ_cnt)++;
+        ReportProgress(table_, *succ_cnt, *failed_cnt);
+    }
+    Dispatch(entries, &batches);
+}
+
+void BinlogReplayer::Wait() {
+    ::openmldb::base::CountDownLatch latch(workers_.size());
+    for (auto& worker : workers_) {
+        worker->AddTask(boost::bind(&::openmldb::base::CountDownLatch::CountDown, &latch));
+    }
+    latch.Wait();
+}
+
+void BinlogReplayer::Decode(uint32_t start, uint32_t end, std::vector<::openmldb::api::LogEntry>* entries,
+                            std::vector<char>* parsed, ::openmldb::base::CountDownLatch* latch) {
+    for (uint32_t i = start; i < end; i++) {
+        if ((*entries)[i].ParseFromString(records_[i])) {
+            (*parsed)[i] = 1;
+        } else {
+            PDLOG(WARNING, "fail parse record for tid %u, pid %u with value %s", table_->GetId(), table_->GetPid(),
+                  ::openmldb::base::DebugString(records_[i]).c_str());
+        }
+    }
+    latch->CountDown();
+}
+
+void BinlogReplayer::Put(std::shared_ptr<std::vector<::openmldb::api::LogEntry>> entries,
+                         std::vector<uint32_t> positions) {
+    for (uint32_t pos : positions) {
+        table_->Put((*entries)[pos]);
+    }
+}
+
+void BinlogReplayer::Dispatch(const std::shared_ptr<std::vector<::openmldb::api::LogEntry>>& entries,
+                              std::vector<std::vector<uint32_t>>* batches) {
+    for (uint32_t i = 0; i < batches->size(); i++) {
+        std::vector<uint32_t>& batch = (*batches)[i];
+        if (batch.empty()) {
+            continue;
+        }
+        workers_[i]->AddTask(boost::bind(&BinlogReplayer::Put, this, entries, batch));
+        batch.clear();
+    }
+}
+
 Binlog::Binlog(LogParts* log_part, const std::string& binlog_path) : log_part_(log_part), log_path_(binlog_path) {}
 
 bool Binlog::RecoverFromBinlog(std::shared_ptr<Table> table, uint64_t offset, uint64_t& latest_offset) {
@@ -53,6 +199,10 @@ bool Binlog::RecoverFromBinlog(std::shared_ptr<Table> table, uint64_t offset, ui
     uint64_t consumed = ::baidu::common::timer::now_time();
     int last_log_index = log_reader.GetLogIndex();
     bool reach_end_log = true;
+    std::unique_ptr<BinlogReplayer> replayer;
+    if (FLAGS_recover_binlog_thread_num > 0) {
+        replayer.reset(new BinlogReplayer(table, FLAGS_recover_binlog_thread_num, FLAGS_recover_binlog_chunk_size));
+    }
     while (true) {
         buffer.clear();
         ::openmldb::base::Slice record;
@@ -68,6 +218,10 @@ bool Binlog::RecoverFromBinlog(std::shared_ptr<Table> table, uint64_t offset, ui
                       tid, pid, cur_log_index, end_log_index, cur_offset);
                 continue;
             }
+            if (replayer) {
+                replayer->Replay(&cur_offset, &succ_cnt, &failed_cnt);
+                replayer->Wait();
+            }
             consumed = ::baidu::common::timer::now_time() - consumed;
             PDLOG(INFO,
                   "table tid %u pid %u completed, succ_cnt %lu, failed_cnt "
@@ -81,6 +235,10 @@ bool Binlog::RecoverFromBinlog(std::shared_ptr<Table> table, uint64_t offset, ui
                 last_log_index = log_reader.GetLogIndex();
                 continue;
             }
+            if (replayer) {
+                replayer->Replay(&cur_offset, &succ_cnt, &failed_cnt);
+                replayer->Wait();
+            }
             break;
         }
 
@@ -88,6 +246,12 @@ bool Binlog::RecoverFromBinlog(std::shared_ptr<Table> table, uint64_t offset, ui
             failed_cnt++;
             continue;
         }
+        if (replayer) {
+            if (replayer->Add(record)) {
+                replayer->Replay(&cur_offset, &succ_cnt, &failed_cnt);
+            }
+            continue;
+        }
         bool ok = entry.ParseFromString(record.ToString());
         if (!ok) {
             PDLOG(WARNING, "fail parse record for tid %u, pid %u with value %s", tid, pid,
@@ -96,18 +260,10 @@ bool Binlog::RecoverFromBinlog(std::shared_ptr<Table> table, uint64_t offset, ui
             continue;
         }
 
-        if (cur_offset >= entry.log_index()) {
-            DEBUGLOG("offset %lu has been made snapshot", entry.log_index());
+        if (!CheckOffset(cur_offset, entry, tid, pid)) {
             continue;
         }
 
-        if (cur_offset + 1 != entry.log_index()) {
-            PDLOG(WARNING,
-                  "missing log entry cur_offset %lu , new entry offset %lu for "
-                  "tid %u, pid %u",
-                  cur_offset, entry.log_index(), tid, pid);
-        }
-
         if (entry.has_method_type() && entry.method_type() == ::openmldb::api::MethodType::kDelete) {
             if (entry.dimensions_size() == 0) {
                 PDLOG(WARNING, "no dimesion. tid %u pid %u offset %lu", tid, pid, entry.log_index());
@@ -119,15 +275,7 @@ bool Binlog::RecoverFromBinlog(std::shared_ptr<Table> table, uint64_t offset, ui
         }
         cur_offset = entry.log_index();
         succ_cnt++;
-        if (succ_cnt % 100000 == 0) {
-            PDLOG(INFO,
-                  "[Recover] load data from binlog succ_cnt %lu, failed_cnt "
-                  "%lu for tid %u, pid %u",
-                  succ_cnt, failed_cnt, tid, pid);
-        }
-        if (succ_cnt % FLAGS_gc_on_table_recover_count == 0) {
-            table->SchedGc();
-        }
+        ReportProgress(table, succ_cnt, failed_cnt);
     }
     latest_offset = cur_offset;
     if (!reach_end_log) {
@@ -18,7 +18,10 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
+#include "base/count_down_latch.h"
+#include "base/taskpool.hpp"
 #include "log/log_reader.h"
 #include "log/log_writer.h"
 #include "storage/table.h"
@@ -28,6 +31,45 @@ typedef ::openmldb::base::Skiplist<uint32_t, uint64_t, ::openmldb::base::Default
 namespace openmldb {
 namespace storage {
 
+// replay the binlog records by chunk. The records of a chunk are decoded on a thread
+// pool, then the entries are put by the workers sharded by the hash of the first
+// dimension key, so the entries of a key of the first index are put in the order of
+// log index. The entries sharing a key of another index only may be put by different
+// workers out of the log order. As the rows of a key are ordered by time, this only
+// changes the order of the rows with the same time in that key. A delete waits for
+// all the puts before it
+class BinlogReplayer {
+ public:
+    BinlogReplayer(std::shared_ptr<Table> table, uint32_t thread_num, uint32_t chunk_size);
+    ~BinlogReplayer() = default;
+    BinlogReplayer(const BinlogReplayer&) = delete;
+    BinlogReplayer& operator=(const BinlogReplayer&) = delete;
+
+    // return true if the chunk is full
+    bool Add(const ::openmldb::base::Slice& record);
+
+    // replay the records added, the entries not newer than cur_offset are skipped
+    void Replay(uint64_t* cur_offset, uint64_t* succ_cnt, uint64_t* failed_cnt);
+
+    // wait until the entries replayed are put
+    void Wait();
+
+ private:
+    void Decode(uint32_t start, uint32_t end, std::vector<::openmldb::api::LogEntry>* entries,
+                std::vector<char>* parsed, ::openmldb::base::CountDownLatch* latch);
+    void Put(std::shared_ptr<std::vector<::openmldb::api::LogEntry>> entries, std::vector<uint32_t> positions);
+    void Dispatch(const std::shared_ptr<std::vector<::openmldb::api::LogEntry>>& entries,
+                  std::vector<std::vector<uint32_t>>* batches);
+
+ private:
+    std::shared_ptr<Table> table_;
+    uint32_t chunk_size_;
+    std::vector<std::string> records_;
+    ::openmldb::base::TaskPool decode_pool_;
+    // a worker has one thread to keep the order of its entries
+    std::vector<std::unique_ptr<::openmldb::base::TaskPool>> workers_;
+};
+
 class Binlog {
  public:
     Binlog(LogParts* log_part, const std::string& binlog_path);
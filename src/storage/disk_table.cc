@@ -29,12 +29,14 @@ DECLARE_uint32(block_cache_mb);
 DECLARE_uint32(write_buffer_mb);
 DECLARE_uint32(block_cache_shardbits);
 DECLARE_bool(verify_compression);
+DECLARE_uint32(disk_bloom_bits_per_key);
 
 namespace openmldb {
 namespace storage {
 
 static rocksdb::Options ssd_option_template;
 static rocksdb::Options hdd_option_template;
+static rocksdb::BlockBasedTableOptions table_option_template;
 static bool options_template_initialized = false;
 
 DiskTable::DiskTable(const std::string& name, uint32_t id, uint32_t pid, const std::map<std::string, uint32_t>& mapping,
@@ -142,10 +144,42 @@ void DiskTable::initOptionTemplate() {
     hdd_option_template.target_file_size_base = 256 << 20;
     hdd_option_template.max_bytes_for_level_base = 1024 << 20;
     hdd_option_template.table_factory.reset(rocksdb::NewBlockBasedTableFactory(table_options));
+    table_option_template = table_options;
 
     options_template_initialized = true;
 }
 
+// Each index lives in its own column family, so its table options follow how the index is read.
+// Lookups of both ttl types seek the prefix of one key: a latest index reads the few newest rows
+// of the key and an absolute index scans a time window of it.
+std::shared_ptr<rocksdb::TableFactory> DiskTable::NewTableFactory(::openmldb::common::StorageMode storage_mode,
+                                                                  ::openmldb::storage::TTLType ttl_type) {
+    rocksdb::BlockBasedTableOptions table_options = table_option_template;
+    bool latest = ttl_type == ::openmldb::storage::TTLType::kLatestTime;
+    if (FLAGS_disk_bloom_bits_per_key > 0) {
+        // the filter holds the key prefixes cut by KeyTsPrefixTransform, so seeks
+        // and gets of a missing key skip the file without reading its data blocks
+        table_options.filter_policy.reset(rocksdb::NewBloomFilterPolicy(FLAGS_disk_bloom_bits_per_key, false));
+        table_options.whole_key_filtering = false;
+    }
+    table_options.cache_index_and_filter_blocks = true;
+    table_options.cache_index_and_filter_blocks_with_high_priority = true;
+    table_options.pin_l0_filter_and_index_blocks_in_cache = true;
+    if (storage_mode == ::openmldb::common::StorageMode::kSSD) {
+        // random reads are cheap on ssd, read no more than the rows a lookup needs
+        table_options.block_size = latest ? 16 << 10 : 64 << 10;
+    } else {
+        // the big sst files on hdd have big index and filter blocks, partition them so
+        // that only the partitions being looked up are loaded into the block cache
+        table_options.block_size = latest ? 64 << 10 : 256 << 10;
+        table_options.index_type = rocksdb::BlockBasedTableOptions::IndexType::kTwoLevelIndexSearch;
+        table_options.partition_filters = FLAGS_disk_bloom_bits_per_key > 0;
+        table_options.metadata_block_size = 4 << 10;
+        table_options.pin_top_level_index_and_filter = true;
+    }
+    return std::shared_ptr<rocksdb::TableFactory>(rocksdb::NewBlockBasedTableFactory(table_options));
+}
+
 bool DiskTable::InitColumnFamilyDescriptor() {
     cf_ds_.clear();
     cf_ds_.push_back(
@@ -164,6 +198,7 @@ bool DiskTable::InitColumnFamilyDescriptor() {
         cfo.prefix_extractor.reset(new KeyTsPrefixTransform());
         const auto& indexs = inner_index->GetIndex();
         auto index_def = indexs.front();
+        cfo.table_factory = NewTableFactory(storage_mode_, index_def->GetTTLType());
         if (index_def->GetTTLType() == ::openmldb::storage::TTLType::kAbsoluteTime ||
             index_def->GetTTLType() == ::openmldb::storage::TTLType::kAbsOrLat) {
             cfo.compaction_filter_factory = std::make_shared<AbsoluteTTLFilterFactory>(inner_index);
@@ -296,17 +331,29 @@ bool DiskTable::Delete(const std::string& pk, uint32_t idx) {
 }
 
 bool DiskTable::Get(uint32_t idx, const std::string& pk, uint64_t ts, std::string& value) {
-    Ticket ticket;
-    auto it = NewIterator(idx, pk, ticket);
-    it->Seek(ts);
-    if ((it->Valid()) && (it->GetKey() == ts)) {
-        value = it->GetValue().ToString();
-        delete it;
-        return true;
-    } else {
-        delete it;
+    std::shared_ptr<IndexDef> index_def = table_index_.GetIndex(idx);
+    if (!index_def) {
+        PDLOG(WARNING, "index %u not found in table, tid %u pid %u", idx, id_, pid_);
         return false;
     }
+    uint32_t inner_pos = index_def->GetInnerPos();
+    auto inner_index = table_index_.GetInnerIndex(inner_pos);
+    auto ts_col = index_def->GetTsColumn();
+    std::string combine_key;
+    if (inner_index && inner_index->GetIndex().size() > 1 && ts_col) {
+        combine_key = CombineKeyTs(pk, ts, ts_col->GetId());
+    } else {
+        combine_key = CombineKeyTs(pk, ts);
+    }
+    // a point lookup checks the bloom filters instead of positioning an iterator in every level
+    rocksdb::Status s = db_->Get(rocksdb::ReadOptions(), cf_hs_[inner_pos + 1], rocksdb::Slice(combine_key), &value);
+    if (s.ok()) {
+        return true;
+    }
+    if (!s.IsNotFound()) {
+        PDLOG(WARNING, "Get failed. tid %u pid %u msg %s", id_, pid_, s.ToString().c_str());
+    }
+    return false;
 }
 
 bool DiskTable::Get(const std::string& pk, uint64_t ts, std::string& value) { return Get(0, pk, ts, value); }
@@ -346,6 +393,7 @@ void DiskTable::GcHead() {
         const rocksdb::Snapshot* snapshot = db_->GetSnapshot();
         ro.snapshot = snapshot;
         // ro.prefix_same_as_start = true;
+        ro.total_order_seek = true;
         ro.pin_data = true;
         rocksdb::Iterator* it = db_->NewIterator(ro, cf_hs_[idx + 1]);
         it->SeekToFirst();
@@ -530,6 +578,7 @@ TableIterator* DiskTable::NewTraverseIterator(uint32_t index) {
     const rocksdb::Snapshot* snapshot = db_->GetSnapshot();
     ro.snapshot = snapshot;
     // ro.prefix_same_as_start = true;
+    ro.total_order_seek = true;
     ro.pin_data = true;
     rocksdb::Iterator* it = db_->NewIterator(ro, cf_hs_[inner_pos + 1]);
     if (inner_index && inner_index->GetIndex().size() > 1) {
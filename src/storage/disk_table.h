@@ -290,6 +290,9 @@ class DiskTable : public Table {
 
     static void initOptionTemplate();
 
+    static std::shared_ptr<rocksdb::TableFactory> NewTableFactory(::openmldb::common::StorageMode storage_mode,
+                                                                  ::openmldb::storage::TTLType ttl_type);
+
     bool Put(const std::string& pk, uint64_t time, const char* data, uint32_t size) override;
 
     bool Put(uint64_t time, const std::string& value, const Dimensions& dimensions) override;
@@ -0,0 +1,132 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <unistd.h>
+
+#include <map>
+#include <string>
+
+#include "base/file_util.h"
+#include "benchmark/benchmark.h"
+#include "gflags/gflags.h"
+#include "storage/disk_table.h"
+
+DECLARE_string(ssd_root_path);
+DECLARE_string(hdd_root_path);
+DECLARE_uint32(write_buffer_mb);
+
+namespace openmldb {
+namespace storage {
+
+static const uint32_t kTsPerKey = 10;
+static const char kValue[] = "test_value_0123456789_test_value_0123456789";
+
+// range(0) is the number of keys, range(1) the storage mode, 2 for ssd and 3 for hdd,
+// range(2) the ttl type, 1 for absolute and 2 for latest
+static DiskTable* CreateTable(benchmark::State& state, std::string* table_path) {  // NOLINT
+    // small memtables so that the lookups go to the sst files
+    FLAGS_write_buffer_mb = 1;
+    auto storage_mode = static_cast<::openmldb::common::StorageMode>(state.range(1));
+    auto ttl_type = state.range(2) == 1 ? ::openmldb::type::TTLType::kAbsoluteTime
+                                        : ::openmldb::type::TTLType::kLatestTime;
+    std::string root_path =
+        storage_mode == ::openmldb::common::StorageMode::kSSD ? FLAGS_ssd_root_path : FLAGS_hdd_root_path;
+    if (root_path.empty()) {
+        root_path = "/tmp";
+    }
+    *table_path = root_path + "/disk_table_bm_" + std::to_string(getpid());
+    ::openmldb::base::RemoveDirRecursive(*table_path);
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx0", 0));
+    DiskTable* table = new DiskTable("bm", 1, 1, mapping, 0, ttl_type, storage_mode, *table_path);
+    if (!table->Init()) {
+        state.SkipWithError("fail to init disk table");
+        return table;
+    }
+    for (int64_t i = 0; i < state.range(0); i++) {
+        std::string key = "key" + std::to_string(i);
+        for (uint32_t ts = 1; ts <= kTsPerKey; ts++) {
+            table->Put(key, ts, kValue, sizeof(kValue));
+        }
+    }
+    return table;
+}
+
+// point lookups of rows which exist
+static void BM_DiskTableGet(benchmark::State& state) {  // NOLINT
+    std::string table_path;
+    DiskTable* table = CreateTable(state, &table_path);
+    std::string value;
+    uint64_t idx = 0;
+    for (auto _ : state) {
+        idx = (idx + 7919) % state.range(0);
+        benchmark::DoNotOptimize(table->Get("key" + std::to_string(idx), idx % kTsPerKey + 1, value));
+    }
+    state.SetItemsProcessed(state.iterations());
+    delete table;
+    ::openmldb::base::RemoveDirRecursive(table_path);
+}
+
+// point lookups of keys which do not exist, the case the bloom filters skip
+static void BM_DiskTableGetMiss(benchmark::State& state) {  // NOLINT
+    std::string table_path;
+    DiskTable* table = CreateTable(state, &table_path);
+    std::string value;
+    uint64_t idx = 0;
+    for (auto _ : state) {
+        idx = (idx + 7919) % state.range(0);
+        benchmark::DoNotOptimize(table->Get("miss" + std::to_string(idx), 1, value));
+    }
+    state.SetItemsProcessed(state.iterations());
+    delete table;
+    ::openmldb::base::RemoveDirRecursive(table_path);
+}
+
+// the lookups of request mode, which read all rows of a key
+static void BM_DiskTableScanKey(benchmark::State& state) {  // NOLINT
+    std::string table_path;
+    DiskTable* table = CreateTable(state, &table_path);
+    uint64_t idx = 0;
+    for (auto _ : state) {
+        idx = (idx + 7919) % state.range(0);
+        Ticket ticket;
+        TableIterator* it = table->NewIterator("key" + std::to_string(idx), ticket);
+        uint32_t cnt = 0;
+        for (it->SeekToFirst(); it->Valid(); it->Next()) {
+            cnt++;
+        }
+        benchmark::DoNotOptimize(cnt);
+        delete it;
+    }
+    state.SetItemsProcessed(state.iterations());
+    delete table;
+    ::openmldb::base::RemoveDirRecursive(table_path);
+}
+
+static void TableArgs(benchmark::internal::Benchmark* b) {
+    for (int64_t storage_mode : {2, 3}) {
+        for (int64_t ttl_type : {1, 2}) {
+            b->Args({100000, storage_mode, ttl_type});
+        }
+    }
+}
+
+BENCHMARK(BM_DiskTableGet)->Apply(TableArgs)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_DiskTableGetMiss)->Apply(TableArgs)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_DiskTableScanKey)->Apply(TableArgs)->Unit(benchmark::kMicrosecond);
+
+}  // namespace storage
+}  // namespace openmldb
@@ -33,6 +33,7 @@ DECLARE_string(ssd_root_path);
 DECLARE_string(hdd_root_path);
 DECLARE_uint32(max_traverse_cnt);
 DECLARE_int32(gc_safe_offset);
+DECLARE_uint32(disk_bloom_bits_per_key);
 
 namespace openmldb {
 namespace storage {
@@ -1198,6 +1199,193 @@ TEST_F(DiskTableTest, CheckPoint) {
     RemoveData(table_path);
 }
 
+TEST_F(DiskTableTest, TableOptions) {
+    auto factory = DiskTable::NewTableFactory(::openmldb::common::StorageMode::kSSD,
+                                              ::openmldb::storage::TTLType::kLatestTime);
+    auto options = factory->GetOptions<rocksdb::BlockBasedTableOptions>();
+    ASSERT_TRUE(options != nullptr);
+    ASSERT_EQ(16u << 10, options->block_size);
+    ASSERT_TRUE(options->filter_policy != nullptr);
+    ASSERT_FALSE(options->whole_key_filtering);
+    ASSERT_TRUE(options->cache_index_and_filter_blocks);
+    ASSERT_EQ(rocksdb::BlockBasedTableOptions::IndexType::kBinarySearch, options->index_type);
+
+    factory = DiskTable::NewTableFactory(::openmldb::common::StorageMode::kSSD,
+                                         ::openmldb::storage::TTLType::kAbsoluteTime);
+    options = factory->GetOptions<rocksdb::BlockBasedTableOptions>();
+    ASSERT_TRUE(options != nullptr);
+    ASSERT_EQ(64u << 10, options->block_size);
+
+    factory = DiskTable::NewTableFactory(::openmldb::common::StorageMode::kHDD,
+                                         ::openmldb::storage::TTLType::kLatestTime);
+    options = factory->GetOptions<rocksdb::BlockBasedTableOptions>();
+    ASSERT_TRUE(options != nullptr);
+    ASSERT_EQ(64u << 10, options->block_size);
+
+    factory = DiskTable::NewTableFactory(::openmldb::common::StorageMode::kHDD,
+                                         ::openmldb::storage::TTLType::kAbsoluteTime);
+    options = factory->GetOptions<rocksdb::BlockBasedTableOptions>();
+    ASSERT_TRUE(options != nullptr);
+    ASSERT_EQ(256u << 10, options->block_size);
+    ASSERT_TRUE(options->filter_policy != nullptr);
+    ASSERT_FALSE(options->whole_key_filtering);
+    ASSERT_EQ(rocksdb::BlockBasedTableOptions::IndexType::kTwoLevelIndexSearch, options->index_type);
+    ASSERT_TRUE(options->partition_filters);
+    ASSERT_TRUE(options->pin_top_level_index_and_filter);
+
+    uint32_t old_bits = FLAGS_disk_bloom_bits_per_key;
+    FLAGS_disk_bloom_bits_per_key = 0;
+    factory = DiskTable::NewTableFactory(::openmldb::common::StorageMode::kHDD,
+                                         ::openmldb::storage::TTLType::kAbsoluteTime);
+    options = factory->GetOptions<rocksdb::BlockBasedTableOptions>();
+    ASSERT_TRUE(options != nullptr);
+    ASSERT_TRUE(options->filter_policy == nullptr);
+    ASSERT_FALSE(options->partition_filters);
+    FLAGS_disk_bloom_bits_per_key = old_bits;
+}
+
+TEST_F(DiskTableTest, TraverseIteratorAcrossPrefix) {
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx0", 0));
+    std::string table_path = FLAGS_hdd_root_path + "/16_1";
+    DiskTable* table = new DiskTable("t1", 16, 1, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime,
+                                     ::openmldb::common::StorageMode::kHDD, table_path);
+    ASSERT_TRUE(table->Init());
+    for (int idx = 0; idx < 100; idx++) {
+        std::string key = "test" + std::to_string(idx);
+        uint64_t ts = 9537;
+        for (int k = 0; k < 10; k++) {
+            ASSERT_TRUE(table->Put(key, ts + k, "value", 5));
+        }
+    }
+    // move the rows into the sst files, where the seeks are filtered by the prefix bloom
+    table->CompactDB();
+    TableIterator* it = table->NewTraverseIterator(0);
+    it->SeekToFirst();
+    int count = 0;
+    int pk_cnt = 0;
+    std::string last_pk;
+    while (it->Valid()) {
+        std::string pk = it->GetPK();
+        ASSERT_LE(last_pk, pk);
+        if (pk != last_pk) {
+            pk_cnt++;
+            last_pk = pk;
+        }
+        count++;
+        it->Next();
+    }
+    ASSERT_EQ(1000, count);
+    ASSERT_EQ(100, pk_cnt);
+
+    // the seek key has no rows, the iterator goes on to the next key
+    it->Seek("test905", 9546);
+    count = 0;
+    while (it->Valid()) {
+        if (count == 0) {
+            ASSERT_EQ("test91", it->GetPK());
+            ASSERT_EQ(9546, (int64_t)it->GetKey());
+        }
+        count++;
+        it->Next();
+    }
+    ASSERT_EQ(90, count);
+
+    it->Seek("test99", 9537);
+    ASSERT_FALSE(it->Valid());
+    delete it;
+    delete table;
+    RemoveData(table_path);
+}
+
+TEST_F(DiskTableTest, PointGet) {
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx0", 0));
+    std::string table_path = FLAGS_hdd_root_path + "/17_1";
+    DiskTable* table = new DiskTable("t1", 17, 1, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime,
+                                     ::openmldb::common::StorageMode::kHDD, table_path);
+    ASSERT_TRUE(table->Init());
+    for (int idx = 0; idx < 10; idx++) {
+        std::string key = "test" + std::to_string(idx);
+        for (int k = 0; k < 10; k++) {
+            std::string value = "value" + std::to_string(k);
+            ASSERT_TRUE(table->Put(key, 9537 + k, value.c_str(), value.size()));
+        }
+    }
+    for (int round = 0; round < 2; round++) {
+        std::string val;
+        ASSERT_TRUE(table->Get(0, "test5", 9540, val));
+        ASSERT_EQ("value3", val);
+        ASSERT_TRUE(table->Get("test9", 9546, val));
+        ASSERT_EQ("value9", val);
+        ASSERT_FALSE(table->Get(0, "test5", 9547, val));
+        ASSERT_FALSE(table->Get(0, "test50", 9540, val));
+        ASSERT_FALSE(table->Get(0, "test", 9540, val));
+        ASSERT_FALSE(table->Get(1, "test5", 9540, val));
+        // read the same rows again from the sst files
+        table->CompactDB();
+    }
+    delete table;
+    RemoveData(table_path);
+
+    ::openmldb::api::TableMeta table_meta;
+    table_meta.set_tid(18);
+    table_meta.set_pid(1);
+    table_meta.set_storage_mode(::openmldb::common::kHDD);
+    table_meta.set_format_version(1);
+    SchemaCodec::SetColumnDesc(table_meta.add_column_desc(), "card", ::openmldb::type::kString);
+    SchemaCodec::SetColumnDesc(table_meta.add_column_desc(), "mcc", ::openmldb::type::kString);
+    SchemaCodec::SetColumnDesc(table_meta.add_column_desc(), "ts1", ::openmldb::type::kBigInt);
+    SchemaCodec::SetColumnDesc(table_meta.add_column_desc(), "ts2", ::openmldb::type::kBigInt);
+    SchemaCodec::SetIndex(table_meta.add_column_key(), "card", "card", "ts1", ::openmldb::type::kAbsoluteTime, 0, 0);
+    SchemaCodec::SetIndex(table_meta.add_column_key(), "card1", "card", "ts2", ::openmldb::type::kAbsoluteTime, 0, 0);
+    SchemaCodec::SetIndex(table_meta.add_column_key(), "mcc", "mcc", "ts2", ::openmldb::type::kAbsoluteTime, 0, 0);
+    table_path = FLAGS_hdd_root_path + "/18_1";
+    table = new DiskTable(table_meta, table_path);
+    ASSERT_TRUE(table->Init());
+    codec::SDKCodec codec(table_meta);
+    for (int idx = 0; idx < 10; idx++) {
+        Dimensions dims;
+        ::openmldb::api::Dimension* dim = dims.Add();
+        dim->set_key("card" + std::to_string(idx));
+        dim->set_idx(0);
+        ::openmldb::api::Dimension* dim1 = dims.Add();
+        dim1->set_key("card" + std::to_string(idx));
+        dim1->set_idx(1);
+        ::openmldb::api::Dimension* dim2 = dims.Add();
+        dim2->set_key("mcc" + std::to_string(idx));
+        dim2->set_idx(2);
+        std::vector<std::string> row = {"card" + std::to_string(idx), "mcc" + std::to_string(idx),
+                                        std::to_string(1000 + idx), std::to_string(2000 + idx)};
+        std::string value;
+        ASSERT_EQ(0, codec.EncodeRow(row, &value));
+        ASSERT_TRUE(table->Put(1000 + idx, value, dims));
+    }
+    for (int round = 0; round < 2; round++) {
+        for (int idx = 0; idx < 10; idx++) {
+            std::string card = "card" + std::to_string(idx);
+            std::string mcc = "mcc" + std::to_string(idx);
+            std::vector<std::string> row;
+            std::string val;
+            // the two indexes on card share a column family, the key holds the ts column
+            ASSERT_TRUE(table->Get(0, card, 1000 + idx, val));
+            ASSERT_EQ(0, codec.DecodeRow(val, &row));
+            ASSERT_EQ(card, row[0]);
+            ASSERT_FALSE(table->Get(0, card, 2000 + idx, val));
+            ASSERT_TRUE(table->Get(1, card, 2000 + idx, val));
+            row.clear();
+            ASSERT_EQ(0, codec.DecodeRow(val, &row));
+            ASSERT_EQ(std::to_string(2000 + idx), row[3]);
+            ASSERT_FALSE(table->Get(1, card, 1000 + idx, val));
+            ASSERT_TRUE(table->Get(2, mcc, 2000 + idx, val));
+            ASSERT_FALSE(table->Get(2, card, 2000 + idx, val));
+        }
+        table->CompactDB();
+    }
+    delete table;
+    RemoveData(table_path);
+}
+
 }  // namespace storage
 }  // namespace openmldb
 
@@ -16,7 +16,11 @@
 
 #include "storage/mem_table.h"
 
+#include <stdlib.h>
+#include <string.h>
+
 #include <algorithm>
+#include <thread>  // NOLINT
 #include <utility>
 
 #include "base/glog_wapper.h"
@@ -32,28 +36,87 @@ DECLARE_uint32(key_entry_max_height);
 DECLARE_uint32(absolute_default_skiplist_height);
 DECLARE_uint32(latest_default_skiplist_height);
 DECLARE_uint32(max_traverse_cnt);
+DECLARE_uint32(gc_deleted_pk_version_delta);
+DECLARE_bool(enable_memtable_slab);
+DECLARE_uint32(memtable_slab_max_size);
+DECLARE_uint32(memtable_slab_chunk_size);
+DECLARE_uint32(memtable_freeze_time);
+DECLARE_uint32(memtable_freeze_min_cnt);
+DECLARE_bool(enable_memtable_segment_split);
+DECLARE_uint32(memtable_segment_split_max_depth);
+DECLARE_uint32(memtable_segment_split_pk_cnt);
+DECLARE_uint32(memtable_segment_split_wait_timeout);
+DECLARE_bool(enable_memtable_string_dict);
+DECLARE_uint32(memtable_string_dict_max_size);
 
 namespace openmldb {
 namespace storage {
 
 static const uint32_t SEED = 0xe17a1465;
+static const uint32_t MAX_SEG_SPLIT_DEPTH = 8;
+
+static inline uint16_t GetCutEpoch(uint64_t state) { return static_cast<uint16_t>(state & 0xFFFF); }
+
+static inline uint32_t GetCutParity(uint64_t state) { return static_cast<uint32_t>((state >> 16) & 1); }
 
 MemTable::MemTable(const std::string& name, uint32_t id, uint32_t pid, uint32_t seg_cnt,
                    const std::map<std::string, uint32_t>& mapping, uint64_t ttl, ::openmldb::type::TTLType ttl_type)
     : Table(::openmldb::common::StorageMode::kMemory, name, id, pid, ttl * 60 * 1000, true, 60 * 1000, mapping,
             ttl_type, ::openmldb::type::CompressType::kNoCompress),
       seg_cnt_(seg_cnt),
+      seg_split_depth_(0),
       segments_(MAX_INDEX_NUM, NULL),
       enable_gc_(true),
       record_cnt_(0),
       segment_released_(false),
-      record_byte_size_(0) {}
+      record_byte_size_(0),
+      put_cnt_(0),
+      put_time_(0),
+      gc_cnt_(0),
+      last_gc_time_(0),
+      gc_record_cnt_(0),
+      slab_(),
+      split_segment_(NULL),
+      split_child_(NULL),
+      split_version_(0),
+      split_time_(0),
+      split_epoch_(),
+      split_mu_(),
+      cut_state_(0),
+      putting_cnt_(),
+      cut_offset_(0),
+      cut_mu_(),
+      cut_cv_(),
+      late_rows_(),
+      dumping_(false),
+      freeze_mu_() {}
 
 MemTable::MemTable(const ::openmldb::api::TableMeta& table_meta)
     : Table(table_meta.storage_mode(), table_meta.name(), table_meta.tid(), table_meta.pid(), 0, true, 60 * 1000,
             std::map<std::string, uint32_t>(), ::openmldb::type::TTLType::kAbsoluteTime,
             ::openmldb::type::CompressType::kNoCompress),
-      segments_(MAX_INDEX_NUM, NULL) {
+      seg_split_depth_(0),
+      segments_(MAX_INDEX_NUM, NULL),
+      put_cnt_(0),
+      put_time_(0),
+      gc_cnt_(0),
+      last_gc_time_(0),
+      gc_record_cnt_(0),
+      slab_(),
+      split_segment_(NULL),
+      split_child_(NULL),
+      split_version_(0),
+      split_time_(0),
+      split_epoch_(),
+      split_mu_(),
+      cut_state_(0),
+      putting_cnt_(),
+      cut_offset_(0),
+      cut_mu_(),
+      cut_cv_(),
+      late_rows_(),
+      dumping_(false),
+      freeze_mu_() {
     seg_cnt_ = 8;
     enable_gc_ = true;
     record_cnt_ = 0;
@@ -70,8 +133,8 @@ MemTable::~MemTable() {
     Release();
     for (uint32_t i = 0; i < segments_.size(); i++) {
         if (segments_[i] != NULL) {
-            for (uint32_t j = 0; j < seg_cnt_; j++) {
-                delete segments_[i][j];
+            for (uint32_t j = 0; j < (seg_cnt_ << seg_split_depth_); j++) {
+                delete GetSegment(i, j);
             }
             delete[] segments_[i];
         }
@@ -88,6 +151,15 @@ bool MemTable::Init() {
     if (table_meta_->seg_cnt() > 0) {
         seg_cnt_ = table_meta_->seg_cnt();
     }
+    if (FLAGS_enable_memtable_segment_split) {
+        seg_split_depth_ = std::min(FLAGS_memtable_segment_split_max_depth, MAX_SEG_SPLIT_DEPTH);
+    }
+    if (FLAGS_enable_memtable_slab) {
+        slab_.reset(new ::openmldb::base::SlabAllocator(FLAGS_memtable_slab_max_size, FLAGS_memtable_slab_chunk_size));
+    }
+    if (FLAGS_enable_memtable_string_dict) {
+        string_dict_.reset(new StringDict(FLAGS_memtable_string_dict_max_size));
+    }
     uint32_t global_key_entry_max_height = 0;
     if (table_meta_->has_key_entry_max_height() && table_meta_->key_entry_max_height() <= FLAGS_skiplist_max_height &&
         table_meta_->key_entry_max_height() > 0) {
@@ -103,7 +175,7 @@ bool MemTable::Init() {
             cur_key_entry_max_height = inner_indexs->at(i)->GetKeyEntryMaxHeight(FLAGS_absolute_default_skiplist_height,
                                                                                  FLAGS_latest_default_skiplist_height);
         }
-        Segment** seg_arr = new Segment*[seg_cnt_];
+        auto* seg_arr = new std::atomic<Segment*>[seg_cnt_ << seg_split_depth_];
         if (!ts_vec.empty()) {
             for (uint32_t j = 0; j < seg_cnt_; j++) {
                 seg_arr[j] = new Segment(cur_key_entry_max_height, ts_vec);
@@ -116,13 +188,33 @@ bool MemTable::Init() {
                 PDLOG(INFO, "init %u, %u segment. height %u tid %u pid %u", i, j, cur_key_entry_max_height, id_, pid_);
             }
         }
+        InitSplitTree(seg_arr);
+        for (uint32_t j = 0; j < seg_cnt_; j++) {
+            seg_arr[j].load(std::memory_order_relaxed)->SetSlabAllocator(slab_.get());
+        }
         segments_[i] = seg_arr;
         key_entry_max_height_ = cur_key_entry_max_height;
     }
-    PDLOG(INFO, "init table name %s, id %d, pid %d, seg_cnt %d", name_.c_str(), id_, pid_, seg_cnt_);
+    PDLOG(INFO, "init table name %s, id %d, pid %d, seg_cnt %d, seg_split_depth %u", name_.c_str(), id_, pid_,
+          seg_cnt_, seg_split_depth_);
     return true;
 }
 
+void MemTable::InitSplitTree(std::atomic<Segment*>* seg_arr) {
+    uint32_t total_cnt = seg_cnt_ << seg_split_depth_;
+    for (uint32_t j = seg_cnt_; j < total_cnt; j++) {
+        seg_arr[j].store(NULL, std::memory_order_relaxed);
+    }
+    if (seg_split_depth_ == 0) {
+        return;
+    }
+    // root segment j splits into j + (seg_cnt_ << k) at the depths k, see SplitSegment
+    for (uint32_t j = 0; j < seg_cnt_; j++) {
+        Segment* root = seg_arr[j].load(std::memory_order_relaxed);
+        root->SetSplitTree(j, seg_cnt_, 0, seg_split_depth_, root);
+    }
+}
+
 void MemTable::SetCompressType(::openmldb::type::CompressType compress_type) { compress_type_ = compress_type; }
 
 ::openmldb::type::CompressType MemTable::GetCompressType() { return compress_type_; }
@@ -133,7 +225,7 @@ bool MemTable::Put(const std::string& pk, uint64_t time, const char* data, uint3
     if (seg_cnt_ > 1) {
         index = ::openmldb::base::hash(pk.c_str(), pk.length(), SEED) % seg_cnt_;
     }
-    Segment* segment = segments_[0][index];
+    Segment* segment = GetSegment(0, index);
     Slice spk(pk);
     segment->Put(spk, time, data, size);
     record_cnt_.fetch_add(1, std::memory_order_relaxed);
@@ -142,22 +234,47 @@ bool MemTable::Put(const std::string& pk, uint64_t time, const char* data, uint3
 }
 
 bool MemTable::Put(uint64_t time, const std::string& value, const Dimensions& dimensions) {
+    std::vector<std::pair<uint32_t, Slice>> keys;
+    keys.reserve(dimensions.size());
+    for (auto iter = dimensions.begin(); iter != dimensions.end(); iter++) {
+        keys.emplace_back(iter->idx(), Slice(iter->key()));
+    }
+    return Put(time, Slice(value), keys);
+}
+
+bool MemTable::Put(uint64_t time, const std::string& value, const Dimensions& dimensions, uint64_t state,
+                   DataBlock** row) {
+    std::vector<std::pair<uint32_t, Slice>> keys;
+    keys.reserve(dimensions.size());
+    for (auto iter = dimensions.begin(); iter != dimensions.end(); iter++) {
+        keys.emplace_back(iter->idx(), Slice(iter->key()));
+    }
+    return Put(time, Slice(value), keys, GetCutEpoch(state), row);
+}
+
+bool MemTable::Put(uint64_t time, const Slice& value, const std::vector<std::pair<uint32_t, Slice>>& dimensions) {
+    return Put(time, value, dimensions, GetCutEpoch(cut_state_.load(std::memory_order_acquire)), NULL);
+}
+
+bool MemTable::Put(uint64_t time, const Slice& value, const std::vector<std::pair<uint32_t, Slice>>& dimensions,
+                   uint16_t epoch, DataBlock** put_row) {
+    uint64_t start_time = ::baidu::common::timer::get_micros();
     if (dimensions.empty()) {
         PDLOG(WARNING, "empty dimension. tid %u pid %u", id_, pid_);
         return false;
     }
-    if (value.length() < codec::HEADER_LENGTH) {
+    if (value.size() < codec::HEADER_LENGTH) {
         PDLOG(WARNING, "invalid value. tid %u pid %u", id_, pid_);
         return false;
     }
     std::map<int32_t, Slice> inner_index_key_map;
-    for (auto iter = dimensions.begin(); iter != dimensions.end(); iter++) {
-        int32_t inner_pos = table_index_.GetInnerIndexPos(iter->idx());
+    for (const auto& dimension : dimensions) {
+        int32_t inner_pos = table_index_.GetInnerIndexPos(dimension.first);
         if (inner_pos < 0) {
-            PDLOG(WARNING, "invalid dimension. dimension idx %u, tid %u pid %u", iter->idx(), id_, pid_);
+            PDLOG(WARNING, "invalid dimension. dimension idx %u, tid %u pid %u", dimension.first, id_, pid_);
             return false;
         }
-        inner_index_key_map.emplace(inner_pos, iter->key());
+        inner_index_key_map.emplace(inner_pos, dimension.second);
     }
     uint32_t real_ref_cnt = 0;
     const int8_t* data = reinterpret_cast<const int8_t*>(value.data());
@@ -194,7 +311,13 @@ bool MemTable::Put(uint64_t time, const std::string& value, const Dimensions& di
     if (ts_map.empty()) {
         return false;
     }
-    auto* block = new DataBlock(real_ref_cnt, value.c_str(), value.length());
+    Slice row = value;
+    std::string coded_row;
+    if (string_dict_ && string_dict_->Encode(GetVersionSchema(version), data, &coded_row)) {
+        row = Slice(coded_row);
+    }
+    auto* block = new DataBlock(real_ref_cnt, row.data(), row.size(), slab_.get());
+    block->epoch.store(epoch, std::memory_order_relaxed);
     for (const auto& kv : inner_index_key_map) {
         auto inner_index = table_index_.GetInnerIndex(kv.first);
         bool need_put = false;
@@ -210,12 +333,17 @@ bool MemTable::Put(uint64_t time, const std::string& value, const Dimensions& di
             if (seg_cnt_ > 1) {
                 seg_idx = ::openmldb::base::hash(kv.second.data(), kv.second.size(), SEED) % seg_cnt_;
             }
-            Segment* segment = segments_[kv.first][seg_idx];
+            Segment* segment = GetSegment(kv.first, seg_idx);
             segment->Put(::openmldb::base::Slice(kv.second), ts_map, block);
         }
     }
     record_cnt_.fetch_add(1, std::memory_order_relaxed);
-    record_byte_size_.fetch_add(GetRecordSize(value.length()));
+    record_byte_size_.fetch_add(GetRecordSize(row.size()));
+    put_cnt_.fetch_add(1, std::memory_order_relaxed);
+    put_time_.fetch_add(::baidu::common::timer::get_micros() - start_time, std::memory_order_relaxed);
+    if (put_row != NULL) {
+        *put_row = block;
+    }
     return true;
 }
 
@@ -230,7 +358,7 @@ bool MemTable::Delete(const std::string& pk, uint32_t idx) {
         seg_idx = ::openmldb::base::hash(spk.data(), spk.size(), SEED) % seg_cnt_;
     }
     uint32_t real_idx = index_def->GetInnerPos();
-    Segment* segment = segments_[real_idx][seg_idx];
+    Segment* segment = GetSegment(real_idx, seg_idx);
     return segment->Delete(spk);
 }
 
@@ -241,11 +369,15 @@ uint64_t MemTable::Release() {
     if (segments_.empty()) {
         return 0;
     }
+    RemoveSplitKeys(true);
     uint64_t total_cnt = 0;
     for (uint32_t i = 0; i < segments_.size(); i++) {
         if (segments_[i] != NULL) {
-            for (uint32_t j = 0; j < seg_cnt_; j++) {
-                total_cnt += segments_[i][j]->Release();
+            for (uint32_t j = 0; j < (seg_cnt_ << seg_split_depth_); j++) {
+                Segment* segment = GetSegment(i, j);
+                if (segment != NULL) {
+                    total_cnt += segment->Release();
+                }
             }
         }
     }
@@ -260,6 +392,14 @@ void MemTable::SchedGc() {
     uint64_t gc_idx_cnt = 0;
     uint64_t gc_record_cnt = 0;
     uint64_t gc_record_byte_size = 0;
+    uint64_t frozen_cnt = 0;
+    if (slab_) {
+        // slab memory freed before the last few gc rounds is no longer visible to readers
+        uint64_t epoch = slab_->IncrEpoch();
+        if (epoch >= FLAGS_gc_deleted_pk_version_delta) {
+            slab_->Reclaim(epoch - FLAGS_gc_deleted_pk_version_delta);
+        }
+    }
     auto inner_indexs = table_index_.GetAllInnerIndex();
     for (uint32_t i = 0; i < inner_indexs->size(); i++) {
         const std::vector<std::shared_ptr<IndexDef>>& real_index = inner_indexs->at(i)->GetIndex();
@@ -280,9 +420,16 @@ void MemTable::SchedGc() {
             } else if (cur_index->GetStatus() == IndexStatus::kDeleting) {
                 if (real_index.size() == 1) {
                     if (segments_[i] != NULL) {
-                        for (uint32_t k = 0; k < seg_cnt_; k++) {
-                            if (segments_[i][k] != NULL) {
-                                segments_[i][k]->ReleaseAndCount(gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+                        Segment* split_segment = split_segment_.load(std::memory_order_acquire);
+                        for (uint32_t k = 0; k < (seg_cnt_ << seg_split_depth_); k++) {
+                            if (split_segment != NULL && GetSegment(i, k) == split_segment) {
+                                RemoveSplitKeys(true);
+                            }
+                        }
+                        for (uint32_t k = 0; k < (seg_cnt_ << seg_split_depth_); k++) {
+                            Segment* segment = GetSegment(i, k);
+                            if (segment != NULL) {
+                                segment->ReleaseAndCount(gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
                             }
                         }
                     }
@@ -299,13 +446,32 @@ void MemTable::SchedGc() {
         if (deleted_num == real_index.size() || ttl_st_map.empty()) {
             continue;
         }
-        for (uint32_t j = 0; j < seg_cnt_; j++) {
+        for (uint32_t j = 0; j < (seg_cnt_ << seg_split_depth_); j++) {
             uint64_t seg_gc_time = ::baidu::common::timer::get_micros() / 1000;
-            Segment* segment = segments_[i][j];
+            Segment* segment = GetSegment(i, j);
+            if (segment == NULL) {
+                continue;
+            }
+            if (segment == split_segment_.load(std::memory_order_acquire) ||
+                segment == split_child_.load(std::memory_order_acquire)) {
+                // the key entries are in both segments until the split keys are removed
+                PDLOG(INFO, "skip gc segment[%u][%u] in split. tid %u pid %u", i, j, id_, pid_);
+                continue;
+            }
             segment->IncrGcVersion();
             segment->GcFreeList(gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
             if (ttl_st_map.size() == 1) {
                 segment->ExecuteGc(ttl_st_map.begin()->second, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+                // the rows are frozen by time, so only the absolute ttl keeps them frozen after gc
+                if (FLAGS_memtable_freeze_time > 0 &&
+                    ttl_st_map.begin()->second.ttl_type == ::openmldb::storage::TTLType::kAbsoluteTime) {
+                    uint64_t freeze_time = ::baidu::common::timer::get_micros() / 1000 -
+                                           static_cast<uint64_t>(FLAGS_memtable_freeze_time) * 1000;
+                    std::lock_guard<std::mutex> lock(freeze_mu_);
+                    if (!dumping_.load(std::memory_order_acquire)) {
+                        frozen_cnt += segment->Freeze(freeze_time, FLAGS_memtable_freeze_min_cnt);
+                    }
+                }
             } else {
                 segment->ExecuteGc(ttl_st_map, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
             }
@@ -317,13 +483,106 @@ void MemTable::SchedGc() {
     consumed = ::baidu::common::timer::get_micros() - consumed;
     record_cnt_.fetch_sub(gc_record_cnt, std::memory_order_relaxed);
     record_byte_size_.fetch_sub(gc_record_byte_size, std::memory_order_relaxed);
+    gc_cnt_.fetch_add(1, std::memory_order_relaxed);
+    last_gc_time_.store(consumed / 1000, std::memory_order_relaxed);
+    gc_record_cnt_.fetch_add(gc_record_cnt, std::memory_order_relaxed);
     PDLOG(INFO,
-          "gc finished, gc_idx_cnt %lu, gc_record_cnt %lu consumed %lu ms for "
+          "gc finished, gc_idx_cnt %lu, gc_record_cnt %lu frozen_cnt %lu consumed %lu ms for "
           "table %s tid %u pid %u",
-          gc_idx_cnt, gc_record_cnt, consumed / 1000, name_.c_str(), id_, pid_);
+          gc_idx_cnt, gc_record_cnt, frozen_cnt, consumed / 1000, name_.c_str(), id_, pid_);
+    if (seg_split_depth_ > 0) {
+        SplitSegment();
+    }
     UpdateTTL();
 }
 
+void MemTable::SplitSegment() {
+    if (!RemoveSplitKeys(false)) {
+        return;
+    }
+    Segment* segment = NULL;
+    uint32_t inner_id = 0;
+    uint32_t seg_idx = 0;
+    uint64_t max_pk_cnt = FLAGS_memtable_segment_split_pk_cnt;
+    auto inner_indexs = table_index_.GetAllInnerIndex();
+    for (uint32_t i = 0; i < inner_indexs->size(); i++) {
+        bool is_valid = false;
+        for (const auto& index_def : inner_indexs->at(i)->GetIndex()) {
+            if (index_def && index_def->IsReady()) {
+                is_valid = true;
+                break;
+            }
+        }
+        if (!is_valid) {
+            continue;
+        }
+        for (uint32_t j = 0; j < (seg_cnt_ << seg_split_depth_); j++) {
+            Segment* cur_segment = GetSegment(i, j);
+            if (cur_segment != NULL && cur_segment->CanSplit() && cur_segment->GetPkCnt() > max_pk_cnt) {
+                max_pk_cnt = cur_segment->GetPkCnt();
+                segment = cur_segment;
+                inner_id = i;
+                seg_idx = j;
+            }
+        }
+    }
+    if (segment == NULL) {
+        return;
+    }
+    uint64_t consumed = ::baidu::common::timer::get_micros();
+    uint32_t depth = segment->GetSplitDepth();
+    uint64_t copy_cnt = 0;
+    {
+        std::lock_guard<std::mutex> lock(split_mu_);
+        // the child is created at the first split of the segment at the depth and published
+        // before the keys are routed to it
+        uint32_t child_idx = seg_idx + (seg_cnt_ << depth);
+        Segment* child = GetSegment(inner_id, child_idx);
+        if (child == NULL) {
+            child = segment->NewSplitChild();
+            if (child == NULL) {
+                return;
+            }
+            segments_[inner_id][child_idx].store(child, std::memory_order_release);
+        }
+        if (!segment->StartSplit(child)) {
+            return;
+        }
+        split_child_.store(child, std::memory_order_release);
+        copy_cnt = segment->CopySplitKeys();
+        segment->FinishSplit();
+    }
+    split_segment_.store(segment, std::memory_order_release);
+    split_version_ = split_epoch_.Incr();
+    split_time_ = ::baidu::common::timer::get_micros() / 1000;
+    consumed = ::baidu::common::timer::get_micros() - consumed;
+    PDLOG(INFO, "split segment[%u][%u] with %lu keys at depth %u, copy %lu keys consumed %lu ms. tid %u pid %u",
+          inner_id, seg_idx, max_pk_cnt, depth, copy_cnt, consumed / 1000, id_, pid_);
+    RemoveSplitKeys(false);
+}
+
+bool MemTable::RemoveSplitKeys(bool force) {
+    Segment* segment = split_segment_.load(std::memory_order_acquire);
+    if (segment == NULL) {
+        return true;
+    }
+    if (!force && split_epoch_.HasRef(split_version_)) {
+        // the iterators left would miss the keys moved to the child, so the keys stay until they are done
+        uint64_t wait_ms = ::baidu::common::timer::get_micros() / 1000 - split_time_;
+        if (wait_ms < FLAGS_memtable_segment_split_wait_timeout) {
+            PDLOG(INFO, "wait the key iterators to remove the split keys. tid %u pid %u", id_, pid_);
+        } else {
+            PDLOG(WARNING, "the key iterators hold the split keys for %lu ms. tid %u pid %u", wait_ms, id_, pid_);
+        }
+        return false;
+    }
+    uint64_t remove_cnt = segment->RemoveSplitKeys();
+    PDLOG(INFO, "remove %lu split keys. tid %u pid %u", remove_cnt, id_, pid_);
+    split_segment_.store(NULL, std::memory_order_release);
+    split_child_.store(NULL, std::memory_order_release);
+    return true;
+}
+
 // tll as ms
 uint64_t MemTable::GetExpireTime(const TTLSt& ttl_st) {
     if (!enable_gc_.load(std::memory_order_relaxed) || ttl_st.abs_ttl == 0 ||
@@ -434,7 +693,7 @@ int MemTable::GetCount(uint32_t index, const std::string& pk, uint64_t& count) {
     }
     Slice spk(pk);
     uint32_t real_idx = index_def->GetInnerPos();
-    Segment* segment = segments_[real_idx][seg_idx];
+    Segment* segment = GetSegment(real_idx, seg_idx);
     auto ts_col = index_def->GetTsColumn();
     if (ts_col) {
         return segment->GetCount(spk, ts_col->GetId(), count);
@@ -456,12 +715,16 @@ TableIterator* MemTable::NewIterator(uint32_t index, const std::string& pk, Tick
     }
     Slice spk(pk);
     uint32_t real_idx = index_def->GetInnerPos();
-    Segment* segment = segments_[real_idx][seg_idx];
+    Segment* segment = GetSegment(real_idx, seg_idx);
     auto ts_col = index_def->GetTsColumn();
+    MemTableIterator* it = NULL;
     if (ts_col) {
-        return segment->NewIterator(spk, ts_col->GetId(), ticket);
+        it = segment->NewIterator(spk, ts_col->GetId(), ticket);
+    } else {
+        it = segment->NewIterator(spk, ticket);
     }
-    return segment->NewIterator(spk, ticket);
+    it->SetStringDict(string_dict_.get());
+    return it;
 }
 
 uint64_t MemTable::GetRecordIdxByteSize() {
@@ -476,8 +739,11 @@ uint64_t MemTable::GetRecordIdxByteSize() {
             }
         }
         if (is_valid) {
-            for (uint32_t j = 0; j < seg_cnt_; j++) {
-                record_idx_byte_size += segments_[i][j]->GetIdxByteSize();
+            for (uint32_t j = 0; j < (seg_cnt_ << seg_split_depth_); j++) {
+                Segment* segment = GetSegment(i, j);
+                if (segment != NULL) {
+                    record_idx_byte_size += segment->GetIdxByteSize();
+                }
             }
         }
     }
@@ -496,8 +762,11 @@ uint64_t MemTable::GetRecordIdxCnt() {
             }
         }
         if (is_valid) {
-            for (uint32_t j = 0; j < seg_cnt_; j++) {
-                record_idx_cnt += segments_[i][j]->GetIdxCnt();
+            for (uint32_t j = 0; j < (seg_cnt_ << seg_split_depth_); j++) {
+                Segment* segment = GetSegment(i, j);
+                if (segment != NULL) {
+                    record_idx_cnt += segment->GetIdxCnt();
+                }
             }
         }
     }
@@ -516,8 +785,11 @@ uint64_t MemTable::GetRecordPkCnt() {
             }
         }
         if (is_valid) {
-            for (uint32_t j = 0; j < seg_cnt_; j++) {
-                record_pk_cnt += segments_[i][j]->GetPkCnt();
+            for (uint32_t j = 0; j < (seg_cnt_ << seg_split_depth_); j++) {
+                Segment* segment = GetSegment(i, j);
+                if (segment != NULL) {
+                    record_pk_cnt += segment->GetPkCnt();
+                }
             }
         }
     }
@@ -535,7 +807,14 @@ bool MemTable::GetRecordIdxCnt(uint32_t idx, uint64_t** stat, uint32_t* size) {
     auto* data_array = new uint64_t[seg_cnt_];
     uint32_t real_idx = index_def->GetInnerPos();
     for (uint32_t i = 0; i < seg_cnt_; i++) {
-        data_array[i] = segments_[real_idx][i]->GetIdxCnt();
+        data_array[i] = 0;
+    }
+    // the records of a split segment are counted in its root segment
+    for (uint32_t i = 0; i < (seg_cnt_ << seg_split_depth_); i++) {
+        Segment* segment = GetSegment(real_idx, i);
+        if (segment != NULL) {
+            data_array[i % seg_cnt_] += segment->GetIdxCnt();
+        }
     }
     *stat = data_array;
     *size = seg_cnt_;
@@ -588,12 +867,16 @@ bool MemTable::AddIndex(const ::openmldb::common::ColumnKey& column_key) {
             ts_vec.push_back(DEFUALT_TS_COL_ID);
         }
         uint32_t inner_id = table_index_.GetAllInnerIndex()->size();
-        Segment** seg_arr = new Segment*[seg_cnt_];
+        auto* seg_arr = new std::atomic<Segment*>[seg_cnt_ << seg_split_depth_];
         for (uint32_t j = 0; j < seg_cnt_; j++) {
             seg_arr[j] = new Segment(FLAGS_absolute_default_skiplist_height, ts_vec);
             PDLOG(INFO, "init %u, %u segment. height %u, ts col num %u. tid %u pid %u", inner_id, j,
                   FLAGS_absolute_default_skiplist_height, ts_vec.size(), id_, pid_);
         }
+        InitSplitTree(seg_arr);
+        for (uint32_t j = 0; j < seg_cnt_; j++) {
+            seg_arr[j].load(std::memory_order_relaxed)->SetSlabAllocator(slab_.get());
+        }
         index_def = std::make_shared<IndexDef>(column_key.index_name(), table_index_.GetMaxIndexId() + 1,
                 IndexStatus::kReady, ::openmldb::type::IndexType::kTimeSerise, col_vec);
         if (table_index_.AddIndex(index_def) < 0) {
@@ -624,6 +907,237 @@ bool MemTable::AddIndex(const ::openmldb::common::ColumnKey& column_key) {
     return true;
 }
 
+uint64_t MemTable::BeginPut() {
+    while (true) {
+        uint64_t state = cut_state_.load();
+        putting_cnt_[GetCutParity(state)].fetch_add(1);
+        if (cut_state_.load() == state) {
+            return state;
+        }
+        // a cut moves on in between, begin in the new state instead of waiting for it
+        EndPut(state);
+    }
+}
+
+void MemTable::EndPut(uint64_t state) {
+    if (putting_cnt_[GetCutParity(state)].fetch_sub(1) == 1 && cut_state_.load() != state) {
+        // the last put begun before a cut, which may wait for it
+        std::lock_guard<std::mutex> lock(cut_mu_);
+        cut_cv_.notify_all();
+    }
+}
+
+void MemTable::CommitPut(uint64_t state, uint64_t log_index, const DataBlock* row) {
+    // pairs with the fence in CutSnapshot, the entry is in the offset of a cut not seen here
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    uint64_t cur_state = cut_state_.load();
+    if (GetCutEpoch(cur_state) == GetCutEpoch(state) || log_index <= cut_offset_.load()) {
+        return;
+    }
+    // the entry is recovered from the binlog after the snapshot
+    std::lock_guard<std::mutex> lock(cut_mu_);
+    late_rows_.insert(row);
+}
+
+uint64_t MemTable::MoveCutState(uint16_t epoch, std::unique_lock<std::mutex>* lock) {
+    uint64_t state = cut_state_.load();
+    uint64_t new_state = (((state >> 16) + 1) << 16) | epoch;
+    cut_state_.store(new_state);
+    cut_cv_.wait(*lock, [&] { return putting_cnt_[GetCutParity(state)].load() == 0; });
+    return new_state;
+}
+
+uint16_t MemTable::CutSnapshot(const std::function<uint64_t()>& get_offset, uint64_t* offset) {
+    {
+        // the rows are not frozen until the dump ends, so the packed rows are older than the cut
+        std::lock_guard<std::mutex> lock(freeze_mu_);
+        dumping_.store(true, std::memory_order_release);
+    }
+    uint16_t epoch = GetCutEpoch(cut_state_.load()) + 1;
+    if (epoch == 0) {
+        // a row not visited by the dumps since may keep the epoch used again, the rows
+        // put during the reset are of the last epoch
+        ResetRowEpoch();
+        // the rows not stamped are of epoch 0
+        epoch = 1;
+    }
+    std::unique_lock<std::mutex> lock(cut_mu_);
+    late_rows_.clear();
+    // wait for the puts which may have put a row frozen before the dump starts
+    MoveCutState(GetCutEpoch(cut_state_.load()), &lock);
+    *offset = get_offset();
+    cut_offset_.store(*offset);
+    // pairs with the fence in CommitPut
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    // the puts begun later stamp the rows with the new epoch and have their entries after the offset.
+    // the rows of the puts in progress are inserted once the state moves
+    MoveCutState(epoch, &lock);
+    return epoch;
+}
+
+static uint32_t GetTsColumnId(const std::shared_ptr<IndexDef>& index_def) {
+    auto ts_col = index_def->GetTsColumn();
+    return ts_col ? ts_col->GetId() : UINT32_MAX;
+}
+
+// a row is expired if all the ttls expire it, it is never expired without ttl
+static bool IsAllExpired(const std::vector<TTLSt>& expire_values, uint64_t time, uint64_t record_idx) {
+    if (expire_values.empty()) {
+        return false;
+    }
+    for (const auto& expire_value : expire_values) {
+        if (!expire_value.IsExpired(time, record_idx)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void MemTable::PinGcVersion(bool pin) {
+    uint32_t seg_total = seg_cnt_ << seg_split_depth_;
+    for (uint32_t i = 0; i < segments_.size(); i++) {
+        if (segments_[i] == NULL) {
+            continue;
+        }
+        // the segments split out later are pinned when they are created
+        for (uint32_t j = 0; j < seg_total; j++) {
+            Segment* segment = GetSegment(i, j);
+            if (segment == NULL) {
+                continue;
+            }
+            if (pin) {
+                segment->PinGcVersion();
+            } else {
+                segment->UnpinGcVersion();
+            }
+        }
+    }
+}
+
+void MemTable::ResetRowEpoch() {
+    PinGcVersion(true);
+    uint64_t split_version = split_epoch_.Ref();
+    uint64_t cnt = 0;
+    for (uint32_t i = 0; i < segments_.size(); i++) {
+        if (segments_[i] == NULL) {
+            continue;
+        }
+        for (uint32_t j = 0; j < seg_cnt_; j++) {
+            uint32_t ts_cnt = GetSegment(i, j)->GetTsCnt();
+            SplitKeyIterator pk_it(segments_[i], seg_cnt_, 1 << seg_split_depth_, j);
+            for (pk_it.SeekToFirst(); pk_it.Valid(); pk_it.Next()) {
+                for (uint32_t k = 0; k < ts_cnt; k++) {
+                    KeyEntry* entry = ts_cnt > 1 ? reinterpret_cast<KeyEntry**>(pk_it.GetValue())[k]
+                                                 : reinterpret_cast<KeyEntry*>(pk_it.GetValue());
+                    Ticket ticket;
+                    ticket.Push(entry);
+                    std::unique_ptr<TimeEntryIterator> it(entry->NewIterator());
+                    for (it->SeekToFirst(); it->Valid(); it->Next()) {
+                        // the rows of packed blocks are not stamped
+                        if (!it->InPacked()) {
+                            it->GetValue()->epoch.store(0, std::memory_order_relaxed);
+                            cnt++;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    split_epoch_.UnRef(split_version);
+    PinGcVersion(false);
+    PDLOG(INFO, "reset the snapshot epoch of %lu rows. tid %u pid %u", cnt, id_, pid_);
+}
+
+bool MemTable::DumpRows(uint16_t epoch, const std::function<bool(uint32_t, uint64_t, const Slice&)>& fn) {
+    PinGcVersion(true);
+    // the rows moved by the splits during the walk are met once as the traverse iterator does
+    uint64_t split_version = split_epoch_.Ref();
+    bool ok = true;
+    std::string decoded;
+    auto inner_indexs = table_index_.GetAllInnerIndex();
+    for (uint32_t i = 0; ok && i < inner_indexs->size() && i < segments_.size(); i++) {
+        if (segments_[i] == NULL) {
+            continue;
+        }
+        // walk by the first ready index of it, the rows are the same for the indexes of an inner index.
+        // a row is skipped only if all the ready indexes expire it
+        std::shared_ptr<IndexDef> index_def;
+        std::vector<TTLSt> expire_values;
+        bool no_expire = !enable_gc_.load(std::memory_order_relaxed);
+        for (const auto& cur_index : inner_indexs->at(i)->GetIndex()) {
+            if (!cur_index || !cur_index->IsReady()) {
+                continue;
+            }
+            if (!index_def) {
+                index_def = cur_index;
+            } else if (GetTsColumnId(cur_index) != GetTsColumnId(index_def)) {
+                // the times of the other ts columns are not known in the walk
+                no_expire = true;
+            }
+            auto ttl = cur_index->GetTTL();
+            expire_values.emplace_back(GetExpireTime(*ttl), ttl->lat_ttl, ttl->ttl_type);
+        }
+        if (!index_def) {
+            continue;
+        }
+        if (no_expire) {
+            expire_values.clear();
+        }
+        uint32_t ts_idx = 0;
+        auto ts_col = index_def->GetTsColumn();
+        if (ts_col && GetSegment(i, 0)->GetTsIdx(ts_col->GetId(), ts_idx) < 0) {
+            ts_idx = 0;
+        }
+        for (uint32_t j = 0; ok && j < seg_cnt_; j++) {
+            SplitKeyIterator pk_it(segments_[i], seg_cnt_, 1 << seg_split_depth_, j);
+            for (pk_it.SeekToFirst(); ok && pk_it.Valid(); pk_it.Next()) {
+                KeyEntry* entry = NULL;
+                if (GetSegment(i, j)->GetTsCnt() > 1) {
+                    entry = reinterpret_cast<KeyEntry**>(pk_it.GetValue())[ts_idx];
+                } else {
+                    entry = reinterpret_cast<KeyEntry*>(pk_it.GetValue());
+                }
+                Ticket ticket;
+                ticket.Push(entry);
+                std::unique_ptr<TimeEntryIterator> it(entry->NewIterator());
+                it->SeekToFirst();
+                for (uint64_t record_idx = 1; it->Valid() && !IsAllExpired(expire_values, it->GetKey(), record_idx);
+                     it->Next(), record_idx++) {
+                    DataBlock* block = it->GetValue();
+                    // the rows of packed blocks are in one index only and older than the cut
+                    if (!it->InPacked()) {
+                        // put after the cut or met in another inner index already
+                        if (block->epoch.load(std::memory_order_relaxed) == epoch || late_rows_.count(block) > 0) {
+                            continue;
+                        }
+                        block->epoch.store(epoch, std::memory_order_relaxed);
+                    }
+                    Slice row(block->data, block->size);
+                    if (string_dict_ && codec::IsDictRow(reinterpret_cast<const int8_t*>(block->data))) {
+                        if (!string_dict_->DecodeRow(reinterpret_cast<const int8_t*>(block->data), &decoded)) {
+                            PDLOG(WARNING, "fail to decode the dictionary coded row. tid %u pid %u", id_, pid_);
+                            ok = false;
+                            break;
+                        }
+                        row = Slice(decoded);
+                    }
+                    if (!fn(i, it->GetKey(), row)) {
+                        ok = false;
+                        break;
+                    }
+                }
+                if (ok && it->Failed()) {
+                    PDLOG(WARNING, "fail to read the packed rows. tid %u pid %u", id_, pid_);
+                    ok = false;
+                }
+            }
+        }
+    }
+    split_epoch_.UnRef(split_version);
+    PinGcVersion(false);
+    return ok;
+}
+
 bool MemTable::DeleteIndex(const std::string& idx_name) {
     std::shared_ptr<IndexDef> index_def = table_index_.GetIndex(idx_name);
     if (!index_def) {
@@ -667,7 +1181,15 @@ bool MemTable::DeleteIndex(const std::string& idx_name) {
     if (ts_col) {
         ts_idx = ts_col->GetId();
     }
-    return new MemTableKeyIterator(segments_[real_idx], seg_cnt_, ttl->ttl_type, expire_time, expire_cnt, ts_idx);
+    MemTableKeyIterator* it = NULL;
+    if (seg_split_depth_ > 0) {
+        it = new MemTableKeyIterator(segments_[real_idx], seg_cnt_, ttl->ttl_type, expire_time, expire_cnt, ts_idx,
+                                     1 << seg_split_depth_, &split_epoch_);
+    } else {
+        it = new MemTableKeyIterator(segments_[real_idx], seg_cnt_, ttl->ttl_type, expire_time, expire_cnt, ts_idx);
+    }
+    it->SetStringDict(string_dict_.get());
+    return it;
 }
 
 TableIterator* MemTable::NewTraverseIterator(uint32_t index) {
@@ -685,11 +1207,20 @@ TableIterator* MemTable::NewTraverseIterator(uint32_t index) {
     }
     uint32_t real_idx = index_def->GetInnerPos();
     auto ts_col = index_def->GetTsColumn();
+    uint32_t ts_idx = 0;
     if (ts_col) {
-        return new MemTableTraverseIterator(segments_[real_idx], seg_cnt_, ttl->ttl_type, expire_time, expire_cnt,
-                                            ts_col->GetId());
+        ts_idx = ts_col->GetId();
     }
-    return new MemTableTraverseIterator(segments_[real_idx], seg_cnt_, ttl->ttl_type, expire_time, expire_cnt, 0);
+    MemTableTraverseIterator* it = NULL;
+    if (seg_split_depth_ > 0) {
+        it = new MemTableTraverseIterator(segments_[real_idx], seg_cnt_, ttl->ttl_type, expire_time, expire_cnt,
+                                          ts_idx, 1 << seg_split_depth_, &split_epoch_);
+    } else {
+        it = new MemTableTraverseIterator(segments_[real_idx], seg_cnt_, ttl->ttl_type, expire_time, expire_cnt,
+                                          ts_idx);
+    }
+    it->SetStringDict(string_dict_.get());
+    return it;
 }
 
 bool MemTable::GetBulkLoadInfo(::openmldb::api::BulkLoadInfoResponse* response) {
@@ -722,7 +1253,7 @@ bool MemTable::GetBulkLoadInfo(::openmldb::api::BulkLoadInfoResponse* response)
         auto segments = segments_[inner_id];
         auto pb_segments = response->add_inner_segments();
         for (decltype(seg_cnt_) i = 0; i < seg_cnt_; ++i) {
-            auto seg = segments[i];
+            auto seg = segments[i].load(std::memory_order_relaxed);
             auto pb_seg = pb_segments->add_segment();
             pb_seg->set_ts_cnt(seg->GetTsCnt());
             const auto& ts_idx_map = seg->GetTsIdxMap();
@@ -738,6 +1269,7 @@ bool MemTable::GetBulkLoadInfo(::openmldb::api::BulkLoadInfoResponse* response)
 
 bool MemTable::BulkLoad(const std::vector<DataBlock*>& data_blocks,
                         const ::google::protobuf::RepeatedPtrField<::openmldb::api::BulkLoadIndex>& indexes) {
+    std::lock_guard<std::mutex> lock(split_mu_);
     // data_block[i] is the block which id == i
     for (int i = 0; i < indexes.size(); ++i) {
         const auto& inner_index = indexes.Get(i);
@@ -745,7 +1277,7 @@ bool MemTable::BulkLoad(const std::vector<DataBlock*>& data_blocks,
         for (int j = 0; j < inner_index.segment_size(); ++j) {
             const auto& segment_index = inner_index.segment(j);
             auto seg_idx = segment_index.id();
-            auto segment = segments_[real_idx][seg_idx];
+            auto segment = GetSegment(real_idx, seg_idx);
             for (int key_idx = 0; key_idx < segment_index.key_entries_size(); ++key_idx) {
                 const auto& key_entries = segment_index.key_entries(key_idx);
                 auto pk = Slice(key_entries.key());
@@ -776,26 +1308,109 @@ bool MemTable::BulkLoad(const std::vector<DataBlock*>& data_blocks,
     return true;
 }
 
-MemTableKeyIterator::MemTableKeyIterator(Segment** segments, uint32_t seg_cnt, ::openmldb::storage::TTLType ttl_type,
-                                         uint64_t expire_time, uint64_t expire_cnt, uint32_t ts_index)
+SplitKeyIterator::SplitKeyIterator(std::atomic<Segment*>* segments, uint32_t seg_cnt, uint32_t seg_split_cnt,
+                                   uint32_t root)
+    : its_(), cur_(NULL) {
+    for (uint32_t i = 0; i < seg_split_cnt; i++) {
+        Segment* segment = segments[root + seg_cnt * i].load(std::memory_order_acquire);
+        if (segment != NULL) {
+            its_.push_back(segment->GetKeyEntries()->NewIterator());
+        }
+    }
+}
+
+SplitKeyIterator::~SplitKeyIterator() {
+    for (auto it : its_) {
+        delete it;
+    }
+}
+
+void SplitKeyIterator::FindSmallest() {
+    cur_ = NULL;
+    for (auto it : its_) {
+        if (it->Valid() && (cur_ == NULL || it->GetKey().compare(cur_->GetKey()) < 0)) {
+            cur_ = it;
+        }
+    }
+}
+
+void SplitKeyIterator::Next() {
+    if (its_.size() > 1) {
+        // the keys in split are in both segments
+        for (auto it : its_) {
+            if (it != cur_ && it->Valid() && it->GetKey().compare(cur_->GetKey()) == 0) {
+                it->Next();
+            }
+        }
+    }
+    cur_->Next();
+    FindSmallest();
+}
+
+void SplitKeyIterator::Seek(const Slice& key) {
+    for (auto it : its_) {
+        it->Seek(key);
+    }
+    FindSmallest();
+}
+
+void SplitKeyIterator::SeekToFirst() {
+    for (auto it : its_) {
+        it->SeekToFirst();
+    }
+    FindSmallest();
+}
+
+bool MemTableWindowIterator::DecodeRow(const int8_t* data) {
+    std::string row;
+    if (!dict_->DecodeRow(data, &row)) {
+        PDLOG(WARNING, "fail to decode the dictionary coded row");
+        return false;
+    }
+    CopyRow(row.data(), row.size());
+    return true;
+}
+
+void MemTableWindowIterator::CopyRow(const char* data, uint32_t size) {
+    // the row frees the buffer with free
+    int8_t* buf = reinterpret_cast<int8_t*>(malloc(size));
+    memcpy(buf, data, size);
+    row_ = ::hybridse::codec::Row(::hybridse::base::RefCountedSlice::CreateManaged(buf, size));
+    decoded_ = true;
+}
+
+MemTableKeyIterator::MemTableKeyIterator(std::atomic<Segment*>* segments, uint32_t seg_cnt,
+                                         ::openmldb::storage::TTLType ttl_type, uint64_t expire_time,
+                                         uint64_t expire_cnt, uint32_t ts_index, uint32_t seg_split_cnt,
+                                         SegmentSplitEpoch* split_epoch)
     : segments_(segments),
       seg_cnt_(seg_cnt),
+      seg_split_cnt_(seg_split_cnt),
+      split_epoch_(split_epoch),
+      split_version_(0),
       seg_idx_(0),
       pk_it_(NULL),
       it_(NULL),
+      dict_(NULL),
       ttl_type_(ttl_type),
       expire_time_(expire_time),
       expire_cnt_(expire_cnt),
       ticket_(),
       ts_idx_(0) {
     uint32_t idx = 0;
-    if (segments_[0]->GetTsIdx(ts_index, idx) == 0) {
+    if (segments_[0].load(std::memory_order_relaxed)->GetTsIdx(ts_index, idx) == 0) {
         ts_idx_ = idx;
     }
+    if (split_epoch_ != NULL) {
+        split_version_ = split_epoch_->Ref();
+    }
 }
 
 MemTableKeyIterator::~MemTableKeyIterator() {
     if (pk_it_ != NULL) delete pk_it_;
+    if (split_epoch_ != NULL) {
+        split_epoch_->UnRef(split_version_);
+    }
 }
 
 void MemTableKeyIterator::SeekToFirst() {
@@ -805,7 +1420,7 @@ void MemTableKeyIterator::SeekToFirst() {
         pk_it_ = NULL;
     }
     for (seg_idx_ = 0; seg_idx_ < seg_cnt_; seg_idx_++) {
-        pk_it_ = segments_[seg_idx_]->GetKeyEntries()->NewIterator();
+        pk_it_ = new SplitKeyIterator(segments_, seg_cnt_, seg_split_cnt_, seg_idx_);
         pk_it_->SeekToFirst();
         if (pk_it_->Valid()) return;
         delete pk_it_;
@@ -823,7 +1438,7 @@ void MemTableKeyIterator::Seek(const std::string& key) {
         seg_idx_ = ::openmldb::base::hash(key.c_str(), key.length(), SEED) % seg_cnt_;
     }
     Slice spk(key);
-    pk_it_ = segments_[seg_idx_]->GetKeyEntries()->NewIterator();
+    pk_it_ = new SplitKeyIterator(segments_, seg_cnt_, seg_split_cnt_, seg_idx_);
     pk_it_->Seek(spk);
     if (!pk_it_->Valid()) {
         NextPK();
@@ -838,33 +1453,34 @@ bool MemTableKeyIterator::Valid() {
 void MemTableKeyIterator::Next() { NextPK(); }
 
 ::hybridse::vm::RowIterator* MemTableKeyIterator::GetRawValue() {
-    TimeEntries::Iterator* it = NULL;
-    if (segments_[seg_idx_]->GetTsCnt() > 1) {
+    TimeEntryIterator* it = NULL;
+    if (segments_[seg_idx_].load(std::memory_order_relaxed)->GetTsCnt() > 1) {
         KeyEntry* entry = ((KeyEntry**)pk_it_->GetValue())[ts_idx_];  // NOLINT
-        it = entry->entries.NewIterator();
+        it = entry->NewIterator();
         ticket_.Push(entry);
     } else {
-        it = ((KeyEntry*)pk_it_->GetValue())  // NOLINT
-                 ->entries.NewIterator();
-        ticket_.Push((KeyEntry*)pk_it_->GetValue());  // NOLINT
+        it = ((KeyEntry*)pk_it_->GetValue())->NewIterator();  // NOLINT
+        ticket_.Push((KeyEntry*)pk_it_->GetValue());          // NOLINT
     }
     it->SeekToFirst();
-    return new MemTableWindowIterator(it, ttl_type_, expire_time_, expire_cnt_);
+    MemTableWindowIterator* wit = new MemTableWindowIterator(it, ttl_type_, expire_time_, expire_cnt_);
+    wit->SetStringDict(dict_);
+    return wit;
 }
 
 std::unique_ptr<::hybridse::vm::RowIterator> MemTableKeyIterator::GetValue() {
-    TimeEntries::Iterator* it = NULL;
-    if (segments_[seg_idx_]->GetTsCnt() > 1) {
+    TimeEntryIterator* it = NULL;
+    if (segments_[seg_idx_].load(std::memory_order_relaxed)->GetTsCnt() > 1) {
         KeyEntry* entry = ((KeyEntry**)pk_it_->GetValue())[ts_idx_];  // NOLINT
-        it = entry->entries.NewIterator();
+        it = entry->NewIterator();
         ticket_.Push(entry);
     } else {
-        it = ((KeyEntry*)pk_it_->GetValue())  // NOLINT
-                 ->entries.NewIterator();
-        ticket_.Push((KeyEntry*)pk_it_->GetValue());  // NOLINT
+        it = ((KeyEntry*)pk_it_->GetValue())->NewIterator();  // NOLINT
+        ticket_.Push((KeyEntry*)pk_it_->GetValue());          // NOLINT
     }
     it->SeekToFirst();
     std::unique_ptr<MemTableWindowIterator> wit(new MemTableWindowIterator(it, ttl_type_, expire_time_, expire_cnt_));
+    wit->SetStringDict(dict_);
     return std::move(wit);
 }
 
@@ -885,7 +1501,7 @@ void MemTableKeyIterator::NextPK() {
             pk_it_ = NULL;
             seg_idx_++;
             if (seg_idx_ < seg_cnt_) {
-                pk_it_ = segments_[seg_idx_]->GetKeyEntries()->NewIterator();
+                pk_it_ = new SplitKeyIterator(segments_, seg_cnt_, seg_split_cnt_, seg_idx_);
                 pk_it_->SeekToFirst();
                 if (!pk_it_->Valid()) {
                     continue;
@@ -896,11 +1512,15 @@ void MemTableKeyIterator::NextPK() {
     } while (true);
 }
 
-MemTableTraverseIterator::MemTableTraverseIterator(Segment** segments, uint32_t seg_cnt,
+MemTableTraverseIterator::MemTableTraverseIterator(std::atomic<Segment*>* segments, uint32_t seg_cnt,
                                                    ::openmldb::storage::TTLType ttl_type, uint64_t expire_time,
-                                                   uint64_t expire_cnt, uint32_t ts_index)
+                                                   uint64_t expire_cnt, uint32_t ts_index, uint32_t seg_split_cnt,
+                                                   SegmentSplitEpoch* split_epoch)
     : segments_(segments),
       seg_cnt_(seg_cnt),
+      seg_split_cnt_(seg_split_cnt),
+      split_epoch_(split_epoch),
+      split_version_(0),
       seg_idx_(0),
       pk_it_(NULL),
       it_(NULL),
@@ -908,16 +1528,24 @@ MemTableTraverseIterator::MemTableTraverseIterator(Segment** segments, uint32_t
       ts_idx_(0),
       expire_value_(expire_time, expire_cnt, ttl_type),
       ticket_(),
-      traverse_cnt_(0) {
+      traverse_cnt_(0),
+      dict_(NULL),
+      decoded_row_() {
     uint32_t idx = 0;
-    if (segments_[0]->GetTsIdx(ts_index, idx) == 0) {
+    if (segments_[0].load(std::memory_order_relaxed)->GetTsIdx(ts_index, idx) == 0) {
         ts_idx_ = idx;
     }
+    if (split_epoch_ != NULL) {
+        split_version_ = split_epoch_->Ref();
+    }
 }
 
 MemTableTraverseIterator::~MemTableTraverseIterator() {
     if (pk_it_ != NULL) delete pk_it_;
     if (it_ != NULL) delete it_;
+    if (split_epoch_ != NULL) {
+        split_epoch_->UnRef(split_version_);
+    }
 }
 
 bool MemTableTraverseIterator::Valid() {
@@ -949,7 +1577,7 @@ void MemTableTraverseIterator::NextPK() {
             pk_it_ = NULL;
             seg_idx_++;
             if (seg_idx_ < seg_cnt_) {
-                pk_it_ = segments_[seg_idx_]->GetKeyEntries()->NewIterator();
+                pk_it_ = new SplitKeyIterator(segments_, seg_cnt_, seg_split_cnt_, seg_idx_);
                 pk_it_->SeekToFirst();
                 if (!pk_it_->Valid()) {
                     continue;
@@ -962,14 +1590,13 @@ void MemTableTraverseIterator::NextPK() {
             delete it_;
             it_ = NULL;
         }
-        if (segments_[seg_idx_]->GetTsCnt() > 1) {
+        if (segments_[seg_idx_].load(std::memory_order_relaxed)->GetTsCnt() > 1) {
             KeyEntry* entry = ((KeyEntry**)pk_it_->GetValue())[0];  // NOLINT
-            it_ = entry->entries.NewIterator();
+            it_ = entry->NewIterator();
             ticket_.Push(entry);
         } else {
-            it_ = ((KeyEntry*)pk_it_->GetValue())  // NOLINT
-                      ->entries.NewIterator();
-            ticket_.Push((KeyEntry*)pk_it_->GetValue());  // NOLINT
+            it_ = ((KeyEntry*)pk_it_->GetValue())->NewIterator();  // NOLINT
+            ticket_.Push((KeyEntry*)pk_it_->GetValue());                     // NOLINT
         }
         it_->SeekToFirst();
         record_idx_ = 1;
@@ -994,17 +1621,16 @@ void MemTableTraverseIterator::Seek(const std::string& key, uint64_t ts) {
         seg_idx_ = ::openmldb::base::hash(key.c_str(), key.length(), SEED) % seg_cnt_;
     }
     Slice spk(key);
-    pk_it_ = segments_[seg_idx_]->GetKeyEntries()->NewIterator();
+    pk_it_ = new SplitKeyIterator(segments_, seg_cnt_, seg_split_cnt_, seg_idx_);
     pk_it_->Seek(spk);
     if (pk_it_->Valid()) {
-        if (segments_[seg_idx_]->GetTsCnt() > 1) {
+        if (segments_[seg_idx_].load(std::memory_order_relaxed)->GetTsCnt() > 1) {
             KeyEntry* entry = ((KeyEntry**)pk_it_->GetValue())[ts_idx_];  // NOLINT
             ticket_.Push(entry);
-            it_ = entry->entries.NewIterator();
+            it_ = entry->NewIterator();
         } else {
-            ticket_.Push((KeyEntry*)pk_it_->GetValue());  // NOLINT
-            it_ = ((KeyEntry*)pk_it_->GetValue())         // NOLINT
-                      ->entries.NewIterator();
+            ticket_.Push((KeyEntry*)pk_it_->GetValue());                     // NOLINT
+            it_ = ((KeyEntry*)pk_it_->GetValue())->NewIterator();  // NOLINT
         }
         if (spk.compare(pk_it_->GetKey()) != 0) {
             it_->SeekToFirst();
@@ -1043,7 +1669,14 @@ void MemTableTraverseIterator::Seek(const std::string& key, uint64_t ts) {
 }
 
 openmldb::base::Slice MemTableTraverseIterator::GetValue() const {
-    return openmldb::base::Slice(it_->GetValue()->data, it_->GetValue()->size);
+    DataBlock* block = it_->GetValue();
+    if (dict_ != NULL && codec::IsDictRow(reinterpret_cast<const int8_t*>(block->data))) {
+        if (dict_->DecodeRow(reinterpret_cast<const int8_t*>(block->data), &decoded_row_)) {
+            return openmldb::base::Slice(decoded_row_);
+        }
+        PDLOG(WARNING, "fail to decode the dictionary coded row");
+    }
+    return openmldb::base::Slice(block->data, block->size);
 }
 
 uint64_t MemTableTraverseIterator::GetKey() const {
@@ -1071,17 +1704,16 @@ void MemTableTraverseIterator::SeekToFirst() {
         it_ = NULL;
     }
     for (seg_idx_ = 0; seg_idx_ < seg_cnt_; seg_idx_++) {
-        pk_it_ = segments_[seg_idx_]->GetKeyEntries()->NewIterator();
+        pk_it_ = new SplitKeyIterator(segments_, seg_cnt_, seg_split_cnt_, seg_idx_);
         pk_it_->SeekToFirst();
         while (pk_it_->Valid()) {
-            if (segments_[seg_idx_]->GetTsCnt() > 1) {
+            if (segments_[seg_idx_].load(std::memory_order_relaxed)->GetTsCnt() > 1) {
                 KeyEntry* entry = ((KeyEntry**)pk_it_->GetValue())[ts_idx_];  // NOLINT
                 ticket_.Push(entry);
-                it_ = entry->entries.NewIterator();
+                it_ = entry->NewIterator();
             } else {
-                ticket_.Push((KeyEntry*)pk_it_->GetValue());  // NOLINT
-                it_ = ((KeyEntry*)pk_it_->GetValue())         // NOLINT
-                          ->entries.NewIterator();
+                ticket_.Push((KeyEntry*)pk_it_->GetValue());                     // NOLINT
+                it_ = ((KeyEntry*)pk_it_->GetValue())->NewIterator();  // NOLINT
             }
             it_->SeekToFirst();
             traverse_cnt_++;
@@ -18,14 +18,20 @@
 #define SRC_STORAGE_MEM_TABLE_H_
 
 #include <atomic>
+#include <condition_variable>  // NOLINT
+#include <functional>
 #include <map>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <string>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "proto/tablet.pb.h"
 #include "storage/iterator.h"
 #include "storage/segment.h"
+#include "storage/string_dict.h"
 #include "storage/table.h"
 #include "storage/ticket.h"
 #include "vm/catalog.h"
@@ -40,9 +46,10 @@ typedef google::protobuf::RepeatedPtrField<::openmldb::api::Dimension> Dimension
 
 class MemTableWindowIterator : public ::hybridse::vm::RowIterator {
  public:
-    MemTableWindowIterator(TimeEntries::Iterator* it, ::openmldb::storage::TTLType ttl_type, uint64_t expire_time,
+    MemTableWindowIterator(TimeEntryIterator* it, ::openmldb::storage::TTLType ttl_type, uint64_t expire_time,
                            uint64_t expire_cnt)
-        : it_(it), record_idx_(1), expire_value_(expire_time, expire_cnt, ttl_type), row_() {}
+        : it_(it), record_idx_(1), expire_value_(expire_time, expire_cnt, ttl_type), row_(), dict_(NULL),
+          decoded_(false) {}
 
     ~MemTableWindowIterator() { delete it_; }
 
@@ -62,24 +69,108 @@ class MemTableWindowIterator : public ::hybridse::vm::RowIterator {
 
     // TODO(wangtaize) unify the row object
     inline const ::hybridse::codec::Row& GetValue() {
-        row_.Reset(reinterpret_cast<const int8_t*>(it_->GetValue()->data), it_->GetValue()->size);
+        DataBlock* block = it_->GetValue();
+        const int8_t* data = reinterpret_cast<const int8_t*>(block->data);
+        if (dict_ != NULL && ::openmldb::codec::IsDictRow(data) && DecodeRow(data)) {
+            return row_;
+        }
+        if (it_->InPacked()) {
+            // the unpacked row is gone once the iterator moves to the next block
+            CopyRow(block->data, block->size);
+            return row_;
+        }
+        if (decoded_) {
+            // drop the decoded row, Reset does not release it
+            row_ = ::hybridse::codec::Row();
+            decoded_ = false;
+        }
+        row_.Reset(data, it_->GetValue()->size);
         return row_;
     }
     inline void Seek(const uint64_t& key) { it_->Seek(key); }
     inline void SeekToFirst() { it_->SeekToFirst(); }
     inline bool IsSeekable() const { return true; }
 
+    // decode the dictionary coded rows with dict
+    inline void SetStringDict(const StringDict* dict) { dict_ = dict; }
+
  private:
-    TimeEntries::Iterator* it_;
+    // the decoded row is owned by row_ and released with the last row refers to it
+    bool DecodeRow(const int8_t* data);
+    void CopyRow(const char* data, uint32_t size);
+
+ private:
+    TimeEntryIterator* it_;
     uint32_t record_idx_;
     TTLSt expire_value_;
     ::hybridse::codec::Row row_;
+    const StringDict* dict_;
+    bool decoded_;
+};
+
+// counts the key iterators by the split version they start in. the keys moved by
+// a segment split are removed from the old segment only after the iterators started
+// before the split are gone, see Segment::RemoveSplitKeys
+class SegmentSplitEpoch {
+ public:
+    SegmentSplitEpoch() : version_(0) {
+        ref_cnt_[0].store(0, std::memory_order_relaxed);
+        ref_cnt_[1].store(0, std::memory_order_relaxed);
+    }
+
+    inline uint64_t Ref() {
+        while (true) {
+            uint64_t version = version_.load(std::memory_order_acquire);
+            ref_cnt_[version & 1].fetch_add(1, std::memory_order_seq_cst);
+            if (version_.load(std::memory_order_seq_cst) == version) {
+                return version;
+            }
+            ref_cnt_[version & 1].fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    inline void UnRef(uint64_t version) { ref_cnt_[version & 1].fetch_sub(1, std::memory_order_release); }
+
+    // start a new version and return the old one
+    inline uint64_t Incr() { return version_.fetch_add(1, std::memory_order_seq_cst); }
+
+    inline bool HasRef(uint64_t version) const { return ref_cnt_[version & 1].load(std::memory_order_acquire) > 0; }
+
+ private:
+    std::atomic<uint64_t> version_;
+    std::atomic<int64_t> ref_cnt_[2];
+};
+
+// iterates the keys of a root segment and the segments split from it in order
+class SplitKeyIterator {
+ public:
+    // the segments split from root are at root + seg_cnt * n, n < seg_split_cnt
+    // the segments not split out yet are NULL
+    SplitKeyIterator(std::atomic<Segment*>* segments, uint32_t seg_cnt, uint32_t seg_split_cnt, uint32_t root);
+    ~SplitKeyIterator();
+    SplitKeyIterator(const SplitKeyIterator&) = delete;
+    SplitKeyIterator& operator=(const SplitKeyIterator&) = delete;
+
+    inline bool Valid() const { return cur_ != NULL; }
+    void Next();
+    void Seek(const Slice& key);
+    void SeekToFirst();
+    inline const Slice& GetKey() const { return cur_->GetKey(); }
+    inline void* GetValue() const { return cur_->GetValue(); }
+
+ private:
+    void FindSmallest();
+
+ private:
+    std::vector<KeyEntries::Iterator*> its_;
+    KeyEntries::Iterator* cur_;
 };
 
 class MemTableKeyIterator : public ::hybridse::vm::WindowIterator {
  public:
-    MemTableKeyIterator(Segment** segments, uint32_t seg_cnt, ::openmldb::storage::TTLType ttl_type,
-                        uint64_t expire_time, uint64_t expire_cnt, uint32_t ts_index);
+    MemTableKeyIterator(std::atomic<Segment*>* segments, uint32_t seg_cnt, ::openmldb::storage::TTLType ttl_type,
+                        uint64_t expire_time, uint64_t expire_cnt, uint32_t ts_index, uint32_t seg_split_cnt = 1,
+                        SegmentSplitEpoch* split_epoch = NULL);
 
     ~MemTableKeyIterator() override;
 
@@ -96,15 +187,22 @@ class MemTableKeyIterator : public ::hybridse::vm::WindowIterator {
 
     const hybridse::codec::Row GetKey() override;
 
+    // decode the dictionary coded rows with dict
+    inline void SetStringDict(const StringDict* dict) { dict_ = dict; }
+
  private:
     void NextPK();
 
  private:
-    Segment** segments_;
+    std::atomic<Segment*>* segments_;
     uint32_t const seg_cnt_;
+    uint32_t const seg_split_cnt_;
+    SegmentSplitEpoch* split_epoch_;
+    uint64_t split_version_;
     uint32_t seg_idx_;
-    KeyEntries::Iterator* pk_it_;
-    TimeEntries::Iterator* it_;
+    SplitKeyIterator* pk_it_;
+    TimeEntryIterator* it_;
+    const StringDict* dict_;
     ::openmldb::storage::TTLType ttl_type_;
     uint64_t expire_time_;
     uint64_t expire_cnt_;
@@ -115,8 +213,9 @@ class MemTableKeyIterator : public ::hybridse::vm::WindowIterator {
 
 class MemTableTraverseIterator : public TableIterator {
  public:
-    MemTableTraverseIterator(Segment** segments, uint32_t seg_cnt, ::openmldb::storage::TTLType ttl_type,
-                             uint64_t expire_time, uint64_t expire_cnt, uint32_t ts_index);
+    MemTableTraverseIterator(std::atomic<Segment*>* segments, uint32_t seg_cnt, ::openmldb::storage::TTLType ttl_type,
+                             uint64_t expire_time, uint64_t expire_cnt, uint32_t ts_index,
+                             uint32_t seg_split_cnt = 1, SegmentSplitEpoch* split_epoch = NULL);
     ~MemTableTraverseIterator() override;
     inline bool Valid() override;
     void Next() override;
@@ -127,21 +226,30 @@ class MemTableTraverseIterator : public TableIterator {
     void SeekToFirst() override;
     uint64_t GetCount() const override;
 
+    // decode the dictionary coded rows with dict
+    inline void SetStringDict(const StringDict* dict) { dict_ = dict; }
+
  private:
     void NextPK();
 
  private:
-    Segment** segments_;
+    std::atomic<Segment*>* segments_;
     uint32_t const seg_cnt_;
+    uint32_t const seg_split_cnt_;
+    SegmentSplitEpoch* split_epoch_;
+    uint64_t split_version_;
     uint32_t seg_idx_;
-    KeyEntries::Iterator* pk_it_;
-    TimeEntries::Iterator* it_;
+    SplitKeyIterator* pk_it_;
+    TimeEntryIterator* it_;
     uint32_t record_idx_;
     uint32_t ts_idx_;
     // uint64_t expire_value_;
     TTLSt expire_value_;
     Ticket ticket_;
     uint64_t traverse_cnt_;
+    const StringDict* dict_;
+    // the decoded current row, valid until the iterator moves
+    mutable std::string decoded_row_;
 };
 
 class MemTable : public Table {
@@ -160,6 +268,14 @@ class MemTable : public Table {
 
     bool Put(uint64_t time, const std::string& value, const Dimensions& dimensions) override;
 
+    // put a row referenced by value, the keys of dimensions are paired with the index id
+    bool Put(uint64_t time, const ::openmldb::base::Slice& value,
+             const std::vector<std::pair<uint32_t, ::openmldb::base::Slice>>& dimensions);
+
+    // put a row of the epoch of the cut state a put begins in, row is set to the row put. see PutGuard
+    bool Put(uint64_t time, const std::string& value, const Dimensions& dimensions, uint64_t state,
+             DataBlock** row);
+
     bool GetBulkLoadInfo(::openmldb::api::BulkLoadInfoResponse* response);
 
     bool BulkLoad(const std::vector<DataBlock*>& data_blocks,
@@ -212,24 +328,177 @@ class MemTable : public Table {
 
     inline uint32_t GetKeyEntryHeight() const { return key_entry_max_height_; }
 
+    inline uint64_t GetPutCnt() const { return put_cnt_.load(std::memory_order_relaxed); }
+
+    // the total time consumed by put in microsecond
+    inline uint64_t GetPutTime() const { return put_time_.load(std::memory_order_relaxed); }
+
+    inline const ::openmldb::base::SlabAllocator* GetSlabAllocator() const { return slab_.get(); }
+
+    inline const StringDict* GetStringDict() const { return string_dict_.get(); }
+
+    inline uint64_t GetGcCnt() const { return gc_cnt_.load(std::memory_order_relaxed); }
+
+    // the time consumed by the last gc in millisecond
+    inline uint64_t GetLastGcTime() const { return last_gc_time_.load(std::memory_order_relaxed); }
+
+    // the total count of records freed by gc
+    inline uint64_t GetGcRecordCnt() const { return gc_record_cnt_.load(std::memory_order_relaxed); }
+
     bool DeleteIndex(const std::string& idx_name) override;
 
     bool AddIndex(const ::openmldb::common::ColumnKey& column_key);
 
+    // a put and the append of its binlog entry are done between BeginPut and EndPut, so
+    // CutSnapshot waits for the puts begun before it. the later puts go on. return the cut state
+    uint64_t BeginPut();
+
+    void EndPut(uint64_t state);
+
+    // the binlog entry of the row put in state is appended at log_index. the row is left out
+    // of the dump if a cut moves on in between and the entry is after the offset of the cut
+    void CommitPut(uint64_t state, uint64_t log_index, const DataBlock* row);
+
+    // start a new snapshot epoch and get the binlog offset by get_offset. the rows put later
+    // are of the new epoch or have their entries after the offset. return the epoch.
+    // the dump started by the cut must be ended by EndDump, see DumpGuard
+    uint16_t CutSnapshot(const std::function<uint64_t()>& get_offset, uint64_t* offset);
+
+    // walk the live rows put before the cut of epoch while the puts go on, each row is passed
+    // to fn once with the inner index and the time it is found by. stop if fn returns false
+    bool DumpRows(uint16_t epoch, const std::function<bool(uint32_t, uint64_t, const Slice&)>& fn);
+
+    // the rows can be frozen again
+    inline void EndDump() { dumping_.store(false, std::memory_order_release); }
+
  private:
     bool CheckAbsolute(const TTLSt& ttl, uint64_t ts);
 
     bool CheckLatest(uint32_t index_id, const std::string& key, uint64_t ts);
 
+    // place the root segments of seg_arr in the split trees, the segments split out
+    // are created by the splits
+    void InitSplitTree(std::atomic<Segment*>* seg_arr);
+
+    // the segment j of inner index i, NULL if it is not split out yet
+    inline Segment* GetSegment(uint32_t i, uint32_t j) const {
+        return segments_[i][j].load(std::memory_order_acquire);
+    }
+
+    // split the segment with the most keys
+    void SplitSegment();
+
+    // remove the keys moved by the last split from the old segment, it waits for the
+    // key iterators started before the split unless force is set
+    bool RemoveSplitKeys(bool force);
+
+    // keep the rows from being freed by gc during a walk of them, or let them go
+    void PinGcVersion(bool pin);
+
+    // stamp all the rows with epoch 0, so that no row keeps an epoch that is used again
+    // after the epoch wraps around
+    void ResetRowEpoch();
+
+    bool Put(uint64_t time, const ::openmldb::base::Slice& value,
+             const std::vector<std::pair<uint32_t, ::openmldb::base::Slice>>& dimensions, uint16_t epoch,
+             DataBlock** put_row);
+
+    // move the cut state to epoch and wait for the puts begun in the old state, need cut_mu_ held
+    uint64_t MoveCutState(uint16_t epoch, std::unique_lock<std::mutex>* lock);
+
  private:
     uint32_t seg_cnt_;
-    std::vector<Segment**> segments_;
+    // the root segments split to at most seg_cnt_ << seg_split_depth_ segments
+    uint32_t seg_split_depth_;
+    std::vector<std::atomic<Segment*>*> segments_;
     std::atomic<bool> enable_gc_;
     uint64_t ttl_offset_;
     std::atomic<uint64_t> record_cnt_;
     bool segment_released_;
     std::atomic<uint64_t> record_byte_size_;
     uint32_t key_entry_max_height_;
+    std::atomic<uint64_t> put_cnt_;
+    std::atomic<uint64_t> put_time_;
+    std::atomic<uint64_t> gc_cnt_;
+    std::atomic<uint64_t> last_gc_time_;
+    std::atomic<uint64_t> gc_record_cnt_;
+    std::unique_ptr<::openmldb::base::SlabAllocator> slab_;
+    // code the repeated strings of the rows put
+    std::unique_ptr<StringDict> string_dict_;
+    // the split with the keys not removed from the old segment yet
+    std::atomic<Segment*> split_segment_;
+    std::atomic<Segment*> split_child_;
+    uint64_t split_version_;
+    // the time in millisecond the split keys start to wait the key iterators
+    uint64_t split_time_;
+    SegmentSplitEpoch split_epoch_;
+    // bulk load puts into the segments directly
+    std::mutex split_mu_;
+    // the count of cuts in the high bits and the epoch the rows put are stamped with in the
+    // low 16 bits, see CutSnapshot
+    std::atomic<uint64_t> cut_state_;
+    // the puts in progress by the parity of the count of cuts they begin in
+    std::atomic<uint32_t> putting_cnt_[2];
+    std::atomic<uint64_t> cut_offset_;
+    std::mutex cut_mu_;
+    std::condition_variable cut_cv_;
+    // the rows of the puts begun before the last cut with the entries after its offset, guarded by cut_mu_.
+    // they are only compared with the rows dumped
+    std::unordered_set<const DataBlock*> late_rows_;
+    // the rows are not frozen while dumping, a packed row is not stamped
+    std::atomic<bool> dumping_;
+    // hold the freeze of a segment off the start of a dump
+    std::mutex freeze_mu_;
+};
+
+// a put to the table and the append of its binlog entry in the scope, see MemTable::BeginPut.
+// table is NULL if the snapshot is not dumped from the memtable
+class PutGuard {
+ public:
+    explicit PutGuard(MemTable* table) : table_(table), state_(0), row_(NULL) {
+        if (table_ != NULL) {
+            state_ = table_->BeginPut();
+        }
+    }
+    ~PutGuard() {
+        if (table_ != NULL) {
+            table_->EndPut(state_);
+        }
+    }
+    PutGuard(const PutGuard&) = delete;
+    PutGuard& operator=(const PutGuard&) = delete;
+
+    // put to table, which is the table of the guard if it is set
+    bool Put(Table* table, uint64_t time, const std::string& value, const Dimensions& dimensions) {
+        if (table_ == NULL) {
+            return table->Put(time, value, dimensions);
+        }
+        return table_->Put(time, value, dimensions, state_, &row_);
+    }
+
+    // the binlog entry of the row put is appended at log_index
+    void Commit(uint64_t log_index) {
+        if (table_ != NULL && row_ != NULL) {
+            table_->CommitPut(state_, log_index, row_);
+        }
+    }
+
+ private:
+    MemTable* table_;
+    uint64_t state_;
+    DataBlock* row_;
+};
+
+// end the dump started by MemTable::CutSnapshot when it leaves the scope
+class DumpGuard {
+ public:
+    explicit DumpGuard(MemTable* table) : table_(table) {}
+    ~DumpGuard() { table_->EndDump(); }
+    DumpGuard(const DumpGuard&) = delete;
+    DumpGuard& operator=(const DumpGuard&) = delete;
+
+ private:
+    MemTable* table_;
 };
 
 }  // namespace storage
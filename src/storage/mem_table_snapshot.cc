@@ -23,6 +23,7 @@
 #include <snappy.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <set>
 #include <utility>
 
@@ -42,6 +43,8 @@
 #include "log/log_reader.h"
 #include "log/sequential_file.h"
 #include "proto/tablet.pb.h"
+#include "storage/binlog.h"
+#include "storage/mem_table.h"
 
 using google::protobuf::RepeatedPtrField;
 using ::openmldb::codec::SchemaCodec;
@@ -53,6 +56,10 @@ DECLARE_uint32(load_table_batch);
 DECLARE_uint32(load_table_thread_num);
 DECLARE_uint32(load_table_queue_size);
 DECLARE_string(snapshot_compression);
+DECLARE_uint32(snapshot_format_version);
+DECLARE_uint32(snapshot_max_delta_num);
+DECLARE_uint32(recover_binlog_thread_num);
+DECLARE_uint32(recover_binlog_chunk_size);
 
 namespace openmldb {
 namespace storage {
@@ -60,6 +67,7 @@ namespace storage {
 const std::string SNAPSHOT_SUBFIX = ".sdb";  // NOLINT
 const uint32_t KEY_NUM_DISPLAY = 1000000;    // NOLINT
 const std::string MANIFEST = "MANIFEST";     // NOLINT
+const uint32_t MMAP_SNAPSHOT_BLOCK_SIZE = 1024 * 1024;
 
 MemTableSnapshot::MemTableSnapshot(uint32_t tid, uint32_t pid, LogParts* log_part, const std::string& db_root_path)
     : Snapshot(tid, pid), log_part_(log_part), db_root_path_(db_root_path) {}
@@ -87,6 +95,12 @@ bool MemTableSnapshot::Recover(std::shared_ptr<Table> table, uint64_t& latest_of
     }
     if (ret == 0) {
         RecoverFromSnapshot(manifest.name(), manifest.count(), table);
+        if (manifest.delta_size() > 0) {
+            uint64_t cur_offset = manifest.delta(0).offset();
+            for (const auto& delta : manifest.delta()) {
+                RecoverFromDelta(delta, table, &cur_offset);
+            }
+        }
         latest_offset = manifest.offset();
         offset_ = latest_offset;
     }
@@ -107,6 +121,77 @@ void MemTableSnapshot::RecoverFromSnapshot(const std::string& snapshot_name, uin
     }
 }
 
+void MemTableSnapshot::RecoverFromDelta(const ::openmldb::api::SnapshotDelta& delta, std::shared_ptr<Table> table,
+                                        uint64_t* cur_offset) {
+    std::string full_path = snapshot_path_ + delta.name();
+    FILE* fd = fopen(full_path.c_str(), "rb");
+    if (fd == NULL) {
+        PDLOG(WARNING, "fail to open path %s for error %s", full_path.c_str(), strerror(errno));
+        return;
+    }
+    uint64_t consumed = ::baidu::common::timer::now_time();
+    SnapshotReader reader(delta.name(), fd, IsCompressed(full_path));
+    // the delta is replayed like binlog, as it has the deletes
+    std::unique_ptr<BinlogReplayer> replayer;
+    if (FLAGS_recover_binlog_thread_num > 0) {
+        replayer.reset(new BinlogReplayer(table, FLAGS_recover_binlog_thread_num, FLAGS_recover_binlog_chunk_size));
+    }
+    ::openmldb::api::LogEntry entry;
+    std::string buffer;
+    uint64_t succ_cnt = 0;
+    uint64_t failed_cnt = 0;
+    while (true) {
+        buffer.clear();
+        ::openmldb::base::Slice record;
+        ::openmldb::log::Status status = reader.ReadRecord(&record, &buffer);
+        if (status.IsWaitRecord() || status.IsEof()) {
+            break;
+        }
+        if (!status.ok()) {
+            PDLOG(WARNING, "fail to read record for tid %u, pid %u with error %s", tid_, pid_,
+                  status.ToString().c_str());
+            failed_cnt++;
+            continue;
+        }
+        if (replayer) {
+            if (replayer->Add(record)) {
+                replayer->Replay(cur_offset, &succ_cnt, &failed_cnt);
+            }
+            continue;
+        }
+        if (!entry.ParseFromString(record.ToString())) {
+            PDLOG(WARNING, "fail parse record for tid %u, pid %u with value %s", tid_, pid_,
+                  ::openmldb::base::DebugString(record.ToString()).c_str());
+            failed_cnt++;
+            continue;
+        }
+        if (entry.log_index() <= *cur_offset) {
+            continue;
+        }
+        if (entry.has_method_type() && entry.method_type() == ::openmldb::api::MethodType::kDelete) {
+            if (entry.dimensions_size() == 0) {
+                PDLOG(WARNING, "no dimesion. tid %u pid %u offset %lu", tid_, pid_, entry.log_index());
+            } else {
+                table->Delete(entry.dimensions(0).key(), entry.dimensions(0).idx());
+            }
+        } else {
+            table->Put(entry);
+        }
+        *cur_offset = entry.log_index();
+        succ_cnt++;
+    }
+    if (replayer) {
+        replayer->Replay(cur_offset, &succ_cnt, &failed_cnt);
+        replayer->Wait();
+    }
+    consumed = ::baidu::common::timer::now_time() - consumed;
+    PDLOG(INFO, "read delta %s for table tid %u pid %u completed, succ_cnt %lu, failed_cnt %lu, consumed %us",
+          delta.name().c_str(), tid_, pid_, succ_cnt, failed_cnt, consumed);
+    if (succ_cnt != delta.count()) {
+        PDLOG(WARNING, "delta %s, expect cnt %lu but succ_cnt %lu", delta.name().c_str(), delta.count(), succ_cnt);
+    }
+}
+
 void MemTableSnapshot::RecoverSingleSnapshot(const std::string& path, std::shared_ptr<Table> table,
                                              std::atomic<uint64_t>* g_succ_cnt, std::atomic<uint64_t>* g_failed_cnt) {
     ::openmldb::base::TaskPool load_pool_(FLAGS_load_table_thread_num, FLAGS_load_table_batch);
@@ -124,6 +209,10 @@ void MemTableSnapshot::RecoverSingleSnapshot(const std::string& path, std::share
             break;
         }
         bool compressed = IsCompressed(path);
+        if (!compressed && MmapSnapshotReader::IsMmapSnapshot(fd)) {
+            RecoverMmapSnapshot(path, fd, table, g_succ_cnt, g_failed_cnt);
+            break;
+        }
         ::openmldb::log::SequentialFile* seq_file = ::openmldb::log::NewSeqFile(path, fd);
         ::openmldb::log::Reader reader(seq_file, NULL, false, 0, compressed);
         std::string buffer;
@@ -196,9 +285,91 @@ void MemTableSnapshot::Put(std::string& path, std::shared_ptr<Table>& table, std
     }
 }
 
+void MemTableSnapshot::RecoverMmapSnapshot(const std::string& path, FILE* fd, std::shared_ptr<Table> table,
+                                           std::atomic<uint64_t>* g_succ_cnt, std::atomic<uint64_t>* g_failed_cnt) {
+    uint64_t consumed = ::baidu::common::timer::now_time();
+    MmapSnapshotReader reader;
+    bool ok = reader.Open(fileno(fd));
+    // the mapping is still valid after the file is closed
+    fclose(fd);
+    if (!ok) {
+        PDLOG(WARNING, "fail to open snapshot %s for tid %u, pid %u", path.c_str(), tid_, pid_);
+        return;
+    }
+    uint32_t thread_num = FLAGS_load_table_thread_num == 0 ? 1 : FLAGS_load_table_thread_num;
+    std::vector<std::vector<const MmapBlock*>> tasks(std::min(thread_num, std::max(reader.GetSectionCnt(), 1u)));
+    for (const auto& block : reader.GetBlocks()) {
+        tasks[block.section % tasks.size()].push_back(&block);
+    }
+    std::atomic<uint64_t> succ_cnt(0);
+    std::atomic<uint64_t> failed_cnt(0);
+    {
+        ::openmldb::base::TaskPool load_pool(tasks.size(), tasks.size());
+        for (auto& blocks : tasks) {
+            load_pool.AddTask(boost::bind(&MemTableSnapshot::PutMmapBlocks, this, &reader, blocks, table, &succ_cnt,
+                                          &failed_cnt));
+        }
+        load_pool.Stop();
+    }
+    consumed = ::baidu::common::timer::now_time() - consumed;
+    PDLOG(INFO,
+          "read path %s for table tid %u pid %u completed, "
+          "succ_cnt %lu, failed_cnt %lu, consumed %us",
+          path.c_str(), tid_, pid_, succ_cnt.load(std::memory_order_relaxed),
+          failed_cnt.load(std::memory_order_relaxed), consumed);
+    if (g_succ_cnt) {
+        g_succ_cnt->fetch_add(succ_cnt, std::memory_order_relaxed);
+    }
+    if (g_failed_cnt) {
+        g_failed_cnt->fetch_add(failed_cnt, std::memory_order_relaxed);
+    }
+}
+
+void MemTableSnapshot::PutMmapBlocks(const MmapSnapshotReader* reader, std::vector<const MmapBlock*> blocks,
+                                     std::shared_ptr<Table> table, std::atomic<uint64_t>* succ_cnt,
+                                     std::atomic<uint64_t>* failed_cnt) {
+    // the rows of memtable are put without being copied to a LogEntry
+    auto mem_table = std::dynamic_pointer_cast<MemTable>(table);
+    MmapRecord record;
+    ::openmldb::api::LogEntry entry;
+    for (const MmapBlock* block : blocks) {
+        if (!reader->PrepareBlock(*block)) {
+            PDLOG(WARNING, "checksum mismatch in block at %lu. tid %u pid %u", block->offset, tid_, pid_);
+            failed_cnt->fetch_add(block->record_cnt, std::memory_order_relaxed);
+            continue;
+        }
+        uint64_t pos = 0;
+        for (uint32_t i = 0; i < block->record_cnt; i++) {
+            if (!reader->DecodeRecord(*block, &pos, &record)) {
+                PDLOG(WARNING, "fail to decode record in block at %lu. tid %u pid %u", block->offset, tid_, pid_);
+                failed_cnt->fetch_add(block->record_cnt - i, std::memory_order_relaxed);
+                break;
+            }
+            if (mem_table) {
+                mem_table->Put(record.ts, record.value, record.dimensions);
+            } else {
+                entry.Clear();
+                entry.set_ts(record.ts);
+                entry.set_value(record.value.data(), record.value.size());
+                for (const auto& dimension : record.dimensions) {
+                    auto dim = entry.add_dimensions();
+                    dim->set_idx(dimension.first);
+                    dim->set_key(dimension.second.data(), dimension.second.size());
+                }
+                table->Put(entry);
+            }
+            auto scount = succ_cnt->fetch_add(1, std::memory_order_relaxed);
+            if (scount % 100000 == 0) {
+                PDLOG(INFO, "load snapshot with succ_cnt %lu, failed_cnt %lu. tid %u pid %u", scount,
+                      failed_cnt->load(std::memory_order_relaxed), tid_, pid_);
+            }
+        }
+    }
+}
+
 int MemTableSnapshot::TTLSnapshot(std::shared_ptr<Table> table, const ::openmldb::api::Manifest& manifest,
                                   WriteHandle* wh, uint64_t& count, uint64_t& expired_key_num,
-                                  uint64_t& deleted_key_num) {
+                                  uint64_t& deleted_key_num, MmapSnapshotWriter* mwh) {
     std::string full_path = snapshot_path_ + manifest.name();
     FILE* fd = fopen(full_path.c_str(), "rb");
     if (fd == NULL) {
@@ -206,8 +377,7 @@ int MemTableSnapshot::TTLSnapshot(std::shared_ptr<Table> table, const ::openmldb
         return -1;
     }
     bool compressed = IsCompressed(full_path);
-    ::openmldb::log::SequentialFile* seq_file = ::openmldb::log::NewSeqFile(manifest.name(), fd);
-    ::openmldb::log::Reader reader(seq_file, NULL, false, 0, compressed);
+    SnapshotReader reader(manifest.name(), fd, compressed);
 
     std::string buffer;
     std::string tmp_buf;
@@ -219,6 +389,8 @@ int MemTableSnapshot::TTLSnapshot(std::shared_ptr<Table> table, const ::openmldb
             deleted_index.insert(it->GetId());
         }
     }
+    // the counts are added up over the base and delta snapshots
+    uint64_t start_num = count + expired_key_num + deleted_key_num;
     while (true) {
         ::openmldb::base::Slice record;
         ::openmldb::log::Status status = reader.ReadRecord(&record, &buffer);
@@ -237,6 +409,11 @@ int MemTableSnapshot::TTLSnapshot(std::shared_ptr<Table> table, const ::openmldb
             has_error = true;
             break;
         }
+        // the deletes of delta snapshot are collected in deleted_keys_
+        if (entry.has_method_type() && entry.method_type() == ::openmldb::api::MethodType::kDelete) {
+            deleted_key_num++;
+            continue;
+        }
         int ret = RemoveDeletedKey(entry, deleted_index, &tmp_buf);
         if (ret == 1) {
             deleted_key_num++;
@@ -248,7 +425,14 @@ int MemTableSnapshot::TTLSnapshot(std::shared_ptr<Table> table, const ::openmldb
             expired_key_num++;
             continue;
         }
-        status = wh->Write(record);
+        if (mwh != NULL) {
+            if (ret == 2) {
+                entry.ParseFromString(tmp_buf);
+            }
+            status = mwh->Write(entry);
+        } else {
+            status = wh->Write(record);
+        }
         if (!status.ok()) {
             PDLOG(WARNING, "fail to write snapshot. status[%s]", status.ToString().c_str());
             has_error = true;
@@ -259,8 +443,7 @@ int MemTableSnapshot::TTLSnapshot(std::shared_ptr<Table> table, const ::openmldb
         }
         count++;
     }
-    delete seq_file;
-    if (expired_key_num + count + deleted_key_num != manifest.count()) {
+    if (expired_key_num + count + deleted_key_num - start_num != manifest.count()) {
         PDLOG(WARNING,
               "key num not match! total key num[%lu] load key num[%lu] ttl key "
               "num[%lu]",
@@ -343,6 +526,21 @@ uint64_t MemTableSnapshot::CollectDeletedKey(uint64_t end_offset) {
 }
 
 int MemTableSnapshot::MakeSnapshot(std::shared_ptr<Table> table, uint64_t& out_offset, uint64_t end_offset) {
+    return MakeSnapshot(table, out_offset, end_offset, false);
+}
+
+int MemTableSnapshot::MergeDeltaSnapshot(std::shared_ptr<Table> table) {
+    ::openmldb::api::Manifest manifest;
+    if (GetLocalManifest(snapshot_path_ + MANIFEST, manifest) != 0 || manifest.delta_size() == 0) {
+        return 0;
+    }
+    PDLOG(INFO, "merge %d delta snapshots. tid %u pid %u", manifest.delta_size(), tid_, pid_);
+    uint64_t offset = 0;
+    return MakeSnapshot(table, offset, 0, true);
+}
+
+int MemTableSnapshot::MakeSnapshot(std::shared_ptr<Table> table, uint64_t& out_offset, uint64_t end_offset,
+                                   bool merge_delta) {
     if (making_snapshot_.load(std::memory_order_acquire)) {
         PDLOG(INFO, "snapshot is doing now!");
         return 0;
@@ -352,9 +550,18 @@ int MemTableSnapshot::MakeSnapshot(std::shared_ptr<Table> table, uint64_t& out_o
         return -1;
     }
     making_snapshot_.store(true, std::memory_order_release);
+    ::openmldb::api::Manifest manifest;
+    int result = GetLocalManifest(snapshot_path_ + MANIFEST, manifest);
+    if (result == 0 && !merge_delta && manifest.delta_size() < static_cast<int>(FLAGS_snapshot_max_delta_num)) {
+        int ret = MakeDeltaSnapshot(manifest, out_offset, end_offset);
+        making_snapshot_.store(false, std::memory_order_release);
+        return ret;
+    }
     std::string now_time = ::openmldb::base::GetNowTime();
     std::string snapshot_name = now_time.substr(0, now_time.length() - 2) + ".sdb";
-    if (FLAGS_snapshot_compression != "off") {
+    // the snapshot of format v2 is mapped to memory on loading, so it is not compressed
+    bool mmap_format = FLAGS_snapshot_format_version == 2;
+    if (FLAGS_snapshot_compression != "off" && !mmap_format) {
         snapshot_name.append(".");
         snapshot_name.append(FLAGS_snapshot_compression);
     }
@@ -368,20 +575,40 @@ int MemTableSnapshot::MakeSnapshot(std::shared_ptr<Table> table, uint64_t& out_o
         return -1;
     }
     uint64_t collected_offset = CollectDeletedKey(end_offset);
+    bool has_error = result == 0 && !CollectDeltaDeletedKey(manifest);
     uint64_t start_time = ::baidu::common::timer::now_time();
-    WriteHandle* wh = new WriteHandle(FLAGS_snapshot_compression, snapshot_name_tmp, fd);
-    ::openmldb::api::Manifest manifest;
-    bool has_error = false;
+    WriteHandle* wh = NULL;
+    std::unique_ptr<MmapSnapshotWriter> mwh;
+    if (mmap_format) {
+        // group the rows by the segment of memtable, so that the segments are loaded in parallel
+        auto mem_table = std::dynamic_pointer_cast<MemTable>(table);
+        uint32_t section_cnt = mem_table ? mem_table->GetSegCnt() : 1;
+        mwh.reset(new MmapSnapshotWriter(fd, section_cnt, MMAP_SNAPSHOT_BLOCK_SIZE));
+    } else {
+        wh = new WriteHandle(FLAGS_snapshot_compression, snapshot_name_tmp, fd);
+    }
     uint64_t write_count = 0;
     uint64_t expired_key_num = 0;
     uint64_t deleted_key_num = 0;
     uint64_t last_term = 0;
-    int result = GetLocalManifest(snapshot_path_ + MANIFEST, manifest);
-    if (result == 0) {
+    if (result == 0 && !has_error) {
         // filter old snapshot
-        if (TTLSnapshot(table, manifest, wh, write_count, expired_key_num, deleted_key_num) < 0) {
+        if (TTLSnapshot(table, manifest, wh, write_count, expired_key_num, deleted_key_num, mwh.get()) < 0) {
             has_error = true;
         }
+        // the delta snapshots are merged in order
+        for (const auto& delta : manifest.delta()) {
+            if (has_error) {
+                break;
+            }
+            ::openmldb::api::Manifest delta_manifest;
+            delta_manifest.set_name(delta.name());
+            delta_manifest.set_count(delta.count());
+            if (TTLSnapshot(table, delta_manifest, wh, write_count, expired_key_num, deleted_key_num, mwh.get()) <
+                0) {
+                has_error = true;
+            }
+        }
         last_term = manifest.term();
         DEBUGLOG("old manifest term is %lu", last_term);
     } else if (result < 0) {
@@ -438,7 +665,15 @@ int MemTableSnapshot::MakeSnapshot(std::shared_ptr<Table> table, uint64_t& out_o
                 expired_key_num++;
                 continue;
             }
-            ::openmldb::log::Status status = wh->Write(record);
+            ::openmldb::log::Status status;
+            if (mwh) {
+                if (ret == 2) {
+                    entry.ParseFromString(tmp_buf);
+                }
+                status = mwh->Write(entry);
+            } else {
+                status = wh->Write(record);
+            }
             if (!status.ok()) {
                 PDLOG(WARNING, "fail to write snapshot. path[%s] status[%s]", tmp_file_path.c_str(),
                       status.ToString().c_str());
@@ -476,6 +711,15 @@ int MemTableSnapshot::MakeSnapshot(std::shared_ptr<Table> table, uint64_t& out_o
         delete wh;
         wh = NULL;
     }
+    if (mwh) {
+        ::openmldb::log::Status status = mwh->EndLog();
+        if (!status.ok()) {
+            PDLOG(WARNING, "fail to end snapshot. path[%s] status[%s]", tmp_file_path.c_str(),
+                  status.ToString().c_str());
+            has_error = true;
+        }
+        mwh.reset();
+    }
     int ret = 0;
     if (has_error) {
         unlink(tmp_file_path.c_str());
@@ -488,6 +732,10 @@ int MemTableSnapshot::MakeSnapshot(std::shared_ptr<Table> table, uint64_t& out_o
                     DEBUGLOG("old snapshot[%s] has deleted", manifest.name().c_str());
                     unlink((snapshot_path_ + manifest.name()).c_str());
                 }
+                for (const auto& delta : manifest.delta()) {
+                    DEBUGLOG("delta snapshot[%s] has deleted", delta.name().c_str());
+                    unlink((snapshot_path_ + delta.name()).c_str());
+                }
                 uint64_t consumed = ::baidu::common::timer::now_time() - start_time;
                 PDLOG(INFO,
                       "make snapshot[%s] success. update offset from %lu to %lu."
@@ -513,6 +761,286 @@ int MemTableSnapshot::MakeSnapshot(std::shared_ptr<Table> table, uint64_t& out_o
     return ret;
 }
 
+int MemTableSnapshot::DumpSnapshot(std::shared_ptr<MemTable> table, const std::function<uint64_t()>& get_offset,
+                                   uint64_t term, uint64_t* out_offset) {
+    if (making_snapshot_.load(std::memory_order_acquire)) {
+        PDLOG(INFO, "snapshot is doing now!");
+        return 0;
+    }
+    making_snapshot_.store(true, std::memory_order_release);
+    ::openmldb::api::Manifest manifest;
+    if (GetLocalManifest(snapshot_path_ + MANIFEST, manifest) < 0) {
+        PDLOG(WARNING, "fail to read manifest. tid %u pid %u", tid_, pid_);
+        making_snapshot_.store(false, std::memory_order_release);
+        return -1;
+    }
+    std::string now_time = ::openmldb::base::GetNowTime();
+    std::string snapshot_name = now_time.substr(0, now_time.length() - 2) + ".sdb";
+    bool mmap_format = FLAGS_snapshot_format_version == 2;
+    if (FLAGS_snapshot_compression != "off" && !mmap_format) {
+        snapshot_name.append(".");
+        snapshot_name.append(FLAGS_snapshot_compression);
+    }
+    std::string snapshot_name_tmp = snapshot_name + ".tmp";
+    std::string full_path = snapshot_path_ + snapshot_name;
+    std::string tmp_file_path = snapshot_path_ + snapshot_name_tmp;
+    FILE* fd = fopen(tmp_file_path.c_str(), "ab+");
+    if (fd == NULL) {
+        PDLOG(WARNING, "fail to create file %s", tmp_file_path.c_str());
+        making_snapshot_.store(false, std::memory_order_release);
+        return -1;
+    }
+    std::unique_ptr<WriteHandle> wh;
+    std::unique_ptr<MmapSnapshotWriter> mwh;
+    if (mmap_format) {
+        mwh.reset(new MmapSnapshotWriter(fd, table->GetSegCnt(), MMAP_SNAPSHOT_BLOCK_SIZE));
+    } else {
+        wh.reset(new WriteHandle(FLAGS_snapshot_compression, snapshot_name_tmp, fd));
+    }
+    // the key of a row is rebuilt from the row for every inner index, by the first ready index of it
+    std::map<uint32_t, std::shared_ptr<IndexDef>> index_defs;
+    for (const auto& index_def : table->GetAllIndex()) {
+        if (index_def && index_def->IsReady()) {
+            index_defs.emplace(index_def->GetInnerPos(), index_def);
+        }
+    }
+    std::map<uint8_t, codec::RowView> decoder_map;
+    bool has_error = !GetAllDecoder(table, &decoder_map).OK();
+    uint64_t start_time = ::baidu::common::timer::now_time();
+    uint64_t offset = 0;
+    uint16_t epoch = table->CutSnapshot(get_offset, &offset);
+    DumpGuard dump_guard(table.get());
+    uint64_t write_count = 0;
+    ::openmldb::api::LogEntry entry;
+    std::string key;
+    std::string buffer;
+    auto dump_row = [&](uint32_t /*inner_pos*/, uint64_t ts, const ::openmldb::base::Slice& row) {
+        entry.Clear();
+        entry.set_ts(ts);
+        entry.set_value(row.data(), row.size());
+        for (const auto& kv : index_defs) {
+            const std::shared_ptr<IndexDef>& index_def = kv.second;
+            base::Status status = GetIndexKey(table, index_def, row, &decoder_map, &key);
+            if (!status.OK()) {
+                PDLOG(WARNING, "fail to get the key of index %s. tid %u pid %u msg %s", index_def->GetName().c_str(),
+                      tid_, pid_, status.GetMsg().c_str());
+                return false;
+            }
+            ::openmldb::api::Dimension* dimension = entry.add_dimensions();
+            dimension->set_key(key);
+            dimension->set_idx(index_def->GetId());
+        }
+        ::openmldb::log::Status status;
+        if (mwh) {
+            status = mwh->Write(entry);
+        } else {
+            entry.SerializeToString(&buffer);
+            status = wh->Write(::openmldb::base::Slice(buffer));
+        }
+        if (!status.ok()) {
+            PDLOG(WARNING, "fail to write snapshot. path[%s] status[%s]", tmp_file_path.c_str(),
+                  status.ToString().c_str());
+            return false;
+        }
+        write_count++;
+        if (write_count % KEY_NUM_DISPLAY == 0) {
+            PDLOG(INFO, "has dump key num[%lu]", write_count);
+        }
+        return true;
+    };
+    if (!has_error && !table->DumpRows(epoch, dump_row)) {
+        has_error = true;
+    }
+    if (wh) {
+        wh->EndLog();
+        wh.reset();
+    }
+    if (mwh) {
+        ::openmldb::log::Status status = mwh->EndLog();
+        if (!status.ok()) {
+            PDLOG(WARNING, "fail to end snapshot. path[%s] status[%s]", tmp_file_path.c_str(),
+                  status.ToString().c_str());
+            has_error = true;
+        }
+        mwh.reset();
+    }
+    int ret = -1;
+    if (has_error) {
+        unlink(tmp_file_path.c_str());
+    } else if (rename(tmp_file_path.c_str(), full_path.c_str()) != 0) {
+        PDLOG(WARNING, "rename[%s] failed", snapshot_name.c_str());
+        unlink(tmp_file_path.c_str());
+    } else if (GenManifest(snapshot_name, write_count, offset, std::max(term, manifest.term())) != 0) {
+        PDLOG(WARNING, "GenManifest failed. delete snapshot file[%s]", full_path.c_str());
+        unlink(full_path.c_str());
+    } else {
+        if (manifest.has_name() && manifest.name() != snapshot_name) {
+            unlink((snapshot_path_ + manifest.name()).c_str());
+        }
+        for (const auto& delta : manifest.delta()) {
+            unlink((snapshot_path_ + delta.name()).c_str());
+        }
+        PDLOG(INFO, "dump snapshot[%s] success. update offset from %lu to %lu. use %lu second. write key %lu",
+              snapshot_name.c_str(), offset_, offset, ::baidu::common::timer::now_time() - start_time, write_count);
+        offset_ = offset;
+        *out_offset = offset;
+        ret = 0;
+    }
+    making_snapshot_.store(false, std::memory_order_release);
+    return ret;
+}
+
+bool MemTableSnapshot::CollectDeltaDeletedKey(const ::openmldb::api::Manifest& manifest) {
+    std::string buffer;
+    for (const auto& delta : manifest.delta()) {
+        std::string full_path = snapshot_path_ + delta.name();
+        FILE* fd = fopen(full_path.c_str(), "rb");
+        if (fd == NULL) {
+            PDLOG(WARNING, "fail to open path %s for error %s", full_path.c_str(), strerror(errno));
+            return false;
+        }
+        SnapshotReader reader(delta.name(), fd, IsCompressed(full_path));
+        while (true) {
+            ::openmldb::base::Slice record;
+            ::openmldb::log::Status status = reader.ReadRecord(&record, &buffer);
+            if (status.IsEof()) {
+                break;
+            }
+            if (!status.ok()) {
+                PDLOG(WARNING, "fail to read record for tid %u, pid %u with error %s", tid_, pid_,
+                      status.ToString().c_str());
+                return false;
+            }
+            ::openmldb::api::LogEntry entry;
+            if (!entry.ParseFromString(record.ToString())) {
+                PDLOG(WARNING, "fail parse record for tid %u, pid %u", tid_, pid_);
+                return false;
+            }
+            if (!entry.has_method_type() || entry.method_type() != ::openmldb::api::MethodType::kDelete ||
+                entry.dimensions_size() == 0) {
+                continue;
+            }
+            std::string combined_key = entry.dimensions(0).key() + "|" + std::to_string(entry.dimensions(0).idx());
+            auto iter = deleted_keys_.find(combined_key);
+            if (iter == deleted_keys_.end() || iter->second < entry.log_index()) {
+                deleted_keys_[combined_key] = entry.log_index();
+            }
+        }
+    }
+    return true;
+}
+
+int MemTableSnapshot::MakeDeltaSnapshot(const ::openmldb::api::Manifest& manifest, uint64_t& out_offset,
+                                        uint64_t end_offset) {
+    std::string now_time = ::openmldb::base::GetNowTime();
+    // the start offset tells apart the deltas made in a minute
+    std::string delta_name = now_time.substr(0, now_time.length() - 2) + "_" + std::to_string(offset_) + ".delta";
+    if (FLAGS_snapshot_compression != "off") {
+        delta_name.append(".");
+        delta_name.append(FLAGS_snapshot_compression);
+    }
+    std::string delta_name_tmp = delta_name + ".tmp";
+    std::string full_path = snapshot_path_ + delta_name;
+    std::string tmp_file_path = snapshot_path_ + delta_name_tmp;
+    FILE* fd = fopen(tmp_file_path.c_str(), "ab+");
+    if (fd == NULL) {
+        PDLOG(WARNING, "fail to create file %s", tmp_file_path.c_str());
+        return -1;
+    }
+    uint64_t start_time = ::baidu::common::timer::now_time();
+    WriteHandle* wh = new WriteHandle(FLAGS_snapshot_compression, delta_name_tmp, fd);
+    ::openmldb::log::LogReader log_reader(log_part_, log_path_, false);
+    log_reader.SetOffset(offset_);
+    uint64_t cur_offset = offset_;
+    uint64_t last_term = manifest.term();
+    uint64_t write_count = 0;
+    bool has_error = false;
+    std::string buffer;
+    while (end_offset == 0 || cur_offset < end_offset) {
+        buffer.clear();
+        ::openmldb::base::Slice record;
+        ::openmldb::log::Status status = log_reader.ReadNextRecord(&record, &buffer);
+        if (status.ok()) {
+            ::openmldb::api::LogEntry entry;
+            if (!entry.ParseFromString(record.ToString())) {
+                PDLOG(WARNING, "fail to parse LogEntry. record[%s] size[%ld]",
+                      ::openmldb::base::DebugString(record.ToString()).c_str(), record.ToString().size());
+                has_error = true;
+                break;
+            }
+            if (entry.log_index() <= cur_offset) {
+                continue;
+            }
+            if (cur_offset + 1 != entry.log_index()) {
+                PDLOG(WARNING, "log missing expect offset %lu but %ld", cur_offset + 1, entry.log_index());
+                continue;
+            }
+            cur_offset = entry.log_index();
+            if (entry.has_term()) {
+                last_term = entry.term();
+            }
+            // the entries are kept as they are, the deletes and expired ones are removed on merging
+            status = wh->Write(record);
+            if (!status.ok()) {
+                PDLOG(WARNING, "fail to write snapshot. path[%s] status[%s]", tmp_file_path.c_str(),
+                      status.ToString().c_str());
+                has_error = true;
+                break;
+            }
+            write_count++;
+        } else if (status.IsEof()) {
+            continue;
+        } else if (status.IsWaitRecord()) {
+            int end_log_index = log_reader.GetEndLogIndex();
+            int cur_log_index = log_reader.GetLogIndex();
+            // judge end_log_index greater than cur_log_index
+            if (end_log_index >= 0 && end_log_index > cur_log_index) {
+                log_reader.RollRLogFile();
+                PDLOG(WARNING,
+                      "read new binlog file. tid[%u] pid[%u] cur_log_index[%d] "
+                      "end_log_index[%d] cur_offset[%lu]",
+                      tid_, pid_, cur_log_index, end_log_index, cur_offset);
+                continue;
+            }
+            DEBUGLOG("has read all record!");
+            break;
+        } else {
+            PDLOG(WARNING, "fail to get record. status is %s", status.ToString().c_str());
+            has_error = true;
+            break;
+        }
+    }
+    wh->EndLog();
+    delete wh;
+    if (has_error || write_count == 0) {
+        unlink(tmp_file_path.c_str());
+        return has_error ? -1 : 0;
+    }
+    if (rename(tmp_file_path.c_str(), full_path.c_str()) != 0) {
+        PDLOG(WARNING, "rename[%s] failed", delta_name.c_str());
+        unlink(tmp_file_path.c_str());
+        return -1;
+    }
+    ::openmldb::api::Manifest new_manifest(manifest);
+    ::openmldb::api::SnapshotDelta* delta = new_manifest.add_delta();
+    delta->set_name(delta_name);
+    delta->set_offset(offset_);
+    delta->set_count(write_count);
+    new_manifest.set_offset(cur_offset);
+    new_manifest.set_term(last_term);
+    if (GenManifest(new_manifest) != 0) {
+        PDLOG(WARNING, "GenManifest failed. delete snapshot file[%s]", full_path.c_str());
+        unlink(full_path.c_str());
+        return -1;
+    }
+    uint64_t consumed = ::baidu::common::timer::now_time() - start_time;
+    PDLOG(INFO, "make delta snapshot[%s] success. update offset from %lu to %lu. use %lu second. write key %lu",
+          delta_name.c_str(), offset_, cur_offset, consumed, write_count);
+    offset_ = cur_offset;
+    out_offset = cur_offset;
+    return 0;
+}
+
 int MemTableSnapshot::RemoveDeletedKey(const ::openmldb::api::LogEntry& entry, const std::set<uint32_t>& deleted_index,
                                        std::string* buffer) {
     uint64_t cur_offset = entry.log_index();
@@ -675,9 +1203,8 @@ base::Status MemTableSnapshot::ExtractIndexFromSnapshot(std::shared_ptr<Table> t
         PDLOG(WARNING, "fail to open path %s for error %s", full_path.c_str(), strerror(errno));
         return base::Status(base::ReturnCode::kError, "fail to open file");
     }
-    ::openmldb::log::SequentialFile* seq_file = ::openmldb::log::NewSeqFile(manifest.name(), fd);
     bool compressed = IsCompressed(full_path);
-    ::openmldb::log::Reader reader(seq_file, NULL, false, 0, compressed);
+    SnapshotReader reader(manifest.name(), fd, compressed);
     std::string buffer;
     ::openmldb::api::LogEntry entry;
     bool has_error = false;
@@ -769,7 +1296,6 @@ base::Status MemTableSnapshot::ExtractIndexFromSnapshot(std::shared_ptr<Table> t
         }
         (*count)++;
     }
-    delete seq_file;
     if (*expired_key_num + write_count + *deleted_key_num != manifest.count()) {
         PDLOG(WARNING, "key num not match! total key[%lu] load key[%lu] ttl key[%lu] delete key [%lu], tid %u pid %u",
                 manifest.count(), *count, *expired_key_num, *deleted_key_num, tid, pid);
@@ -795,9 +1321,8 @@ int MemTableSnapshot::ExtractIndexFromSnapshot(std::shared_ptr<Table> table, con
         PDLOG(WARNING, "fail to open path %s for error %s", full_path.c_str(), strerror(errno));
         return -1;
     }
-    ::openmldb::log::SequentialFile* seq_file = ::openmldb::log::NewSeqFile(manifest.name(), fd);
     bool compressed = IsCompressed(full_path);
-    ::openmldb::log::Reader reader(seq_file, NULL, false, 0, compressed);
+    SnapshotReader reader(manifest.name(), fd, compressed);
     std::string buffer;
     ::openmldb::api::LogEntry entry;
     bool has_error = false;
@@ -927,7 +1452,6 @@ int MemTableSnapshot::ExtractIndexFromSnapshot(std::shared_ptr<Table> table, con
         }
         count++;
     }
-    delete seq_file;
     if (expired_key_num + count + deleted_key_num + schame_size_less_count + other_error_count != manifest.count()) {
         LOG(WARNING) << "key num not match ! total key num[" << manifest.count() << "] load key num[" << count
                      << "] ttl key num[" << expired_key_num << "] schema size less num[" << schame_size_less_count
@@ -1100,6 +1624,10 @@ int MemTableSnapshot::ExtractIndexData(std::shared_ptr<Table> table,
     }
     uint32_t tid = table->GetId();
     uint32_t pid = table->GetPid();
+    // the index data is extracted from a single snapshot file
+    if (MergeDeltaSnapshot(table) < 0) {
+        return -1;
+    }
     if (making_snapshot_.exchange(true, std::memory_order_consume)) {
         PDLOG(INFO, "snapshot is doing now. tid %u, pid %u", tid, pid);
         return -1;
@@ -1192,6 +1720,9 @@ int MemTableSnapshot::ExtractIndexData(std::shared_ptr<Table> table, const ::ope
                                        uint32_t idx, uint32_t partition_num, uint64_t& out_offset) {
     uint32_t tid = table->GetId();
     uint32_t pid = table->GetPid();
+    if (MergeDeltaSnapshot(table) < 0) {
+        return -1;
+    }
     if (making_snapshot_.exchange(true, std::memory_order_consume)) {
         PDLOG(INFO, "snapshot is doing now. tid %u, pid %u", tid, pid);
         return -1;
@@ -1552,9 +2083,8 @@ bool MemTableSnapshot::DumpSnapshotIndexData(std::shared_ptr<Table> table,
         PDLOG(WARNING, "fail to open path %s for error %s", path.c_str(), strerror(errno));
         return false;
     }
-    ::openmldb::log::SequentialFile* seq_file = ::openmldb::log::NewSeqFile(path, fd);
     bool compressed = IsCompressed(path);
-    ::openmldb::log::Reader reader(seq_file, NULL, false, 0, compressed);
+    SnapshotReader reader(path, fd, compressed);
     ::openmldb::api::LogEntry entry;
     std::string buffer;
     std::string entry_buff;
@@ -1592,7 +2122,6 @@ bool MemTableSnapshot::DumpSnapshotIndexData(std::shared_ptr<Table> table,
         ::openmldb::base::Slice new_record(entry_str);
         status = whs[index_pid]->Write(new_record);
         if (!status.ok()) {
-            delete seq_file;
             PDLOG(WARNING,
                   "fail to dump index entrylog in snapshot to pid[%u]. tid "
                   "%u pid %u",
@@ -1601,7 +2130,6 @@ bool MemTableSnapshot::DumpSnapshotIndexData(std::shared_ptr<Table> table,
         }
         succ_cnt++;
     }
-    delete seq_file;
     return true;
 }
 
@@ -1609,6 +2137,9 @@ bool MemTableSnapshot::DumpIndexData(std::shared_ptr<Table> table, const ::openm
                                      uint32_t idx, const std::vector<::openmldb::log::WriteHandle*>& whs) {
     uint32_t tid = table->GetId();
     uint32_t pid = table->GetPid();
+    if (MergeDeltaSnapshot(table) < 0) {
+        return false;
+    }
     if (making_snapshot_.exchange(true, std::memory_order_consume)) {
         PDLOG(INFO, "snapshot is doing now. tid %u, pid %u", tid, pid);
         return false;
@@ -17,6 +17,7 @@
 #pragma once
 
 #include <atomic>
+#include <functional>
 #include <map>
 #include <memory>
 #include <set>
@@ -29,6 +30,7 @@
 #include "log/log_writer.h"
 #include "log/sequential_file.h"
 #include "proto/tablet.pb.h"
+#include "storage/mmap_snapshot.h"
 #include "storage/snapshot.h"
 
 using ::openmldb::api::LogEntry;
@@ -37,6 +39,8 @@ namespace storage {
 
 using ::openmldb::log::WriteHandle;
 
+class MemTable;
+
 typedef ::openmldb::base::Skiplist<uint32_t, uint64_t, ::openmldb::base::DefaultComparator> LogParts;
 
 // table snapshot
@@ -52,13 +56,27 @@ class MemTableSnapshot : public Snapshot {
 
     void RecoverFromSnapshot(const std::string& snapshot_name, uint64_t expect_cnt, std::shared_ptr<Table> table);
 
+    // replay the entries of a delta snapshot after cur_offset
+    void RecoverFromDelta(const ::openmldb::api::SnapshotDelta& delta, std::shared_ptr<Table> table,
+                          uint64_t* cur_offset);
+
     int MakeSnapshot(std::shared_ptr<Table> table,
                      uint64_t& out_offset,  // NOLINT
                      uint64_t end_offset) override;
 
+    // dump the rows of the memtable to a new base snapshot instead of replaying the binlog, the puts
+    // go on meanwhile. get_offset gives the offset of the binlog at the cut of the rows
+    int DumpSnapshot(std::shared_ptr<MemTable> table, const std::function<uint64_t()>& get_offset, uint64_t term,
+                     uint64_t* out_offset);
+
+    // merge the delta snapshots to a new base snapshot, so that the snapshot is a single file
+    int MergeDeltaSnapshot(std::shared_ptr<Table> table);
+
+    // the rows are written by mwh if it is not NULL
     int TTLSnapshot(std::shared_ptr<Table> table, const ::openmldb::api::Manifest& manifest, WriteHandle* wh,
                     uint64_t& count, uint64_t& expired_key_num,  // NOLINT
-                    uint64_t& deleted_key_num);                  // NOLINT
+                    uint64_t& deleted_key_num,                   // NOLINT
+                    MmapSnapshotWriter* mwh = NULL);
 
     void Put(std::string& path, std::shared_ptr<Table>& table,  // NOLINT
              std::vector<std::string*> recordPtr, std::atomic<uint64_t>* succ_cnt, std::atomic<uint64_t>* failed_cnt);
@@ -119,8 +137,27 @@ class MemTableSnapshot : public Snapshot {
     void RecoverSingleSnapshot(const std::string& path, std::shared_ptr<Table> table, std::atomic<uint64_t>* g_succ_cnt,
                                std::atomic<uint64_t>* g_failed_cnt);
 
+    // load the snapshot of format v2, a thread loads the blocks of some sections
+    void RecoverMmapSnapshot(const std::string& path, FILE* fd, std::shared_ptr<Table> table,
+                             std::atomic<uint64_t>* g_succ_cnt, std::atomic<uint64_t>* g_failed_cnt);
+
+    void PutMmapBlocks(const MmapSnapshotReader* reader, std::vector<const MmapBlock*> blocks,
+                       std::shared_ptr<Table> table, std::atomic<uint64_t>* succ_cnt,
+                       std::atomic<uint64_t>* failed_cnt);
+
     uint64_t CollectDeletedKey(uint64_t end_offset);
 
+    // collect the keys deleted in the delta snapshots, the ones deleted later in binlog are kept
+    bool CollectDeltaDeletedKey(const ::openmldb::api::Manifest& manifest);
+
+    // make the whole snapshot if merge_delta is true or the delta snapshots are too many
+    int MakeSnapshot(std::shared_ptr<Table> table, uint64_t& out_offset, uint64_t end_offset,  // NOLINT
+                     bool merge_delta);
+
+    // write the binlog after the last snapshot to a delta snapshot as it is
+    int MakeDeltaSnapshot(const ::openmldb::api::Manifest& manifest, uint64_t& out_offset,  // NOLINT
+                          uint64_t end_offset);
+
     int DecodeData(std::shared_ptr<Table> table, const openmldb::api::LogEntry& entry, uint32_t maxIdx,
                    std::vector<std::string>& row);  // NOLINT
 
@@ -0,0 +1,338 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/mmap_snapshot.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "base/glog_wapper.h"
+#include "base/hash.h"
+#include "log/coding.h"
+#include "log/crc32c.h"
+
+namespace openmldb {
+namespace storage {
+
+static const uint32_t SEED = 0xe17a1465;
+static const char MAGIC[] = "OMSNAP02";
+static const uint32_t MAGIC_SIZE = 8;
+static const uint32_t RECORD_HEADER_SIZE = 24;
+static const uint32_t DIMENSION_HEADER_SIZE = 8;
+static const uint32_t BLOCK_INDEX_SIZE = 28;
+static const uint32_t TRAILER_SIZE = 32;
+
+static void PutFixed32(std::string* dst, uint32_t value) {
+    char buf[4];
+    ::openmldb::log::EncodeFixed32(buf, value);
+    dst->append(buf, 4);
+}
+
+static void PutFixed64(std::string* dst, uint64_t value) {
+    char buf[8];
+    ::openmldb::log::EncodeFixed64(buf, value);
+    dst->append(buf, 8);
+}
+
+MmapSnapshotWriter::MmapSnapshotWriter(FILE* fd, uint32_t section_cnt, uint32_t block_size)
+    : fd_(fd),
+      block_size_(block_size),
+      offset_(0),
+      buffers_(section_cnt == 0 ? 1 : section_cnt),
+      record_cnts_(buffers_.size(), 0),
+      blocks_() {
+    Append(MAGIC, MAGIC_SIZE);
+}
+
+MmapSnapshotWriter::~MmapSnapshotWriter() {
+    if (fd_ != NULL) {
+        fclose(fd_);
+    }
+}
+
+::openmldb::log::Status MmapSnapshotWriter::Write(const ::openmldb::api::LogEntry& entry) {
+    uint32_t section = 0;
+    if (entry.dimensions_size() > 0) {
+        const std::string& first_key = entry.dimensions(0).key();
+        section = ::openmldb::base::hash(first_key.data(), first_key.size(), SEED) % buffers_.size();
+    }
+    std::string* buffer = &buffers_[section];
+    PutFixed64(buffer, entry.log_index());
+    PutFixed64(buffer, entry.ts());
+    PutFixed32(buffer, entry.dimensions_size());
+    PutFixed32(buffer, entry.value().size());
+    for (const auto& dimension : entry.dimensions()) {
+        PutFixed32(buffer, dimension.idx());
+        PutFixed32(buffer, dimension.key().size());
+        buffer->append(dimension.key());
+    }
+    buffer->append(entry.value());
+    record_cnts_[section]++;
+    if (buffer->size() >= block_size_) {
+        return WriteBlock(section);
+    }
+    return ::openmldb::log::Status::OK();
+}
+
+::openmldb::log::Status MmapSnapshotWriter::WriteBlock(uint32_t section) {
+    std::string* buffer = &buffers_[section];
+    MmapBlock block;
+    block.section = section;
+    block.record_cnt = record_cnts_[section];
+    block.offset = offset_;
+    block.size = buffer->size();
+    block.crc = ::openmldb::log::Value(buffer->data(), buffer->size());
+    ::openmldb::log::Status status = Append(buffer->data(), buffer->size());
+    if (!status.ok()) {
+        return status;
+    }
+    blocks_.push_back(block);
+    buffer->clear();
+    record_cnts_[section] = 0;
+    return status;
+}
+
+::openmldb::log::Status MmapSnapshotWriter::EndLog() {
+    for (uint32_t section = 0; section < buffers_.size(); section++) {
+        if (record_cnts_[section] == 0) {
+            continue;
+        }
+        ::openmldb::log::Status status = WriteBlock(section);
+        if (!status.ok()) {
+            return status;
+        }
+    }
+    uint64_t index_offset = offset_;
+    std::string index;
+    index.reserve(blocks_.size() * BLOCK_INDEX_SIZE);
+    for (const auto& block : blocks_) {
+        PutFixed32(&index, block.section);
+        PutFixed32(&index, block.record_cnt);
+        PutFixed64(&index, block.offset);
+        PutFixed64(&index, block.size);
+        PutFixed32(&index, block.crc);
+    }
+    std::string trailer;
+    PutFixed64(&trailer, index_offset);
+    PutFixed64(&trailer, blocks_.size());
+    PutFixed32(&trailer, buffers_.size());
+    PutFixed32(&trailer, ::openmldb::log::Value(index.data(), index.size()));
+    trailer.append(MAGIC, MAGIC_SIZE);
+    ::openmldb::log::Status status = Append(index.data(), index.size());
+    if (status.ok()) {
+        status = Append(trailer.data(), trailer.size());
+    }
+    if (status.ok() && fflush(fd_) != 0) {
+        status = ::openmldb::log::Status::IOError("fail to flush", strerror(errno));
+    }
+    return status;
+}
+
+::openmldb::log::Status MmapSnapshotWriter::Append(const char* data, size_t size) {
+    if (size == 0) {
+        return ::openmldb::log::Status::OK();
+    }
+    if (fwrite(data, 1, size, fd_) != size) {
+        return ::openmldb::log::Status::IOError("fail to write", strerror(errno));
+    }
+    offset_ += size;
+    return ::openmldb::log::Status::OK();
+}
+
+MmapSnapshotReader::MmapSnapshotReader() : data_(NULL), size_(0), section_cnt_(0), blocks_() {}
+
+MmapSnapshotReader::~MmapSnapshotReader() {
+    if (data_ != NULL) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+}
+
+bool MmapSnapshotReader::IsMmapSnapshot(FILE* fd) {
+    char magic[MAGIC_SIZE];
+    bool ok = pread(fileno(fd), magic, MAGIC_SIZE, 0) == static_cast<ssize_t>(MAGIC_SIZE) && memcmp(magic, MAGIC, MAGIC_SIZE) == 0;
+    return ok;
+}
+
+bool MmapSnapshotReader::Open(int fd) {
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        PDLOG(WARNING, "fail to stat snapshot. error %s", strerror(errno));
+        return false;
+    }
+    if (static_cast<uint64_t>(st.st_size) < MAGIC_SIZE + TRAILER_SIZE) {
+        PDLOG(WARNING, "snapshot size %ld is too small", st.st_size);
+        return false;
+    }
+    void* addr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED) {
+        PDLOG(WARNING, "fail to mmap snapshot. error %s", strerror(errno));
+        return false;
+    }
+    data_ = reinterpret_cast<const char*>(addr);
+    size_ = st.st_size;
+    const char* trailer = data_ + size_ - TRAILER_SIZE;
+    if (memcmp(trailer + TRAILER_SIZE - MAGIC_SIZE, MAGIC, MAGIC_SIZE) != 0) {
+        PDLOG(WARNING, "snapshot has no trailer, it may be incomplete");
+        return false;
+    }
+    uint64_t index_offset = ::openmldb::log::DecodeFixed64(trailer);
+    uint64_t block_cnt = ::openmldb::log::DecodeFixed64(trailer + 8);
+    section_cnt_ = ::openmldb::log::DecodeFixed32(trailer + 16);
+    uint32_t index_crc = ::openmldb::log::DecodeFixed32(trailer + 20);
+    uint64_t index_size = block_cnt * BLOCK_INDEX_SIZE;
+    if (index_offset < MAGIC_SIZE || index_offset + index_size != size_ - TRAILER_SIZE) {
+        PDLOG(WARNING, "invalid block index offset %lu, block count %lu", index_offset, block_cnt);
+        return false;
+    }
+    const char* index = data_ + index_offset;
+    if (::openmldb::log::Value(index, index_size) != index_crc) {
+        PDLOG(WARNING, "block index checksum mismatch");
+        return false;
+    }
+    blocks_.resize(block_cnt);
+    for (uint64_t i = 0; i < block_cnt; i++) {
+        const char* cur = index + i * BLOCK_INDEX_SIZE;
+        MmapBlock& block = blocks_[i];
+        block.section = ::openmldb::log::DecodeFixed32(cur);
+        block.record_cnt = ::openmldb::log::DecodeFixed32(cur + 4);
+        block.offset = ::openmldb::log::DecodeFixed64(cur + 8);
+        block.size = ::openmldb::log::DecodeFixed64(cur + 16);
+        block.crc = ::openmldb::log::DecodeFixed32(cur + 24);
+        if (block.offset < MAGIC_SIZE || block.offset + block.size > index_offset) {
+            PDLOG(WARNING, "invalid block offset %lu size %lu", block.offset, block.size);
+            blocks_.clear();
+            return false;
+        }
+    }
+    // the blocks are read once in order
+    madvise(addr, size_, MADV_SEQUENTIAL);
+    return true;
+}
+
+bool MmapSnapshotReader::PrepareBlock(const MmapBlock& block) const {
+    const char* start = data_ + block.offset;
+    // madvise needs an address aligned to the page
+    uint64_t page_size = sysconf(_SC_PAGESIZE);
+    uint64_t aligned = block.offset / page_size * page_size;
+    madvise(const_cast<char*>(data_ + aligned), block.offset + block.size - aligned, MADV_WILLNEED);
+    return ::openmldb::log::Value(start, block.size) == block.crc;
+}
+
+bool MmapSnapshotReader::DecodeRecord(const MmapBlock& block, uint64_t* pos, MmapRecord* record) const {
+    const char* start = data_ + block.offset;
+    uint64_t cur = *pos;
+    if (cur + RECORD_HEADER_SIZE > block.size) {
+        return false;
+    }
+    record->log_index = ::openmldb::log::DecodeFixed64(start + cur);
+    record->ts = ::openmldb::log::DecodeFixed64(start + cur + 8);
+    uint32_t dimension_cnt = ::openmldb::log::DecodeFixed32(start + cur + 16);
+    uint32_t value_size = ::openmldb::log::DecodeFixed32(start + cur + 20);
+    cur += RECORD_HEADER_SIZE;
+    record->dimensions.clear();
+    for (uint32_t i = 0; i < dimension_cnt; i++) {
+        if (cur + DIMENSION_HEADER_SIZE > block.size) {
+            return false;
+        }
+        uint32_t idx = ::openmldb::log::DecodeFixed32(start + cur);
+        uint32_t key_size = ::openmldb::log::DecodeFixed32(start + cur + 4);
+        cur += DIMENSION_HEADER_SIZE;
+        if (cur + key_size > block.size) {
+            return false;
+        }
+        record->dimensions.emplace_back(idx, ::openmldb::base::Slice(start + cur, key_size));
+        cur += key_size;
+    }
+    if (cur + value_size > block.size) {
+        return false;
+    }
+    record->value = ::openmldb::base::Slice(start + cur, value_size);
+    *pos = cur + value_size;
+    return true;
+}
+
+SnapshotReader::SnapshotReader(const std::string& path, FILE* fd, bool compressed)
+    : seq_file_(NULL), error_reported_(false), block_idx_(0), pos_(0) {
+    if (!compressed && MmapSnapshotReader::IsMmapSnapshot(fd)) {
+        mmap_reader_.reset(new MmapSnapshotReader());
+        if (!mmap_reader_->Open(fileno(fd))) {
+            PDLOG(WARNING, "fail to open snapshot %s", path.c_str());
+            mmap_reader_.reset();
+        }
+        fclose(fd);
+    } else {
+        seq_file_ = ::openmldb::log::NewSeqFile(path, fd);
+        reader_.reset(new ::openmldb::log::Reader(seq_file_, NULL, false, 0, compressed));
+    }
+}
+
+SnapshotReader::~SnapshotReader() {
+    reader_.reset();
+    // will close the fd atomic
+    delete seq_file_;
+}
+
+::openmldb::log::Status SnapshotReader::ReadRecord(::openmldb::base::Slice* record, std::string* scratch) {
+    if (reader_) {
+        return reader_->ReadRecord(record, scratch);
+    }
+    if (!mmap_reader_) {
+        // report the broken file once, then end it
+        if (!error_reported_) {
+            error_reported_ = true;
+            return ::openmldb::log::Status::Corruption("invalid snapshot");
+        }
+        return ::openmldb::log::Status::Eof();
+    }
+    const auto& blocks = mmap_reader_->GetBlocks();
+    while (block_idx_ < blocks.size()) {
+        const MmapBlock& block = blocks[block_idx_];
+        if (pos_ == 0 && !mmap_reader_->PrepareBlock(block)) {
+            block_idx_++;
+            return ::openmldb::log::Status::Corruption("checksum mismatch");
+        }
+        if (pos_ >= block.size) {
+            block_idx_++;
+            pos_ = 0;
+            continue;
+        }
+        if (!mmap_reader_->DecodeRecord(block, &pos_, &mmap_record_)) {
+            block_idx_++;
+            pos_ = 0;
+            return ::openmldb::log::Status::Corruption("bad record");
+        }
+        entry_.Clear();
+        entry_.set_log_index(mmap_record_.log_index);
+        entry_.set_ts(mmap_record_.ts);
+        entry_.set_value(mmap_record_.value.data(), mmap_record_.value.size());
+        for (const auto& dimension : mmap_record_.dimensions) {
+            auto dim = entry_.add_dimensions();
+            dim->set_idx(dimension.first);
+            dim->set_key(dimension.second.data(), dimension.second.size());
+        }
+        scratch->clear();
+        entry_.SerializeToString(scratch);
+        *record = ::openmldb::base::Slice(*scratch);
+        return ::openmldb::log::Status::OK();
+    }
+    return ::openmldb::log::Status::Eof();
+}
+
+}  // namespace storage
+}  // namespace openmldb
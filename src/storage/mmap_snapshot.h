@@ -0,0 +1,142 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdio.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/slice.h"
+#include "log/log_reader.h"
+#include "log/sequential_file.h"
+#include "log/status.h"
+#include "proto/tablet.pb.h"
+
+namespace openmldb {
+namespace storage {
+
+// The snapshot of format v2 is read by mapping it to memory. The rows are laid out
+// plainly to be put to a memtable without parsing protobuf, and they are grouped in
+// blocks by the segment of their first dimension key, the blocks of a segment are
+// loaded by a thread.
+//
+// file:      magic | block ... | block index ... | trailer
+// block:     record ...
+// record:    log index(8) ts(8) dimension count(4) value size(4) dimension ... value
+// dimension: index id(4) key size(4) key
+// index:     section(4) record count(4) offset(8) size(8) crc(4)
+// trailer:   index offset(8) block count(8) section count(4) index crc(4) magic(8)
+
+struct MmapRecord {
+    uint64_t log_index;
+    uint64_t ts;
+    std::vector<std::pair<uint32_t, ::openmldb::base::Slice>> dimensions;
+    ::openmldb::base::Slice value;
+};
+
+struct MmapBlock {
+    uint32_t section;
+    uint32_t record_cnt;
+    uint64_t offset;
+    uint64_t size;
+    uint32_t crc;
+};
+
+class MmapSnapshotWriter {
+ public:
+    // the file is closed by the writer
+    MmapSnapshotWriter(FILE* fd, uint32_t section_cnt, uint32_t block_size);
+    ~MmapSnapshotWriter();
+    MmapSnapshotWriter(const MmapSnapshotWriter&) = delete;
+    MmapSnapshotWriter& operator=(const MmapSnapshotWriter&) = delete;
+
+    ::openmldb::log::Status Write(const ::openmldb::api::LogEntry& entry);
+
+    // write the blocks left, the block index and the trailer
+    ::openmldb::log::Status EndLog();
+
+ private:
+    ::openmldb::log::Status WriteBlock(uint32_t section);
+    ::openmldb::log::Status Append(const char* data, size_t size);
+
+ private:
+    FILE* fd_;
+    uint32_t const block_size_;
+    uint64_t offset_;
+    std::vector<std::string> buffers_;
+    std::vector<uint32_t> record_cnts_;
+    std::vector<MmapBlock> blocks_;
+};
+
+class MmapSnapshotReader {
+ public:
+    MmapSnapshotReader();
+    ~MmapSnapshotReader();
+    MmapSnapshotReader(const MmapSnapshotReader&) = delete;
+    MmapSnapshotReader& operator=(const MmapSnapshotReader&) = delete;
+
+    // return true if the file is of format v2
+    static bool IsMmapSnapshot(FILE* fd);
+
+    // map the file, fd can be closed after it
+    bool Open(int fd);
+
+    inline uint32_t GetSectionCnt() const { return section_cnt_; }
+
+    inline const std::vector<MmapBlock>& GetBlocks() const { return blocks_; }
+
+    // check the crc of the block and tell the kernel to read it ahead
+    bool PrepareBlock(const MmapBlock& block) const;
+
+    // decode the record at pos of the block and move pos to the next one,
+    // the slices of record refer to the mapped file
+    bool DecodeRecord(const MmapBlock& block, uint64_t* pos, MmapRecord* record) const;
+
+ private:
+    const char* data_;
+    uint64_t size_;
+    uint32_t section_cnt_;
+    std::vector<MmapBlock> blocks_;
+};
+
+// read the records of a snapshot as serialized LogEntry whichever format it is of
+class SnapshotReader {
+ public:
+    // the file is closed by the reader
+    SnapshotReader(const std::string& path, FILE* fd, bool compressed);
+    ~SnapshotReader();
+    SnapshotReader(const SnapshotReader&) = delete;
+    SnapshotReader& operator=(const SnapshotReader&) = delete;
+
+    ::openmldb::log::Status ReadRecord(::openmldb::base::Slice* record, std::string* scratch);
+
+ private:
+    ::openmldb::log::SequentialFile* seq_file_;
+    std::unique_ptr<::openmldb::log::Reader> reader_;
+    std::unique_ptr<MmapSnapshotReader> mmap_reader_;
+    bool error_reported_;
+    uint32_t block_idx_;
+    uint64_t pos_;
+    MmapRecord mmap_record_;
+    ::openmldb::api::LogEntry entry_;
+};
+
+}  // namespace storage
+}  // namespace openmldb
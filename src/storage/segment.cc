@@ -17,8 +17,15 @@
 #include "storage/segment.h"
 
 #include <gflags/gflags.h>
+#include <snappy.h>
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <thread>  // NOLINT
+#include <utility>
 
 #include "base/glog_wapper.h"
+#include "base/hash.h"
 #include "base/strings.h"
 #include "common/timer.h"
 #include "storage/record.h"
@@ -26,51 +33,124 @@
 DECLARE_int32(gc_safe_offset);
 DECLARE_uint32(skiplist_max_height);
 DECLARE_uint32(gc_deleted_pk_version_delta);
+DECLARE_bool(enable_gc_expire_index);
+DECLARE_uint32(gc_expire_index_bucket_ms);
+DECLARE_bool(enable_memtable_key_index);
+DECLARE_uint32(gc_slice_key_cnt);
+DECLARE_uint32(gc_slice_sleep_ms);
+DECLARE_bool(enable_memtable_block_compress);
+DECLARE_uint32(memtable_compress_block_cnt);
 
 namespace openmldb {
 namespace storage {
 
 static const SliceComparator scmp;
+static const uint32_t KEY_INDEX_INIT_SIZE = 1024;
+static const uint32_t SEED = 0xe17a1465;
+
+// pause between gc slices, so a long sweep does not occupy the cpu all the time
+static inline void GcSliceYield(uint64_t* key_cnt) {
+    if (FLAGS_gc_slice_sleep_ms > 0 && FLAGS_gc_slice_key_cnt > 0 && ++(*key_cnt) % FLAGS_gc_slice_key_cnt == 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(FLAGS_gc_slice_sleep_ms));
+    }
+}
+
+// return false if the key entry is empty
+static bool GetOldestTime(KeyEntry* entry, uint64_t* time) {
+    bool has_row = false;
+    if (!entry->entries.IsEmpty()) {
+        *time = entry->entries.GetLast()->GetKey();
+        has_row = true;
+    }
+    FrozenBlock* block = entry->frozen_.load(std::memory_order_relaxed);
+    if (block != NULL) {
+        while (block->next != NULL) {
+            block = block->next;
+        }
+        if (!has_row || block->MinTime() < *time) {
+            *time = block->MinTime();
+        }
+        has_row = true;
+    }
+    return has_row;
+}
 Segment::Segment()
     : entries_(NULL),
+      key_index_(FLAGS_enable_memtable_key_index ? new KeyIndex(KEY_INDEX_INIT_SIZE, SliceHasher(), scmp) : NULL),
       mu_(),
       idx_cnt_(0),
-      idx_byte_size_(0),
+      idx_byte_size_(key_index_ != NULL ? key_index_->GetByteSize() : 0),
       pk_cnt_(0),
       ts_cnt_(1),
       gc_version_(0),
-      ttl_offset_(FLAGS_gc_safe_offset * 60 * 1000) {
+      pinned_version_(UINT64_MAX),
+      ttl_offset_(FLAGS_gc_safe_offset * 60 * 1000),
+      slab_(NULL),
+      expire_bucket_ms_(FLAGS_enable_gc_expire_index ? FLAGS_gc_expire_index_bucket_ms : 0),
+      split_idx_(0),
+      split_seg_cnt_(1),
+      split_depth_(0),
+      split_children_(),
+      split_root_(this),
+      split_state_(0) {
     entries_ = new KeyEntries((uint8_t)FLAGS_skiplist_max_height, 4, scmp);
     key_entry_max_height_ = (uint8_t)FLAGS_skiplist_max_height;
     entry_free_list_ = new KeyEntryNodeList(4, 4, tcmp);
+    moved_free_list_ = new KeyEntryNodeList(4, 4, tcmp);
+    frozen_free_list_ = new FrozenFreeList(4, 4, tcmp);
 }
 
 Segment::Segment(uint8_t height)
     : entries_(NULL),
+      key_index_(FLAGS_enable_memtable_key_index ? new KeyIndex(KEY_INDEX_INIT_SIZE, SliceHasher(), scmp) : NULL),
       mu_(),
       idx_cnt_(0),
-      idx_byte_size_(0),
+      idx_byte_size_(key_index_ != NULL ? key_index_->GetByteSize() : 0),
       pk_cnt_(0),
       key_entry_max_height_(height),
       ts_cnt_(1),
       gc_version_(0),
-      ttl_offset_(FLAGS_gc_safe_offset * 60 * 1000) {
+      pinned_version_(UINT64_MAX),
+      ttl_offset_(FLAGS_gc_safe_offset * 60 * 1000),
+      slab_(NULL),
+      expire_bucket_ms_(FLAGS_enable_gc_expire_index ? FLAGS_gc_expire_index_bucket_ms : 0),
+      split_idx_(0),
+      split_seg_cnt_(1),
+      split_depth_(0),
+      split_children_(),
+      split_root_(this),
+      split_state_(0) {
     entries_ = new KeyEntries((uint8_t)FLAGS_skiplist_max_height, 4, scmp);
     entry_free_list_ = new KeyEntryNodeList(4, 4, tcmp);
+    moved_free_list_ = new KeyEntryNodeList(4, 4, tcmp);
+    frozen_free_list_ = new FrozenFreeList(4, 4, tcmp);
 }
 
 Segment::Segment(uint8_t height, const std::vector<uint32_t>& ts_idx_vec)
     : entries_(NULL),
+      key_index_(FLAGS_enable_memtable_key_index ? new KeyIndex(KEY_INDEX_INIT_SIZE, SliceHasher(), scmp) : NULL),
       mu_(),
       idx_cnt_(0),
-      idx_byte_size_(0),
+      idx_byte_size_(key_index_ != NULL ? key_index_->GetByteSize() : 0),
       pk_cnt_(0),
       key_entry_max_height_(height),
       ts_cnt_(ts_idx_vec.size()),
       gc_version_(0),
-      ttl_offset_(FLAGS_gc_safe_offset * 60 * 1000) {
+      pinned_version_(UINT64_MAX),
+      ttl_offset_(FLAGS_gc_safe_offset * 60 * 1000),
+      slab_(NULL),
+      expire_bucket_ms_(FLAGS_enable_gc_expire_index && ts_idx_vec.size() <= 1 ? FLAGS_gc_expire_index_bucket_ms
+                                                                                : 0),
+      split_idx_(0),
+      split_seg_cnt_(1),
+      split_depth_(0),
+      split_children_(),
+      split_root_(this),
+      split_state_(0) {
     entries_ = new KeyEntries((uint8_t)FLAGS_skiplist_max_height, 4, scmp);
     entry_free_list_ = new KeyEntryNodeList(4, 4, tcmp);
+    moved_free_list_ = new KeyEntryNodeList(4, 4, tcmp);
+    frozen_free_list_ = new FrozenFreeList(4, 4, tcmp);
     for (uint32_t i = 0; i < ts_idx_vec.size(); i++) {
         ts_idx_map_[ts_idx_vec[i]] = i;
         idx_cnt_vec_.push_back(std::make_shared<std::atomic<uint64_t>>(0));
@@ -79,7 +159,10 @@ Segment::Segment(uint8_t height, const std::vector<uint32_t>& ts_idx_vec)
 
 Segment::~Segment() {
     delete entries_;
+    delete key_index_;
     delete entry_free_list_;
+    delete moved_free_list_;
+    delete frozen_free_list_;
 }
 
 uint64_t Segment::Release() {
@@ -92,19 +175,24 @@ uint64_t Segment::Release() {
             if (ts_cnt_ > 1) {
                 KeyEntry** entry_arr = (KeyEntry**)it->GetValue();  // NOLINT
                 for (uint32_t i = 0; i < ts_cnt_; i++) {
-                    cnt += entry_arr[i]->Release();
+                    cnt += entry_arr[i]->Release(slab_);
                     delete entry_arr[i];
                 }
                 delete[] entry_arr;
             } else {
                 KeyEntry* entry = (KeyEntry*)it->GetValue();  // NOLINT
-                cnt += entry->Release();
+                cnt += entry->Release(slab_);
                 delete entry;
             }
         }
         it->Next();
     }
     entries_->Clear();
+    if (key_index_ != NULL) {
+        uint64_t byte_size = key_index_->GetByteSize();
+        key_index_->Clear();
+        idx_byte_size_.fetch_sub(byte_size - key_index_->GetByteSize(), std::memory_order_relaxed);
+    }
     delete it;
 
     KeyEntryNodeList::Iterator* f_it = entry_free_list_->NewIterator();
@@ -115,13 +203,13 @@ uint64_t Segment::Release() {
         if (ts_cnt_ > 1) {
             KeyEntry** entry_arr = (KeyEntry**)node->GetValue();  // NOLINT
             for (uint32_t i = 0; i < ts_cnt_; i++) {
-                entry_arr[i]->Release();
+                entry_arr[i]->Release(slab_);
                 delete entry_arr[i];
             }
             delete[] entry_arr;
         } else {
             KeyEntry* entry = (KeyEntry*)node->GetValue();  // NOLINT
-            entry->Release();
+            entry->Release(slab_);
             delete entry;
         }
         delete node;
@@ -129,7 +217,28 @@ uint64_t Segment::Release() {
     }
     delete f_it;
     entry_free_list_->Clear();
+    f_it = moved_free_list_->NewIterator();
+    f_it->SeekToFirst();
+    while (f_it->Valid()) {
+        ::openmldb::base::Node<Slice, void*>* node = f_it->GetValue();
+        delete[] node->GetKey().data();
+        delete node;
+        f_it->Next();
+    }
+    delete f_it;
+    moved_free_list_->Clear();
+    ::openmldb::base::Node<uint64_t, FrozenGarbage>* garbage = NULL;
+    {
+        std::lock_guard<std::mutex> lock(gc_mu_);
+        garbage = frozen_free_list_->Split(UINT64_MAX);
+    }
+    FreeFrozenGarbage(garbage);
     idx_cnt_vec_.clear();
+    {
+        std::lock_guard<std::mutex> lock(expire_mu_);
+        expire_records_.clear();
+        expire_buckets_.clear();
+    }
     return cnt;
 }
 
@@ -141,7 +250,7 @@ void Segment::ReleaseAndCount(uint64_t& gc_idx_cnt, uint64_t& gc_record_cnt, uin
         ::openmldb::base::Node<Slice, void*>* entry_node = NULL;
         {
             std::lock_guard<std::mutex> lock(mu_);
-            entry_node = entries_->Remove(key);
+            entry_node = RemoveKeyEntry(key);
         }
         if (entry_node != NULL) {
             FreeEntry(entry_node, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
@@ -159,7 +268,7 @@ void Segment::Put(const Slice& key, uint64_t time, const char* data, uint32_t si
     if (ts_cnt_ > 1) {
         return;
     }
-    auto* db = new DataBlock(1, data, size);
+    auto* db = new DataBlock(1, data, size, slab_);
     Put(key, time, db);
 }
 
@@ -167,37 +276,123 @@ void Segment::Put(const Slice& key, uint64_t time, DataBlock* row) {
     if (ts_cnt_ > 1) {
         return;
     }
-    std::lock_guard<std::mutex> lock(mu_);
+    uint32_t hash = 0;
+    uint32_t state = 0;
+    Segment* next = NULL;
+    Segment* segment = Route(key, &hash, &next, &state);
+    void* entry = nullptr;
+    Segment* owner = NULL;
+    if (segment->GetKeyEntry(key, entry) == 0 && entry != NULL) {
+        owner = segment;
+    } else if (next != NULL && next->GetKeyEntry(key, entry) == 0 && entry != NULL) {
+        owner = next;
+    }
+    if (owner != NULL && segment->PutToLinkedEntry(owner, key, entry, (KeyEntry*)entry, time, row)) {  // NOLINT
+        segment->idx_cnt_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    segment->PutSlow(key, hash, time, row);
+}
+
+void Segment::PutSlow(const Slice& key, uint32_t hash, uint64_t time, DataBlock* row) {
+    std::unique_lock<std::mutex> lock(mu_);
+    void* entry = nullptr;
+    if (GetKeyEntry(key, entry) < 0 || entry == NULL) {
+        bool splitting = false;
+        Segment* child = GetSplitChild(hash, split_state_.load(std::memory_order_relaxed), &splitting);
+        if (child != NULL) {
+            // the key is not here and belongs to a segment split from this one
+            lock.unlock();
+            child->PutSlow(key, hash, time, row);
+            return;
+        }
+    }
     PutUnlock(key, time, row);
 }
 
 void Segment::PutUnlock(const Slice& key, uint64_t time, DataBlock* row) {
     void* entry = nullptr;
-    uint32_t byte_size = 0;
-    int ret = entries_->Get(key, entry);
+    int ret = GetKeyEntry(key, entry);
     if (ret < 0 || entry == NULL) {
         char* pk = new char[key.size()];
         memcpy(pk, key.data(), key.size());
         // need to delete memory when free node
         Slice skey(pk, key.size());
         entry = (void*)new KeyEntry(key_entry_max_height_);  // NOLINT
-        uint8_t height = entries_->Insert(skey, entry);
-        byte_size += GetRecordPkIdxSize(height, key.size(), key_entry_max_height_);
+        uint8_t height = InsertKeyEntry(skey, entry);
+        idx_byte_size_.fetch_add(GetRecordPkIdxSize(height, key.size(), key_entry_max_height_),
+                                 std::memory_order_relaxed);
         pk_cnt_.fetch_add(1, std::memory_order_relaxed);
+        if (IsExpireIndexEnabled()) {
+            RegisterExpire((KeyEntry*)entry, skey, time);  // NOLINT
+        }
     }
     idx_cnt_.fetch_add(1, std::memory_order_relaxed);
-    uint8_t height = ((KeyEntry*)entry)->entries.Insert(time, row);  // NOLINT
-    ((KeyEntry*)entry)                                               // NOLINT
-        ->count_.fetch_add(1, std::memory_order_relaxed);
-    byte_size += GetRecordTsIdxSize(height);
-    idx_byte_size_.fetch_add(byte_size, std::memory_order_relaxed);
+    PutToEntry((KeyEntry*)entry, time, row);  // NOLINT
+}
+
+void Segment::PutToEntry(KeyEntry* entry, uint64_t time, DataBlock* row) {
+    bool is_oldest = false;
+    {
+        std::lock_guard<::openmldb::base::SpinMutex> lock(GetEntryMutex(entry));
+        is_oldest = InsertToEntry(entry, time, row);
+    }
+    if (is_oldest) {
+        UpdateExpire(entry, time);
+    }
+}
+
+// An entry is removed from entries_ by gc only when it is empty and mu_ is held,
+// so without mu_ a row can only be put into a non empty entry. A delete removes
+// the entry with rows, so it has to be still linked after the entry mutex is taken,
+// then the put is ordered before the delete and its row goes with the entry
+bool Segment::PutToLinkedEntry(Segment* owner, const Slice& key, void* value, KeyEntry* entry, uint64_t time,
+                               DataBlock* row) {
+    bool is_oldest = false;
+    {
+        std::lock_guard<::openmldb::base::SpinMutex> lock(GetEntryMutex(entry));
+        if (entry->IsEmpty()) {
+            return false;
+        }
+        void* cur = NULL;
+        if (owner->GetKeyEntry(key, cur) < 0 || cur != value) {
+            return false;
+        }
+        is_oldest = InsertToEntry(entry, time, row);
+    }
+    if (is_oldest) {
+        UpdateExpire(entry, time);
+    }
+    return true;
+}
+
+bool Segment::InsertToEntry(KeyEntry* entry, uint64_t time, DataBlock* row) {
+    bool is_oldest = false;
+    if (IsExpireIndexEnabled()) {
+        ::openmldb::base::Node<uint64_t, DataBlock*>* last = entry->entries.GetLast();
+        is_oldest = entry->entries.IsEmpty() || last == NULL || time < last->GetKey();
+    }
+    uint8_t height = entry->entries.Insert(time, row);
+    entry->count_.fetch_add(1, std::memory_order_relaxed);
+    idx_byte_size_.fetch_add(GetRecordTsIdxSize(height), std::memory_order_relaxed);
+    return is_oldest;
 }
 
 void Segment::BulkLoadPut(unsigned int key_entry_id, const Slice& key, uint64_t time, DataBlock* row) {
+    if (!split_children_.empty()) {
+        uint32_t hash = 0;
+        uint32_t state = 0;
+        Segment* next = NULL;
+        Segment* segment = Route(key, &hash, &next, &state);
+        if (segment != this) {
+            segment->BulkLoadPut(key_entry_id, key, time, row);
+            return;
+        }
+    }
     void* key_entry_or_list = nullptr;
     uint32_t byte_size = 0;
     std::lock_guard<std::mutex> lock(mu_);  // TODO(hw): need lock?
-    int ret = entries_->Get(key, key_entry_or_list);
+    int ret = GetKeyEntry(key, key_entry_or_list);
     if (ts_cnt_ == 1) {
         PutUnlock(key, time, row);
     } else {
@@ -209,17 +404,13 @@ void Segment::BulkLoadPut(unsigned int key_entry_id, const Slice& key, uint64_t
             for (uint32_t i = 0; i < ts_cnt_; i++) {
                 entry_arr_tmp[i] = new KeyEntry(key_entry_max_height_);
             }
-            auto entry_arr = (void*)entry_arr_tmp;  // NOLINT
-            uint8_t height = entries_->Insert(skey, entry_arr);
+            key_entry_or_list = (void*)entry_arr_tmp;  // NOLINT
+            uint8_t height = InsertKeyEntry(skey, key_entry_or_list);
             byte_size += GetRecordPkMultiIdxSize(height, key.size(), key_entry_max_height_, ts_cnt_);
             pk_cnt_.fetch_add(1, std::memory_order_relaxed);
         }
-        uint8_t height = ((KeyEntry**)key_entry_or_list)[key_entry_id]->entries.Insert(  // NOLINT
-            time, row);
-        ((KeyEntry**)key_entry_or_list)[key_entry_id]->count_.fetch_add(  // NOLINT
-            1, std::memory_order_relaxed);
-        byte_size += GetRecordTsIdxSize(height);
         idx_byte_size_.fetch_add(byte_size, std::memory_order_relaxed);
+        PutToEntry(((KeyEntry**)key_entry_or_list)[key_entry_id], time, row);  // NOLINT
         idx_cnt_vec_[key_entry_id]->fetch_add(1, std::memory_order_relaxed);
     }
 }
@@ -236,37 +427,68 @@ void Segment::Put(const Slice& key, const std::map<int32_t, uint64_t>& ts_map, D
         }
         return;
     }
+    uint32_t hash = 0;
+    uint32_t state = 0;
+    Segment* next = NULL;
+    Segment* segment = Route(key, &hash, &next, &state);
     void* entry_arr = NULL;
-    std::lock_guard<std::mutex> lock(mu_);
+    Segment* owner = NULL;
+    std::vector<std::pair<uint32_t, uint64_t>> slow_ts;
+    if (segment->GetKeyEntry(key, entry_arr) == 0 && entry_arr != NULL) {
+        owner = segment;
+    } else if (next != NULL && next->GetKeyEntry(key, entry_arr) == 0 && entry_arr != NULL) {
+        owner = next;
+    } else {
+        entry_arr = NULL;
+    }
     for (const auto& kv : ts_map) {
-        uint32_t byte_size = 0;
         auto pos = ts_idx_map_.find(kv.first);
         if (pos == ts_idx_map_.end()) {
             continue;
         }
-        if (entry_arr == NULL) {
-            int ret = entries_->Get(key, entry_arr);
-            if (ret < 0 || entry_arr == NULL) {
-                char* pk = new char[key.size()];
-                memcpy(pk, key.data(), key.size());
-                Slice skey(pk, key.size());
-                KeyEntry** entry_arr_tmp = new KeyEntry*[ts_cnt_];
-                for (uint32_t i = 0; i < ts_cnt_; i++) {
-                    entry_arr_tmp[i] = new KeyEntry(key_entry_max_height_);
-                }
-                entry_arr = (void*)entry_arr_tmp;  // NOLINT
-                uint8_t height = entries_->Insert(skey, entry_arr);
-                byte_size += GetRecordPkMultiIdxSize(height, key.size(), key_entry_max_height_, ts_cnt_);
-                pk_cnt_.fetch_add(1, std::memory_order_relaxed);
-            }
+        if (entry_arr != NULL &&
+            segment->PutToLinkedEntry(owner, key, entry_arr, ((KeyEntry**)entry_arr)[pos->second],  // NOLINT
+                                      kv.second, row)) {
+            segment->idx_cnt_vec_[pos->second]->fetch_add(1, std::memory_order_relaxed);
+        } else {
+            slow_ts.emplace_back(pos->second, kv.second);
         }
-        uint8_t height = ((KeyEntry**)entry_arr)[pos->second]->entries.Insert(  // NOLINT
-            kv.second, row);
-        ((KeyEntry**)entry_arr)[pos->second]->count_.fetch_add(  // NOLINT
-            1, std::memory_order_relaxed);
-        byte_size += GetRecordTsIdxSize(height);
-        idx_byte_size_.fetch_add(byte_size, std::memory_order_relaxed);
-        idx_cnt_vec_[pos->second]->fetch_add(1, std::memory_order_relaxed);
+    }
+    if (slow_ts.empty()) {
+        return;
+    }
+    segment->PutSlow(key, hash, slow_ts, row);
+}
+
+void Segment::PutSlow(const Slice& key, uint32_t hash, const std::vector<std::pair<uint32_t, uint64_t>>& ts,
+                      DataBlock* row) {
+    std::unique_lock<std::mutex> lock(mu_);
+    void* entry_arr = NULL;
+    int ret = GetKeyEntry(key, entry_arr);
+    if (ret < 0 || entry_arr == NULL) {
+        bool splitting = false;
+        Segment* child = GetSplitChild(hash, split_state_.load(std::memory_order_relaxed), &splitting);
+        if (child != NULL) {
+            lock.unlock();
+            child->PutSlow(key, hash, ts, row);
+            return;
+        }
+        char* pk = new char[key.size()];
+        memcpy(pk, key.data(), key.size());
+        Slice skey(pk, key.size());
+        KeyEntry** entry_arr_tmp = new KeyEntry*[ts_cnt_];
+        for (uint32_t i = 0; i < ts_cnt_; i++) {
+            entry_arr_tmp[i] = new KeyEntry(key_entry_max_height_);
+        }
+        entry_arr = (void*)entry_arr_tmp;  // NOLINT
+        uint8_t height = InsertKeyEntry(skey, entry_arr);
+        idx_byte_size_.fetch_add(GetRecordPkMultiIdxSize(height, key.size(), key_entry_max_height_, ts_cnt_),
+                                 std::memory_order_relaxed);
+        pk_cnt_.fetch_add(1, std::memory_order_relaxed);
+    }
+    for (const auto& kv : ts) {
+        PutToEntry(((KeyEntry**)entry_arr)[kv.first], kv.second, row);  // NOLINT
+        idx_cnt_vec_[kv.first]->fetch_add(1, std::memory_order_relaxed);
     }
 }
 
@@ -275,11 +497,10 @@ bool Segment::Get(const Slice& key, const uint64_t time, DataBlock** block) {
         return false;
     }
     void* entry = NULL;
-    if (entries_->Get(key, entry) < 0 || entry == NULL) {
+    if (!FindEntry(key, &entry)) {
         return false;
     }
-    *block = ((KeyEntry*)entry)->entries.Get(time);  // NOLINT
-    return true;
+    return ((KeyEntry*)entry)->Get(time, block);  // NOLINT
 }
 
 bool Segment::Get(const Slice& key, uint32_t idx, const uint64_t time, DataBlock** block) {
@@ -294,29 +515,318 @@ bool Segment::Get(const Slice& key, uint32_t idx, const uint64_t time, DataBlock
         return Get(key, time, block);
     }
     void* entry = NULL;
-    if (entries_->Get(key, entry) < 0 || entry == NULL) {
+    if (!FindEntry(key, &entry)) {
         return false;
     }
-    *block = ((KeyEntry**)entry)[pos->second]->entries.Get(time);  // NOLINT
-    return true;
+    return ((KeyEntry**)entry)[pos->second]->Get(time, block);  // NOLINT
 }
 
 bool Segment::Delete(const Slice& key) {
     ::openmldb::base::Node<Slice, void*>* entry_node = NULL;
+    // the node of the same key entry copied to the split child
+    ::openmldb::base::Node<Slice, void*>* moved_node = NULL;
+    Segment* segment = this;
+    Segment* next = NULL;
+    while (true) {
+        uint32_t hash = 0;
+        uint32_t state = 0;
+        segment = Route(key, &hash, &next, &state);
+        std::lock_guard<std::mutex> lock(segment->mu_);
+        if (segment->split_state_.load(std::memory_order_relaxed) != state) {
+            continue;
+        }
+        entry_node = segment->RemoveKeyEntry(key);
+        if (next != NULL) {
+            std::lock_guard<std::mutex> next_lock(next->mu_);
+            moved_node = next->RemoveKeyEntry(key);
+        }
+        break;
+    }
+    if (moved_node != NULL) {
+        // the key entry copied or created in the split child is counted there
+        std::swap(entry_node, moved_node);
+        std::swap(segment, next);
+    }
+    if (entry_node == NULL) {
+        return false;
+    }
+    if (segment->IsExpireIndexEnabled()) {
+        segment->UnregisterExpire((KeyEntry*)entry_node->GetValue());  // NOLINT
+    }
     {
-        std::lock_guard<std::mutex> lock(mu_);
-        entry_node = entries_->Remove(key);
-        if (entry_node == NULL) {
+        std::lock_guard<std::mutex> lock(segment->gc_mu_);
+        segment->entry_free_list_->Insert(segment->gc_version_.load(std::memory_order_relaxed), entry_node);
+    }
+    if (moved_node != NULL) {
+        if (next->IsExpireIndexEnabled()) {
+            next->UnregisterExpire((KeyEntry*)moved_node->GetValue());  // NOLINT
+        }
+        std::lock_guard<std::mutex> lock(next->gc_mu_);
+        next->moved_free_list_->Insert(next->gc_version_.load(std::memory_order_relaxed), moved_node);
+    }
+    return true;
+}
+
+uint8_t Segment::InsertKeyEntry(const Slice& key, void* entry) {
+    ::openmldb::base::Node<Slice, void*>* node = entries_->InsertNode(key, entry);
+    if (key_index_ != NULL) {
+        uint64_t byte_size = key_index_->GetByteSize();
+        key_index_->Insert(node, gc_version_.load(std::memory_order_relaxed));
+        // the index grows by a new table, the old one is freed by Reclaim
+        idx_byte_size_.fetch_add(key_index_->GetByteSize() - byte_size, std::memory_order_relaxed);
+    }
+    return node->Height();
+}
+
+::openmldb::base::Node<Slice, void*>* Segment::RemoveKeyEntry(const Slice& key) {
+    if (key_index_ != NULL) {
+        key_index_->Remove(key);
+    }
+    return entries_->Remove(key);
+}
+
+::openmldb::base::Node<Slice, void*>* Segment::UnlinkKeyEntry(const Slice& key) {
+    if (key_index_ != NULL) {
+        key_index_->Remove(key);
+    }
+    return entries_->Unlink(key);
+}
+
+Segment* Segment::Route(const Slice& key, uint32_t* hash, Segment** next, uint32_t* state) {
+    *next = NULL;
+    *state = split_state_.load(std::memory_order_acquire);
+    if (split_children_.empty()) {
+        return this;
+    }
+    *hash = ::openmldb::base::hash(key.data(), key.size(), SEED);
+    Segment* segment = this;
+    while (true) {
+        bool splitting = false;
+        Segment* child = segment->GetSplitChild(*hash, *state, &splitting);
+        if (child == NULL) {
+            return segment;
+        }
+        if (splitting) {
+            *next = child;
+            return segment;
+        }
+        segment = child;
+        *state = segment->split_state_.load(std::memory_order_acquire);
+    }
+}
+
+Segment* Segment::GetSplitChild(uint32_t hash, uint32_t state, bool* splitting) const {
+    uint32_t depth = (state >> 1) + (state & 1);
+    for (uint32_t k = split_depth_; k < depth; k++) {
+        if (hash % (split_seg_cnt_ << (k + 1)) != split_idx_) {
+            *splitting = (state & 1) && k + 1 == depth;
+            return split_children_[k - split_depth_];
+        }
+    }
+    return NULL;
+}
+
+bool Segment::FindEntry(const Slice& key, void** entry) {
+    if (split_children_.empty()) {
+        return GetKeyEntry(key, *entry) == 0 && *entry != NULL;
+    }
+    while (true) {
+        uint32_t hash = 0;
+        uint32_t state = 0;
+        Segment* next = NULL;
+        Segment* segment = Route(key, &hash, &next, &state);
+        if ((segment->GetKeyEntry(key, *entry) == 0 && *entry != NULL) ||
+            (next != NULL && next->GetKeyEntry(key, *entry) == 0 && *entry != NULL)) {
+            return true;
+        }
+        // the key may be moved away after the route is taken
+        if (segment->split_state_.load(std::memory_order_acquire) == state) {
             return false;
         }
     }
-    {
-        std::lock_guard<std::mutex> lock(gc_mu_);
-        entry_free_list_->Insert(gc_version_.load(std::memory_order_relaxed), entry_node);
+}
+
+void Segment::SetSplitTree(uint32_t idx, uint32_t seg_cnt, uint32_t depth, uint32_t max_depth, Segment* root) {
+    split_idx_ = idx;
+    split_seg_cnt_ = seg_cnt;
+    split_depth_ = depth;
+    split_children_.assign(max_depth > depth ? max_depth - depth : 0, NULL);
+    split_root_ = root;
+    split_state_.store(depth << 1, std::memory_order_release);
+}
+
+Segment* Segment::NewSplitChild() {
+    if (!CanSplit()) {
+        return NULL;
     }
+    Segment* child = NULL;
+    if (ts_idx_map_.empty()) {
+        child = new Segment(key_entry_max_height_);
+    } else {
+        std::vector<uint32_t> ts_idx_vec(ts_idx_map_.size());
+        for (const auto& kv : ts_idx_map_) {
+            ts_idx_vec[kv.second] = kv.first;
+        }
+        child = new Segment(key_entry_max_height_, ts_idx_vec);
+    }
+    uint32_t depth = GetSplitDepth();
+    child->SetSplitTree(split_idx_ + (split_seg_cnt_ << depth), split_seg_cnt_, depth + 1,
+                        split_depth_ + split_children_.size(), split_root_);
+    child->SetSlabAllocator(slab_);
+    if (pinned_version_.load() != UINT64_MAX) {
+        // a dump walking the tree is going on
+        child->PinGcVersion();
+    }
+    return child;
+}
+
+bool Segment::StartSplit(Segment* child) {
+    std::lock_guard<std::mutex> lock(mu_);
+    uint32_t state = split_state_.load(std::memory_order_relaxed);
+    uint32_t depth = state >> 1;
+    if (child == NULL || (state & 1) || depth - split_depth_ >= split_children_.size()) {
+        return false;
+    }
+    split_children_[depth - split_depth_] = child;
+    // the new keys of the child are created in it from now on
+    split_state_.store(state | 1, std::memory_order_release);
     return true;
 }
 
+uint64_t Segment::CopySplitKeys() {
+    uint32_t state = split_state_.load(std::memory_order_acquire);
+    if ((state & 1) == 0) {
+        return 0;
+    }
+    uint32_t depth = state >> 1;
+    Segment* child = split_children_[depth - split_depth_];
+    uint32_t mod = split_seg_cnt_ << (depth + 1);
+    uint64_t copy_cnt = 0;
+    uint64_t slice_cnt = 0;
+    KeyEntries::Iterator* it = entries_->NewIterator();
+    it->SeekToFirst();
+    while (it->Valid()) {
+        GcSliceYield(&slice_cnt);
+        Slice key = it->GetKey();
+        std::lock_guard<std::mutex> lock(mu_);
+        void* value = NULL;
+        if (GetKeyEntry(key, value) < 0 || value == NULL) {
+            // a delete cleared the next pointers of the node
+            it->Seek(key);
+            continue;
+        }
+        it->Next();
+        if (::openmldb::base::hash(key.data(), key.size(), SEED) % mod == split_idx_) {
+            continue;
+        }
+        std::lock_guard<std::mutex> child_lock(child->mu_);
+        void* child_value = NULL;
+        if (child->GetKeyEntry(key, child_value) == 0) {
+            if (child_value != value) {
+                PDLOG(WARNING, "key %s is in both segments of split with different entries",
+                      key.ToString().c_str());
+            }
+            continue;
+        }
+        char* pk = new char[key.size()];
+        memcpy(pk, key.data(), key.size());
+        Slice skey(pk, key.size());
+        uint8_t height = child->InsertKeyEntry(skey, value);
+        uint64_t byte_size = ts_cnt_ > 1
+                                 ? GetRecordPkMultiIdxSize(height, key.size(), key_entry_max_height_, ts_cnt_)
+                                 : GetRecordPkIdxSize(height, key.size(), key_entry_max_height_);
+        child->idx_byte_size_.fetch_add(byte_size, std::memory_order_relaxed);
+        child->pk_cnt_.fetch_add(1, std::memory_order_relaxed);
+        pk_cnt_.fetch_sub(1, std::memory_order_relaxed);
+        if (child->IsExpireIndexEnabled()) {
+            KeyEntry* entry = (KeyEntry*)value;  // NOLINT
+            uint64_t time = UINT64_MAX;
+            {
+                std::lock_guard<::openmldb::base::SpinMutex> entry_lock(GetEntryMutex(entry));
+                GetOldestTime(entry, &time);
+            }
+            child->RegisterExpire(entry, skey, time);
+        }
+        copy_cnt++;
+    }
+    delete it;
+    return copy_cnt;
+}
+
+void Segment::FinishSplit() {
+    std::lock_guard<std::mutex> lock(mu_);
+    uint32_t state = split_state_.load(std::memory_order_relaxed);
+    if (state & 1) {
+        split_state_.store(((state >> 1) + 1) << 1, std::memory_order_release);
+    }
+}
+
+uint64_t Segment::RemoveSplitKeys() {
+    uint32_t state = split_state_.load(std::memory_order_acquire);
+    uint32_t depth = state >> 1;
+    if ((state & 1) || depth == split_depth_) {
+        return 0;
+    }
+    Segment* child = split_children_[depth - 1 - split_depth_];
+    uint32_t mod = split_seg_cnt_ << depth;
+    uint64_t remove_cnt = 0;
+    uint64_t slice_cnt = 0;
+    KeyEntries::Iterator* it = entries_->NewIterator();
+    it->SeekToFirst();
+    while (it->Valid()) {
+        GcSliceYield(&slice_cnt);
+        Slice key = it->GetKey();
+        ::openmldb::base::Node<Slice, void*>* node = NULL;
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+            void* value = NULL;
+            if (GetKeyEntry(key, value) < 0) {
+                // a delete cleared the next pointers of the node
+                it->Seek(key);
+                continue;
+            }
+            it->Next();
+            if (::openmldb::base::hash(key.data(), key.size(), SEED) % mod == split_idx_) {
+                continue;
+            }
+            // the readers standing on the node go on to the next key
+            node = UnlinkKeyEntry(key);
+        }
+        if (node == NULL) {
+            continue;
+        }
+        uint64_t byte_size = ts_cnt_ > 1 ? GetRecordPkMultiIdxSize(node->Height(), key.size(),
+                                                                   key_entry_max_height_, ts_cnt_)
+                                         : GetRecordPkIdxSize(node->Height(), key.size(), key_entry_max_height_);
+        idx_byte_size_.fetch_sub(byte_size, std::memory_order_relaxed);
+        if (IsExpireIndexEnabled()) {
+            KeyEntry* entry = (KeyEntry*)node->GetValue();  // NOLINT
+            UnregisterExpire(entry);
+            // the puts finding the key entry here updated the expire index of this segment
+            std::lock_guard<std::mutex> child_lock(child->mu_);
+            void* value = NULL;
+            uint64_t time = 0;
+            if (child->GetKeyEntry(key, value) == 0 && value == entry) {
+                bool has_time = false;
+                {
+                    std::lock_guard<::openmldb::base::SpinMutex> entry_lock(GetEntryMutex(entry));
+                    has_time = GetOldestTime(entry, &time);
+                }
+                if (has_time) {
+                    child->UpdateExpire(entry, time);
+                }
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(gc_mu_);
+            moved_free_list_->Insert(gc_version_.load(std::memory_order_relaxed), node);
+        }
+        remove_cnt++;
+    }
+    delete it;
+    return remove_cnt;
+}
+
 void Segment::FreeList(::openmldb::base::Node<uint64_t, DataBlock*>* node, uint64_t& gc_idx_cnt,
                        uint64_t& gc_record_cnt, uint64_t& gc_record_byte_size) {
     while (node != NULL) {
@@ -330,7 +840,7 @@ void Segment::FreeList(::openmldb::base::Node<uint64_t, DataBlock*>* node, uint6
         } else {
             DEBUGLOG("delele data block for key %lu", tmp->GetKey());
             gc_record_byte_size += GetRecordSize(tmp->GetValue()->size);
-            delete tmp->GetValue();
+            FreeDataBlock(tmp->GetValue(), slab_);
             gc_record_cnt++;
         }
         delete tmp;
@@ -357,6 +867,8 @@ void Segment::FreeEntry(::openmldb::base::Node<Slice, void*>* entry_node, uint64
                 FreeList(data_node, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
             }
             delete it;
+            FreeFrozen(entry->frozen_.exchange(NULL, std::memory_order_relaxed), 0, gc_idx_cnt, gc_record_cnt,
+                       gc_record_byte_size);
             delete entry;
             idx_cnt_vec_[i]->fetch_sub(gc_idx_cnt - old, std::memory_order_relaxed);
         }
@@ -375,6 +887,8 @@ void Segment::FreeEntry(::openmldb::base::Node<Slice, void*>* entry_node, uint64
             FreeList(data_node, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
         }
         delete it;
+        FreeFrozen(entry->frozen_.exchange(NULL, std::memory_order_relaxed), 0, gc_idx_cnt, gc_record_cnt,
+                   gc_record_byte_size);
         delete entry;
         uint64_t byte_size =
             GetRecordPkIdxSize(entry_node->Height(), entry_node->GetKey().size(), key_entry_max_height_);
@@ -399,6 +913,31 @@ void Segment::GcEntryFreeList(uint64_t version, uint64_t& gc_idx_cnt, uint64_t&
         delete tmp;
         pk_cnt_.fetch_sub(1, std::memory_order_relaxed);
     }
+    {
+        std::lock_guard<std::mutex> lock(gc_mu_);
+        node = moved_free_list_->Split(version);
+    }
+    while (node != NULL) {
+        ::openmldb::base::Node<Slice, void*>* entry_node = node->GetValue();
+        delete[] entry_node->GetKey().data();
+        delete entry_node;
+        ::openmldb::base::Node<uint64_t, ::openmldb::base::Node<Slice, void*>*>* tmp = node;
+        node = node->GetNextNoBarrier(0);
+        delete tmp;
+    }
+    ::openmldb::base::Node<uint64_t, FrozenGarbage>* garbage = NULL;
+    {
+        std::lock_guard<std::mutex> lock(gc_mu_);
+        garbage = frozen_free_list_->Split(version);
+    }
+    FreeFrozenGarbage(garbage);
+    if (key_index_ != NULL) {
+        // the tables replaced in the same version as the nodes freed above are not visible either
+        std::lock_guard<std::mutex> lock(mu_);
+        uint64_t byte_size = key_index_->GetByteSize();
+        key_index_->Reclaim(version);
+        idx_byte_size_.fetch_sub(byte_size - key_index_->GetByteSize(), std::memory_order_relaxed);
+    }
 }
 
 void Segment::GcFreeList(uint64_t& gc_idx_cnt, uint64_t& gc_record_cnt, uint64_t& gc_record_byte_size) {
@@ -407,6 +946,8 @@ void Segment::GcFreeList(uint64_t& gc_idx_cnt, uint64_t& gc_record_cnt, uint64_t
         return;
     }
     uint64_t free_list_version = cur_version - FLAGS_gc_deleted_pk_version_delta;
+    // the nodes inserted since the pinned version may be visited by the walk pinning it
+    free_list_version = std::min(free_list_version, pinned_version_.load());
     GcEntryFreeList(free_list_version, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
 }
 
@@ -483,12 +1024,14 @@ void Segment::Gc4Head(uint64_t keep_cnt, uint64_t& gc_idx_cnt, uint64_t& gc_reco
     uint64_t old = gc_idx_cnt;
     KeyEntries::Iterator* it = entries_->NewIterator();
     it->SeekToFirst();
+    uint64_t slice_cnt = 0;
     while (it->Valid()) {
+        GcSliceYield(&slice_cnt);
         KeyEntry* entry = (KeyEntry*)it->GetValue();  // NOLINT
         ::openmldb::base::Node<uint64_t, DataBlock*>* node = NULL;
         {
-            std::lock_guard<std::mutex> lock(mu_);
-            if (entry->refs_.load(std::memory_order_acquire) <= 0) {
+            std::lock_guard<::openmldb::base::SpinMutex> lock(GetEntryMutex(entry));
+            if (entry->refs_.load(std::memory_order_acquire) <= 0 && ThawEntry(entry)) {
                 node = entry->entries.SplitByPos(keep_cnt);
             }
         }
@@ -510,7 +1053,9 @@ void Segment::GcAllType(const std::map<uint32_t, TTLSt>& ttl_st_map, uint64_t& g
     uint64_t consumed = ::baidu::common::timer::get_micros();
     KeyEntries::Iterator* it = entries_->NewIterator();
     it->SeekToFirst();
+    uint64_t slice_cnt = 0;
     while (it->Valid()) {
+        GcSliceYield(&slice_cnt);
         KeyEntry** entry_arr = (KeyEntry**)it->GetValue();  // NOLINT
         Slice key = it->GetKey();
         it->Next();
@@ -533,16 +1078,16 @@ void Segment::GcAllType(const std::map<uint32_t, TTLSt>& ttl_st_map, uint64_t& g
                         continue_flag = true;
                     } else {
                         node = NULL;
-                        std::lock_guard<std::mutex> lock(mu_);
+                        std::lock_guard<::openmldb::base::SpinMutex> lock(GetEntryMutex(entry));
                         SplitList(entry, kv.second.abs_ttl, &node);
-                        if (entry->entries.IsEmpty()) {
+                        if (entry->IsEmpty()) {
                             empty_cnt++;
                         }
                     }
                     break;
                 }
                 case ::openmldb::storage::TTLType::kLatestTime: {
-                    std::lock_guard<std::mutex> lock(mu_);
+                    std::lock_guard<::openmldb::base::SpinMutex> lock(GetEntryMutex(entry));
                     if (entry->refs_.load(std::memory_order_acquire) <= 0) {
                         node = entry->entries.SplitByPos(kv.second.lat_ttl);
                     }
@@ -554,7 +1099,7 @@ void Segment::GcAllType(const std::map<uint32_t, TTLSt>& ttl_st_map, uint64_t& g
                         continue_flag = true;
                     } else {
                         node = NULL;
-                        std::lock_guard<std::mutex> lock(mu_);
+                        std::lock_guard<::openmldb::base::SpinMutex> lock(GetEntryMutex(entry));
                         if (entry->refs_.load(std::memory_order_acquire) <= 0) {
                             node = entry->entries.SplitByKeyAndPos(kv.second.abs_ttl, kv.second.lat_ttl);
                         }
@@ -567,7 +1112,7 @@ void Segment::GcAllType(const std::map<uint32_t, TTLSt>& ttl_st_map, uint64_t& g
                         continue_flag = true;
                     } else {
                         node = NULL;
-                        std::lock_guard<std::mutex> lock(mu_);
+                        std::lock_guard<::openmldb::base::SpinMutex> lock(GetEntryMutex(entry));
                         if (entry->refs_.load(std::memory_order_acquire) <= 0) {
                             if (kv.second.abs_ttl == 0) {
                                 node = entry->entries.SplitByPos(kv.second.lat_ttl);
@@ -577,7 +1122,7 @@ void Segment::GcAllType(const std::map<uint32_t, TTLSt>& ttl_st_map, uint64_t& g
                                 node = entry->entries.SplitByKeyOrPos(kv.second.abs_ttl, kv.second.lat_ttl);
                             }
                         }
-                        if (entry->entries.IsEmpty()) {
+                        if (entry->IsEmpty()) {
                             empty_cnt++;
                         }
                     }
@@ -601,13 +1146,13 @@ void Segment::GcAllType(const std::map<uint32_t, TTLSt>& ttl_st_map, uint64_t& g
             {
                 std::lock_guard<std::mutex> lock(mu_);
                 for (uint32_t i = 0; i < ts_cnt_; i++) {
-                    if (!entry_arr[i]->entries.IsEmpty()) {
+                    if (!entry_arr[i]->IsEmpty()) {
                         is_empty = false;
                         break;
                     }
                 }
                 if (is_empty) {
-                    entry_node = entries_->Remove(key);
+                    entry_node = RemoveKeyEntry(key);
                 }
             }
             if (entry_node != NULL) {
@@ -628,21 +1173,358 @@ void Segment::SplitList(KeyEntry* entry, uint64_t ts, ::openmldb::base::Node<uin
     }
 }
 
+uint64_t Segment::FreezeList(KeyEntry* entry, ::openmldb::base::Node<uint64_t, DataBlock*>* node) {
+    if (node == NULL) {
+        return 0;
+    }
+    uint32_t cnt = 0;
+    uint64_t node_byte_size = 0;
+    uint64_t min_time = 0;
+    for (auto* cur = node; cur != NULL; cur = cur->GetNextNoBarrier(0)) {
+        cnt++;
+        node_byte_size += GetRecordTsIdxSize(cur->Height());
+        min_time = cur->GetKey();
+    }
+    FrozenBlock* head = entry->frozen_.load(std::memory_order_relaxed);
+    FrozenBlock* end = head;
+    uint64_t merged_byte_size = 0;
+    uint32_t total = cnt;
+    while (end != NULL && end->MaxTime() >= min_time) {
+        total += end->cnt;
+        merged_byte_size += FrozenBlock::GetSize(end->cnt);
+        end = end->next;
+    }
+    FrozenBlock* block = FrozenBlock::New(total);
+    FrozenBlock* cur_block = head;
+    uint32_t block_pos = 0;
+    for (uint32_t pos = 0; pos < total; pos++) {
+        if (cur_block == end || (node != NULL && node->GetKey() >= cur_block->ts[block_pos])) {
+            block->ts[pos] = node->GetKey();
+            block->rows[pos] = node->GetValue();
+            node = node->GetNextNoBarrier(0);
+        } else {
+            block->ts[pos] = cur_block->ts[block_pos];
+            block->rows[pos] = cur_block->rows[block_pos];
+            if (++block_pos >= cur_block->cnt) {
+                cur_block = cur_block->next;
+                block_pos = 0;
+            }
+        }
+    }
+    block->next = end;
+    entry->frozen_.store(block, std::memory_order_release);
+    while (head != end) {
+        FrozenBlock* tmp = head;
+        head = head->next;
+        RetireFrozen(tmp, NULL, NULL);
+    }
+    idx_byte_size_.fetch_add(FrozenBlock::GetSize(total), std::memory_order_relaxed);
+    idx_byte_size_.fetch_sub(node_byte_size + merged_byte_size, std::memory_order_relaxed);
+    return cnt;
+}
+
+bool Segment::ThawEntry(KeyEntry* entry) {
+    if (!InflateFrozen(entry, 0)) {
+        return false;
+    }
+    FrozenBlock* block = entry->frozen_.exchange(NULL, std::memory_order_relaxed);
+    while (block != NULL) {
+        for (uint32_t i = 0; i < block->cnt; i++) {
+            uint8_t height = entry->entries.Insert(block->ts[i], block->rows[i]);
+            idx_byte_size_.fetch_add(GetRecordTsIdxSize(height), std::memory_order_relaxed);
+        }
+        idx_byte_size_.fetch_sub(FrozenBlock::GetSize(block->cnt), std::memory_order_relaxed);
+        FrozenBlock* tmp = block;
+        block = block->next;
+        RetireFrozen(tmp, NULL, NULL);
+    }
+    return true;
+}
+
+// detach the frozen rows not newer than time, the rows of the returned blocks
+// start from pos should be freed
+FrozenBlock* Segment::SplitFrozen(KeyEntry* entry, uint64_t time, uint32_t* pos) {
+    *pos = 0;
+    if (entry->refs_.load(std::memory_order_acquire) > 0) {
+        return NULL;
+    }
+    FrozenBlock* pre = NULL;
+    FrozenBlock* block = entry->frozen_.load(std::memory_order_relaxed);
+    while (block != NULL && block->MinTime() > time) {
+        pre = block;
+        block = block->next;
+    }
+    if (block == NULL) {
+        return NULL;
+    }
+    FrozenBlock* remain = NULL;
+    uint32_t keep = block->LowerBound(time);
+    if (keep > 0) {
+        if (block->IsPacked()) {
+            remain = Inflate(block, keep);
+            if (remain == NULL) {
+                return NULL;
+            }
+        } else {
+            remain = FrozenBlock::New(keep);
+            memcpy(remain->ts, block->ts, keep * sizeof(uint64_t));
+            memcpy(remain->rows, block->rows, keep * sizeof(DataBlock*));
+        }
+        idx_byte_size_.fetch_add(FrozenBlock::GetSize(keep), std::memory_order_relaxed);
+        *pos = keep;
+    }
+    if (pre == NULL) {
+        entry->frozen_.store(remain, std::memory_order_release);
+    } else {
+        pre->next = remain;
+    }
+    return block;
+}
+
+void Segment::FreeFrozen(FrozenBlock* block, uint32_t pos, uint64_t& gc_idx_cnt, uint64_t& gc_record_cnt,
+                         uint64_t& gc_record_byte_size) {
+    while (block != NULL) {
+        for (uint32_t i = pos; block->IsPacked() && i < block->cnt; i++) {
+            // the packed rows are referred by this index only
+            gc_idx_cnt++;
+            gc_record_byte_size += GetRecordSize(block->GetRowSize(i));
+            gc_record_cnt++;
+        }
+        for (uint32_t i = pos; !block->IsPacked() && i < block->cnt; i++) {
+            gc_idx_cnt++;
+            DataBlock* row = block->rows[i];
+            if (row->dim_cnt_down > 1) {
+                row->dim_cnt_down--;
+            } else {
+                gc_record_byte_size += GetRecordSize(row->size);
+                FreeDataBlock(row, slab_);
+                gc_record_cnt++;
+            }
+        }
+        idx_byte_size_.fetch_sub(block->GetByteSize(), std::memory_order_relaxed);
+        pos = 0;
+        FrozenBlock* tmp = block;
+        block = block->next;
+        RetireFrozen(tmp, NULL, NULL);
+    }
+}
+
+FrozenBlock* Segment::Inflate(const FrozenBlock* block, uint32_t cnt) {
+    UnpackedBlock unpacked(block);
+    if (!unpacked.ok) {
+        return NULL;
+    }
+    FrozenBlock* plain = FrozenBlock::New(cnt);
+    memcpy(plain->ts, block->ts, cnt * sizeof(uint64_t));
+    for (uint32_t i = 0; i < cnt; i++) {
+        plain->rows[i] = new DataBlock(1, unpacked.rows[i].data, unpacked.rows[i].size, slab_);
+    }
+    return plain;
+}
+
+bool Segment::InflateFrozen(KeyEntry* entry, uint64_t time) {
+    FrozenBlock* pre = NULL;
+    FrozenBlock* block = entry->frozen_.load(std::memory_order_relaxed);
+    while (block != NULL && block->MaxTime() >= time) {
+        if (block->IsPacked()) {
+            FrozenBlock* plain = Inflate(block, block->cnt);
+            if (plain == NULL) {
+                // the iterators report the block as failed, keep it rather than lose the rows
+                return false;
+            }
+            plain->next = block->next;
+            if (pre == NULL) {
+                entry->frozen_.store(plain, std::memory_order_release);
+            } else {
+                pre->next = plain;
+            }
+            idx_byte_size_.fetch_add(plain->GetByteSize(), std::memory_order_relaxed);
+            idx_byte_size_.fetch_sub(block->GetByteSize(), std::memory_order_relaxed);
+            RetireFrozen(block, NULL, NULL);
+            block = plain;
+        }
+        pre = block;
+        block = block->next;
+    }
+    return true;
+}
+
+// compress the rows together, return NULL if it does not save memory
+static FrozenBlock* PackRows(const FrozenBlock* block, uint32_t start, uint32_t cnt) {
+    uint64_t raw_size = 0;
+    for (uint32_t i = start; i < start + cnt; i++) {
+        raw_size += block->rows[i]->size;
+    }
+    if (raw_size > UINT32_MAX) {
+        return NULL;
+    }
+    std::string raw;
+    raw.reserve(raw_size);
+    for (uint32_t i = start; i < start + cnt; i++) {
+        raw.append(block->rows[i]->data, block->rows[i]->size);
+    }
+    std::string compressed;
+    snappy::Compress(raw.data(), raw.size(), &compressed);
+    if (FrozenBlock::GetPackedSize(cnt, compressed.size()) >=
+        FrozenBlock::GetSize(cnt) + raw_size + cnt * sizeof(DataBlock)) {
+        return NULL;
+    }
+    FrozenBlock* packed = FrozenBlock::NewPacked(cnt, compressed.size());
+    memcpy(packed->ts, block->ts + start, cnt * sizeof(uint64_t));
+    uint32_t offset = 0;
+    for (uint32_t i = 0; i < cnt; i++) {
+        packed->offsets[i] = offset;
+        offset += block->rows[start + i]->size;
+    }
+    packed->offsets[cnt] = offset;
+    memcpy(packed->packed, compressed.data(), compressed.size());
+    return packed;
+}
+
+void Segment::PackFrozen(KeyEntry* entry, uint32_t max_cnt) {
+    FrozenBlock* block = entry->frozen_.load(std::memory_order_relaxed);
+    if (block == NULL || block->IsPacked() || max_cnt == 0 || entry->refs_.load(std::memory_order_acquire) > 0) {
+        return;
+    }
+    std::vector<FrozenBlock*> blocks;
+    bool packed = false;
+    for (uint32_t start = 0; start < block->cnt; start += max_cnt) {
+        uint32_t cnt = std::min(max_cnt, block->cnt - start);
+        FrozenBlock* cur = NULL;
+        bool exclusive = true;
+        for (uint32_t i = start; i < start + cnt && exclusive; i++) {
+            exclusive = block->rows[i]->dim_cnt_down == 1;
+        }
+        if (exclusive) {
+            cur = PackRows(block, start, cnt);
+        }
+        if (cur == NULL) {
+            cur = FrozenBlock::New(cnt);
+            memcpy(cur->ts, block->ts + start, cnt * sizeof(uint64_t));
+            memcpy(cur->rows, block->rows + start, cnt * sizeof(DataBlock*));
+        } else {
+            packed = true;
+        }
+        blocks.push_back(cur);
+    }
+    if (!packed) {
+        for (FrozenBlock* cur : blocks) {
+            FrozenBlock::Delete(cur);
+        }
+        return;
+    }
+    blocks.back()->next = block->next;
+    for (uint32_t i = blocks.size() - 1; i > 0; i--) {
+        blocks[i - 1]->next = blocks[i];
+    }
+    entry->frozen_.store(blocks[0], std::memory_order_release);
+    uint32_t start = 0;
+    for (FrozenBlock* cur : blocks) {
+        for (uint32_t i = start; cur->IsPacked() && i < start + cur->cnt; i++) {
+            RetireFrozen(NULL, block->rows[i], NULL);
+        }
+        start += cur->cnt;
+        idx_byte_size_.fetch_add(cur->GetByteSize(), std::memory_order_relaxed);
+    }
+    idx_byte_size_.fetch_sub(block->GetByteSize(), std::memory_order_relaxed);
+    RetireFrozen(block, NULL, NULL);
+}
+
+void Segment::RetireFrozen(FrozenBlock* block, DataBlock* row, ::openmldb::base::Node<uint64_t, DataBlock*>* nodes) {
+    FrozenGarbage garbage = {block, row, nodes};
+    std::lock_guard<std::mutex> lock(gc_mu_);
+    frozen_free_list_->Insert(gc_version_.load(std::memory_order_relaxed), garbage);
+}
+
+void Segment::FreeFrozenGarbage(::openmldb::base::Node<uint64_t, FrozenGarbage>* node) {
+    while (node != NULL) {
+        FrozenGarbage& garbage = node->GetValue();
+        if (garbage.block != NULL) {
+            FrozenBlock::Delete(garbage.block);
+        }
+        if (garbage.row != NULL) {
+            FreeDataBlock(garbage.row, slab_);
+        }
+        while (garbage.nodes != NULL) {
+            ::openmldb::base::Node<uint64_t, DataBlock*>* tmp = garbage.nodes;
+            garbage.nodes = garbage.nodes->GetNextNoBarrier(0);
+            delete tmp;
+        }
+        ::openmldb::base::Node<uint64_t, FrozenGarbage>* tmp = node;
+        node = node->GetNextNoBarrier(0);
+        delete tmp;
+    }
+}
+
+uint64_t Segment::Freeze(uint64_t time, uint64_t min_cnt) {
+    if (ts_cnt_ > 1) {
+        return 0;
+    }
+    uint64_t consumed = ::baidu::common::timer::get_micros();
+    uint64_t frozen_cnt = 0;
+    KeyEntries::Iterator* it = entries_->NewIterator();
+    it->SeekToFirst();
+    uint64_t slice_cnt = 0;
+    while (it->Valid()) {
+        GcSliceYield(&slice_cnt);
+        KeyEntry* entry = (KeyEntry*)it->GetValue();  // NOLINT
+        it->Next();
+        if (entry->count_.load(std::memory_order_relaxed) < min_cnt) {
+            continue;
+        }
+        ::openmldb::base::Node<uint64_t, DataBlock*>* node = entry->entries.GetLast();
+        if (node == NULL || node->GetKey() > time) {
+            continue;
+        }
+        node = NULL;
+        {
+            std::lock_guard<::openmldb::base::SpinMutex> lock(GetEntryMutex(entry));
+            // the blocks newer than the oldest row in list are merged with it, so blocks never overlap.
+            // Skip the entry if one of them can not be uncompressed
+            ::openmldb::base::Node<uint64_t, DataBlock*>* last = entry->entries.GetLast();
+            if (last == NULL || !InflateFrozen(entry, last->GetKey())) {
+                continue;
+            }
+            SplitList(entry, time, &node);
+            uint64_t cnt = FreezeList(entry, node);
+            if (cnt > 0 && FLAGS_enable_memtable_block_compress) {
+                PackFrozen(entry, FLAGS_memtable_compress_block_cnt);
+            }
+            frozen_cnt += cnt;
+        }
+        // the rows have been moved into the frozen block, just free the nodes
+        if (node != NULL) {
+            RetireFrozen(NULL, NULL, node);
+        }
+    }
+    delete it;
+    DEBUGLOG("[Freeze] segment freeze with key %lu consumed %lu, count %lu", time,
+             (::baidu::common::timer::get_micros() - consumed) / 1000, frozen_cnt);
+    return frozen_cnt;
+}
+
 // fast gc with no global pause
 void Segment::Gc4TTL(const uint64_t time, uint64_t& gc_idx_cnt, uint64_t& gc_record_cnt,
                      uint64_t& gc_record_byte_size) {
+    if (IsExpireIndexEnabled()) {
+        Gc4TTLByIndex(time, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+        return;
+    }
     uint64_t consumed = ::baidu::common::timer::get_micros();
     uint64_t old = gc_idx_cnt;
     KeyEntries::Iterator* it = entries_->NewIterator();
     it->SeekToFirst();
+    uint64_t slice_cnt = 0;
     while (it->Valid()) {
+        GcSliceYield(&slice_cnt);
         KeyEntry* entry = (KeyEntry*)it->GetValue();  // NOLINT
         Slice key = it->GetKey();
         it->Next();
         ::openmldb::base::Node<uint64_t, DataBlock*>* node = entry->entries.GetLast();
-        if (node == NULL) {
+        bool has_frozen = entry->frozen_.load(std::memory_order_relaxed) != NULL;
+        if (node == NULL && !has_frozen) {
             continue;
-        } else if (node->GetKey() > time) {
+        } else if (!has_frozen && node->GetKey() > time) {
             DEBUGLOG(
                 "[Gc4TTL] segment gc with key %lu need not ttl, last node "
                 "key %lu",
@@ -650,12 +1532,23 @@ void Segment::Gc4TTL(const uint64_t time, uint64_t& gc_idx_cnt, uint64_t& gc_rec
             continue;
         }
         node = NULL;
+        FrozenBlock* frozen = NULL;
+        uint32_t frozen_pos = 0;
         ::openmldb::base::Node<Slice, void*>* entry_node = NULL;
+        bool is_empty = false;
         {
-            std::lock_guard<std::mutex> lock(mu_);
+            std::lock_guard<::openmldb::base::SpinMutex> lock(GetEntryMutex(entry));
             SplitList(entry, time, &node);
-            if (entry->entries.IsEmpty()) {
-                entry_node = entries_->Remove(key);
+            if (has_frozen) {
+                frozen = SplitFrozen(entry, time, &frozen_pos);
+            }
+            is_empty = entry->IsEmpty();
+        }
+        if (is_empty) {
+            // an empty entry can only be refilled with mu_ held
+            std::lock_guard<std::mutex> lock(mu_);
+            if (entry->IsEmpty()) {
+                entry_node = RemoveKeyEntry(key);
             }
         }
         if (entry_node != NULL) {
@@ -664,6 +1557,7 @@ void Segment::Gc4TTL(const uint64_t time, uint64_t& gc_idx_cnt, uint64_t& gc_rec
         }
         uint64_t entry_gc_idx_cnt = 0;
         FreeList(node, entry_gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+        FreeFrozen(frozen, frozen_pos, entry_gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
         entry->count_.fetch_sub(entry_gc_idx_cnt, std::memory_order_relaxed);
         gc_idx_cnt += entry_gc_idx_cnt;
     }
@@ -673,6 +1567,91 @@ void Segment::Gc4TTL(const uint64_t time, uint64_t& gc_idx_cnt, uint64_t& gc_rec
     delete it;
 }
 
+void Segment::Gc4TTLByIndex(const uint64_t time, uint64_t& gc_idx_cnt, uint64_t& gc_record_cnt,
+                            uint64_t& gc_record_byte_size) {
+    uint64_t consumed = ::baidu::common::timer::get_micros();
+    uint64_t old = gc_idx_cnt;
+    std::vector<std::pair<KeyEntry*, Slice>> expired;
+    {
+        std::lock_guard<std::mutex> lock(expire_mu_);
+        auto it = expire_buckets_.begin();
+        while (it != expire_buckets_.end() && it->first * expire_bucket_ms_ <= time) {
+            for (KeyEntry* entry : it->second) {
+                auto pos = expire_records_.find(entry);
+                if (pos != expire_records_.end() && pos->second.bucket == it->first) {
+                    // a put with older time will move it into a bucket again
+                    pos->second.bucket = UINT32_MAX;
+                    expired.emplace_back(entry, Slice(pos->second.key, pos->second.key_size));
+                }
+            }
+            it = expire_buckets_.erase(it);
+        }
+    }
+    uint64_t slice_cnt = 0;
+    for (const auto& kv : expired) {
+        GcSliceYield(&slice_cnt);
+        KeyEntry* entry = kv.first;
+        ::openmldb::base::Node<uint64_t, DataBlock*>* node = NULL;
+        FrozenBlock* frozen = NULL;
+        uint32_t frozen_pos = 0;
+        ::openmldb::base::Node<Slice, void*>* entry_node = NULL;
+        uint64_t oldest = time;
+        bool is_empty = false;
+        {
+            std::lock_guard<::openmldb::base::SpinMutex> lock(GetEntryMutex(entry));
+            SplitList(entry, time, &node);
+            frozen = SplitFrozen(entry, time, &frozen_pos);
+            is_empty = !GetOldestTime(entry, &oldest);
+        }
+        if (is_empty) {
+            std::lock_guard<std::mutex> lock(mu_);
+            void* cur = NULL;
+            if (entry->IsEmpty() && GetKeyEntry(kv.second, cur) == 0 && cur == entry) {
+                entry_node = RemoveKeyEntry(kv.second);
+            }
+        }
+        if (entry_node != NULL) {
+            UnregisterExpire(entry);
+            std::lock_guard<std::mutex> lock(gc_mu_);
+            entry_free_list_->Insert(gc_version_.load(std::memory_order_relaxed), entry_node);
+        } else {
+            // the entry skipped by a reader stays in an expired bucket and will be checked next time
+            UpdateExpire(entry, is_empty ? time : oldest);
+        }
+        uint64_t entry_gc_idx_cnt = 0;
+        FreeList(node, entry_gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+        FreeFrozen(frozen, frozen_pos, entry_gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+        entry->count_.fetch_sub(entry_gc_idx_cnt, std::memory_order_relaxed);
+        gc_idx_cnt += entry_gc_idx_cnt;
+    }
+    DEBUGLOG("[Gc4TTLByIndex] segment gc with key %lu, visit %lu entries, consumed %lu, count %lu", time,
+             expired.size(), (::baidu::common::timer::get_micros() - consumed) / 1000, gc_idx_cnt - old);
+    idx_cnt_.fetch_sub(gc_idx_cnt - old, std::memory_order_relaxed);
+}
+
+void Segment::RegisterExpire(KeyEntry* entry, const Slice& key, uint64_t time) {
+    uint32_t bucket = GetExpireBucket(time);
+    std::lock_guard<std::mutex> lock(expire_mu_);
+    expire_records_[entry] = {key.data(), key.size(), bucket};
+    expire_buckets_[bucket].push_back(entry);
+}
+
+void Segment::UpdateExpire(KeyEntry* entry, uint64_t time) {
+    uint32_t bucket = GetExpireBucket(time);
+    std::lock_guard<std::mutex> lock(expire_mu_);
+    auto pos = expire_records_.find(entry);
+    if (pos == expire_records_.end() || pos->second.bucket <= bucket) {
+        return;
+    }
+    pos->second.bucket = bucket;
+    expire_buckets_[bucket].push_back(entry);
+}
+
+void Segment::UnregisterExpire(KeyEntry* entry) {
+    std::lock_guard<std::mutex> lock(expire_mu_);
+    expire_records_.erase(entry);
+}
+
 void Segment::Gc4TTLAndHead(const uint64_t time, const uint64_t keep_cnt, uint64_t& gc_idx_cnt, uint64_t& gc_record_cnt,
                             uint64_t& gc_record_byte_size) {
     if (time == 0 || keep_cnt == 0) {
@@ -683,13 +1662,16 @@ void Segment::Gc4TTLAndHead(const uint64_t time, const uint64_t keep_cnt, uint64
     uint64_t old = gc_idx_cnt;
     KeyEntries::Iterator* it = entries_->NewIterator();
     it->SeekToFirst();
+    uint64_t slice_cnt = 0;
     while (it->Valid()) {
+        GcSliceYield(&slice_cnt);
         KeyEntry* entry = (KeyEntry*)it->GetValue();  // NOLINT
         ::openmldb::base::Node<uint64_t, DataBlock*>* node = entry->entries.GetLast();
+        bool has_frozen = entry->frozen_.load(std::memory_order_relaxed) != NULL;
         it->Next();
-        if (node == NULL) {
+        if (node == NULL && !has_frozen) {
             continue;
-        } else if (node->GetKey() > time) {
+        } else if (!has_frozen && node->GetKey() > time) {
             DEBUGLOG(
                 "[Gc4TTLAndHead] segment gc with key %lu need not ttl, last "
                 "node key %lu",
@@ -698,8 +1680,8 @@ void Segment::Gc4TTLAndHead(const uint64_t time, const uint64_t keep_cnt, uint64
         }
         node = NULL;
         {
-            std::lock_guard<std::mutex> lock(mu_);
-            if (entry->refs_.load(std::memory_order_acquire) <= 0) {
+            std::lock_guard<::openmldb::base::SpinMutex> lock(GetEntryMutex(entry));
+            if (entry->refs_.load(std::memory_order_acquire) <= 0 && ThawEntry(entry)) {
                 node = entry->entries.SplitByKeyAndPos(time, keep_cnt);
             }
         }
@@ -732,26 +1714,36 @@ void Segment::Gc4TTLOrHead(const uint64_t time, const uint64_t keep_cnt, uint64_
     uint64_t old = gc_idx_cnt;
     KeyEntries::Iterator* it = entries_->NewIterator();
     it->SeekToFirst();
+    uint64_t slice_cnt = 0;
     while (it->Valid()) {
+        GcSliceYield(&slice_cnt);
         KeyEntry* entry = (KeyEntry*)it->GetValue();  // NOLINT
         Slice key = it->GetKey();
         it->Next();
         ::openmldb::base::Node<uint64_t, DataBlock*>* node = entry->entries.GetLast();
-        if (node == NULL) {
+        if (node == NULL && entry->frozen_.load(std::memory_order_relaxed) == NULL) {
             continue;
         }
         node = NULL;
         ::openmldb::base::Node<Slice, void*>* entry_node = NULL;
+        bool is_empty = false;
         {
-            std::lock_guard<std::mutex> lock(mu_);
-            if (entry->refs_.load(std::memory_order_acquire) <= 0) {
+            std::lock_guard<::openmldb::base::SpinMutex> lock(GetEntryMutex(entry));
+            if (entry->refs_.load(std::memory_order_acquire) <= 0 && ThawEntry(entry)) {
                 node = entry->entries.SplitByKeyOrPos(time, keep_cnt);
             }
-            if (entry->entries.IsEmpty()) {
-                entry_node = entries_->Remove(key);
+            is_empty = entry->IsEmpty();
+        }
+        if (is_empty) {
+            std::lock_guard<std::mutex> lock(mu_);
+            if (entry->IsEmpty()) {
+                entry_node = RemoveKeyEntry(key);
             }
         }
         if (entry_node != NULL) {
+            if (IsExpireIndexEnabled()) {
+                UnregisterExpire(entry);
+            }
             std::lock_guard<std::mutex> lock(gc_mu_);
             entry_free_list_->Insert(gc_version_.load(std::memory_order_relaxed), entry_node);
         }
@@ -773,7 +1765,7 @@ int Segment::GetCount(const Slice& key, uint64_t& count) {
         return -1;
     }
     void* entry = NULL;
-    if (entries_->Get(key, entry) < 0 || entry == NULL) {
+    if (!FindEntry(key, &entry)) {
         return -1;
     }
     count = ((KeyEntry*)entry)->count_.load(std::memory_order_relaxed);  // NOLINT
@@ -789,7 +1781,7 @@ int Segment::GetCount(const Slice& key, uint32_t idx, uint64_t& count) {
         return GetCount(key, count);
     }
     void* entry_arr = NULL;
-    if (entries_->Get(key, entry_arr) < 0 || entry_arr == NULL) {
+    if (!FindEntry(key, &entry_arr)) {
         return -1;
     }
     count = ((KeyEntry**)entry_arr)[pos->second]->count_.load(  // NOLINT
@@ -803,11 +1795,11 @@ MemTableIterator* Segment::NewIterator(const Slice& key, Ticket& ticket) {
         return new MemTableIterator(NULL);
     }
     void* entry = NULL;
-    if (entries_->Get(key, entry) < 0 || entry == NULL) {
+    if (!FindEntry(key, &entry)) {
         return new MemTableIterator(NULL);
     }
-    ticket.Push((KeyEntry*)entry);                                           // NOLINT
-    return new MemTableIterator(((KeyEntry*)entry)->entries.NewIterator());  // NOLINT
+    ticket.Push((KeyEntry*)entry);                // NOLINT
+    return new MemTableIterator((KeyEntry*)entry);  // NOLINT
 }
 
 MemTableIterator* Segment::NewIterator(const Slice& key, uint32_t idx, Ticket& ticket) {
@@ -819,14 +1811,89 @@ MemTableIterator* Segment::NewIterator(const Slice& key, uint32_t idx, Ticket& t
         return NewIterator(key, ticket);
     }
     void* entry_arr = NULL;
-    if (entries_->Get(key, entry_arr) < 0 || entry_arr == NULL) {
+    if (!FindEntry(key, &entry_arr)) {
         return new MemTableIterator(NULL);
     }
-    ticket.Push(((KeyEntry**)entry_arr)[pos->second]);                                         // NOLINT
-    return new MemTableIterator(((KeyEntry**)entry_arr)[pos->second]->entries.NewIterator());  // NOLINT
+    ticket.Push(((KeyEntry**)entry_arr)[pos->second]);                  // NOLINT
+    return new MemTableIterator(((KeyEntry**)entry_arr)[pos->second]);  // NOLINT
 }
 
-MemTableIterator::MemTableIterator(TimeEntries::Iterator* it) : it_(it) {}
+UnpackedBlock::UnpackedBlock(const FrozenBlock* packed_block)
+    : block(packed_block), data(new char[packed_block->offsets[packed_block->cnt]]), ok(true), rows() {
+    if (!snappy::RawUncompress(block->packed, block->packed_size, data)) {
+        PDLOG(WARNING, "fail to uncompress the packed block with %u rows", block->cnt);
+        ok = false;
+        return;
+    }
+    for (uint32_t i = 0; i < block->cnt; i++) {
+        rows.emplace_back(1, data + block->offsets[i], block->GetRowSize(i), true);
+    }
+}
+
+UnpackedBlock::~UnpackedBlock() {
+    // the rows do not own their data
+    for (auto& row : rows) {
+        row.data = NULL;
+    }
+    delete[] data;
+}
+
+TimeEntryIterator::TimeEntryIterator(KeyEntry* entry)
+    : entry_(entry),
+      it_(entry->entries.NewIterator()),
+      block_(NULL),
+      pos_(0),
+      in_frozen_(false),
+      failed_(false),
+      unpacked_() {}
+
+void TimeEntryIterator::Unpack() {
+    // drop the rows of the block left behind
+    unpacked_.reset(new UnpackedBlock(block_));
+    if (!unpacked_->ok) {
+        failed_ = true;
+    }
+}
+
+void TimeEntryIterator::Seek(const uint64_t time) {
+    it_->Seek(time);
+    block_ = entry_->frozen_.load(std::memory_order_acquire);
+    while (block_ != NULL && block_->MinTime() > time) {
+        block_ = block_->next;
+    }
+    pos_ = block_ == NULL ? 0 : block_->LowerBound(time);
+    Pick();
+}
+
+void TimeEntryIterator::SeekToFirst() {
+    it_->SeekToFirst();
+    block_ = entry_->frozen_.load(std::memory_order_acquire);
+    pos_ = 0;
+    Pick();
+}
+
+void TimeEntryIterator::SeekToLast() {
+    it_->SeekToLast();
+    FrozenBlock* block = entry_->frozen_.load(std::memory_order_acquire);
+    block_ = NULL;
+    pos_ = 0;
+    if (block != NULL) {
+        while (block->next != NULL) {
+            block = block->next;
+        }
+        if (!it_->Valid() || block->MinTime() <= it_->GetKey()) {
+            block_ = block;
+            pos_ = block->cnt - 1;
+            if (it_->Valid()) {
+                it_->Next();
+            }
+        }
+    }
+    Pick();
+}
+
+MemTableIterator::MemTableIterator(KeyEntry* entry)
+    : it_(entry == NULL ? NULL : entry->NewIterator()), dict_(NULL), decoded_row_() {}
 
 MemTableIterator::~MemTableIterator() {
     if (it_ != NULL) {
@@ -856,7 +1923,14 @@ void MemTableIterator::Next() {
 }
 
 ::openmldb::base::Slice MemTableIterator::GetValue() const {
-    return ::openmldb::base::Slice(it_->GetValue()->data, it_->GetValue()->size);
+    DataBlock* block = it_->GetValue();
+    if (dict_ != NULL && ::openmldb::codec::IsDictRow(reinterpret_cast<const int8_t*>(block->data))) {
+        if (dict_->DecodeRow(reinterpret_cast<const int8_t*>(block->data), &decoded_row_)) {
+            return ::openmldb::base::Slice(decoded_row_);
+        }
+        PDLOG(WARNING, "fail to decode the dictionary coded row");
+    }
+    return ::openmldb::base::Slice(block->data, block->size);
 }
 
 uint64_t MemTableIterator::GetKey() const { return it_->GetKey(); }
@@ -17,17 +17,28 @@
 #ifndef SRC_STORAGE_SEGMENT_H_
 #define SRC_STORAGE_SEGMENT_H_
 
+#include <assert.h>
+
+#include <algorithm>
 #include <atomic>
+#include <deque>
 #include <map>
 #include <memory>
 #include <mutex>  // NOLINT
+#include <string>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
+#include "base/hash.h"
+#include "base/hash_index.h"
 #include "base/skiplist.h"
+#include "base/slab_allocator.h"
 #include "base/slice.h"
+#include "base/spinlock.h"
 #include "proto/tablet.pb.h"
 #include "storage/iterator.h"
 #include "storage/schema.h"
+#include "storage/string_dict.h"
 #include "storage/ticket.h"
 
 namespace openmldb {
@@ -43,16 +54,21 @@ class Ticket;
 struct DataBlock {
     // dimension count down
     uint8_t dim_cnt_down;
+    // data is allocated from slab and must be released by the owner
+    bool in_slab;
+    // the snapshot epoch the row is put in or dumped at last, see MemTable::DumpRows
+    std::atomic<uint16_t> epoch;
     uint32_t size;
     char* data;
 
-    DataBlock(uint8_t dim_cnt, const char* input, uint32_t len) : dim_cnt_down(dim_cnt), size(len), data(NULL) {
+    DataBlock(uint8_t dim_cnt, const char* input, uint32_t len)
+        : dim_cnt_down(dim_cnt), in_slab(false), epoch(0), size(len), data(NULL) {
         data = new char[len];
         memcpy(data, input, len);
     }
 
     DataBlock(uint8_t dim_cnt, char* input, uint32_t len, bool skip_copy)
-        : dim_cnt_down(dim_cnt), size(len), data(NULL) {
+        : dim_cnt_down(dim_cnt), in_slab(false), epoch(0), size(len), data(NULL) {
         if (skip_copy) {
             data = input;
         } else {
@@ -61,12 +77,35 @@ struct DataBlock {
         }
     }
 
+    DataBlock(uint8_t dim_cnt, const char* input, uint32_t len, ::openmldb::base::SlabAllocator* slab)
+        : dim_cnt_down(dim_cnt), in_slab(false), epoch(0), size(len), data(NULL) {
+        if (slab != NULL && slab->IsSlabSize(len)) {
+            data = slab->Alloc(len);
+            in_slab = true;
+        } else {
+            data = new char[len];
+        }
+        memcpy(data, input, len);
+    }
+
     ~DataBlock() {
-        delete[] data;
+        if (!in_slab) {
+            delete[] data;
+        }
         data = NULL;
     }
 };
 
+// release the data block and give back its slab memory, slab has to be the
+// allocator of the block if the block is in slab
+static inline void FreeDataBlock(DataBlock* block, ::openmldb::base::SlabAllocator* slab) {
+    if (block->in_slab) {
+        assert(slab != NULL);
+        slab->Free(block->data, block->size);
+    }
+    delete block;
+}
+
 // the desc time comparator
 struct TimeComparator {
     int operator()(const uint64_t& a, const uint64_t& b) const {
@@ -82,9 +121,169 @@ struct TimeComparator {
 static const TimeComparator tcmp;
 typedef ::openmldb::base::Skiplist<uint64_t, DataBlock*, TimeComparator> TimeEntries;
 
+// An immutable run of rows frozen from the time entries of a key entry.
+// The time and row arrays are sorted by time desc and laid out right after
+// the header, so a long scan is a sequential read instead of pointer chasing.
+// The blocks of a key entry are chained from newer to older without overlap.
+// A packed block holds the rows compressed together instead of the row pointers,
+// the row at pos is at [offsets[pos], offsets[pos + 1]) of the uncompressed data
+struct FrozenBlock {
+    uint32_t cnt;
+    FrozenBlock* next;
+    uint64_t* ts;
+    DataBlock** rows;
+    uint32_t* offsets;
+    char* packed;
+    uint32_t packed_size;
+
+    static FrozenBlock* New(uint32_t cnt) {
+        char* buf = new char[GetSize(cnt)];
+        FrozenBlock* block = reinterpret_cast<FrozenBlock*>(buf);
+        block->cnt = cnt;
+        block->next = NULL;
+        block->ts = reinterpret_cast<uint64_t*>(buf + sizeof(FrozenBlock));
+        block->rows = reinterpret_cast<DataBlock**>(buf + sizeof(FrozenBlock) + cnt * sizeof(uint64_t));
+        block->offsets = NULL;
+        block->packed = NULL;
+        block->packed_size = 0;
+        return block;
+    }
+
+    static FrozenBlock* NewPacked(uint32_t cnt, uint32_t packed_size) {
+        char* buf = new char[GetPackedSize(cnt, packed_size)];
+        FrozenBlock* block = reinterpret_cast<FrozenBlock*>(buf);
+        block->cnt = cnt;
+        block->next = NULL;
+        block->ts = reinterpret_cast<uint64_t*>(buf + sizeof(FrozenBlock));
+        block->rows = NULL;
+        block->offsets = reinterpret_cast<uint32_t*>(buf + sizeof(FrozenBlock) + cnt * sizeof(uint64_t));
+        block->packed = buf + sizeof(FrozenBlock) + cnt * sizeof(uint64_t) + (cnt + 1) * sizeof(uint32_t);
+        block->packed_size = packed_size;
+        return block;
+    }
+
+    // only the block itself is released, the rows are owned by the caller
+    static void Delete(FrozenBlock* block) { delete[] reinterpret_cast<char*>(block); }
+
+    static inline uint64_t GetSize(uint32_t cnt) {
+        return sizeof(FrozenBlock) + cnt * (sizeof(uint64_t) + sizeof(DataBlock*));
+    }
+
+    static inline uint64_t GetPackedSize(uint32_t cnt, uint32_t packed_size) {
+        return sizeof(FrozenBlock) + cnt * sizeof(uint64_t) + (cnt + 1) * sizeof(uint32_t) + packed_size;
+    }
+
+    inline bool IsPacked() const { return packed != NULL; }
+
+    inline uint64_t GetByteSize() const { return IsPacked() ? GetPackedSize(cnt, packed_size) : GetSize(cnt); }
+
+    inline uint32_t GetRowSize(uint32_t pos) const {
+        return IsPacked() ? offsets[pos + 1] - offsets[pos] : rows[pos]->size;
+    }
+
+    inline uint64_t MaxTime() const { return ts[0]; }
+    inline uint64_t MinTime() const { return ts[cnt - 1]; }
+
+    // return the first position whose time is less or equal than the input one
+    uint32_t LowerBound(uint64_t time) const {
+        uint32_t low = 0;
+        uint32_t high = cnt;
+        while (low < high) {
+            uint32_t mid = low + (high - low) / 2;
+            if (ts[mid] > time) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        return low;
+    }
+};
+
+// the rows of a packed block uncompressed for the readers
+struct UnpackedBlock {
+    explicit UnpackedBlock(const FrozenBlock* packed_block);
+    ~UnpackedBlock();
+    UnpackedBlock(const UnpackedBlock&) = delete;
+    UnpackedBlock& operator=(const UnpackedBlock&) = delete;
+
+    const FrozenBlock* block;
+    char* data;
+    // false if the block fails to uncompress, then the rows are empty
+    bool ok;
+    // the rows refer to data, a deque as the rows can not be moved
+    std::deque<DataBlock> rows;
+};
+
+class KeyEntry;
+
+// iterate the rows of a key entry in time desc order, merging the time entries
+// and the frozen blocks. The rows of a packed block are uncompressed when the
+// iterator reaches it, only the rows of the current block are kept and must be
+// copied before the iterator leaves the block. The iterator turns invalid if a
+// block fails to uncompress
+class TimeEntryIterator {
+ public:
+    explicit TimeEntryIterator(KeyEntry* entry);
+    ~TimeEntryIterator() { delete it_; }
+
+    inline bool Valid() const { return !failed_ && (in_frozen_ || it_->Valid()); }
+
+    inline void Next() {
+        if (in_frozen_) {
+            if (++pos_ >= block_->cnt) {
+                block_ = block_->next;
+                pos_ = 0;
+            }
+        } else {
+            it_->Next();
+        }
+        Pick();
+    }
+
+    inline const uint64_t& GetKey() const { return in_frozen_ ? block_->ts[pos_] : it_->GetKey(); }
+
+    inline DataBlock* GetValue() {
+        if (!in_frozen_) {
+            return it_->GetValue();
+        }
+        return block_->IsPacked() ? &unpacked_->rows[pos_] : block_->rows[pos_];
+    }
+
+    // the current row is in a packed block
+    inline bool InPacked() const { return in_frozen_ && block_->IsPacked(); }
+
+    // a block failed to uncompress, the iterator is invalid since then
+    inline bool Failed() const { return failed_; }
+
+    void Seek(const uint64_t time);
+    void SeekToFirst();
+    void SeekToLast();
+
+ private:
+    // the bigger time comes first, the time entries win on equal time
+    inline void Pick() {
+        in_frozen_ = block_ != NULL && (!it_->Valid() || it_->GetKey() < block_->ts[pos_]);
+        if (in_frozen_ && block_->IsPacked() && (!unpacked_ || unpacked_->block != block_)) {
+            Unpack();
+        }
+    }
+
+    void Unpack();
+
+ private:
+    KeyEntry* entry_;
+    TimeEntries::Iterator* it_;
+    FrozenBlock* block_;
+    uint32_t pos_;
+    bool in_frozen_;
+    bool failed_;
+    std::unique_ptr<UnpackedBlock> unpacked_;
+};
+
 class MemTableIterator : public TableIterator {
  public:
-    explicit MemTableIterator(TimeEntries::Iterator* it);
+    explicit MemTableIterator(KeyEntry* entry);
     virtual ~MemTableIterator();
     void Seek(const uint64_t time) override;
     bool Valid() override;
@@ -93,48 +292,98 @@ class MemTableIterator : public TableIterator {
     uint64_t GetKey() const override;
     void SeekToFirst() override;
     void SeekToLast() override;
+    // decode the dictionary coded rows with dict
+    void SetStringDict(const StringDict* dict) { dict_ = dict; }
 
  private:
-    TimeEntries::Iterator* it_;
+    TimeEntryIterator* it_;
+    const StringDict* dict_;
+    // the decoded current row, valid until the iterator moves
+    mutable std::string decoded_row_;
 };
 
 class KeyEntry {
  public:
-    KeyEntry() : entries(12, 4, tcmp), refs_(0), count_(0) {}
-    explicit KeyEntry(uint8_t height) : entries(height, 4, tcmp), refs_(0), count_(0) {}
+    KeyEntry() : entries(12, 4, tcmp), refs_(0), count_(0), frozen_(NULL) {}
+    explicit KeyEntry(uint8_t height) : entries(height, 4, tcmp), refs_(0), count_(0), frozen_(NULL) {}
     ~KeyEntry() {}
 
-    // just return the count of datablock
-    uint64_t Release() {
+    // just return the count of datablock, slab is the allocator of the rows
+    uint64_t Release(::openmldb::base::SlabAllocator* slab) {
         uint64_t cnt = 0;
         TimeEntries::Iterator* it = entries.NewIterator();
         it->SeekToFirst();
         while (it->Valid()) {
             cnt += 1;
-            DataBlock* block = it->GetValue();
-            // Avoid double free
-            if (block->dim_cnt_down > 1) {
-                block->dim_cnt_down--;
-            } else {
-                delete block;
-            }
+            ReleaseRow(it->GetValue(), slab);
             it->Next();
         }
         entries.Clear();
         delete it;
+        FrozenBlock* block = frozen_.exchange(NULL, std::memory_order_relaxed);
+        while (block != NULL) {
+            // the packed rows are freed with the block
+            for (uint32_t i = 0; !block->IsPacked() && i < block->cnt; i++) {
+                ReleaseRow(block->rows[i], slab);
+            }
+            cnt += block->cnt;
+            FrozenBlock* tmp = block;
+            block = block->next;
+            FrozenBlock::Delete(tmp);
+        }
         return cnt;
     }
 
+    // delete the iterator after it's used
+    TimeEntryIterator* NewIterator() { return new TimeEntryIterator(this); }
+
+    // set row NULL if there is no row of time. The rows in packed blocks are only
+    // read by the iterators, which hold the uncompressed data, return false for them
+    bool Get(uint64_t time, DataBlock** row) {
+        *row = NULL;
+        if (entries.Get(time, *row) == 0) {
+            return true;
+        }
+        for (FrozenBlock* block = frozen_.load(std::memory_order_acquire); block != NULL; block = block->next) {
+            if (block->MinTime() <= time) {
+                uint32_t pos = block->LowerBound(time);
+                if (block->ts[pos] != time) {
+                    return true;
+                }
+                if (block->IsPacked()) {
+                    return false;
+                }
+                *row = block->rows[pos];
+                return true;
+            }
+        }
+        return true;
+    }
+
+    bool IsEmpty() { return entries.IsEmpty() && frozen_.load(std::memory_order_relaxed) == NULL; }
+
     void Ref() { refs_.fetch_add(1, std::memory_order_relaxed); }
 
     void UnRef() { refs_.fetch_sub(1, std::memory_order_relaxed); }
 
     uint64_t GetCount() { return count_.load(std::memory_order_relaxed); }
 
+ private:
+    static inline void ReleaseRow(DataBlock* block, ::openmldb::base::SlabAllocator* slab) {
+        // Avoid double free
+        if (block->dim_cnt_down > 1) {
+            block->dim_cnt_down--;
+        } else {
+            FreeDataBlock(block, slab);
+        }
+    }
+
  public:
     TimeEntries entries;
     std::atomic<uint64_t> refs_;
     std::atomic<uint64_t> count_;
+    // the rows moved out of entries by Segment::Freeze
+    std::atomic<FrozenBlock*> frozen_;
     friend Segment;
 };
 
@@ -142,9 +391,27 @@ struct SliceComparator {
     int operator()(const ::openmldb::base::Slice& a, const ::openmldb::base::Slice& b) const { return a.compare(b); }
 };
 
+struct SliceHasher {
+    // not the seed routing the keys to segments, the keys of a segment share those hash bits
+    uint32_t operator()(const ::openmldb::base::Slice& key) const {
+        return ::openmldb::base::hash(key.data(), key.size(), 0x9747b28c);
+    }
+};
+
 typedef ::openmldb::base::Skiplist<::openmldb::base::Slice, void*, SliceComparator> KeyEntries;
+typedef ::openmldb::base::HashIndex<::openmldb::base::Slice, void*, SliceHasher, SliceComparator> KeyIndex;
 typedef ::openmldb::base::Skiplist<uint64_t, ::openmldb::base::Node<Slice, void*>*, TimeComparator> KeyEntryNodeList;
 
+// the memory unlinked from the frozen rows of a key entry, only one of the fields is set.
+// The readers visit the frozen rows without the entry mutex, so it is freed by gc version
+struct FrozenGarbage {
+    FrozenBlock* block;
+    DataBlock* row;
+    // the time nodes moved into a frozen block, the rows are not freed with them
+    ::openmldb::base::Node<uint64_t, DataBlock*>* nodes;
+};
+typedef ::openmldb::base::Skiplist<uint64_t, FrozenGarbage, TimeComparator> FrozenFreeList;
+
 class Segment {
  public:
     Segment();
@@ -194,6 +461,10 @@ class Segment {
     void GcAllType(const std::map<uint32_t, TTLSt>& ttl_st_map, uint64_t& gc_idx_cnt,  // NOLINT
                    uint64_t& gc_record_cnt,                                            // NOLINT
                    uint64_t& gc_record_byte_size);                                     // NOLINT
+    // move the rows not newer than time into frozen blocks for the key entries
+    // holding at least min_cnt rows, return the count of rows frozen
+    uint64_t Freeze(uint64_t time, uint64_t min_cnt);
+
     MemTableIterator* NewIterator(const Slice& key, Ticket& ticket);                   // NOLINT
     MemTableIterator* NewIterator(const Slice& key, uint32_t idx,
                                   Ticket& ticket);  // NOLINT
@@ -241,16 +512,138 @@ class Segment {
 
     void IncrGcVersion() { gc_version_.fetch_add(1, std::memory_order_relaxed); }
 
+    // the key entries removed after the pin are not freed until unpinned, so a walk over
+    // the key entries started after the pin may last longer than gc_deleted_pk_version_delta
+    void PinGcVersion() { pinned_version_.store(gc_version_.load(std::memory_order_relaxed)); }
+
+    void UnpinGcVersion() { pinned_version_.store(UINT64_MAX); }
+
     void ReleaseAndCount(uint64_t& gc_idx_cnt,            // NOLINT
                          uint64_t& gc_record_cnt,         // NOLINT
                          uint64_t& gc_record_byte_size);  // NOLINT
 
+    // the slab is shared by all segments of a table and owned by the table
+    void SetSlabAllocator(::openmldb::base::SlabAllocator* slab) { slab_ = slab; }
+
+    ::openmldb::base::SlabAllocator* GetSlabAllocator() const { return slab_; }
+
+    inline bool IsExpireIndexEnabled() const { return expire_bucket_ms_ > 0; }
+
+    // place the segment at idx of the split tree of seg_cnt root segments. the segment owns
+    // the keys whose hash mod (seg_cnt << depth) equals idx, the child split out at depth k
+    // takes over half of them, depth <= k < max_depth. all segments of a tree share the
+    // entry mutexes of root
+    void SetSplitTree(uint32_t idx, uint32_t seg_cnt, uint32_t depth, uint32_t max_depth, Segment* root);
+
+    inline uint32_t GetSplitDepth() const { return split_state_.load(std::memory_order_acquire) >> 1; }
+
+    inline bool CanSplit() const { return GetSplitDepth() - split_depth_ < split_children_.size(); }
+
+    // create the child for the next split of the segment, which is placed at
+    // idx + (seg_cnt << depth) of the split tree. the caller owns it, return NULL if the
+    // segment can not split any more
+    Segment* NewSplitChild();
+
+    // a split moves the keys of the next depth to the child in three steps. StartSplit and
+    // CopySplitKeys copy the key entries into the child, FinishSplit routes the keys to the
+    // child, RemoveSplitKeys drops the copies left here. until then a key entry may be found
+    // in both segments, so the caller must not run gc on the two segments in the meantime.
+    // RemoveSplitKeys must wait for the key iterators started before FinishSplit, which may
+    // have passed the copies in the child. child is from NewSplitChild
+    bool StartSplit(Segment* child);
+    uint64_t CopySplitKeys();
+    void FinishSplit();
+    uint64_t RemoveSplitKeys();
+
+    // the count of key entries tracked by the expire index
+    uint64_t GetExpireIndexCnt() {
+        std::lock_guard<std::mutex> lock(expire_mu_);
+        return expire_records_.size();
+    }
+
  private:
     void FreeList(::openmldb::base::Node<uint64_t, DataBlock*>* node, uint64_t& gc_idx_cnt,  // NOLINT
                   uint64_t& gc_record_cnt,         // NOLINT
                   uint64_t& gc_record_byte_size);  // NOLINT
     void SplitList(KeyEntry* entry, uint64_t ts, ::openmldb::base::Node<uint64_t, DataBlock*>** node);
 
+    // put a row into the entry, need mu_ held
+    void PutToEntry(KeyEntry* entry, uint64_t time, DataBlock* row);
+    // put a row into the entry of key found in owner without mu_, value is the entry
+    // or the entry array linked to key. Fail if the entry is empty or no longer linked
+    bool PutToLinkedEntry(Segment* owner, const Slice& key, void* value, KeyEntry* entry, uint64_t time,
+                          DataBlock* row);
+    // need the entry mutex held, return true if the row is the oldest one of the entry
+    // and the expire index has to be updated after the mutex is released
+    bool InsertToEntry(KeyEntry* entry, uint64_t time, DataBlock* row);
+
+    // find the segment of the key in the split tree, next is the child the key may have
+    // been copied to if the segment is splitting
+    Segment* Route(const Slice& key, uint32_t* hash, Segment** next, uint32_t* state);
+    // return the child owning the hash under the split state, or NULL if it stays here
+    Segment* GetSplitChild(uint32_t hash, uint32_t state, bool* splitting) const;
+    // the key entry or the entry array of the key in this segment, return 0 if found
+    inline int GetKeyEntry(const Slice& key, void*& entry) {  // NOLINT
+        if (key_index_ != NULL) {
+            ::openmldb::base::Node<Slice, void*>* node = key_index_->Get(key);
+            if (node == NULL) {
+                return -1;
+            }
+            entry = node->GetValue();
+            return 0;
+        }
+        return entries_->Get(key, entry);
+    }
+    // update entries_ and key_index_ together, need mu_ held
+    uint8_t InsertKeyEntry(const Slice& key, void* entry);
+    ::openmldb::base::Node<Slice, void*>* RemoveKeyEntry(const Slice& key);
+    ::openmldb::base::Node<Slice, void*>* UnlinkKeyEntry(const Slice& key);
+    // find the key entry or the entry array of the key in the split tree
+    bool FindEntry(const Slice& key, void** entry);
+    void PutSlow(const Slice& key, uint32_t hash, uint64_t time, DataBlock* row);
+    void PutSlow(const Slice& key, uint32_t hash, const std::vector<std::pair<uint32_t, uint64_t>>& ts,
+                 DataBlock* row);
+
+    // the frozen block helpers need the entry mutex held
+    // the blocks newer than the oldest row of node should have been inflated
+    uint64_t FreezeList(KeyEntry* entry, ::openmldb::base::Node<uint64_t, DataBlock*>* node);
+    // false if one of the packed blocks can not be uncompressed, the entry is unchanged then
+    bool ThawEntry(KeyEntry* entry);
+    FrozenBlock* SplitFrozen(KeyEntry* entry, uint64_t time, uint32_t* pos);
+    // replace the first block of entry with packed blocks of at most max_cnt rows,
+    // the rows referred by other indexes stay in plain blocks
+    void PackFrozen(KeyEntry* entry, uint32_t max_cnt);
+    // the plain block of the first cnt rows of a packed block, NULL if it can not be uncompressed
+    FrozenBlock* Inflate(const FrozenBlock* block, uint32_t cnt);
+    // inflate the packed blocks with rows not older than time, false if one of them is kept packed
+    bool InflateFrozen(KeyEntry* entry, uint64_t time);
+    void FreeFrozen(FrozenBlock* block, uint32_t pos, uint64_t& gc_idx_cnt,  // NOLINT
+                    uint64_t& gc_record_cnt,                                 // NOLINT
+                    uint64_t& gc_record_byte_size);                          // NOLINT
+    // free the garbage after gc version moves past the current one like the key entries
+    void RetireFrozen(FrozenBlock* block, DataBlock* row, ::openmldb::base::Node<uint64_t, DataBlock*>* nodes);
+    void FreeFrozenGarbage(::openmldb::base::Node<uint64_t, FrozenGarbage>* node);
+
+    // the time entries of a key entry are guarded by one of the striped mutexes
+    inline ::openmldb::base::SpinMutex& GetEntryMutex(KeyEntry* entry) {
+        return split_root_->entry_mu_[(reinterpret_cast<uintptr_t>(entry) / sizeof(KeyEntry)) % ENTRY_MUTEX_CNT];
+    }
+
+    // the expire index tracks the bucket of the oldest time of every key entry,
+    // so gc by absolute time only visits the key entries with expired rows
+    void Gc4TTLByIndex(const uint64_t time, uint64_t& gc_idx_cnt,  // NOLINT
+                       uint64_t& gc_record_cnt,                    // NOLINT
+                       uint64_t& gc_record_byte_size);             // NOLINT
+    // the bucket of the time, the buckets beyond uint32 are clamped to an earlier one,
+    // which is only visited earlier than needed
+    inline uint32_t GetExpireBucket(uint64_t time) const {
+        return static_cast<uint32_t>(std::min<uint64_t>(time / expire_bucket_ms_, UINT32_MAX - 1));
+    }
+    void RegisterExpire(KeyEntry* entry, const Slice& key, uint64_t time);
+    // need no entry mutex held, the bucket only moves to an earlier one
+    void UpdateExpire(KeyEntry* entry, uint64_t time);
+    void UnregisterExpire(KeyEntry* entry);
+
     void GcEntryFreeList(uint64_t version, uint64_t& gc_idx_cnt,  // NOLINT
                          uint64_t& gc_record_cnt,                 // NOLINT
                          uint64_t& gc_record_byte_size);          // NOLINT
@@ -259,20 +652,57 @@ class Segment {
                    uint64_t& gc_record_byte_size);  // NOLINT
 
  private:
+    static const uint32_t ENTRY_MUTEX_CNT = 64;
+
     KeyEntries* entries_;
-    // only Put need mutex
+    // the nodes of entries_ by hash for the point lookups, NULL if disabled
+    KeyIndex* key_index_;
+    // insert or remove key entry need mutex
     std::mutex mu_;
+    ::openmldb::base::SpinMutex entry_mu_[ENTRY_MUTEX_CNT];
     std::mutex gc_mu_;
     std::atomic<uint64_t> idx_cnt_;
     std::atomic<uint64_t> idx_byte_size_;
     std::atomic<uint64_t> pk_cnt_;
     uint8_t key_entry_max_height_;
     KeyEntryNodeList* entry_free_list_;
+    // the nodes unlinked by RemoveSplitKeys, the key entries are owned and counted by the split child
+    KeyEntryNodeList* moved_free_list_;
+    // the frozen blocks, rows and time nodes replaced by Freeze and gc
+    FrozenFreeList* frozen_free_list_;
     uint32_t ts_cnt_;
     std::atomic<uint64_t> gc_version_;
+    // UINT64_MAX if not pinned
+    std::atomic<uint64_t> pinned_version_;
     std::map<uint32_t, uint32_t> ts_idx_map_;
     std::vector<std::shared_ptr<std::atomic<uint64_t>>> idx_cnt_vec_;
     uint64_t ttl_offset_;
+    ::openmldb::base::SlabAllocator* slab_;
+
+    // the key refers to the key of the node in entries_, which is freed after the record is removed
+    struct ExpireRecord {
+        const char* key;
+        uint32_t key_size;
+        uint32_t bucket;
+    };
+    // zero means the expire index is disabled
+    uint64_t expire_bucket_ms_;
+    std::mutex expire_mu_;
+    // the records are kept inline, about 24 bytes a key entry
+    absl::flat_hash_map<KeyEntry*, ExpireRecord> expire_records_;
+    // a key entry may be left in the old buckets after it moves, check the record before use
+    std::map<uint32_t, std::vector<KeyEntry*>> expire_buckets_;
+
+    // the split tree, see SetSplitTree
+    uint32_t split_idx_;
+    uint32_t split_seg_cnt_;
+    uint32_t split_depth_;
+    // the child split out at depth split_depth_ + k, NULL until StartSplit sets it before
+    // split_state_ is released, so a reader acquiring split_state_ sees the children in it
+    std::vector<Segment*> split_children_;
+    Segment* split_root_;
+    // the local depth << 1, the lowest bit is set when splitting
+    std::atomic<uint32_t> split_state_;
 };
 
 }  // namespace storage
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "gflags/gflags.h"
+#include "storage/segment.h"
+
+DECLARE_bool(enable_memtable_key_index);
+
+namespace openmldb {
+namespace storage {
+
+static Segment* segment = NULL;
+static const char kValue[] = "test_value_0123456789";
+
+// all threads put into the same few keys, the worst case for a single segment lock
+static void BM_SegmentPutHotKey(benchmark::State& state) {  // NOLINT
+    if (state.thread_index == 0) {
+        segment = new Segment();
+    }
+    uint32_t key_cnt = state.range(0);
+    uint64_t ts = (static_cast<uint64_t>(state.thread_index) << 40) + 1;
+    uint32_t idx = 0;
+    for (auto _ : state) {
+        std::string key = "key" + std::to_string(idx++ % key_cnt);
+        segment->Put(Slice(key), ts++, kValue, sizeof(kValue));
+    }
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index == 0) {
+        delete segment;
+        segment = NULL;
+    }
+}
+
+// every put creates a new key entry
+static void BM_SegmentPutNewKey(benchmark::State& state) {  // NOLINT
+    if (state.thread_index == 0) {
+        segment = new Segment();
+    }
+    std::string prefix = "key" + std::to_string(state.thread_index) + "_";
+    uint64_t idx = 0;
+    for (auto _ : state) {
+        std::string key = prefix + std::to_string(idx++);
+        segment->Put(Slice(key), 1, kValue, sizeof(kValue));
+    }
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index == 0) {
+        delete segment;
+        segment = NULL;
+    }
+}
+
+// the point lookups of request mode, with the key skiplist or the key index
+static void BM_SegmentNewIterator(benchmark::State& state) {  // NOLINT
+    FLAGS_enable_memtable_key_index = state.range(1) > 0;
+    Segment segment;
+    FLAGS_enable_memtable_key_index = false;
+    uint32_t key_cnt = state.range(0);
+    std::vector<std::string> keys;
+    for (uint32_t i = 0; i < key_cnt; i++) {
+        keys.push_back("key" + std::to_string(i));
+        segment.Put(Slice(keys.back()), 1, kValue, sizeof(kValue));
+    }
+    uint32_t idx = 0;
+    for (auto _ : state) {
+        // visit the keys out of order as the requests do
+        idx = (idx + 7919) % key_cnt;
+        Ticket ticket;
+        MemTableIterator* it = segment.NewIterator(Slice(keys[idx]), ticket);
+        it->SeekToFirst();
+        benchmark::DoNotOptimize(it->Valid());
+        delete it;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_SegmentPutHotKey)->Arg(1)->Arg(16)->Arg(1024)->ThreadRange(1, 16)->UseRealTime();
+BENCHMARK(BM_SegmentPutNewKey)->ThreadRange(1, 16)->UseRealTime();
+BENCHMARK(BM_SegmentNewIterator)->Args({1000, 0})->Args({1000, 1})->Args({1000000, 0})->Args({1000000, 1});
+
+}  // namespace storage
+}  // namespace openmldb
@@ -17,13 +17,23 @@
 #include "storage/segment.h"
 
 #include <iostream>
+#include <memory>
 #include <string>
+#include <thread>  // NOLINT
+#include <vector>
 
 #include "base/glog_wapper.h"  // NOLINT
 #include "base/slice.h"
+#include "gflags/gflags.h"
 #include "gtest/gtest.h"
 #include "storage/record.h"
 
+DECLARE_bool(enable_gc_expire_index);
+DECLARE_uint32(gc_expire_index_bucket_ms);
+DECLARE_bool(enable_memtable_key_index);
+DECLARE_bool(enable_memtable_block_compress);
+DECLARE_uint32(memtable_compress_block_cnt);
+
 using ::openmldb::base::Slice;
 
 namespace openmldb {
@@ -37,7 +47,7 @@ class SegmentTest : public ::testing::Test {
 
 TEST_F(SegmentTest, Size) {
     ASSERT_EQ(16, (int64_t)sizeof(DataBlock));
-    ASSERT_EQ(40, (int64_t)sizeof(KeyEntry));
+    ASSERT_EQ(48, (int64_t)sizeof(KeyEntry));
 }
 
 TEST_F(SegmentTest, DataBlock) {
@@ -125,6 +135,85 @@ TEST_F(SegmentTest, Delete) {
     ASSERT_EQ(84, (int64_t)gc_record_byte_size);
 }
 
+TEST_F(SegmentTest, KeyIndex) {
+    FLAGS_enable_memtable_key_index = true;
+    Segment segment;
+    Segment child;
+    FLAGS_enable_memtable_key_index = false;
+    Segment plain;
+    // the hash table of the index is counted in the index byte size
+    ASSERT_GT(segment.GetIdxByteSize(), 0u);
+    ASSERT_EQ(0u, plain.GetIdxByteSize());
+    segment.SetSplitTree(0, 1, 0, 1, &segment);
+    child.SetSplitTree(1, 1, 1, 1, &segment);
+    std::string value = "test0";
+    for (uint32_t i = 0; i < 2000; i++) {
+        std::string key = "key" + std::to_string(i);
+        segment.Put(Slice(key), 1000 + i % 10 * 10, value.c_str(), value.size());
+        plain.Put(Slice(key), 1000 + i % 10 * 10, value.c_str(), value.size());
+    }
+    ASSERT_GT(segment.GetIdxByteSize(), plain.GetIdxByteSize());
+    segment.StartSplit(&child);
+    segment.CopySplitKeys();
+    segment.FinishSplit();
+    segment.RemoveSplitKeys();
+    for (uint32_t i = 0; i < 2000; i += 2) {
+        ASSERT_TRUE(segment.Delete(Slice("key" + std::to_string(i))));
+    }
+    uint64_t gc_idx_cnt = 0;
+    uint64_t gc_record_cnt = 0;
+    uint64_t gc_record_byte_size = 0;
+    // the keys with rows all expired are removed
+    segment.Gc4TTL(1045, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    child.Gc4TTL(1045, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    for (uint32_t i = 0; i < 2000; i++) {
+        std::string key = "key" + std::to_string(i);
+        uint64_t count = 0;
+        DataBlock* result = NULL;
+        if (i % 2 == 0 || i % 10 < 5) {
+            ASSERT_EQ(-1, segment.GetCount(Slice(key), count));
+            ASSERT_FALSE(segment.Get(Slice(key), 1000 + i % 10 * 10, &result));
+        } else {
+            ASSERT_EQ(0, segment.GetCount(Slice(key), count));
+            ASSERT_EQ(1, (int64_t)count);
+            ASSERT_TRUE(segment.Get(Slice(key), 1000 + i % 10 * 10, &result));
+        }
+    }
+    for (Segment* cur : {&segment, &child}) {
+        cur->IncrGcVersion();
+        cur->IncrGcVersion();
+        cur->GcFreeList(gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    }
+    ASSERT_EQ(600, (int64_t)(segment.GetPkCnt() + child.GetPkCnt()));
+}
+
+TEST_F(SegmentTest, PutWithSlab) {
+    ::openmldb::base::SlabAllocator slab(128, 4096);
+    Segment segment;
+    segment.SetSlabAllocator(&slab);
+    Slice pk("test1");
+    std::string value = "test0";
+    segment.Put(pk, 9527, value.c_str(), value.size());
+    segment.Put(pk, 9528, value.c_str(), value.size());
+    ASSERT_EQ(32u, slab.GetUsedByteSize());
+    DataBlock* db = NULL;
+    ASSERT_TRUE(segment.Get(pk, 9528, &db));
+    ASSERT_TRUE(db->in_slab);
+    ASSERT_EQ(value, std::string(db->data, db->size));
+    ASSERT_TRUE(segment.Delete(pk));
+    uint64_t gc_idx_cnt = 0;
+    uint64_t gc_record_cnt = 0;
+    uint64_t gc_record_byte_size = 0;
+    segment.IncrGcVersion();
+    segment.IncrGcVersion();
+    segment.GcFreeList(gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(2, (int64_t)gc_record_cnt);
+    ASSERT_EQ(0u, slab.GetUsedByteSize());
+    ASSERT_EQ(32u, slab.GetPendingByteSize());
+    slab.Reclaim(slab.GetEpoch());
+    ASSERT_EQ(0u, slab.GetPendingByteSize());
+}
+
 TEST_F(SegmentTest, GetCount) {
     Segment segment;
     Slice pk("test1");
@@ -350,6 +439,231 @@ TEST_F(SegmentTest, TestGc4TTLOrHead) {
     ASSERT_EQ(3 * GetRecordSize(5), (int64_t)gc_record_byte_size);
 }
 
+TEST_F(SegmentTest, Freeze) {
+    Segment segment;
+    Slice pk("PK");
+    for (uint64_t ts = 1; ts <= 100; ts++) {
+        segment.Put(pk, ts, "test", 4);
+    }
+    segment.Put("cold", 1, "test", 4);
+    ASSERT_EQ(0, (int64_t)segment.Freeze(50, 200));
+    ASSERT_EQ(50, (int64_t)segment.Freeze(50, 100));
+    ASSERT_EQ(0, (int64_t)segment.Freeze(50, 100));
+    // late rows are merged with the frozen block
+    segment.Put(pk, 30, "late", 4);
+    segment.Put(pk, 200, "test", 4);
+    ASSERT_EQ(11, (int64_t)segment.Freeze(60, 100));
+    // a new block is chained before the old one
+    ASSERT_EQ(10, (int64_t)segment.Freeze(70, 100));
+    ASSERT_EQ(103, (int64_t)segment.GetIdxCnt());
+    uint64_t count = 0;
+    ASSERT_EQ(0, segment.GetCount(pk, count));
+    ASSERT_EQ(102, (int64_t)count);
+
+    DataBlock* db = NULL;
+    ASSERT_TRUE(segment.Get(pk, 30, &db));
+    ASSERT_TRUE(db != NULL);
+    ASSERT_TRUE(segment.Get(pk, 65, &db));
+    ASSERT_TRUE(db != NULL);
+    ASSERT_TRUE(segment.Get(pk, 150, &db));
+    ASSERT_TRUE(db == NULL);
+
+    Ticket ticket;
+    MemTableIterator* it = segment.NewIterator(pk, ticket);
+    it->SeekToFirst();
+    uint64_t last = UINT64_MAX;
+    uint32_t cnt = 0;
+    while (it->Valid()) {
+        ASSERT_LE(it->GetKey(), last);
+        last = it->GetKey();
+        cnt++;
+        it->Next();
+    }
+    ASSERT_EQ(102u, cnt);
+    it->Seek(75);
+    ASSERT_TRUE(it->Valid());
+    ASSERT_EQ(75, (int64_t)it->GetKey());
+    it->Seek(65);
+    ASSERT_TRUE(it->Valid());
+    ASSERT_EQ(65, (int64_t)it->GetKey());
+    it->Seek(30);
+    ASSERT_EQ(30, (int64_t)it->GetKey());
+    it->Next();
+    ASSERT_EQ(30, (int64_t)it->GetKey());
+    it->Next();
+    ASSERT_EQ(29, (int64_t)it->GetKey());
+    it->SeekToLast();
+    ASSERT_TRUE(it->Valid());
+    ASSERT_EQ(1, (int64_t)it->GetKey());
+    it->Next();
+    ASSERT_FALSE(it->Valid());
+    delete it;
+}
+
+TEST_F(SegmentTest, FreezeAndGc) {
+    Segment segment;
+    Slice pk("PK");
+    for (uint64_t ts = 1; ts <= 100; ts++) {
+        segment.Put(pk, ts, "test", 4);
+    }
+    ASSERT_EQ(40, (int64_t)segment.Freeze(40, 1));
+    ASSERT_EQ(40, (int64_t)segment.Freeze(80, 1));
+    uint64_t gc_idx_cnt = 0;
+    uint64_t gc_record_cnt = 0;
+    uint64_t gc_record_byte_size = 0;
+    // expire the whole old block and part of the new one
+    segment.Gc4TTL(60, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(60, (int64_t)gc_idx_cnt);
+    ASSERT_EQ(60, (int64_t)gc_record_cnt);
+    ASSERT_EQ(60 * GetRecordSize(4), (int64_t)gc_record_byte_size);
+    ASSERT_EQ(40, (int64_t)segment.GetIdxCnt());
+    {
+        Ticket ticket;
+        MemTableIterator* it = segment.NewIterator(pk, ticket);
+        it->SeekToLast();
+        ASSERT_EQ(61, (int64_t)it->GetKey());
+        delete it;
+    }
+    // the frozen rows are moved back before gc by head
+    segment.Gc4Head(10, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(90, (int64_t)gc_idx_cnt);
+    ASSERT_EQ(10, (int64_t)segment.GetIdxCnt());
+    ASSERT_EQ(10, (int64_t)segment.Freeze(100, 1));
+    // the entry is removed only when both of the entries and frozen blocks are empty
+    segment.Gc4TTL(100, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(100, (int64_t)gc_record_cnt);
+    ASSERT_EQ(0, (int64_t)segment.GetIdxCnt());
+    ASSERT_EQ(1, (int64_t)segment.GetPkCnt());
+    segment.IncrGcVersion();
+    segment.IncrGcVersion();
+    segment.GcFreeList(gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(0, (int64_t)segment.GetPkCnt());
+    ASSERT_EQ(0, (int64_t)segment.GetIdxByteSize());
+}
+
+TEST_F(SegmentTest, FreezeCompress) {
+    FLAGS_enable_memtable_block_compress = true;
+    FLAGS_memtable_compress_block_cnt = 16;
+    Segment segment;
+    Segment plain;
+    Slice pk("PK");
+    std::string value(100, 'a');
+    for (uint64_t ts = 1; ts <= 100; ts++) {
+        std::string row = value + std::to_string(ts);
+        segment.Put(pk, ts, row.c_str(), row.size());
+        plain.Put(pk, ts, row.c_str(), row.size());
+    }
+    ASSERT_EQ(50, (int64_t)segment.Freeze(50, 1));
+    FLAGS_enable_memtable_block_compress = false;
+    ASSERT_EQ(50, (int64_t)plain.Freeze(50, 1));
+    FLAGS_enable_memtable_block_compress = true;
+    // the packed data is counted in the index, it takes less memory than the rows freed
+    ASSERT_GT(segment.GetIdxByteSize(), plain.GetIdxByteSize());
+    ASSERT_LT(segment.GetIdxByteSize(), plain.GetIdxByteSize() + 50 * GetRecordSize(value.size()));
+    // late rows inflate the packed blocks to merge
+    segment.Put(pk, 30, "late", 4);
+    ASSERT_EQ(21, (int64_t)segment.Freeze(70, 1));
+    ASSERT_EQ(101, (int64_t)segment.GetIdxCnt());
+    {
+        Ticket ticket;
+        MemTableIterator* it = segment.NewIterator(pk, ticket);
+        it->SeekToFirst();
+        uint32_t cnt = 0;
+        while (it->Valid()) {
+            // only the rows of the current block are kept unpacked
+            if (it->GetValue().ToString() == "late") {
+                ASSERT_EQ(30u, it->GetKey());
+            } else {
+                ASSERT_EQ(value + std::to_string(it->GetKey()), it->GetValue().ToString());
+            }
+            cnt++;
+            it->Next();
+        }
+        ASSERT_EQ(101u, cnt);
+        it->Seek(35);
+        ASSERT_TRUE(it->Valid());
+        ASSERT_EQ(35, (int64_t)it->GetKey());
+        ASSERT_EQ(value + "35", it->GetValue().ToString());
+        delete it;
+    }
+    // the rows in packed blocks are only read by the iterators
+    DataBlock* db = NULL;
+    ASSERT_FALSE(segment.Get(pk, 35, &db));
+    ASSERT_TRUE(db == NULL);
+    ASSERT_TRUE(plain.Get(pk, 35, &db));
+    ASSERT_TRUE(db != NULL);
+    ASSERT_EQ(value + "35", std::string(db->data, db->size));
+    ASSERT_TRUE(segment.Get(pk, 80, &db));
+    ASSERT_TRUE(db != NULL);
+    ASSERT_EQ(value + "80", std::string(db->data, db->size));
+    ASSERT_TRUE(segment.Get(pk, 200, &db));
+    ASSERT_TRUE(db == NULL);
+    uint64_t gc_idx_cnt = 0;
+    uint64_t gc_record_cnt = 0;
+    uint64_t gc_record_byte_size = 0;
+    segment.Gc4TTL(40, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(41, (int64_t)gc_idx_cnt);
+    ASSERT_EQ(41, (int64_t)gc_record_cnt);
+    ASSERT_EQ(60, (int64_t)segment.GetIdxCnt());
+    {
+        Ticket ticket;
+        MemTableIterator* it = segment.NewIterator(pk, ticket);
+        it->SeekToLast();
+        ASSERT_EQ(41, (int64_t)it->GetKey());
+        ASSERT_EQ(value + "41", it->GetValue().ToString());
+        delete it;
+    }
+    // the frozen rows are moved back before gc by head
+    segment.Gc4Head(10, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(91, (int64_t)gc_record_cnt);
+    ASSERT_EQ(10, (int64_t)segment.GetIdxCnt());
+    segment.Gc4TTL(100, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    segment.IncrGcVersion();
+    segment.IncrGcVersion();
+    segment.GcFreeList(gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(0, (int64_t)segment.GetPkCnt());
+    ASSERT_EQ(0, (int64_t)segment.GetIdxByteSize());
+    FLAGS_enable_memtable_block_compress = false;
+}
+
+TEST_F(SegmentTest, Gc4TTLByIndex) {
+    FLAGS_enable_gc_expire_index = true;
+    FLAGS_gc_expire_index_bucket_ms = 10;
+    Segment segment;
+    FLAGS_enable_gc_expire_index = false;
+    ASSERT_TRUE(segment.IsExpireIndexEnabled());
+    for (uint64_t ts = 100; ts < 200; ts++) {
+        segment.Put("old", ts, "test", 4);
+        segment.Put("new", ts + 1000, "test", 4);
+    }
+    ASSERT_EQ(2u, segment.GetExpireIndexCnt());
+    uint64_t gc_idx_cnt = 0;
+    uint64_t gc_record_cnt = 0;
+    uint64_t gc_record_byte_size = 0;
+    segment.Gc4TTL(50, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(0, (int64_t)gc_idx_cnt);
+    segment.Gc4TTL(149, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(50, (int64_t)gc_idx_cnt);
+    ASSERT_EQ(50, (int64_t)gc_record_cnt);
+    ASSERT_EQ(50 * GetRecordSize(4), (int64_t)gc_record_byte_size);
+    // a put with older time moves the key back to an expired bucket
+    segment.Put("new", 10, "test", 4);
+    segment.Gc4TTL(149, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(51, (int64_t)gc_idx_cnt);
+    uint64_t count = 0;
+    ASSERT_EQ(0, segment.GetCount("new", count));
+    ASSERT_EQ(100, (int64_t)count);
+    // the key entry is removed from index with the entry
+    segment.Gc4TTL(500, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(101, (int64_t)gc_idx_cnt);
+    ASSERT_EQ(1u, segment.GetExpireIndexCnt());
+    ASSERT_EQ(100, (int64_t)segment.GetIdxCnt());
+    ASSERT_TRUE(segment.Delete("new"));
+    ASSERT_EQ(0u, segment.GetExpireIndexCnt());
+    segment.Gc4TTL(5000, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(101, (int64_t)gc_idx_cnt);
+}
+
 TEST_F(SegmentTest, TestStat) {
     Segment segment;
     segment.Put("PK", 9768, "test1", 5);
@@ -369,6 +683,194 @@ TEST_F(SegmentTest, TestStat) {
     ASSERT_EQ(0, (int64_t)segment.GetIdxCnt());
 }
 
+TEST_F(SegmentTest, ConcurrentPut) {
+    Segment segment;
+    std::vector<std::thread> threads;
+    uint32_t thread_num = 4;
+    uint32_t put_num = 10000;
+    std::string value = "test0";
+    for (uint32_t t = 0; t < thread_num; t++) {
+        threads.emplace_back([&segment, &value, t, put_num]() {
+            for (uint32_t i = 0; i < put_num; i++) {
+                // half of the rows go to a hot key shared by all threads
+                std::string key = i % 2 == 0 ? "hot" : "key" + std::to_string(t) + "_" + std::to_string(i % 100);
+                segment.Put(Slice(key), t * put_num + i, value.c_str(), value.size());
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    ASSERT_EQ(thread_num * put_num, segment.GetIdxCnt());
+    ASSERT_EQ(1 + thread_num * 50, segment.GetPkCnt());
+    uint64_t count = 0;
+    ASSERT_EQ(0, segment.GetCount(Slice("hot"), count));
+    ASSERT_EQ(thread_num * put_num / 2, count);
+    Ticket ticket;
+    MemTableIterator* it = segment.NewIterator(Slice("hot"), ticket);
+    it->SeekToFirst();
+    uint64_t last_ts = UINT64_MAX;
+    uint64_t cnt = 0;
+    while (it->Valid()) {
+        ASSERT_LT(it->GetKey(), last_ts);
+        last_ts = it->GetKey();
+        cnt++;
+        it->Next();
+    }
+    ASSERT_EQ(count, cnt);
+    delete it;
+}
+
+TEST_F(SegmentTest, ConcurrentPutAndGc) {
+    Segment segment;
+    std::atomic<bool> stop(false);
+    std::string value = "test0";
+    std::thread gc_thread([&segment, &stop]() {
+        while (!stop.load(std::memory_order_relaxed)) {
+            uint64_t gc_idx_cnt = 0;
+            uint64_t gc_record_cnt = 0;
+            uint64_t gc_record_byte_size = 0;
+            segment.Gc4TTL(500, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+        }
+    });
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < 4; t++) {
+        threads.emplace_back([&segment, &value]() {
+            for (uint32_t i = 0; i < 10000; i++) {
+                std::string key = "key" + std::to_string(i % 10);
+                segment.Put(Slice(key), i % 1000, value.c_str(), value.size());
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    stop.store(true, std::memory_order_relaxed);
+    gc_thread.join();
+    uint64_t gc_idx_cnt = 0;
+    uint64_t gc_record_cnt = 0;
+    uint64_t gc_record_byte_size = 0;
+    segment.Gc4TTL(500, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    // rows newer than the ttl are never lost
+    for (uint32_t k = 0; k < 10; k++) {
+        uint64_t expect = 0;
+        for (uint32_t i = k; i < 10000; i += 10) {
+            if (i % 1000 > 500) {
+                expect += 4;
+            }
+        }
+        std::string key = "key" + std::to_string(k);
+        uint64_t count = 0;
+        ASSERT_EQ(0, segment.GetCount(Slice(key), count));
+        ASSERT_EQ(expect, count);
+    }
+}
+
+TEST_F(SegmentTest, Split) {
+    Segment segment;
+    segment.SetSplitTree(0, 1, 0, 1, &segment);
+    ASSERT_TRUE(segment.CanSplit());
+    // the child is created when the segment splits
+    std::unique_ptr<Segment> child_ptr(segment.NewSplitChild());
+    ASSERT_TRUE(child_ptr);
+    Segment& child = *child_ptr;
+    ASSERT_FALSE(child.CanSplit());
+    ASSERT_EQ(1, (int64_t)child.GetSplitDepth());
+    std::string value = "test0";
+    for (uint32_t i = 0; i < 100; i++) {
+        std::string key = "key" + std::to_string(i);
+        segment.Put(Slice(key), 1000, value.c_str(), value.size());
+        segment.Put(Slice(key), 1001, value.c_str(), value.size());
+    }
+    ASSERT_EQ(100, (int64_t)segment.GetPkCnt());
+    ASSERT_TRUE(segment.StartSplit(&child));
+    ASSERT_FALSE(segment.StartSplit(&child));
+    uint64_t copy_cnt = segment.CopySplitKeys();
+    ASSERT_GT(copy_cnt, 0);
+    ASSERT_LT(copy_cnt, 100);
+    ASSERT_EQ(copy_cnt, child.GetPkCnt());
+    ASSERT_EQ(100, (int64_t)(segment.GetPkCnt() + child.GetPkCnt()));
+    segment.FinishSplit();
+    ASSERT_EQ(1, (int64_t)segment.GetSplitDepth());
+    ASSERT_FALSE(segment.CanSplit());
+    ASSERT_TRUE(segment.NewSplitChild() == NULL);
+    for (uint32_t i = 0; i < 100; i++) {
+        std::string key = "key" + std::to_string(i);
+        segment.Put(Slice(key), 1002, value.c_str(), value.size());
+        uint64_t count = 0;
+        ASSERT_EQ(0, segment.GetCount(Slice(key), count));
+        ASSERT_EQ(3, (int64_t)count);
+    }
+    ASSERT_EQ(copy_cnt, segment.RemoveSplitKeys());
+    ASSERT_EQ(100, (int64_t)(segment.GetPkCnt() + child.GetPkCnt()));
+    ASSERT_EQ(300, (int64_t)(segment.GetIdxCnt() + child.GetIdxCnt()));
+    for (uint32_t i = 0; i < 100; i++) {
+        std::string key = "key" + std::to_string(i);
+        uint64_t count = 0;
+        ASSERT_EQ(0, segment.GetCount(Slice(key), count));
+        ASSERT_EQ(3, (int64_t)count);
+        DataBlock* result = NULL;
+        ASSERT_TRUE(segment.Get(Slice(key), 1001, &result));
+    }
+    for (uint32_t i = 0; i < 10; i++) {
+        std::string key = "key" + std::to_string(i);
+        ASSERT_TRUE(segment.Delete(Slice(key)));
+        ASSERT_FALSE(segment.Delete(Slice(key)));
+        uint64_t count = 0;
+        ASSERT_EQ(-1, segment.GetCount(Slice(key), count));
+    }
+}
+
+TEST_F(SegmentTest, ConcurrentPutAndSplit) {
+    Segment segment;
+    Segment child;
+    segment.SetSplitTree(0, 1, 0, 1, &segment);
+    child.SetSplitTree(1, 1, 1, 1, &segment);
+    std::string value = "test0";
+    for (uint32_t i = 0; i < 1000; i++) {
+        std::string key = "key" + std::to_string(i);
+        segment.Put(Slice(key), 0, value.c_str(), value.size());
+    }
+    std::atomic<bool> stop(false);
+    std::thread reader([&segment, &stop]() {
+        while (!stop.load(std::memory_order_relaxed)) {
+            for (uint32_t i = 0; i < 1000; i += 7) {
+                std::string key = "key" + std::to_string(i);
+                uint64_t count = 0;
+                ASSERT_EQ(0, segment.GetCount(Slice(key), count));
+                ASSERT_GE(count, 1);
+            }
+        }
+    });
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < 4; t++) {
+        threads.emplace_back([&segment, &value, t]() {
+            // the new keys and the existing keys go on during the split
+            for (uint32_t i = 0; i < 4000; i++) {
+                std::string key = "key" + std::to_string(i % 2000);
+                segment.Put(Slice(key), 1 + t * 4000 + i, value.c_str(), value.size());
+            }
+        });
+    }
+    ASSERT_TRUE(segment.StartSplit(&child));
+    segment.CopySplitKeys();
+    segment.FinishSplit();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    segment.RemoveSplitKeys();
+    stop.store(true, std::memory_order_relaxed);
+    reader.join();
+    ASSERT_EQ(2000, (int64_t)(segment.GetPkCnt() + child.GetPkCnt()));
+    ASSERT_EQ(1000 + 16000, (int64_t)(segment.GetIdxCnt() + child.GetIdxCnt()));
+    for (uint32_t i = 0; i < 2000; i++) {
+        std::string key = "key" + std::to_string(i);
+        uint64_t count = 0;
+        ASSERT_EQ(0, segment.GetCount(Slice(key), count));
+        ASSERT_EQ(i < 1000 ? 9 : 8, (int64_t)count);
+    }
+}
+
 TEST_F(SegmentTest, GetTsIdx) {
     std::vector<uint32_t> ts_idx_vec = {1, 3, 5};
     Segment segment(8, ts_idx_vec);
@@ -24,11 +24,14 @@
 #include <unistd.h>
 
 #include <iostream>
+#include <mutex>  // NOLINT
+#include <thread>  // NOLINT
 
 #include "base/file_util.h"
 #include "base/glog_wapper.h"
 #include "base/strings.h"
 #include "codec/schema_codec.h"
+#include "codec/sdk_codec.h"
 #include "common/timer.h"
 #include "gtest/gtest.h"
 #include "log/log_writer.h"
@@ -42,6 +45,10 @@
 
 DECLARE_string(db_root_path);
 DECLARE_string(snapshot_compression);
+DECLARE_uint32(snapshot_format_version);
+DECLARE_uint32(snapshot_max_delta_num);
+DECLARE_uint32(recover_binlog_thread_num);
+DECLARE_uint32(recover_binlog_chunk_size);
 
 using ::openmldb::api::LogEntry;
 namespace openmldb {
@@ -347,6 +354,65 @@ TEST_F(SnapshotTest, Recover_only_binlog) {
     ASSERT_FALSE(it->Valid());
 }
 
+TEST_F(SnapshotTest, Recover_binlog_parallel) {
+    std::string binlog_dir = FLAGS_db_root_path + "/3_4/binlog/";
+    LogParts* log_part = new LogParts(12, 4, scmp);
+    uint64_t offset = 0;
+    uint32_t binlog_index = 0;
+    WriteHandle* wh = NULL;
+    RollWLogFile(&wh, log_part, binlog_dir, binlog_index, offset);
+    for (int count = 0; count < 1000; count++) {
+        offset++;
+        std::string key = "key" + std::to_string(count % 10);
+        auto entry = ::openmldb::test::PackKVEntry(offset, key, "value" + std::to_string(count), count + 1, 0);
+        std::string buffer;
+        entry.SerializeToString(&buffer);
+        ASSERT_TRUE(wh->Write(::openmldb::base::Slice(buffer)).ok());
+        if (count == 500) {
+            // key0 keeps the 49 entries after the delete
+            offset++;
+            ::openmldb::api::LogEntry delete_entry;
+            delete_entry.set_log_index(offset);
+            delete_entry.set_method_type(::openmldb::api::MethodType::kDelete);
+            ::openmldb::api::Dimension* dimension = delete_entry.add_dimensions();
+            dimension->set_key(key);
+            dimension->set_idx(0);
+            delete_entry.SerializeToString(&buffer);
+            ASSERT_TRUE(wh->Write(::openmldb::base::Slice(buffer)).ok());
+        }
+        if (count == 700) {
+            RollWLogFile(&wh, log_part, binlog_dir, binlog_index, offset);
+        }
+    }
+    wh->Sync();
+    FLAGS_recover_binlog_thread_num = 4;
+    FLAGS_recover_binlog_chunk_size = 64;
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx0", 0));
+    std::shared_ptr<MemTable> table =
+        std::make_shared<MemTable>("test", 3, 4, 8, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime);
+    table->Init();
+    uint64_t latest_offset = 0;
+    Binlog binlog(log_part, binlog_dir);
+    ASSERT_TRUE(binlog.RecoverFromBinlog(table, 0, latest_offset));
+    FLAGS_recover_binlog_thread_num = 0;
+    ASSERT_EQ(1001u, latest_offset);
+    for (int i = 0; i < 10; i++) {
+        Ticket ticket;
+        std::unique_ptr<TableIterator> it(table->NewIterator("key" + std::to_string(i), ticket));
+        it->SeekToFirst();
+        int count = 0;
+        uint64_t last_ts = UINT64_MAX;
+        while (it->Valid()) {
+            ASSERT_LT(it->GetKey(), last_ts);
+            last_ts = it->GetKey();
+            count++;
+            it->Next();
+        }
+        ASSERT_EQ(i == 0 ? 49 : 100, count);
+    }
+}
+
 TEST_F(SnapshotTest, Recover_only_snapshot_multi) {
     std::string snapshot_dir = FLAGS_db_root_path + "/3_2/snapshot";
     std::string binlog_dir = FLAGS_db_root_path + "/3_2/binlog";
@@ -855,6 +921,306 @@ TEST_F(SnapshotTest, MakeSnapshot) {
     ASSERT_EQ(7, (int64_t)manifest.term());
 }
 
+TEST_F(SnapshotTest, MakeSnapshot_mmap) {
+    LogParts* log_part = new LogParts(12, 4, scmp);
+    MemTableSnapshot snapshot(6, 1, log_part, FLAGS_db_root_path);
+    snapshot.Init();
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx0", 0));
+    std::shared_ptr<MemTable> table =
+        std::make_shared<MemTable>("tx_log", 6, 1, 8, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime);
+    table->Init();
+    uint64_t offset = 0;
+    uint32_t binlog_index = 0;
+    std::string log_path = FLAGS_db_root_path + "/6_1/binlog/";
+    std::string snapshot_path = FLAGS_db_root_path + "/6_1/snapshot/";
+    WriteHandle* wh = NULL;
+    RollWLogFile(&wh, log_part, log_path, binlog_index, offset);
+    for (int count = 0; count < 1000; count++) {
+        offset++;
+        auto entry = ::openmldb::test::PackKVEntry(offset, "key" + std::to_string(count % 10),
+                                                   "value" + std::to_string(count), count + 1, 5);
+        std::string buffer;
+        entry.SerializeToString(&buffer);
+        ASSERT_TRUE(wh->Write(::openmldb::base::Slice(buffer)).ok());
+    }
+    wh->Sync();
+    FLAGS_snapshot_format_version = 2;
+    uint64_t offset_value = 0;
+    ASSERT_EQ(0, snapshot.MakeSnapshot(table, offset_value, 0));
+    ASSERT_EQ(1000u, offset_value);
+
+    // the delete of key0 is applied to the snapshot made before
+    offset++;
+    ::openmldb::api::LogEntry delete_entry;
+    delete_entry.set_log_index(offset);
+    delete_entry.set_method_type(::openmldb::api::MethodType::kDelete);
+    ::openmldb::api::Dimension* dimension = delete_entry.add_dimensions();
+    dimension->set_key("key0");
+    dimension->set_idx(0);
+    std::string buffer;
+    delete_entry.SerializeToString(&buffer);
+    ASSERT_TRUE(wh->Write(::openmldb::base::Slice(buffer)).ok());
+    for (int count = 1000; count < 1100; count++) {
+        offset++;
+        auto entry = ::openmldb::test::PackKVEntry(offset, "key" + std::to_string(count % 10),
+                                                   "value" + std::to_string(count), count + 1, 6);
+        entry.SerializeToString(&buffer);
+        ASSERT_TRUE(wh->Write(::openmldb::base::Slice(buffer)).ok());
+    }
+    wh->Sync();
+    ASSERT_EQ(0, snapshot.MakeSnapshot(table, offset_value, 0));
+    FLAGS_snapshot_format_version = 1;
+    ASSERT_EQ(1101u, offset_value);
+
+    ::openmldb::api::Manifest manifest;
+    {
+        int fd = open((snapshot_path + "MANIFEST").c_str(), O_RDONLY);
+        google::protobuf::io::FileInputStream fileInput(fd);
+        fileInput.SetCloseOnDelete(true);
+        google::protobuf::TextFormat::Parse(&fileInput, &manifest);
+    }
+    ASSERT_EQ(1101u, manifest.offset());
+    ASSERT_EQ(1000u, manifest.count());
+    FILE* fd = fopen((snapshot_path + manifest.name()).c_str(), "rb");
+    ASSERT_TRUE(fd != NULL);
+    ASSERT_TRUE(MmapSnapshotReader::IsMmapSnapshot(fd));
+    fclose(fd);
+
+    std::shared_ptr<MemTable> new_table =
+        std::make_shared<MemTable>("tx_log", 6, 1, 8, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime);
+    new_table->Init();
+    MemTableSnapshot new_snapshot(6, 1, log_part, FLAGS_db_root_path);
+    new_snapshot.Init();
+    uint64_t latest_offset = 0;
+    ASSERT_TRUE(new_snapshot.Recover(new_table, latest_offset));
+    ASSERT_EQ(1101u, latest_offset);
+    ASSERT_EQ(1000u, new_table->GetRecordCnt());
+    for (int i = 0; i < 10; i++) {
+        Ticket ticket;
+        std::unique_ptr<TableIterator> it(new_table->NewIterator("key" + std::to_string(i), ticket));
+        it->SeekToFirst();
+        int count = 0;
+        uint64_t last_ts = UINT64_MAX;
+        while (it->Valid()) {
+            ASSERT_LT(it->GetKey(), last_ts);
+            last_ts = it->GetKey();
+            count++;
+            it->Next();
+        }
+        ASSERT_EQ(i == 0 ? 10 : 110, count);
+    }
+}
+
+TEST_F(SnapshotTest, MakeSnapshot_delta) {
+    LogParts* log_part = new LogParts(12, 4, scmp);
+    MemTableSnapshot snapshot(6, 2, log_part, FLAGS_db_root_path);
+    snapshot.Init();
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx0", 0));
+    std::shared_ptr<MemTable> table =
+        std::make_shared<MemTable>("tx_log", 6, 2, 8, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime);
+    table->Init();
+    uint64_t offset = 0;
+    uint32_t binlog_index = 0;
+    std::string log_path = FLAGS_db_root_path + "/6_2/binlog/";
+    std::string snapshot_path = FLAGS_db_root_path + "/6_2/snapshot/";
+    WriteHandle* wh = NULL;
+    RollWLogFile(&wh, log_part, log_path, binlog_index, offset);
+    auto write_entries = [&](int start, int end) {
+        for (int count = start; count < end; count++) {
+            offset++;
+            auto entry = ::openmldb::test::PackKVEntry(offset, "key" + std::to_string(count % 10),
+                                                       "value" + std::to_string(count), count + 1, 5);
+            std::string buffer;
+            entry.SerializeToString(&buffer);
+            ASSERT_TRUE(wh->Write(::openmldb::base::Slice(buffer)).ok());
+        }
+        wh->Sync();
+    };
+    auto read_manifest = [&](::openmldb::api::Manifest* manifest) {
+        manifest->Clear();
+        int fd = open((snapshot_path + "MANIFEST").c_str(), O_RDONLY);
+        google::protobuf::io::FileInputStream fileInput(fd);
+        fileInput.SetCloseOnDelete(true);
+        google::protobuf::TextFormat::Parse(&fileInput, manifest);
+    };
+    auto check_recover = [&](uint64_t expect_offset) {
+        std::shared_ptr<MemTable> new_table =
+            std::make_shared<MemTable>("tx_log", 6, 2, 8, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime);
+        new_table->Init();
+        MemTableSnapshot new_snapshot(6, 2, log_part, FLAGS_db_root_path);
+        new_snapshot.Init();
+        uint64_t latest_offset = 0;
+        ASSERT_TRUE(new_snapshot.Recover(new_table, latest_offset));
+        ASSERT_EQ(expect_offset, latest_offset);
+        for (int i = 0; i < 10; i++) {
+            Ticket ticket;
+            std::unique_ptr<TableIterator> it(new_table->NewIterator("key" + std::to_string(i), ticket));
+            it->SeekToFirst();
+            int count = 0;
+            while (it->Valid()) {
+                count++;
+                it->Next();
+            }
+            ASSERT_EQ(i == 0 ? 10 : 25, count);
+        }
+    };
+    FLAGS_snapshot_max_delta_num = 2;
+    uint64_t offset_value = 0;
+    write_entries(0, 100);
+    ASSERT_EQ(0, snapshot.MakeSnapshot(table, offset_value, 0));
+
+    // the first delta has the delete of key0
+    write_entries(100, 150);
+    offset++;
+    ::openmldb::api::LogEntry delete_entry;
+    delete_entry.set_log_index(offset);
+    delete_entry.set_method_type(::openmldb::api::MethodType::kDelete);
+    ::openmldb::api::Dimension* dimension = delete_entry.add_dimensions();
+    dimension->set_key("key0");
+    dimension->set_idx(0);
+    std::string buffer;
+    delete_entry.SerializeToString(&buffer);
+    ASSERT_TRUE(wh->Write(::openmldb::base::Slice(buffer)).ok());
+    write_entries(150, 200);
+    ASSERT_EQ(0, snapshot.MakeSnapshot(table, offset_value, 0));
+    ASSERT_EQ(201u, offset_value);
+    write_entries(200, 250);
+    ASSERT_EQ(0, snapshot.MakeSnapshot(table, offset_value, 0));
+    ASSERT_EQ(251u, offset_value);
+
+    ::openmldb::api::Manifest manifest;
+    read_manifest(&manifest);
+    ASSERT_EQ(251u, manifest.offset());
+    ASSERT_EQ(100u, manifest.count());
+    ASSERT_EQ(2, manifest.delta_size());
+    ASSERT_EQ(100u, manifest.delta(0).offset());
+    ASSERT_EQ(101u, manifest.delta(0).count());
+    ASSERT_EQ(201u, manifest.delta(1).offset());
+    ASSERT_EQ(50u, manifest.delta(1).count());
+    std::vector<std::string> vec;
+    ASSERT_EQ(0, ::openmldb::base::GetFileName(snapshot_path, vec));
+    ASSERT_EQ(4u, vec.size());
+    check_recover(251);
+
+    // the deltas are merged once there are too many of them
+    ASSERT_EQ(0, snapshot.MakeSnapshot(table, offset_value, 0));
+    FLAGS_snapshot_max_delta_num = 0;
+    read_manifest(&manifest);
+    ASSERT_EQ(251u, manifest.offset());
+    ASSERT_EQ(235u, manifest.count());
+    ASSERT_EQ(0, manifest.delta_size());
+    vec.clear();
+    ASSERT_EQ(0, ::openmldb::base::GetFileName(snapshot_path, vec));
+    ASSERT_EQ(2u, vec.size());
+    check_recover(251);
+}
+
+TEST_F(SnapshotTest, DumpSnapshot) {
+    LogParts* log_part = new LogParts(12, 4, scmp);
+    MemTableSnapshot snapshot(6, 3, log_part, FLAGS_db_root_path);
+    snapshot.Init();
+    ::openmldb::api::TableMeta table_meta;
+    table_meta.set_name("test");
+    table_meta.set_tid(6);
+    table_meta.set_pid(3);
+    table_meta.set_seg_cnt(8);
+    table_meta.set_format_version(1);
+    SchemaCodec::SetColumnDesc(table_meta.add_column_desc(), "card", ::openmldb::type::kString);
+    SchemaCodec::SetColumnDesc(table_meta.add_column_desc(), "merchant", ::openmldb::type::kString);
+    SchemaCodec::SetColumnDesc(table_meta.add_column_desc(), "value", ::openmldb::type::kString);
+    SchemaCodec::SetIndex(table_meta.add_column_key(), "card", "card", "", ::openmldb::type::kAbsoluteTime, 0, 0);
+    SchemaCodec::SetIndex(table_meta.add_column_key(), "merchant", "merchant", "", ::openmldb::type::kAbsoluteTime, 0,
+                          0);
+    std::shared_ptr<MemTable> table = std::make_shared<MemTable>(table_meta);
+    table->Init();
+    uint64_t offset = 0;
+    uint32_t binlog_index = 0;
+    std::string log_path = FLAGS_db_root_path + "/6_3/binlog/";
+    std::string snapshot_path = FLAGS_db_root_path + "/6_3/snapshot/";
+    WriteHandle* wh = NULL;
+    RollWLogFile(&wh, log_part, log_path, binlog_index, offset);
+    ::openmldb::codec::SDKCodec sdk_codec(table_meta);
+    std::mutex mu;
+    // put the row to the table and the binlog as the tablet does
+    auto put_rows = [&](int start, int end) {
+        for (int count = start; count < end; count++) {
+            PutGuard put_guard(table.get());
+            ::openmldb::api::LogEntry entry;
+            entry.set_ts(count + 1);
+            sdk_codec.EncodeRow({"card" + std::to_string(count % 10), "merchant" + std::to_string(count % 7),
+                                 "value" + std::to_string(count)},
+                                entry.mutable_value());
+            ::openmldb::api::Dimension* d1 = entry.add_dimensions();
+            d1->set_key("card" + std::to_string(count % 10));
+            d1->set_idx(0);
+            ::openmldb::api::Dimension* d2 = entry.add_dimensions();
+            d2->set_key("merchant" + std::to_string(count % 7));
+            d2->set_idx(1);
+            ASSERT_TRUE(put_guard.Put(table.get(), entry.ts(), entry.value(), entry.dimensions()));
+            std::lock_guard<std::mutex> lock(mu);
+            entry.set_log_index(++offset);
+            std::string buffer;
+            entry.SerializeToString(&buffer);
+            ASSERT_TRUE(wh->Write(::openmldb::base::Slice(buffer)).ok());
+            put_guard.Commit(entry.log_index());
+        }
+    };
+    auto get_offset = [&]() {
+        std::lock_guard<std::mutex> lock(mu);
+        return offset;
+    };
+    put_rows(0, 500);
+    // the rows put during the dump are either in the snapshot or after its offset
+    std::thread writer(put_rows, 500, 1000);
+    uint64_t offset_value = 0;
+    ASSERT_EQ(0, snapshot.DumpSnapshot(table, get_offset, 5, &offset_value));
+    writer.join();
+    wh->Sync();
+    ASSERT_GE(offset_value, 500u);
+
+    std::shared_ptr<MemTable> new_table = std::make_shared<MemTable>(table_meta);
+    new_table->Init();
+    MemTableSnapshot new_snapshot(6, 3, log_part, FLAGS_db_root_path);
+    new_snapshot.Init();
+    uint64_t latest_offset = 0;
+    ASSERT_TRUE(new_snapshot.Recover(new_table, latest_offset));
+    ASSERT_EQ(offset_value, latest_offset);
+    Binlog binlog(log_part, log_path);
+    ASSERT_TRUE(binlog.RecoverFromBinlog(new_table, latest_offset, latest_offset));
+    ASSERT_EQ(1000u, latest_offset);
+    auto check_count = [&](uint32_t idx, const std::string& key, int expect) {
+        Ticket ticket;
+        std::unique_ptr<TableIterator> it(new_table->NewIterator(idx, key, ticket));
+        it->SeekToFirst();
+        int count = 0;
+        while (it->Valid()) {
+            count++;
+            it->Next();
+        }
+        ASSERT_EQ(expect, count);
+    };
+    for (int i = 0; i < 10; i++) {
+        check_count(0, "card" + std::to_string(i), 100);
+    }
+    for (int i = 0; i < 7; i++) {
+        check_count(1, "merchant" + std::to_string(i), 1000 / 7 + (i < 1000 % 7 ? 1 : 0));
+    }
+
+    // the rows of the last epoch are dumped once each
+    ASSERT_EQ(0, snapshot.DumpSnapshot(table, get_offset, 5, &offset_value));
+    ASSERT_EQ(1000u, offset_value);
+    ::openmldb::api::Manifest manifest;
+    int fd = open((snapshot_path + "MANIFEST").c_str(), O_RDONLY);
+    google::protobuf::io::FileInputStream fileInput(fd);
+    fileInput.SetCloseOnDelete(true);
+    google::protobuf::TextFormat::Parse(&fileInput, &manifest);
+    ASSERT_EQ(1000u, manifest.offset());
+    ASSERT_EQ(1000u, manifest.count());
+    ASSERT_EQ(5u, manifest.term());
+}
+
 TEST_F(SnapshotTest, MakeSnapshot_with_delete_index) {
     LogParts* log_part = new LogParts(12, 4, scmp);
     MemTableSnapshot snapshot(1, 3, log_part, FLAGS_db_root_path);
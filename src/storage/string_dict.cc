@@ -0,0 +1,259 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/string_dict.h"
+
+#include <string.h>
+
+#include <vector>
+
+#include "base/hash.h"
+
+namespace openmldb {
+namespace storage {
+
+static const uint32_t SEED = 0xe17a1465;
+static const uint32_t INIT_CODE_TABLE_SIZE = 64;
+
+StringDict::Column::Column(uint32_t max_size)
+    : mu(), table(new CodeTable(INIT_CODE_TABLE_SIZE)), retired(), chunk_cnt((max_size + DICT_CHUNK_SIZE - 1) / DICT_CHUNK_SIZE),
+      chunks(NULL), size(0) {
+    chunks = new std::atomic<Value*>[chunk_cnt];
+    for (uint32_t i = 0; i < chunk_cnt; i++) {
+        chunks[i].store(NULL, std::memory_order_relaxed);
+    }
+}
+
+StringDict::Column::~Column() {
+    uint32_t cnt = size.load(std::memory_order_relaxed);
+    for (uint32_t i = 0; i < chunk_cnt; i++) {
+        Value* chunk = chunks[i].load(std::memory_order_relaxed);
+        if (chunk == NULL) {
+            break;
+        }
+        for (uint32_t j = 0; j < DICT_CHUNK_SIZE && (i << DICT_CHUNK_BITS) + j < cnt; j++) {
+            delete[] chunk[j].data;
+        }
+        delete[] chunk;
+    }
+    delete[] chunks;
+    delete table.load(std::memory_order_relaxed);
+    for (CodeTable* old : retired) {
+        delete old;
+    }
+}
+
+StringDict::StringDict(uint32_t max_size) : max_size_(max_size), mu_(), byte_size_(0) {
+    for (uint32_t i = 0; i <= UINT8_MAX; i++) {
+        views_[i].store(NULL, std::memory_order_relaxed);
+    }
+    for (uint32_t i = 0; i < MAX_DICT_COLUMN_CNT; i++) {
+        columns_[i].store(NULL, std::memory_order_relaxed);
+    }
+}
+
+StringDict::~StringDict() {
+    for (uint32_t i = 0; i <= UINT8_MAX; i++) {
+        delete views_[i].load(std::memory_order_relaxed);
+    }
+    for (uint32_t i = 0; i < MAX_DICT_COLUMN_CNT; i++) {
+        delete columns_[i].load(std::memory_order_relaxed);
+    }
+}
+
+codec::RowView* StringDict::GetView(uint8_t version, const std::shared_ptr<codec::Schema>& schema) {
+    codec::RowView* view = views_[version].load(std::memory_order_acquire);
+    if (view != NULL) {
+        return view;
+    }
+    std::lock_guard<std::mutex> lock(mu_);
+    view = views_[version].load(std::memory_order_relaxed);
+    if (view == NULL) {
+        // the view refers to the schema, keep it as long as the view
+        schemas_[version] = schema;
+        view = new codec::RowView(*schema);
+        view->SetStringDict(this);
+        views_[version].store(view, std::memory_order_release);
+    }
+    return view;
+}
+
+StringDict::Column* StringDict::GetColumn(uint32_t idx) {
+    if (idx >= MAX_DICT_COLUMN_CNT) {
+        return NULL;
+    }
+    Column* column = columns_[idx].load(std::memory_order_acquire);
+    if (column != NULL) {
+        return column;
+    }
+    std::lock_guard<std::mutex> lock(mu_);
+    column = columns_[idx].load(std::memory_order_relaxed);
+    if (column == NULL) {
+        column = new Column(max_size_);
+        columns_[idx].store(column, std::memory_order_release);
+        byte_size_.fetch_add(sizeof(CodeSlot) * INIT_CODE_TABLE_SIZE, std::memory_order_relaxed);
+    }
+    return column;
+}
+
+uint32_t StringDict::FindCode(const Column* column, uint32_t hash, const char* val, uint32_t length) {
+    const CodeTable* table = column->table.load(std::memory_order_acquire);
+    uint32_t mask = table->capacity - 1;
+    for (uint32_t i = 0, pos = hash & mask; i <= mask; i++, pos = (pos + 1) & mask) {
+        const CodeSlot& slot = table->slots[pos];
+        uint32_t code = slot.code.load(std::memory_order_acquire);
+        if (code == 0) {
+            break;
+        }
+        code--;
+        if (slot.hash.load(std::memory_order_relaxed) != hash) {
+            continue;
+        }
+        // the value is set before the code is put in the table
+        const Value* chunk = column->chunks[code >> DICT_CHUNK_BITS].load(std::memory_order_acquire);
+        const Value& value = chunk[code & (DICT_CHUNK_SIZE - 1)];
+        if (value.size == length && memcmp(value.data, val, length) == 0) {
+            return code;
+        }
+    }
+    return codec::NO_DICT_CODE;
+}
+
+void StringDict::InsertCode(Column* column, uint32_t hash, uint32_t code) {
+    CodeTable* table = column->table.load(std::memory_order_relaxed);
+    if ((code + 1) * 2 > table->capacity) {
+        CodeTable* new_table = new CodeTable(table->capacity * 2);
+        uint32_t mask = new_table->capacity - 1;
+        for (uint32_t i = 0; i < table->capacity; i++) {
+            uint32_t cur = table->slots[i].code.load(std::memory_order_relaxed);
+            if (cur == 0) {
+                continue;
+            }
+            uint32_t cur_hash = table->slots[i].hash.load(std::memory_order_relaxed);
+            uint32_t pos = cur_hash & mask;
+            while (new_table->slots[pos].code.load(std::memory_order_relaxed) != 0) {
+                pos = (pos + 1) & mask;
+            }
+            new_table->slots[pos].hash.store(cur_hash, std::memory_order_relaxed);
+            new_table->slots[pos].code.store(cur, std::memory_order_relaxed);
+        }
+        column->table.store(new_table, std::memory_order_release);
+        column->retired.push_back(table);
+        byte_size_.fetch_add(sizeof(CodeSlot) * new_table->capacity, std::memory_order_relaxed);
+        table = new_table;
+    }
+    uint32_t mask = table->capacity - 1;
+    uint32_t pos = hash & mask;
+    while (table->slots[pos].code.load(std::memory_order_relaxed) != 0) {
+        pos = (pos + 1) & mask;
+    }
+    // the readers see the hash of the code they load
+    table->slots[pos].hash.store(hash, std::memory_order_relaxed);
+    table->slots[pos].code.store(code + 1, std::memory_order_release);
+}
+
+uint32_t StringDict::GetCode(uint32_t idx, const char* val, uint32_t length) {
+    Column* column = GetColumn(idx);
+    if (column == NULL) {
+        return codec::NO_DICT_CODE;
+    }
+    uint32_t hash = ::openmldb::base::hash(val, length, SEED);
+    uint32_t code = FindCode(column, hash, val, length);
+    if (code != codec::NO_DICT_CODE) {
+        return code;
+    }
+    std::lock_guard<std::mutex> lock(column->mu);
+    code = FindCode(column, hash, val, length);
+    if (code != codec::NO_DICT_CODE) {
+        return code;
+    }
+    code = column->size.load(std::memory_order_relaxed);
+    if (code >= max_size_) {
+        return codec::NO_DICT_CODE;
+    }
+    Value* chunk = column->chunks[code >> DICT_CHUNK_BITS].load(std::memory_order_relaxed);
+    if (chunk == NULL) {
+        chunk = new Value[DICT_CHUNK_SIZE];
+        column->chunks[code >> DICT_CHUNK_BITS].store(chunk, std::memory_order_release);
+    }
+    char* data = new char[length];
+    memcpy(data, val, length);
+    chunk[code & (DICT_CHUNK_SIZE - 1)] = {data, length};
+    column->size.store(code + 1, std::memory_order_release);
+    InsertCode(column, hash, code);
+    byte_size_.fetch_add(length + sizeof(Value), std::memory_order_relaxed);
+    return code;
+}
+
+bool StringDict::Encode(const std::shared_ptr<codec::Schema>& schema, const int8_t* row, std::string* out) {
+    if (!schema || row == NULL || codec::IsDictRow(row)) {
+        return false;
+    }
+    codec::RowView* view = GetView(codec::RowView::GetSchemaVersion(row), schema);
+    std::vector<uint32_t> codes(schema->size(), codec::NO_DICT_CODE);
+    bool coded = false;
+    for (int32_t idx = 0; idx < schema->size(); idx++) {
+        auto type = schema->Get(idx).data_type();
+        if (type != ::openmldb::type::kVarchar && type != ::openmldb::type::kString) {
+            continue;
+        }
+        if (view->IsNULL(row, idx)) {
+            continue;
+        }
+        char* val = NULL;
+        uint32_t length = 0;
+        // a code takes 4 bytes, the shorter strings are kept plain
+        if (view->GetValue(row, idx, &val, &length) != 0 || length <= sizeof(uint32_t)) {
+            continue;
+        }
+        codes[idx] = GetCode(idx, val, length);
+        coded = coded || codes[idx] != codec::NO_DICT_CODE;
+    }
+    if (!coded) {
+        return false;
+    }
+    return view->EncodeDictRow(row, codes, out);
+}
+
+bool StringDict::DecodeRow(const int8_t* row, std::string* out) const {
+    if (row == NULL || !codec::IsDictRow(row)) {
+        return false;
+    }
+    // a coded row of a version is put after the view of the version is created
+    codec::RowView* view = views_[codec::RowView::GetSchemaVersion(row)].load(std::memory_order_acquire);
+    if (view == NULL) {
+        return false;
+    }
+    return view->DecodeDictRow(row, out);
+}
+
+bool StringDict::Decode(uint32_t idx, uint32_t code, const char** val, uint32_t* length) const {
+    if (idx >= MAX_DICT_COLUMN_CNT || val == NULL || length == NULL) {
+        return false;
+    }
+    Column* column = columns_[idx].load(std::memory_order_acquire);
+    if (column == NULL || code >= column->size.load(std::memory_order_acquire)) {
+        return false;
+    }
+    const Value* chunk = column->chunks[code >> DICT_CHUNK_BITS].load(std::memory_order_acquire);
+    const Value& value = chunk[code & (DICT_CHUNK_SIZE - 1)];
+    *val = value.data;
+    *length = value.size;
+    return true;
+}
+
+}  // namespace storage
+}  // namespace openmldb
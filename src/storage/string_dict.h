@@ -0,0 +1,115 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_STORAGE_STRING_DICT_H_
+#define SRC_STORAGE_STRING_DICT_H_
+
+#include <atomic>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "codec/codec.h"
+
+namespace openmldb {
+namespace storage {
+
+static constexpr uint32_t MAX_DICT_COLUMN_CNT = 1024;
+static constexpr uint32_t DICT_CHUNK_BITS = 10;
+static constexpr uint32_t DICT_CHUNK_SIZE = 1 << DICT_CHUNK_BITS;
+
+// The dictionaries of the string columns of a memtable. The strings are appended
+// and never removed, so the rows coded with them stay readable as long as the table.
+// A column stops coding new strings once it has max_size of them, the rows with the
+// other strings keep them plain. Decode and the lookup of a coded string are lock free,
+// only coding a new string takes the lock of the column
+class StringDict : public ::openmldb::codec::StringDictReader {
+ public:
+    explicit StringDict(uint32_t max_size);
+    ~StringDict() override;
+
+    StringDict(const StringDict&) = delete;
+    StringDict& operator=(const StringDict&) = delete;
+
+    // code the strings of the plain row with schema, the schema of the row version.
+    // return false if no string is coded, then the row is kept plain
+    bool Encode(const std::shared_ptr<codec::Schema>& schema, const int8_t* row, std::string* out);
+
+    // rebuild the plain row of a coded row
+    bool DecodeRow(const int8_t* row, std::string* out) const;
+
+    bool Decode(uint32_t idx, uint32_t code, const char** val, uint32_t* length) const override;
+
+    uint64_t GetByteSize() const { return byte_size_.load(std::memory_order_relaxed); }
+
+ private:
+    struct Value {
+        const char* data;
+        uint32_t size;
+    };
+
+    // an open addressing table from the strings to their codes, a slot keeps the
+    // code plus one, so 0 is empty. The strings are never removed
+    struct CodeSlot {
+        CodeSlot() : hash(0), code(0) {}
+        std::atomic<uint32_t> hash;
+        std::atomic<uint32_t> code;
+    };
+
+    struct CodeTable {
+        explicit CodeTable(uint32_t cap) : capacity(cap), slots(new CodeSlot[cap]) {}
+        ~CodeTable() { delete[] slots; }
+        uint32_t capacity;
+        CodeSlot* slots;
+    };
+
+    struct Column {
+        explicit Column(uint32_t max_size);
+        ~Column();
+        // guard coding a new string
+        std::mutex mu;
+        std::atomic<CodeTable*> table;
+        // the replaced tables are kept for the lock free lookups until the column is freed
+        std::vector<CodeTable*> retired;
+        uint32_t const chunk_cnt;
+        std::atomic<Value*>* chunks;
+        // the codes below size can be decoded
+        std::atomic<uint32_t> size;
+    };
+
+    codec::RowView* GetView(uint8_t version, const std::shared_ptr<codec::Schema>& schema);
+    Column* GetColumn(uint32_t idx);
+    uint32_t GetCode(uint32_t idx, const char* val, uint32_t length);
+    // return NO_DICT_CODE if the string is not coded
+    static uint32_t FindCode(const Column* column, uint32_t hash, const char* val, uint32_t length);
+    // need the lock of column held
+    void InsertCode(Column* column, uint32_t hash, uint32_t code);
+
+ private:
+    uint32_t const max_size_;
+    // guard the creation of views and columns
+    std::mutex mu_;
+    std::atomic<codec::RowView*> views_[UINT8_MAX + 1];
+    std::shared_ptr<codec::Schema> schemas_[UINT8_MAX + 1];
+    std::atomic<Column*> columns_[MAX_DICT_COLUMN_CNT];
+    std::atomic<uint64_t> byte_size_;
+};
+
+}  // namespace storage
+}  // namespace openmldb
+
+#endif  // SRC_STORAGE_STRING_DICT_H_
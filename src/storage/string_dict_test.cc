@@ -0,0 +1,265 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/string_dict.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "codec/schema_codec.h"
+#include "gflags/gflags.h"
+#include "gtest/gtest.h"
+#include "storage/mem_table.h"
+
+DECLARE_bool(enable_memtable_string_dict);
+
+namespace openmldb {
+namespace storage {
+
+using ::openmldb::codec::SchemaCodec;
+
+class StringDictTest : public ::testing::Test {
+ public:
+    StringDictTest() {}
+    ~StringDictTest() {}
+};
+
+std::shared_ptr<codec::Schema> CreateSchema() {
+    auto schema = std::make_shared<codec::Schema>();
+    SchemaCodec::SetColumnDesc(schema->Add(), "card", ::openmldb::type::kString);
+    SchemaCodec::SetColumnDesc(schema->Add(), "mcc", ::openmldb::type::kString);
+    SchemaCodec::SetColumnDesc(schema->Add(), "price", ::openmldb::type::kBigInt);
+    SchemaCodec::SetColumnDesc(schema->Add(), "city", ::openmldb::type::kVarchar);
+    SchemaCodec::SetColumnDesc(schema->Add(), "ts", ::openmldb::type::kTimestamp);
+    return schema;
+}
+
+std::string EncodeRow(const codec::Schema& schema, const std::string& card, const std::string& mcc, int64_t price,
+                      const std::string* city, int64_t ts) {
+    codec::RowBuilder builder(schema);
+    uint32_t size = builder.CalTotalLength(card.size() + mcc.size() + (city == NULL ? 0 : city->size()));
+    std::string row;
+    row.resize(size);
+    builder.SetBuffer(reinterpret_cast<int8_t*>(&(row[0])), size);
+    builder.AppendString(card.c_str(), card.size());
+    builder.AppendString(mcc.c_str(), mcc.size());
+    builder.AppendInt64(price);
+    if (city == NULL) {
+        builder.AppendNULL();
+    } else {
+        builder.AppendString(city->c_str(), city->size());
+    }
+    builder.AppendTimestamp(ts);
+    return row;
+}
+
+TEST_F(StringDictTest, EncodeAndDecode) {
+    auto schema = CreateSchema();
+    StringDict dict(100);
+    std::string city = "beijing";
+    std::string row = EncodeRow(*schema, "card00000001", "mcc", 100, &city, 1000);
+    const int8_t* data = reinterpret_cast<const int8_t*>(row.data());
+    std::string coded;
+    ASSERT_TRUE(dict.Encode(schema, data, &coded));
+    ASSERT_TRUE(codec::IsDictRow(reinterpret_cast<const int8_t*>(coded.data())));
+    // the short string is kept plain
+    ASSERT_LT(coded.size(), row.size());
+
+    codec::RowView view(*schema);
+    view.SetStringDict(&dict);
+    ASSERT_TRUE(view.Reset(reinterpret_cast<const int8_t*>(coded.data()), coded.size()));
+    char* val = NULL;
+    uint32_t length = 0;
+    ASSERT_EQ(0, view.GetString(0, &val, &length));
+    ASSERT_EQ("card00000001", std::string(val, length));
+    ASSERT_EQ(0, view.GetString(1, &val, &length));
+    ASSERT_EQ("mcc", std::string(val, length));
+    ASSERT_EQ(0, view.GetString(3, &val, &length));
+    ASSERT_EQ("beijing", std::string(val, length));
+    int64_t price = 0;
+    ASSERT_EQ(0, view.GetInt64(2, &price));
+    ASSERT_EQ(100, price);
+    std::string str;
+    ASSERT_EQ(0, view.GetStrValue(reinterpret_cast<const int8_t*>(coded.data()), 3, &str));
+    ASSERT_EQ("beijing", str);
+
+    std::string decoded;
+    ASSERT_TRUE(dict.DecodeRow(reinterpret_cast<const int8_t*>(coded.data()), &decoded));
+    ASSERT_EQ(row, decoded);
+
+    // the same strings get the same codes, the null field stays null
+    std::string row2 = EncodeRow(*schema, "card00000001", "mcc1", 200, NULL, 2000);
+    std::string coded2;
+    ASSERT_TRUE(dict.Encode(schema, reinterpret_cast<const int8_t*>(row2.data()), &coded2));
+    ASSERT_TRUE(view.Reset(reinterpret_cast<const int8_t*>(coded2.data()), coded2.size()));
+    ASSERT_TRUE(view.IsNULL(3));
+    ASSERT_EQ(0, view.GetString(0, &val, &length));
+    ASSERT_EQ("card00000001", std::string(val, length));
+    ASSERT_TRUE(dict.DecodeRow(reinterpret_cast<const int8_t*>(coded2.data()), &decoded));
+    ASSERT_EQ(row2, decoded);
+
+    // no string is long enough to code
+    std::string row3 = EncodeRow(*schema, "c", "m", 300, NULL, 3000);
+    ASSERT_FALSE(dict.Encode(schema, reinterpret_cast<const int8_t*>(row3.data()), &coded));
+    ASSERT_FALSE(dict.DecodeRow(reinterpret_cast<const int8_t*>(row3.data()), &decoded));
+}
+
+TEST_F(StringDictTest, Full) {
+    auto schema = CreateSchema();
+    StringDict dict(10);
+    std::string city = "shanghai";
+    std::vector<std::string> rows;
+    std::vector<std::string> coded_rows;
+    for (int i = 0; i < 2000; i++) {
+        rows.push_back(EncodeRow(*schema, "card" + std::to_string(i), "mcc", i, &city, 1000 + i));
+        coded_rows.emplace_back();
+        // the city is always coded even if the cards are not
+        ASSERT_TRUE(dict.Encode(schema, reinterpret_cast<const int8_t*>(rows.back().data()), &coded_rows.back()));
+    }
+    codec::RowView view(*schema);
+    view.SetStringDict(&dict);
+    for (int i = 0; i < 2000; i++) {
+        const int8_t* data = reinterpret_cast<const int8_t*>(coded_rows[i].data());
+        char* val = NULL;
+        uint32_t length = 0;
+        ASSERT_EQ(0, view.GetValue(data, 0, &val, &length));
+        ASSERT_EQ("card" + std::to_string(i), std::string(val, length));
+        ASSERT_EQ(0, view.GetValue(data, 3, &val, &length));
+        ASSERT_EQ(city, std::string(val, length));
+        std::string decoded;
+        ASSERT_TRUE(dict.DecodeRow(data, &decoded));
+        ASSERT_EQ(rows[i], decoded);
+    }
+    ASSERT_GT(dict.GetByteSize(), 0u);
+}
+
+TEST_F(StringDictTest, Concurrent) {
+    auto schema = CreateSchema();
+    StringDict dict(1000);
+    std::string city = "shenzhen";
+    std::vector<std::thread> threads;
+    std::atomic<uint32_t> failed(0);
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&, t]() {
+            codec::RowView view(*schema);
+            view.SetStringDict(&dict);
+            for (int i = 0; i < 2000; i++) {
+                // the threads code the same cards in different orders
+                int card = (i * (t + 1)) % 800;
+                std::string row = EncodeRow(*schema, "card" + std::to_string(card), "mcc", i, &city, 1000 + i);
+                std::string coded;
+                std::string decoded;
+                if (!dict.Encode(schema, reinterpret_cast<const int8_t*>(row.data()), &coded) ||
+                    !dict.DecodeRow(reinterpret_cast<const int8_t*>(coded.data()), &decoded) || decoded != row) {
+                    failed++;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    ASSERT_EQ(0u, failed.load());
+    // every card is coded once
+    uint32_t code = 0;
+    const char* val = NULL;
+    uint32_t length = 0;
+    for (code = 0; code < 800; code++) {
+        ASSERT_TRUE(dict.Decode(0, code, &val, &length));
+    }
+    ASSERT_FALSE(dict.Decode(0, code, &val, &length));
+}
+
+TEST_F(StringDictTest, MemTable) {
+    FLAGS_enable_memtable_string_dict = true;
+    ::openmldb::api::TableMeta table_meta;
+    table_meta.set_name("t1");
+    table_meta.set_tid(1);
+    table_meta.set_pid(0);
+    table_meta.set_seg_cnt(8);
+    table_meta.set_format_version(1);
+    auto schema = CreateSchema();
+    table_meta.mutable_column_desc()->CopyFrom(*schema);
+    SchemaCodec::SetIndex(table_meta.add_column_key(), "card", "card", "ts", ::openmldb::type::kAbsoluteTime, 0, 0);
+    MemTable table(table_meta);
+    ASSERT_TRUE(table.Init());
+    ASSERT_TRUE(table.GetStringDict() != NULL);
+    std::vector<std::string> rows;
+    std::string city = "guangzhou";
+    for (int i = 0; i < 100; i++) {
+        rows.push_back(EncodeRow(*schema, "card" + std::to_string(i % 10), "mcc" + std::to_string(i % 3), i, &city,
+                                 1000 + i));
+        Dimensions dimensions;
+        auto dim = dimensions.Add();
+        dim->set_idx(0);
+        dim->set_key("card" + std::to_string(i % 10));
+        ASSERT_TRUE(table.Put(0, rows.back(), dimensions));
+    }
+    Ticket ticket;
+    TableIterator* it = table.NewIterator(0, "card1", ticket);
+    it->SeekToFirst();
+    uint32_t cnt = 0;
+    while (it->Valid()) {
+        // the decoded value is valid until the iterator moves
+        ASSERT_EQ(rows[91 - cnt * 10], it->GetValue().ToString());
+        ASSERT_EQ(rows[91 - cnt * 10], it->GetValue().ToString());
+        cnt++;
+        it->Next();
+    }
+    ASSERT_EQ(10u, cnt);
+    delete it;
+
+    it = table.NewTraverseIterator(0);
+    it->SeekToFirst();
+    int count = 0;
+    while (it->Valid()) {
+        ASSERT_EQ(rows[it->GetKey() - 1000], it->GetValue().ToString());
+        count++;
+        it->Next();
+    }
+    ASSERT_EQ(100, count);
+    delete it;
+
+    ::hybridse::vm::WindowIterator* kit = table.NewWindowIterator(0);
+    kit->SeekToFirst();
+    count = 0;
+    while (kit->Valid()) {
+        std::unique_ptr<::hybridse::vm::RowIterator> wit = kit->GetValue();
+        wit->SeekToFirst();
+        while (wit->Valid()) {
+            const ::hybridse::codec::Row& row = wit->GetValue();
+            ASSERT_EQ(rows[wit->GetKey() - 1000], std::string(reinterpret_cast<char*>(row.buf()), row.size()));
+            count++;
+            wit->Next();
+        }
+        kit->Next();
+    }
+    ASSERT_EQ(100, count);
+    delete kit;
+    FLAGS_enable_memtable_string_dict = false;
+}
+
+}  // namespace storage
+}  // namespace openmldb
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    ::google::ParseCommandLineFlags(&argc, &argv, true);
+    return RUN_ALL_TESTS();
+}
@@ -16,9 +16,12 @@
 
 #include "tablet/file_receiver.h"
 
+#include <snappy.h>
+
 #include "base/file_util.h"
 #include "base/glog_wapper.h"
 #include "base/strings.h"
+#include "log/crc32c.h"
 
 namespace openmldb {
 namespace tablet {
@@ -80,6 +83,23 @@ int FileReceiver::WriteData(const std::string& data, uint64_t block_id) {
     return 0;
 }
 
+bool FileReceiver::DecodeBlock(::openmldb::type::CompressType compress_type, bool has_crc, uint32_t crc,
+                               std::string* data) {
+    if (compress_type == ::openmldb::type::CompressType::kSnappy) {
+        std::string uncompressed;
+        if (!snappy::Uncompress(data->data(), data->size(), &uncompressed)) {
+            PDLOG(WARNING, "fail to uncompress block");
+            return false;
+        }
+        data->swap(uncompressed);
+    }
+    if (has_crc && ::openmldb::log::Value(data->data(), data->size()) != crc) {
+        PDLOG(WARNING, "block crc mismatch. size %lu", data->size());
+        return false;
+    }
+    return true;
+}
+
 void FileReceiver::SaveFile() {
     std::string full_path = path_ + file_name_;
     std::string tmp_file_path = full_path + ".tmp";
@@ -18,6 +18,8 @@
 
 #include <string>
 
+#include "proto/type.pb.h"
+
 namespace openmldb {
 namespace tablet {
 
@@ -32,6 +34,10 @@ class FileReceiver {
     void SaveFile();
     uint64_t GetBlockId();
 
+    // uncompress the block received in place and check its crc if has_crc is set
+    static bool DecodeBlock(::openmldb::type::CompressType compress_type, bool has_crc, uint32_t crc,
+                            std::string* data);
+
  private:
     std::string file_name_;
     std::string dir_name_;
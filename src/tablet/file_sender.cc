@@ -16,6 +16,10 @@
 
 #include "tablet/file_sender.h"
 
+#include <snappy.h>
+
+#include <algorithm>
+#include <atomic>
 #include <thread>  // NOLINT
 #include <vector>
 
@@ -24,12 +28,13 @@
 #include "boost/algorithm/string/predicate.hpp"
 #include "common/timer.h"
 #include "gflags/gflags.h"
+#include "log/crc32c.h"
 
 DECLARE_int32(send_file_max_try);
 DECLARE_uint32(stream_block_size);
 DECLARE_int32(stream_bandwidth_limit);
-DECLARE_uint32(stream_block_size);
-DECLARE_int32(stream_bandwidth_limit);
+DECLARE_string(stream_compression);
+DECLARE_uint32(stream_send_file_concurrency);
 DECLARE_int32(stream_close_wait_time_ms);
 DECLARE_int32(retry_send_file_wait_time_ms);
 DECLARE_int32(request_max_retry);
@@ -44,7 +49,8 @@ FileSender::FileSender(uint32_t tid, uint32_t pid, const std::string& endpoint)
       endpoint_(endpoint),
       cur_try_time_(0),
       max_try_time_(FLAGS_send_file_max_try),
-      limit_time_(0),
+      limit_mu_(),
+      next_send_time_(0),
       channel_(NULL),
       stub_(NULL) {}
 
@@ -54,12 +60,6 @@ FileSender::~FileSender() {
 }
 
 bool FileSender::Init() {
-    // compute the used time(microseconds) that send a block by limit bandwidth.
-    // limit_time = (FLAGS_stream_block_size / FLAGS_stream_bandwidth_limit) *
-    // 1000 * 1000
-    if (FLAGS_stream_bandwidth_limit > 0) {
-        limit_time_ = (FLAGS_stream_block_size * 1000000) / FLAGS_stream_bandwidth_limit;
-    }
     channel_ = new brpc::Channel();
     brpc::ChannelOptions options;
     options.timeout_ms = FLAGS_request_timeout_ms;
@@ -73,12 +73,59 @@ bool FileSender::Init() {
     return true;
 }
 
+void FileSender::Throttle(size_t len) {
+    if (FLAGS_stream_bandwidth_limit <= 0 || len == 0) {
+        return;
+    }
+    // the time(microseconds) to send len bytes under the limit bandwidth
+    uint64_t cost = static_cast<uint64_t>(len) * 1000000 / FLAGS_stream_bandwidth_limit;
+    uint64_t cur_time = ::baidu::common::timer::get_micros();
+    uint64_t send_time = cur_time;
+    {
+        std::lock_guard<std::mutex> lock(limit_mu_);
+        send_time = std::max(cur_time, next_send_time_);
+        next_send_time_ = send_time + cost;
+    }
+    if (send_time > cur_time) {
+        DEBUGLOG("sleep %lu us, cost %lu", send_time - cur_time, cost);
+        std::this_thread::sleep_for(std::chrono::microseconds(send_time - cur_time));
+    }
+}
+
+int FileSender::InitReceiver(const std::string& file_name, const std::string& dir_name, bool resume,
+                             uint64_t* block_id) {
+    ::openmldb::api::SendDataRequest request;
+    request.set_tid(tid_);
+    request.set_pid(pid_);
+    request.set_file_name(file_name);
+    if (!dir_name.empty()) {
+        request.set_dir_name(dir_name);
+    }
+    request.set_block_id(0);
+    request.set_block_size(0);
+    request.set_resume(resume);
+    brpc::Controller cntl;
+    ::openmldb::api::GeneralResponse response;
+    stub_->SendData(&cntl, &request, &response, NULL);
+    if (cntl.Failed()) {
+        PDLOG(WARNING, "init receiver failed. tid %u pid %u file %s error msg %s", tid_, pid_, file_name.c_str(),
+              cntl.ErrorText().c_str());
+        return -1;
+    } else if (response.code() != 0) {
+        PDLOG(WARNING, "init receiver failed. tid %u pid %u file %s error msg %s", tid_, pid_, file_name.c_str(),
+              response.msg().c_str());
+        return -1;
+    }
+    // the receiver not supporting resume starts over
+    *block_id = response.additional_ids_size() > 0 ? response.additional_ids(0) : 0;
+    return 0;
+}
+
 int FileSender::WriteData(const std::string& file_name, const std::string& dir_name, const char* buffer, size_t len,
                           uint64_t block_id) {
     if (buffer == NULL) {
         return -1;
     }
-    uint64_t cur_time = ::baidu::common::timer::get_micros();
     ::openmldb::api::SendDataRequest request;
     request.set_tid(tid_);
     request.set_pid(pid_);
@@ -87,14 +134,26 @@ int FileSender::WriteData(const std::string& file_name, const std::string& dir_n
         request.set_dir_name(dir_name);
     }
     request.set_block_id(block_id);
-    request.set_block_size(len);
     brpc::Controller cntl;
     if (block_id > 0) {
-        cntl.request_attachment().append(buffer, len);
+        request.set_crc(::openmldb::log::Value(buffer, len));
+        std::string compressed;
+        if (FLAGS_stream_compression == "snappy" && len > 0) {
+            snappy::Compress(buffer, len, &compressed);
+        }
+        // the block is sent as it is if it can not be compressed
+        if (!compressed.empty() && compressed.size() < len) {
+            request.set_compress_type(::openmldb::type::CompressType::kSnappy);
+            cntl.request_attachment().append(compressed);
+        } else {
+            cntl.request_attachment().append(buffer, len);
+        }
     }
+    request.set_block_size(cntl.request_attachment().size());
     if (len > 0 && len < FLAGS_stream_block_size) {
         request.set_eof(true);
     }
+    Throttle(request.block_size());
     ::openmldb::api::GeneralResponse response;
     stub_->SendData(&cntl, &request, &response, NULL);
     if (cntl.Failed()) {
@@ -106,12 +165,6 @@ int FileSender::WriteData(const std::string& file_name, const std::string& dir_n
               response.msg().c_str());
         return -1;
     }
-    uint64_t time_used = ::baidu::common::timer::get_micros() - cur_time;
-    if (limit_time_ > time_used && len > FLAGS_stream_block_size / 2) {
-        uint64_t sleep_time = limit_time_ - time_used;
-        DEBUGLOG("sleep %lu us, limit_time %lu time_used %lu", sleep_time, limit_time_, time_used);
-        std::this_thread::sleep_for(std::chrono::microseconds(sleep_time));
-    }
     return 0;
 }
 
@@ -138,8 +191,10 @@ int FileSender::SendFile(const std::string& file_name, const std::string& dir_na
             PDLOG(INFO, "retry to send file %s to %s. total size[%lu]", full_path.c_str(), endpoint_.c_str(),
                   file_size);
         }
+        // a retry goes on from the block the receiver has got
+        bool resume = try_times < FLAGS_send_file_max_try;
         try_times--;
-        if (SendFileInternal(file_name, dir_name, full_path, file_size) < 0) {
+        if (SendFileInternal(file_name, dir_name, full_path, file_size, resume) < 0) {
             continue;
         }
         if (CheckFile(file_name, dir_name, file_size) < 0) {
@@ -151,24 +206,34 @@ int FileSender::SendFile(const std::string& file_name, const std::string& dir_na
 }
 
 int FileSender::SendFileInternal(const std::string& file_name, const std::string& dir_name,
-                                 const std::string& full_path, uint64_t file_size) {
+                                 const std::string& full_path, uint64_t file_size, bool resume) {
     FILE* file = fopen(full_path.c_str(), "rb");
     if (file == NULL) {
         PDLOG(WARNING, "fail to open file %s", full_path.c_str());
         return -1;
     }
-    char buffer[FLAGS_stream_block_size];
+    uint64_t block_count = 0;
+    if (InitReceiver(file_name, dir_name, resume, &block_count) < 0) {
+        PDLOG(WARNING, "Init file receiver failed. tid[%u] pid[%u] file %s", tid_, pid_, file_name.c_str());
+        fclose(file);
+        return -1;
+    }
+    if (block_count > 0) {
+        if (fseek(file, block_count * FLAGS_stream_block_size, SEEK_SET) != 0) {
+            PDLOG(WARNING, "fail to seek file %s to block %lu", full_path.c_str(), block_count);
+            fclose(file);
+            return -1;
+        }
+        PDLOG(INFO, "resume to send file %s from block %lu. tid[%u] pid[%u]", file_name.c_str(), block_count + 1,
+              tid_, pid_);
+    }
+    std::vector<char> block(FLAGS_stream_block_size);
+    char* buffer = block.data();
 
     uint64_t block_num = file_size / FLAGS_stream_block_size + 1;
     uint64_t report_block_num = block_num / 100;
     int ret = 0;
-    uint64_t block_count = 0;
     do {
-        if (block_count == 0 && WriteData(file_name, dir_name, buffer, 0, block_count) < 0) {
-            PDLOG(WARNING, "Init file receiver failed. tid[%u] pid[%u] file %s", tid_, pid_, file_name.c_str());
-            ret = -1;
-            break;
-        }
         block_count++;
 
 #ifdef __APPLE__
@@ -232,12 +297,31 @@ int FileSender::CheckFile(const std::string& file_name, const std::string& dir_n
 int FileSender::SendDir(const std::string& dir_name, const std::string& full_path) {
     std::vector<std::string> file_vec;
     ::openmldb::base::GetFileName(full_path, file_vec);
-    for (const std::string& file : file_vec) {
-        if (SendFile(file.substr(file.find_last_of("/") + 1), dir_name, file) < 0) {
-            return -1;
+    return SendFiles(file_vec, dir_name);
+}
+
+int FileSender::SendFiles(const std::vector<std::string>& full_paths, const std::string& dir_name) {
+    std::atomic<uint32_t> next(0);
+    std::atomic<bool> failed(false);
+    auto send = [&]() {
+        for (uint32_t idx = next++; idx < full_paths.size() && !failed.load(); idx = next++) {
+            const std::string& file = full_paths[idx];
+            if (SendFile(file.substr(file.find_last_of("/") + 1), dir_name, file) < 0) {
+                failed.store(true);
+            }
         }
+    };
+    uint32_t thread_num = std::min(std::max(FLAGS_stream_send_file_concurrency, 1u),
+                                   static_cast<uint32_t>(full_paths.size()));
+    std::vector<std::thread> threads;
+    for (uint32_t i = 1; i < thread_num; i++) {
+        threads.emplace_back(send);
     }
-    return 0;
+    send();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    return failed.load() ? -1 : 0;
 }
 
 }  // namespace tablet
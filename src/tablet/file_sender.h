@@ -19,7 +19,9 @@
 #include <brpc/channel.h>
 #include <brpc/controller.h>
 
+#include <mutex>  // NOLINT
 #include <string>
+#include <vector>
 
 #include "proto/tablet.pb.h"
 
@@ -33,20 +35,33 @@ class FileSender {
     bool Init();
     int SendFile(const std::string& file_name, const std::string& dir_name, const std::string& full_path);
     int SendFile(const std::string& file_name, const std::string& full_path);
+    // go on from the block the receiver has got if resume is set
     int SendFileInternal(const std::string& file_name, const std::string& dir_name, const std::string& full_path,
-                         uint64_t file_size);
+                         uint64_t file_size, bool resume);
     int SendDir(const std::string& dir_name, const std::string& full_path);
+    // send the files of full_paths, stream_send_file_concurrency of them at a time
+    int SendFiles(const std::vector<std::string>& full_paths, const std::string& dir_name);
     int WriteData(const std::string& file_name, const std::string& dir_name, const char* buffer, size_t len,
                   uint64_t block_id);
     int CheckFile(const std::string& file_name, const std::string& dir_name, uint64_t file_size);
 
+ private:
+    // start the receiver of the file, keep the part received if resume is set. block_id is
+    // set to the block received last
+    int InitReceiver(const std::string& file_name, const std::string& dir_name, bool resume, uint64_t* block_id);
+
+    // wait until the bytes can be sent under the bandwidth limit
+    void Throttle(size_t len);
+
  private:
     uint32_t tid_;
     uint32_t pid_;
     std::string endpoint_;
     uint32_t cur_try_time_;
     uint32_t max_try_time_;
-    uint64_t limit_time_;
+    // the time the next block can be sent at in microsecond, shared by the files sent together
+    std::mutex limit_mu_;
+    uint64_t next_send_time_;
     brpc::Channel* channel_;
     ::openmldb::api::TabletServer_Stub* stub_;
 };
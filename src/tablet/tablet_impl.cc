@@ -89,7 +89,11 @@ DECLARE_uint32(task_check_interval);
 DECLARE_uint32(load_index_max_wait_time);
 DECLARE_bool(use_name);
 DECLARE_bool(enable_distsql);
+DECLARE_string(jit_object_cache_dir);
+DECLARE_uint32(jit_object_cache_max_mb);
+DECLARE_uint32(tiered_compile_threshold);
 DECLARE_string(snapshot_compression);
+DECLARE_bool(snapshot_dump_memtable);
 DECLARE_string(file_compression);
 
 // cluster config
@@ -101,6 +105,7 @@ DECLARE_int32(zk_keep_alive_check_interval);
 
 DECLARE_int32(binlog_sync_to_disk_interval);
 DECLARE_int32(binlog_delete_interval);
+DECLARE_int32(binlog_sync_wait_time);
 DECLARE_uint32(absolute_ttl_max);
 DECLARE_uint32(latest_ttl_max);
 DECLARE_uint32(max_traverse_cnt);
@@ -118,6 +123,11 @@ static const uint32_t SEED = 0xe17a1465;
 
 static constexpr const char DEPLOY_STATS[] = "deploy_stats";
 
+// the memtable whose puts hold the snapshot cut off, only the dump of memtable snapshots cuts
+static MemTable* GetCutTable(const std::shared_ptr<Table>& table) {
+    return FLAGS_snapshot_dump_memtable ? dynamic_cast<MemTable*>(table.get()) : NULL;
+}
+
 TabletImpl::TabletImpl()
     : tables_(),
       mu_(),
@@ -190,6 +200,9 @@ bool TabletImpl::Init(const std::string& zk_cluster, const std::string& zk_path,
     } else {
         options.SetClusterOptimized(false);
     }
+    options.jit_options().SetObjectCacheDir(FLAGS_jit_object_cache_dir);
+    options.jit_options().SetObjectCacheMaxSize(static_cast<uint64_t>(FLAGS_jit_object_cache_max_mb) << 20);
+    options.SetTieredCompileThreshold(FLAGS_tiered_compile_threshold);
     engine_ = std::unique_ptr<::hybridse::vm::Engine>(new ::hybridse::vm::Engine(catalog_, options));
     catalog_->SetLocalTablet(
         std::shared_ptr<::hybridse::vm::Tablet>(new ::hybridse::vm::LocalTablet(engine_.get(), sp_cache_)));
@@ -643,6 +656,8 @@ void TabletImpl::Put(RpcController* controller, const ::openmldb::api::PutReques
         response->set_msg("table is loading");
         return;
     }
+    // the row and its binlog entry are on the same side of a snapshot cut
+    ::openmldb::storage::PutGuard put_guard(GetCutTable(table));
     bool ok = false;
     if (request->dimensions_size() > 0) {
         int32_t ret_code = CheckDimessionPut(request, table->GetIdxCnt());
@@ -653,7 +668,7 @@ void TabletImpl::Put(RpcController* controller, const ::openmldb::api::PutReques
         }
         DLOG(INFO) << "put data to tid " << request->tid() << " pid " << request->pid() << " with key "
                    << request->dimensions(0).key();
-        ok = table->Put(request->time(), request->value(), request->dimensions());
+        ok = put_guard.Put(table.get(), request->time(), request->value(), request->dimensions());
     }
     if (!ok) {
         response->set_code(::openmldb::base::ReturnCode::kPutFailed);
@@ -680,7 +695,16 @@ void TabletImpl::Put(RpcController* controller, const ::openmldb::api::PutReques
         if (request->ts_dimensions_size() > 0) {
             entry.mutable_ts_dimensions()->CopyFrom(request->ts_dimensions());
         }
-        replicator->AppendEntry(entry);
+        if (!replicator->AppendEntry(entry)) {
+            // the row is in the table already and the entry is not logged ahead of it, as a put
+            // failed by the table must not be logged. the client retries at least once
+            PDLOG(WARNING, "put applied but fail to append entry to binlog. tid %u pid %u", request->tid(),
+                  request->pid());
+            response->set_code(::openmldb::base::ReturnCode::kAppliedNotReplicated);
+            response->set_msg("put applied but fail to append entry to replicator");
+            return;
+        }
+        put_guard.Commit(entry.log_index());
     } while (false);
 
     ok = UpdateAggrs(request->tid(), request->pid(), request->value(),
@@ -1492,6 +1516,7 @@ void TabletImpl::Delete(RpcController* controller, const ::openmldb::api::Delete
         }
         idx = index_def->GetId();
     }
+    ::openmldb::storage::PutGuard put_guard(GetCutTable(table));
     if (table->Delete(request->key(), idx)) {
         response->set_code(::openmldb::base::ReturnCode::kOk);
         response->set_msg("ok");
@@ -1514,7 +1539,14 @@ void TabletImpl::Delete(RpcController* controller, const ::openmldb::api::Delete
         ::openmldb::api::Dimension* dimension = entry.add_dimensions();
         dimension->set_key(request->key());
         dimension->set_idx(idx);
-        replicator->AppendEntry(entry);
+        if (!replicator->AppendEntry(entry)) {
+            // the key is deleted from the table already, see Put
+            PDLOG(WARNING, "delete applied but fail to append entry to binlog. tid %u pid %u", request->tid(),
+                  request->pid());
+            response->set_code(::openmldb::base::ReturnCode::kAppliedNotReplicated);
+            response->set_msg("delete applied but fail to append entry to replicator");
+            return;
+        }
     } while (false);
     if (replicator && FLAGS_binlog_notify_on_put) {
         replicator->Notify();
@@ -2118,6 +2150,18 @@ void TabletImpl::AppendEntries(RpcController* controller, const ::openmldb::api:
         PDLOG(INFO, "first sync log_index! log_offset[%lu] tid[%u] pid[%u]", last_log_offset, tid, pid);
         return;
     }
+    if (request->pre_log_index() > last_log_offset) {
+        // the pipelined requests may arrive out of order, wait for the ones before
+        last_log_offset = replicator->WaitOffset(request->pre_log_index(), FLAGS_binlog_sync_wait_time);
+        if (request->pre_log_index() > last_log_offset) {
+            PDLOG(WARNING, "pre log index %lu gt cur log offset %lu. tid %u pid %u", request->pre_log_index(),
+                  last_log_offset, tid, pid);
+            response->set_code(::openmldb::base::ReturnCode::kLogIndexMismatch);
+            response->set_msg("log index mismatch");
+            response->set_log_offset(last_log_offset);
+            return;
+        }
+    }
     for (int32_t i = 0; i < request->entries_size(); i++) {
         const auto& entry = request->entries(i);
         if (entry.log_index() <= last_log_offset) {
@@ -2125,12 +2169,18 @@ void TabletImpl::AppendEntries(RpcController* controller, const ::openmldb::api:
                     last_log_offset, tid, pid);
             continue;
         }
-        if (!replicator->ApplyEntry(entry)) {
+        ::openmldb::storage::PutGuard put_guard(GetCutTable(table));
+        bool applied = false;
+        if (!replicator->ApplyEntry(entry, &applied)) {
             PDLOG(WARNING, "fail to write binlog. tid %u pid %u", tid, pid);
             response->set_code(::openmldb::base::ReturnCode::kFailToAppendEntriesToReplicator);
             response->set_msg("fail to append entries to replicator");
             return;
         }
+        if (!applied) {
+            // put to the table by the pipelined request applied it
+            continue;
+        }
         if (entry.has_method_type() && entry.method_type() == ::openmldb::api::MethodType::kDelete) {
             if (entry.dimensions_size() == 0) {
                 PDLOG(WARNING, "no dimesion. tid %u pid %u", tid, pid);
@@ -2140,12 +2190,13 @@ void TabletImpl::AppendEntries(RpcController* controller, const ::openmldb::api:
             }
             table->Delete(entry.dimensions(0).key(), entry.dimensions(0).idx());
         }
-        if (!table->Put(entry)) {
+        if (!put_guard.Put(table.get(), entry.ts(), entry.value(), entry.dimensions())) {
             PDLOG(WARNING, "fail to put entry. tid %u pid %u", tid, pid);
             response->set_code(::openmldb::base::ReturnCode::kFailToAppendEntriesToReplicator);
             response->set_msg("fail to append entry to table");
             return;
         }
+        put_guard.Commit(entry.log_index());
     }
     response->set_log_offset(replicator->GetOffset());
 }
@@ -2275,6 +2326,7 @@ void TabletImpl::GetTableStatus(RpcController* controller, const ::openmldb::api
             std::shared_ptr<LogReplicator> replicator = GetReplicatorUnLock(table->GetId(), table->GetPid());
             if (replicator) {
                 status->set_offset(replicator->GetOffset());
+                status->set_replicate_lag(replicator->GetReplicateLag());
             }
             status->set_record_cnt(table->GetRecordCnt());
             if (MemTable* mem_table = dynamic_cast<MemTable*>(table.get())) {
@@ -2376,7 +2428,14 @@ void TabletImpl::MakeSnapshotInternal(uint32_t tid, uint32_t pid, uint64_t end_o
               tid, pid, cur_offset, snapshot_offset, end_offset);
     } else {
         uint64_t offset = 0;
-        ret = snapshot->MakeSnapshot(table, offset, end_offset);
+        auto mem_table = std::dynamic_pointer_cast<MemTable>(table);
+        auto mem_snapshot = std::dynamic_pointer_cast<::openmldb::storage::MemTableSnapshot>(snapshot);
+        if (FLAGS_snapshot_dump_memtable && end_offset == 0 && mem_table && mem_snapshot) {
+            ret = mem_snapshot->DumpSnapshot(
+                mem_table, [replicator] { return replicator->GetOffset(); }, replicator->GetLeaderTerm(), &offset);
+        } else {
+            ret = snapshot->MakeSnapshot(table, offset, end_offset);
+        }
         if (ret == 0) {
             std::shared_ptr<LogReplicator> replicator = GetReplicator(tid, pid);
             if (replicator) {
@@ -2531,6 +2590,14 @@ void TabletImpl::SendData(RpcController* controller, const ::openmldb::api::Send
                 file_receiver_map_.insert(
                     std::make_pair(combine_key, std::make_shared<FileReceiver>(request->file_name(), dir_name, path)));
                 iter = file_receiver_map_.find(combine_key);
+            } else if (request->resume() && iter->second->GetBlockId() > 0) {
+                // the sender goes on from the block after the one received last
+                PDLOG(INFO, "resume file receiver from block %lu. tid %u, pid %u, file_name %s",
+                      iter->second->GetBlockId(), tid, pid, request->file_name().c_str());
+                response->add_additional_ids(iter->second->GetBlockId());
+                response->set_code(::openmldb::base::ReturnCode::kOk);
+                response->set_msg("ok");
+                return;
             }
             if (!iter->second->Init()) {
                 PDLOG(WARNING, "file receiver init failed. tid %u, pid %u, file_name %s", tid, pid,
@@ -2541,6 +2608,9 @@ void TabletImpl::SendData(RpcController* controller, const ::openmldb::api::Send
                 return;
             }
             PDLOG(INFO, "file receiver init ok. tid %u, pid %u, file_name %s", tid, pid, request->file_name().c_str());
+            if (request->resume()) {
+                response->add_additional_ids(0);
+            }
             response->set_code(::openmldb::base::ReturnCode::kOk);
             response->set_msg("ok");
         } else if (iter == file_receiver_map_.end()) {
@@ -2582,6 +2652,13 @@ void TabletImpl::SendData(RpcController* controller, const ::openmldb::api::Send
         response->set_msg("receive data error");
         return;
     }
+    if (!FileReceiver::DecodeBlock(request->compress_type(), request->has_crc(), request->crc(), &data)) {
+        PDLOG(WARNING, "fail to decode block %lu. tid %u, pid %u, file_name %s", request->block_id(), tid, pid,
+              request->file_name().c_str());
+        response->set_code(::openmldb::base::ReturnCode::kReceiveDataError);
+        response->set_msg("receive data error");
+        return;
+    }
     if (receiver->WriteData(data, request->block_id()) < 0) {
         PDLOG(WARNING, "receiver write data failed. tid %u, pid %u, file_name %s", tid, pid,
               request->file_name().c_str());
@@ -2695,6 +2772,7 @@ void TabletImpl::SendSnapshotInternal(const std::string& endpoint, uint32_t tid,
         full_path.append("snapshot/");
         std::string manifest_file = full_path + "MANIFEST";
         std::string snapshot_file;
+        std::vector<std::string> delta_files;
         {
             int fd = open(manifest_file.c_str(), O_RDONLY);
             if (fd < 0) {
@@ -2710,9 +2788,16 @@ void TabletImpl::SendSnapshotInternal(const std::string& endpoint, uint32_t tid,
                 break;
             }
             snapshot_file = manifest.name();
+            for (const auto& delta : manifest.delta()) {
+                delta_files.push_back(delta.name());
+            }
+        }
+        // send the snapshot and delta snapshot files together before the manifest refers to them
+        std::vector<std::string> snapshot_files = {full_path + snapshot_file};
+        for (const auto& delta_file : delta_files) {
+            snapshot_files.push_back(full_path + delta_file);
         }
-        // send snapshot file
-        if (sender.SendFile(snapshot_file, full_path + snapshot_file) < 0) {
+        if (sender.SendFiles(snapshot_files, "") < 0) {
             PDLOG(WARNING, "send snapshot failed. tid[%u] pid[%u]", tid, pid);
             break;
         }
@@ -3182,6 +3267,9 @@ void TabletImpl::GetTableFollower(RpcController* controller, const ::openmldb::a
         ::openmldb::api::FollowerInfo* follower_info = response->add_follower_info();
         follower_info->set_endpoint(kv.first);
         follower_info->set_offset(kv.second);
+        if (response->offset() > kv.second) {
+            follower_info->set_lag(response->offset() - kv.second);
+        }
     }
     response->set_msg("ok");
     response->set_code(::openmldb::base::ReturnCode::kOk);
@@ -3875,17 +3963,52 @@ bool TabletImpl::UpdateAggrs(uint32_t tid, uint32_t pid, const std::string& valu
 void TabletImpl::ShowMemPool(RpcController* controller, const ::openmldb::api::HttpRequest* request,
                              ::openmldb::api::HttpResponse* response, Closure* done) {
     brpc::ClosureGuard done_guard(done);
-#ifdef TCMALLOC_ENABLE
     brpc::Controller* cntl = static_cast<brpc::Controller*>(controller);
+    cntl->response_attachment().append("<html><head><title>Mem Stat</title></head><body><pre>");
+#ifdef TCMALLOC_ENABLE
     MallocExtension* tcmalloc = MallocExtension::instance();
     std::string stat;
     stat.resize(1024);
     char* buffer = reinterpret_cast<char*>(&(stat[0]));
     tcmalloc->GetStats(buffer, 1024);
-    cntl->response_attachment().append("<html><head><title>Mem Stat</title></head><body><pre>");
     cntl->response_attachment().append(stat);
-    cntl->response_attachment().append("</pre></body></html>");
 #endif
+    std::vector<std::shared_ptr<Table>> tables;
+    {
+        std::lock_guard<SpinMutex> spin_lock(spin_mutex_);
+        for (auto it = tables_.begin(); it != tables_.end(); ++it) {
+            for (auto pit = it->second.begin(); pit != it->second.end(); ++pit) {
+                tables.push_back(pit->second);
+            }
+        }
+    }
+    cntl->response_attachment().append("\n------------------------------------------------\n");
+    cntl->response_attachment().append(
+        "MemTable: tid pid record_cnt bytes_per_row avg_put_us slab_reserved slab_used gc_cnt last_gc_ms "
+        "gc_record_cnt\n");
+    for (const auto& table : tables) {
+        MemTable* mem_table = dynamic_cast<MemTable*>(table.get());
+        if (mem_table == NULL) {
+            continue;
+        }
+        uint64_t record_cnt = mem_table->GetRecordCnt();
+        uint64_t put_cnt = mem_table->GetPutCnt();
+        uint64_t byte_size = mem_table->GetRecordByteSize() + mem_table->GetRecordIdxByteSize();
+        uint64_t slab_reserved = 0;
+        uint64_t slab_used = 0;
+        const auto* slab = mem_table->GetSlabAllocator();
+        if (slab != NULL) {
+            slab_reserved = slab->GetReservedByteSize();
+            slab_used = slab->GetUsedByteSize();
+        }
+        char line[256];
+        snprintf(line, sizeof(line), "MemTable: %u %u %lu %lu %.2f %lu %lu %lu %lu %lu\n", mem_table->GetId(),
+                 mem_table->GetPid(), record_cnt, record_cnt == 0 ? 0 : byte_size / record_cnt,
+                 put_cnt == 0 ? 0.0 : static_cast<double>(mem_table->GetPutTime()) / put_cnt, slab_reserved, slab_used,
+                 mem_table->GetGcCnt(), mem_table->GetLastGcTime(), mem_table->GetGcRecordCnt());
+        cntl->response_attachment().append(line);
+    }
+    cntl->response_attachment().append("</pre></body></html>");
 }
 
 void TabletImpl::CheckZkClient() {